@@ -0,0 +1,966 @@
+/** @file
+    Measure the read throughput of the FAT driver on a RAM disk with an
+    injected latency.
+
+    The application installs a RAM disk producing EFI_BLOCK_IO_PROTOCOL and
+    EFI_BLOCK_IO2_PROTOCOL, formats it as a FAT16 superfloppy, connects the
+    file system drivers to it and writes a test file. The file is then read
+    with blocking reads, and with non-blocking reads keeping a number of
+    requests in flight. Every access of the RAM disk completes after the
+    injected latency; blocking accesses stall for it, and non-blocking
+    accesses complete from a timer event, so concurrent requests overlap as
+    on a device with a deep queue.
+
+    The completion of a non-blocking access is as precise as the timer tick
+    of the platform, the latency should be a multiple of it.
+
+    Usage: FatIoBench [-l LatencyUs] [-s FileSizeMb] [-b RequestSizeKb] [-q QueueDepth]
+
+    Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+    This program and the accompanying materials
+    are licensed and made available under the terms and conditions of the BSD License
+    which accompanies this distribution. The full text of the license may be found at
+    http://opensource.org/licenses/bsd-license.php
+
+    THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+    WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+#include  <Uefi.h>
+#include  <Library/BaseLib.h>
+#include  <Library/BaseMemoryLib.h>
+#include  <Library/DebugLib.h>
+#include  <Library/DevicePathLib.h>
+#include  <Library/MemoryAllocationLib.h>
+#include  <Library/UefiBootServicesTableLib.h>
+#include  <Library/UefiLib.h>
+#include  <Library/ShellCEntryLib.h>
+#include  <Protocol/BlockIo.h>
+#include  <Protocol/BlockIo2.h>
+#include  <Protocol/DevicePath.h>
+#include  <Protocol/SimpleFileSystem.h>
+
+#define RAM_DISK_BLOCK_SIZE         512
+#define RAM_DISK_SIZE               SIZE_128MB
+#define RAM_DISK_SECTORS_PER_CLUSTER  8
+#define RAM_DISK_ROOT_ENTRIES       512
+#define RAM_DISK_NUM_FATS           2
+
+#define TICK_PERIOD                 100000      // 10ms in 100ns units
+#define TICK_MS                     10
+
+#define DEFAULT_LATENCY_US          10000
+#define DEFAULT_FILE_SIZE_MB        32
+#define DEFAULT_REQUEST_SIZE_KB     64
+#define DEFAULT_QUEUE_DEPTH         8
+
+#define WRITE_CHUNK_SIZE            SIZE_1MB
+
+#define TEST_FILE_NAME              L"FatIoBench.dat"
+
+#define RAM_DISK_SIGNATURE          SIGNATURE_32 ('f', 'i', 'o', 'b')
+
+EFI_GUID  mFatIoBenchRamDiskGuid = {
+  0x199115a7, 0xcc38, 0x47b1, { 0xb9, 0x23, 0x64, 0xd1, 0xf4, 0xaa, 0x13, 0x62 }
+};
+
+#pragma pack(1)
+typedef struct {
+  UINT8   Ia32Jump[3];
+  CHAR8   OemId[8];
+  UINT16  SectorSize;
+  UINT8   SectorsPerCluster;
+  UINT16  ReservedSectors;
+  UINT8   NumFats;
+  UINT16  RootEntries;
+  UINT16  Sectors;
+  UINT8   Media;
+  UINT16  SectorsPerFat;
+  UINT16  SectorsPerTrack;
+  UINT16  Heads;
+  UINT32  HiddenSectors;
+  UINT32  LargeSectors;
+  UINT8   PhysicalDriveNumber;
+  UINT8   CurrentHead;
+  UINT8   Signature;
+  UINT32  Id;
+  CHAR8   FatLabel[11];
+  CHAR8   SystemId[8];
+} FAT16_BOOT_SECTOR;
+
+typedef struct {
+  VENDOR_DEVICE_PATH        Vendor;
+  EFI_DEVICE_PATH_PROTOCOL  End;
+} RAM_DISK_DEVICE_PATH;
+#pragma pack()
+
+typedef struct {
+  UINT32                    Signature;
+  EFI_HANDLE                Handle;
+  EFI_BLOCK_IO_PROTOCOL     BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL    BlockIo2;
+  EFI_BLOCK_IO_MEDIA        Media;
+  RAM_DISK_DEVICE_PATH      DevicePath;
+  UINT8                     *Data;
+  UINTN                     LatencyUs;
+  UINTN                     Outstanding;
+} RAM_DISK;
+
+#define RAM_DISK_FROM_BLOCK_IO(a)   CR (a, RAM_DISK, BlockIo, RAM_DISK_SIGNATURE)
+#define RAM_DISK_FROM_BLOCK_IO2(a)  CR (a, RAM_DISK, BlockIo2, RAM_DISK_SIGNATURE)
+
+typedef struct {
+  RAM_DISK                  *RamDisk;
+  EFI_BLOCK_IO2_TOKEN       *Token;
+  EFI_EVENT                 Timer;
+  BOOLEAN                   Write;
+  EFI_LBA                   Lba;
+  UINTN                     BufferSize;
+  VOID                      *Buffer;
+} RAM_DISK_REQUEST;
+
+volatile UINTN  mTicks;
+
+/**
+  Count the ticks of the benchmark clock.
+
+  @param[in]  Event     The periodic timer event.
+  @param[in]  Context   Unused.
+**/
+VOID
+EFIAPI
+OnTick (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  mTicks++;
+}
+
+/**
+  Check the range of a RAM disk access.
+
+  @param[in]  RamDisk     The RAM disk.
+  @param[in]  MediaId     The media ID of the request.
+  @param[in]  Lba         The first block accessed.
+  @param[in]  BufferSize  The number of bytes accessed.
+  @param[in]  Buffer      The buffer of the access.
+
+  @retval  EFI_SUCCESS    The access is valid.
+  @retval  Other          The access is invalid.
+**/
+EFI_STATUS
+RamDiskCheck (
+  IN RAM_DISK   *RamDisk,
+  IN UINT32     MediaId,
+  IN EFI_LBA    Lba,
+  IN UINTN      BufferSize,
+  IN VOID       *Buffer
+  )
+{
+  if (MediaId != RamDisk->Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+  if (Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if ((BufferSize % RAM_DISK_BLOCK_SIZE) != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+  if (Lba > RamDisk->Media.LastBlock ||
+      DivU64x32 (BufferSize, RAM_DISK_BLOCK_SIZE) > RamDisk->Media.LastBlock - Lba + 1) {
+    return EFI_INVALID_PARAMETER;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy the data of a RAM disk access.
+
+  @param[in]  RamDisk     The RAM disk.
+  @param[in]  Write       Whether the access writes to the disk.
+  @param[in]  Lba         The first block accessed.
+  @param[in]  BufferSize  The number of bytes accessed.
+  @param[in]  Buffer      The buffer of the access.
+**/
+VOID
+RamDiskCopy (
+  IN RAM_DISK   *RamDisk,
+  IN BOOLEAN    Write,
+  IN EFI_LBA    Lba,
+  IN UINTN      BufferSize,
+  IN VOID       *Buffer
+  )
+{
+  UINT8         *Data;
+
+  Data = RamDisk->Data + (UINTN) MultU64x32 (Lba, RAM_DISK_BLOCK_SIZE);
+  if (Write) {
+    CopyMem (Data, Buffer, BufferSize);
+  } else {
+    CopyMem (Buffer, Data, BufferSize);
+  }
+}
+
+/**
+  Access the RAM disk after stalling for the injected latency.
+
+  @param[in]  RamDisk     The RAM disk.
+  @param[in]  Write       Whether the access writes to the disk.
+  @param[in]  MediaId     The media ID of the request.
+  @param[in]  Lba         The first block accessed.
+  @param[in]  BufferSize  The number of bytes accessed.
+  @param[in]  Buffer      The buffer of the access.
+
+  @retval  EFI_SUCCESS    The data is accessed.
+  @retval  Other          The access is invalid.
+**/
+EFI_STATUS
+RamDiskAccess (
+  IN RAM_DISK   *RamDisk,
+  IN BOOLEAN    Write,
+  IN UINT32     MediaId,
+  IN EFI_LBA    Lba,
+  IN UINTN      BufferSize,
+  IN VOID       *Buffer
+  )
+{
+  EFI_STATUS    Status;
+
+  Status = RamDiskCheck (RamDisk, MediaId, Lba, BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if (RamDisk->LatencyUs != 0) {
+    gBS->Stall (RamDisk->LatencyUs);
+  }
+  RamDiskCopy (RamDisk, Write, Lba, BufferSize, Buffer);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskReset (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL *This,
+  IN  UINT32                MediaId,
+  IN  EFI_LBA               Lba,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  return RamDiskAccess (RAM_DISK_FROM_BLOCK_IO (This), FALSE, MediaId, Lba, BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  return RamDiskAccess (RAM_DISK_FROM_BLOCK_IO (This), TRUE, MediaId, Lba, BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Complete a non-blocking access of the RAM disk when its latency elapsed.
+
+  @param[in]  Event     The timer event of the request.
+  @param[in]  Context   The request.
+**/
+VOID
+EFIAPI
+RamDiskOnRequestTimer (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  RAM_DISK_REQUEST  *Request;
+
+  Request = (RAM_DISK_REQUEST *) Context;
+  RamDiskCopy (Request->RamDisk, Request->Write, Request->Lba, Request->BufferSize, Request->Buffer);
+  Request->Token->TransactionStatus = EFI_SUCCESS;
+  gBS->SignalEvent (Request->Token->Event);
+
+  Request->RamDisk->Outstanding--;
+  gBS->CloseEvent (Request->Timer);
+  FreePool (Request);
+}
+
+/**
+  Start a non-blocking access of the RAM disk, completing after the injected
+  latency. The access is blocking if the token has no event.
+
+  @param[in]  RamDisk     The RAM disk.
+  @param[in]  Write       Whether the access writes to the disk.
+  @param[in]  MediaId     The media ID of the request.
+  @param[in]  Lba         The first block accessed.
+  @param[in]  Token       The token of the access.
+  @param[in]  BufferSize  The number of bytes accessed.
+  @param[in]  Buffer      The buffer of the access.
+
+  @retval  EFI_SUCCESS    The access is started.
+  @retval  Other          The access can not be started.
+**/
+EFI_STATUS
+RamDiskAccessEx (
+  IN RAM_DISK               *RamDisk,
+  IN BOOLEAN                Write,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN EFI_BLOCK_IO2_TOKEN    *Token,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  RAM_DISK_REQUEST  *Request;
+  EFI_TPL           OldTpl;
+  EFI_STATUS        Status;
+
+  if (Token == NULL || Token->Event == NULL) {
+    return RamDiskAccess (RamDisk, Write, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  Status = RamDiskCheck (RamDisk, MediaId, Lba, BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (RamDisk->LatencyUs == 0) {
+    RamDiskCopy (RamDisk, Write, Lba, BufferSize, Buffer);
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  Request = AllocatePool (sizeof (*Request));
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Request->RamDisk    = RamDisk;
+  Request->Token      = Token;
+  Request->Write      = Write;
+  Request->Lba        = Lba;
+  Request->BufferSize = BufferSize;
+  Request->Buffer     = Buffer;
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  RamDiskOnRequestTimer,
+                  Request,
+                  &Request->Timer
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (Request);
+    return Status;
+  }
+
+  //
+  // The request can not complete before it is counted
+  //
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  Status = gBS->SetTimer (Request->Timer, TimerRelative, MultU64x32 (RamDisk->LatencyUs, 10));
+  if (!EFI_ERROR (Status)) {
+    RamDisk->Outstanding++;
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (Request->Timer);
+    FreePool (Request);
+  }
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  return RamDiskAccessEx (RAM_DISK_FROM_BLOCK_IO2 (This), FALSE, MediaId, Lba, Token, BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  return RamDiskAccessEx (RAM_DISK_FROM_BLOCK_IO2 (This), TRUE, MediaId, Lba, Token, BufferSize, Buffer);
+}
+
+EFI_STATUS
+EFIAPI
+RamDiskFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  if (Token != NULL && Token->Event != NULL) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Format the RAM disk as a FAT16 superfloppy.
+
+  @param[in]  RamDisk   The RAM disk.
+**/
+VOID
+RamDiskFormat (
+  IN RAM_DISK   *RamDisk
+  )
+{
+  FAT16_BOOT_SECTOR *BootSector;
+  UINT32            Sectors;
+  UINT32            SectorsPerFat;
+  UINT8             *Fat;
+  UINTN             Index;
+
+  Sectors       = RAM_DISK_SIZE / RAM_DISK_BLOCK_SIZE;
+  SectorsPerFat = ((Sectors / RAM_DISK_SECTORS_PER_CLUSTER + 2) * 2 + RAM_DISK_BLOCK_SIZE - 1) / RAM_DISK_BLOCK_SIZE;
+
+  ZeroMem (RamDisk->Data, RAM_DISK_SIZE);
+  BootSector = (FAT16_BOOT_SECTOR *) RamDisk->Data;
+  BootSector->Ia32Jump[0]         = 0xEB;
+  BootSector->Ia32Jump[1]         = 0x3C;
+  BootSector->Ia32Jump[2]         = 0x90;
+  CopyMem (BootSector->OemId, "EDK2    ", sizeof (BootSector->OemId));
+  BootSector->SectorSize          = RAM_DISK_BLOCK_SIZE;
+  BootSector->SectorsPerCluster   = RAM_DISK_SECTORS_PER_CLUSTER;
+  BootSector->ReservedSectors     = 1;
+  BootSector->NumFats             = RAM_DISK_NUM_FATS;
+  BootSector->RootEntries         = RAM_DISK_ROOT_ENTRIES;
+  BootSector->Media               = 0xF8;
+  BootSector->SectorsPerFat       = (UINT16) SectorsPerFat;
+  BootSector->LargeSectors        = Sectors;
+  BootSector->PhysicalDriveNumber = 0x80;
+  BootSector->Signature           = 0x29;
+  BootSector->Id                  = 0x46494F42;
+  CopyMem (BootSector->FatLabel, "FATIOBENCH ", sizeof (BootSector->FatLabel));
+  CopyMem (BootSector->SystemId, "FAT16   ", sizeof (BootSector->SystemId));
+  RamDisk->Data[510] = 0x55;
+  RamDisk->Data[511] = 0xAA;
+
+  for (Index = 0; Index < RAM_DISK_NUM_FATS; Index++) {
+    Fat = RamDisk->Data + (1 + Index * SectorsPerFat) * RAM_DISK_BLOCK_SIZE;
+    Fat[0] = 0xF8;
+    Fat[1] = 0xFF;
+    Fat[2] = 0xFF;
+    Fat[3] = 0xFF;
+  }
+}
+
+/**
+  Create a RAM disk, install its protocols and connect the drivers to it.
+
+  @param[out] RamDisk   The RAM disk.
+
+  @retval  EFI_SUCCESS  The RAM disk is created.
+  @retval  Other        The RAM disk can not be created.
+**/
+EFI_STATUS
+RamDiskCreate (
+  OUT RAM_DISK  **RamDisk
+  )
+{
+  RAM_DISK      *Disk;
+  EFI_STATUS    Status;
+
+  Disk = AllocateZeroPool (sizeof (*Disk));
+  if (Disk == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Disk->Data = AllocatePool (RAM_DISK_SIZE);
+  if (Disk->Data == NULL) {
+    FreePool (Disk);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  RamDiskFormat (Disk);
+
+  Disk->Signature               = RAM_DISK_SIGNATURE;
+  Disk->Media.MediaId           = 1;
+  Disk->Media.MediaPresent      = TRUE;
+  Disk->Media.BlockSize         = RAM_DISK_BLOCK_SIZE;
+  Disk->Media.LastBlock         = RAM_DISK_SIZE / RAM_DISK_BLOCK_SIZE - 1;
+
+  Disk->BlockIo.Revision        = EFI_BLOCK_IO_PROTOCOL_REVISION;
+  Disk->BlockIo.Media           = &Disk->Media;
+  Disk->BlockIo.Reset           = RamDiskReset;
+  Disk->BlockIo.ReadBlocks      = RamDiskReadBlocks;
+  Disk->BlockIo.WriteBlocks     = RamDiskWriteBlocks;
+  Disk->BlockIo.FlushBlocks     = RamDiskFlushBlocks;
+
+  Disk->BlockIo2.Media          = &Disk->Media;
+  Disk->BlockIo2.Reset          = RamDiskResetEx;
+  Disk->BlockIo2.ReadBlocksEx   = RamDiskReadBlocksEx;
+  Disk->BlockIo2.WriteBlocksEx  = RamDiskWriteBlocksEx;
+  Disk->BlockIo2.FlushBlocksEx  = RamDiskFlushBlocksEx;
+
+  Disk->DevicePath.Vendor.Header.Type     = HARDWARE_DEVICE_PATH;
+  Disk->DevicePath.Vendor.Header.SubType  = HW_VENDOR_DP;
+  SetDevicePathNodeLength (&Disk->DevicePath.Vendor.Header, sizeof (VENDOR_DEVICE_PATH));
+  CopyGuid (&Disk->DevicePath.Vendor.Guid, &mFatIoBenchRamDiskGuid);
+  SetDevicePathEndNode (&Disk->DevicePath.End);
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Disk->Handle,
+                  &gEfiDevicePathProtocolGuid, &Disk->DevicePath,
+                  &gEfiBlockIoProtocolGuid, &Disk->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Disk->BlockIo2,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (Disk->Data);
+    FreePool (Disk);
+    return Status;
+  }
+
+  gBS->ConnectController (Disk->Handle, NULL, NULL, TRUE);
+  *RamDisk = Disk;
+  return EFI_SUCCESS;
+}
+
+/**
+  Wait for the non-blocking accesses of the RAM disk, disconnect the drivers
+  from it and free it.
+
+  @param[in]  RamDisk   The RAM disk.
+**/
+VOID
+RamDiskDestroy (
+  IN RAM_DISK   *RamDisk
+  )
+{
+  while (RamDisk->Outstanding != 0) {
+    gBS->Stall (1000);
+  }
+
+  gBS->DisconnectController (RamDisk->Handle, NULL, NULL);
+  gBS->UninstallMultipleProtocolInterfaces (
+         RamDisk->Handle,
+         &gEfiDevicePathProtocolGuid, &RamDisk->DevicePath,
+         &gEfiBlockIoProtocolGuid, &RamDisk->BlockIo,
+         &gEfiBlockIo2ProtocolGuid, &RamDisk->BlockIo2,
+         NULL
+         );
+  FreePool (RamDisk->Data);
+  FreePool (RamDisk);
+}
+
+/**
+  Fill a buffer with the pattern of the test file.
+
+  @param[in]  Buffer      The buffer.
+  @param[in]  Offset      The offset of the buffer in the file.
+  @param[in]  BufferSize  The size of the buffer.
+**/
+VOID
+FillPattern (
+  OUT UINT32  *Buffer,
+  IN  UINTN   Offset,
+  IN  UINTN   BufferSize
+  )
+{
+  UINTN       Index;
+
+  for (Index = 0; Index < BufferSize / sizeof (UINT32); Index++) {
+    Buffer[Index] = (UINT32) (Offset / sizeof (UINT32) + Index);
+  }
+}
+
+/**
+  Check that a buffer holds the pattern of the test file.
+
+  @param[in]  Buffer      The buffer read from the start of the file.
+  @param[in]  BufferSize  The size of the buffer.
+
+  @retval  TRUE           The buffer holds the pattern.
+  @retval  FALSE          The buffer does not hold the pattern.
+**/
+BOOLEAN
+CheckPattern (
+  IN UINT32   *Buffer,
+  IN UINTN    BufferSize
+  )
+{
+  UINTN       Index;
+
+  for (Index = 0; Index < BufferSize / sizeof (UINT32); Index++) {
+    if (Buffer[Index] != (UINT32) Index) {
+      Print (L"Data mismatch at offset 0x%lx\n", (UINT64) (Index * sizeof (UINT32)));
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Write the test file.
+
+  @param[in]  Root      The root directory of the RAM disk.
+  @param[in]  FileSize  The size of the test file.
+
+  @retval  EFI_SUCCESS  The test file is written.
+  @retval  Other        The test file can not be written.
+**/
+EFI_STATUS
+WriteTestFile (
+  IN EFI_FILE_PROTOCOL  *Root,
+  IN UINTN              FileSize
+  )
+{
+  EFI_FILE_PROTOCOL     *File;
+  UINT32                *Buffer;
+  UINTN                 Offset;
+  UINTN                 Size;
+  EFI_STATUS            Status;
+
+  Buffer = AllocatePool (WRITE_CHUNK_SIZE);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = Root->Open (Root, &File, TEST_FILE_NAME, EFI_FILE_MODE_CREATE | EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0);
+  if (!EFI_ERROR (Status)) {
+    for (Offset = 0; Offset < FileSize && !EFI_ERROR (Status); Offset += Size) {
+      Size = MIN (FileSize - Offset, WRITE_CHUNK_SIZE);
+      FillPattern (Buffer, Offset, Size);
+      Status = File->Write (File, &Size, Buffer);
+    }
+    if (!EFI_ERROR (Status)) {
+      Status = File->Flush (File);
+    }
+    File->Close (File);
+  }
+
+  FreePool (Buffer);
+  return Status;
+}
+
+/**
+  Read the test file with blocking reads.
+
+  @param[in]  File          The test file.
+  @param[in]  Buffer        The buffer receiving the file.
+  @param[in]  FileSize      The size of the test file.
+  @param[in]  RequestSize   The size of a read.
+
+  @retval  EFI_SUCCESS      The test file is read.
+  @retval  Other            The test file can not be read.
+**/
+EFI_STATUS
+ReadBlocking (
+  IN EFI_FILE_PROTOCOL  *File,
+  IN UINT8              *Buffer,
+  IN UINTN              FileSize,
+  IN UINTN              RequestSize
+  )
+{
+  UINTN                 Offset;
+  UINTN                 Size;
+  EFI_STATUS            Status;
+
+  Status = EFI_SUCCESS;
+  for (Offset = 0; Offset < FileSize && !EFI_ERROR (Status); Offset += Size) {
+    Size = MIN (FileSize - Offset, RequestSize);
+    Status = File->Read (File, &Size, Buffer + Offset);
+    if (!EFI_ERROR (Status) && Size == 0) {
+      Status = EFI_END_OF_FILE;
+    }
+  }
+  return Status;
+}
+
+/**
+  Read the test file with non-blocking reads, keeping QueueDepth reads in
+  flight.
+
+  @param[in]  File          The test file.
+  @param[in]  Buffer        The buffer receiving the file.
+  @param[in]  FileSize      The size of the test file.
+  @param[in]  RequestSize   The size of a read.
+  @param[in]  QueueDepth    The number of reads in flight.
+
+  @retval  EFI_SUCCESS      The test file is read.
+  @retval  Other            The test file can not be read.
+**/
+EFI_STATUS
+ReadNonBlocking (
+  IN EFI_FILE_PROTOCOL  *File,
+  IN UINT8              *Buffer,
+  IN UINTN              FileSize,
+  IN UINTN              RequestSize,
+  IN UINTN              QueueDepth
+  )
+{
+  EFI_FILE_IO_TOKEN     *Tokens;
+  UINTN                 Submitted;
+  UINTN                 Completed;
+  UINTN                 Offset;
+  UINTN                 Index;
+  EFI_STATUS            Status;
+
+  Tokens = AllocateZeroPool (QueueDepth * sizeof (*Tokens));
+  if (Tokens == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < QueueDepth && !EFI_ERROR (Status); Index++) {
+    Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Tokens[Index].Event);
+  }
+
+  //
+  // Wait for the oldest read and reuse its token for the next one
+  //
+  Submitted = 0;
+  Completed = 0;
+  Offset    = 0;
+  while (!EFI_ERROR (Status) && (Offset < FileSize || Completed < Submitted)) {
+    if (Offset < FileSize && Submitted - Completed < QueueDepth) {
+      Index = Submitted % QueueDepth;
+      Tokens[Index].BufferSize  = MIN (FileSize - Offset, RequestSize);
+      Tokens[Index].Buffer      = Buffer + Offset;
+      Status = File->ReadEx (File, &Tokens[Index]);
+      if (!EFI_ERROR (Status)) {
+        Offset += Tokens[Index].BufferSize;
+        Submitted++;
+      }
+      continue;
+    }
+
+    Index  = Completed % QueueDepth;
+    Status = gBS->WaitForEvent (1, &Tokens[Index].Event, &Index);
+    if (!EFI_ERROR (Status)) {
+      Status = Tokens[Completed % QueueDepth].Status;
+      Completed++;
+    }
+  }
+
+  //
+  // The reads already submitted have to complete before their tokens are freed
+  //
+  while (Completed < Submitted) {
+    Index = Completed % QueueDepth;
+    gBS->WaitForEvent (1, &Tokens[Index].Event, &Index);
+    Completed++;
+  }
+
+  for (Index = 0; Index < QueueDepth; Index++) {
+    if (Tokens[Index].Event != NULL) {
+      gBS->CloseEvent (Tokens[Index].Event);
+    }
+  }
+  FreePool (Tokens);
+  return Status;
+}
+
+/**
+  Print the throughput of a read of the test file.
+
+  @param[in]  Name      The name of the read.
+  @param[in]  FileSize  The size of the test file.
+  @param[in]  Ms        The duration of the read in milliseconds.
+**/
+VOID
+PrintThroughput (
+  IN CHAR16   *Name,
+  IN UINTN    FileSize,
+  IN UINTN    Ms
+  )
+{
+  UINTN       KbPerSecond;
+
+  KbPerSecond = (UINTN) DivU64x64Remainder (MultU64x32 (FileSize / SIZE_1KB, 1000), MAX (Ms, 1), NULL);
+  Print (L"%-13s %6d ms %6d.%03d MB/s\n", Name, Ms, KbPerSecond / 1024, (KbPerSecond % 1024) * 1000 / 1024);
+}
+
+/**
+  Measure the read throughput of the FAT driver.
+
+  @retval  0         The application exited normally.
+  @retval  Other     An error occurred.
+***/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN Argc,
+  IN CHAR16 **Argv
+  )
+{
+  UINTN                           LatencyUs;
+  UINTN                           FileSize;
+  UINTN                           RequestSize;
+  UINTN                           QueueDepth;
+  UINTN                           Index;
+  RAM_DISK                        *RamDisk;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *FileSystem;
+  EFI_FILE_PROTOCOL               *Root;
+  EFI_FILE_PROTOCOL               *File;
+  EFI_EVENT                       TickEvent;
+  UINT8                           *Buffer;
+  UINTN                           Start;
+  UINTN                           BlockingMs;
+  UINTN                           NonBlockingMs;
+  EFI_STATUS                      Status;
+
+  LatencyUs   = DEFAULT_LATENCY_US;
+  FileSize    = DEFAULT_FILE_SIZE_MB;
+  RequestSize = DEFAULT_REQUEST_SIZE_KB;
+  QueueDepth  = DEFAULT_QUEUE_DEPTH;
+  for (Index = 1; Index + 1 < Argc; Index += 2) {
+    if (StrCmp (Argv[Index], L"-l") == 0) {
+      LatencyUs = StrDecimalToUintn (Argv[Index + 1]);
+    } else if (StrCmp (Argv[Index], L"-s") == 0) {
+      FileSize = StrDecimalToUintn (Argv[Index + 1]);
+    } else if (StrCmp (Argv[Index], L"-b") == 0) {
+      RequestSize = StrDecimalToUintn (Argv[Index + 1]);
+    } else if (StrCmp (Argv[Index], L"-q") == 0) {
+      QueueDepth = StrDecimalToUintn (Argv[Index + 1]);
+    } else {
+      break;
+    }
+  }
+  if (Index < Argc || FileSize == 0 || FileSize > RAM_DISK_SIZE / SIZE_1MB / 2 ||
+      RequestSize == 0 || RequestSize > FileSize * SIZE_1KB || QueueDepth == 0) {
+    Print (L"Usage: FatIoBench [-l LatencyUs] [-s FileSizeMb] [-b RequestSizeKb] [-q QueueDepth]\n");
+    Print (L"  The file size is at most %d MB\n", RAM_DISK_SIZE / SIZE_1MB / 2);
+    return 1;
+  }
+  FileSize    *= SIZE_1MB;
+  RequestSize *= SIZE_1KB;
+
+  Buffer = AllocatePool (FileSize);
+  if (Buffer == NULL) {
+    Print (L"Out of memory\n");
+    return 1;
+  }
+
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY, OnTick, NULL, &TickEvent);
+  if (EFI_ERROR (Status)) {
+    FreePool (Buffer);
+    return 1;
+  }
+  gBS->SetTimer (TickEvent, TimerPeriodic, TICK_PERIOD);
+
+  Status = RamDiskCreate (&RamDisk);
+  if (EFI_ERROR (Status)) {
+    Print (L"Can not create the RAM disk: %r\n", Status);
+    gBS->CloseEvent (TickEvent);
+    FreePool (Buffer);
+    return 1;
+  }
+
+  Root          = NULL;
+  BlockingMs    = 0;
+  NonBlockingMs = 0;
+  Status = gBS->HandleProtocol (RamDisk->Handle, &gEfiSimpleFileSystemProtocolGuid, (VOID **) &FileSystem);
+  if (!EFI_ERROR (Status)) {
+    Status = FileSystem->OpenVolume (FileSystem, &Root);
+  }
+  if (!EFI_ERROR (Status)) {
+    Status = WriteTestFile (Root, FileSize);
+  }
+  if (EFI_ERROR (Status)) {
+    Print (L"Can not write the test file: %r\n", Status);
+    goto Done;
+  }
+
+  if (Root->Revision < EFI_FILE_PROTOCOL_REVISION2) {
+    Print (L"The file system does not support non-blocking reads\n");
+    Status = EFI_UNSUPPORTED;
+    goto Done;
+  }
+
+  Print (L"Latency %d us, file %d MB, request %d KB, queue depth %d\n",
+    LatencyUs, FileSize / SIZE_1MB, RequestSize / SIZE_1KB, QueueDepth);
+  RamDisk->LatencyUs = LatencyUs;
+
+  //
+  // Each read opens the file again, so nothing read ahead before is reused
+  //
+  Status = Root->Open (Root, &File, TEST_FILE_NAME, EFI_FILE_MODE_READ, 0);
+  if (!EFI_ERROR (Status)) {
+    ZeroMem (Buffer, FileSize);
+    Start   = mTicks;
+    Status  = ReadBlocking (File, Buffer, FileSize, RequestSize);
+    BlockingMs = (mTicks - Start) * TICK_MS;
+    File->Close (File);
+  }
+  if (EFI_ERROR (Status) || !CheckPattern ((UINT32 *) Buffer, FileSize)) {
+    Print (L"Blocking read failed: %r\n", Status);
+    Status = EFI_ERROR (Status) ? Status : EFI_VOLUME_CORRUPTED;
+    goto Done;
+  }
+  PrintThroughput (L"Blocking", FileSize, BlockingMs);
+
+  Status = Root->Open (Root, &File, TEST_FILE_NAME, EFI_FILE_MODE_READ, 0);
+  if (!EFI_ERROR (Status)) {
+    ZeroMem (Buffer, FileSize);
+    Start   = mTicks;
+    Status  = ReadNonBlocking (File, Buffer, FileSize, RequestSize, QueueDepth);
+    NonBlockingMs = (mTicks - Start) * TICK_MS;
+    File->Close (File);
+  }
+  if (EFI_ERROR (Status) || !CheckPattern ((UINT32 *) Buffer, FileSize)) {
+    Print (L"Non-blocking read failed: %r\n", Status);
+    Status = EFI_ERROR (Status) ? Status : EFI_VOLUME_CORRUPTED;
+    goto Done;
+  }
+  PrintThroughput (L"Non-blocking", FileSize, NonBlockingMs);
+  Print (L"Speedup %d.%02d\n", BlockingMs / MAX (NonBlockingMs, 1), (BlockingMs % MAX (NonBlockingMs, 1)) * 100 / MAX (NonBlockingMs, 1));
+
+Done:
+  if (Root != NULL) {
+    Root->Close (Root);
+  }
+  RamDiskDestroy (RamDisk);
+  gBS->CloseEvent (TickEvent);
+  FreePool (Buffer);
+  return EFI_ERROR (Status) ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+## @file
+#  Convert the DXE dispatch graph of a debug log into a Graphviz DOT graph
+#
+#  The DXE core prints the graph before it enters BDS, as DISPATCH_GRAPH lines
+#  at the DEBUG_DISPATCH level. Each driver is a node labelled with its
+#  dispatch order and state, each protocol its Depex references is a node
+#  linked to the driver, and each BEFORE or AFTER Depex links two drivers.
+#  Drivers and protocols that block a driver are drawn in red.
+#
+#  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials are licensed and made
+#  available under the terms and conditions of the BSD License which
+#  accompanies this distribution. The full text of the license may be
+#  found at http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS"
+#  BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER
+#  EXPRESS OR IMPLIED.
+#
+
+from __future__ import print_function
+
+VersionNumber = '0.1'
+__copyright__ = "Copyright (c) 2016, Intel Corporation  All rights reserved."
+
+import argparse
+import sys
+
+MARKER = 'DISPATCH_GRAPH '
+
+def read_guid_xref(file_name):
+    """Map the upper case GUIDs of a Guid.xref file to names."""
+    names = {}
+    if file_name:
+        with open(file_name) as f:
+            for line in f:
+                fields = line.split()
+                if len(fields) >= 2:
+                    names[fields[0].upper()] = fields[1]
+    return names
+
+def read_graph(f):
+    """Return the nodes and edges of the last graph printed in a log."""
+    nodes = {}
+    edges = []
+    for line in f:
+        position = line.find(MARKER)
+        if position < 0:
+            continue
+        fields = line[position + len(MARKER):].split()
+        if fields[0] == 'NODE' and len(fields) == 4:
+            #
+            # A driver seen twice starts a new graph
+            #
+            if fields[1].upper() in nodes:
+                nodes = {}
+                edges = []
+            nodes[fields[1].upper()] = (fields[2], fields[3])
+        elif fields[0] == 'EDGE' and len(fields) == 5:
+            edges.append((fields[1].upper(), fields[2], fields[3].upper(),
+                          fields[4]))
+    return nodes, edges
+
+def write_dot(out, nodes, edges, names):
+    def name(guid):
+        return names.get(guid, guid)
+
+    out.write('digraph Dispatch {\n')
+    out.write('  rankdir=LR;\n')
+    out.write('  node [fontsize=10];\n')
+    for guid in sorted(nodes, key=lambda g: (nodes[g][0] == '-',
+                                             int(nodes[g][0])
+                                             if nodes[g][0] != '-' else 0)):
+        order, state = nodes[guid]
+        color = 'black' if state == 'Dispatched' else 'red'
+        out.write('  "%s" [shape=box, color=%s, label="%s\\n%s %s"];\n' % (
+            guid, color, name(guid), order, state))
+
+    protocols = set()
+    for driver, kind, target, status in edges:
+        if kind == 'PROTOCOL':
+            if target not in protocols:
+                protocols.add(target)
+                out.write('  "%s" [shape=ellipse, color=%s, label="%s"];\n' % (
+                    target, 'red' if status == 'Missing' else 'black',
+                    name(target)))
+            out.write('  "%s" -> "%s";\n' % (target, driver))
+        elif kind == 'AFTER':
+            out.write('  "%s" -> "%s" [style=dashed, label="AFTER"];\n' % (
+                target, driver))
+        else:
+            out.write('  "%s" -> "%s" [style=dashed, label="BEFORE"];\n' % (
+                driver, target))
+    out.write('}\n')
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert the DXE dispatch graph of a debug log into a '
+                    'Graphviz DOT graph',
+        prog='DispatchGraphToDot',
+        usage='%(prog)s [options] LOG')
+    parser.add_argument('--version', action='version',
+                        version='%(prog)s ' + VersionNumber)
+    parser.add_argument('log', metavar='LOG',
+                        help='Debug log with the DEBUG_DISPATCH messages')
+    parser.add_argument('-g', '--guid-xref', metavar='FILE',
+                        help='Guid.xref of the build to name the drivers and '
+                             'protocols')
+    parser.add_argument('-o', '--output', metavar='OUTPUT',
+                        help='Output file (default: standard output)')
+    args = parser.parse_args()
+
+    try:
+        names = read_guid_xref(args.guid_xref)
+        with open(args.log) as f:
+            nodes, edges = read_graph(f)
+    except IOError as e:
+        print('%s' % e, file=sys.stderr)
+        return 1
+    if not nodes:
+        print('%s: no dispatch graph, is PcdDebugPrintErrorLevel including '
+              'DEBUG_DISPATCH?' % args.log, file=sys.stderr)
+        return 1
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    try:
+        write_dot(out, nodes, edges, names)
+    finally:
+        if args.output:
+            out.close()
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,117 @@
+## @file
+#  Compare the compression ratio and wall time of LzmaCompress encoder settings
+#
+#  Each input file (typically an uncompressed FV image taken from the FV
+#  directory of a platform build) is compressed with every requested thread
+#  count, decompressed again to check the round trip, and the best wall time of
+#  the repeated runs is reported.
+#
+#  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials are licensed and made
+#  available under the terms and conditions of the BSD License which
+#  accompanies this distribution. The full text of the license may be
+#  found at http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS"
+#  BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER
+#  EXPRESS OR IMPLIED.
+#
+
+from __future__ import print_function
+
+VersionNumber = '0.1'
+__copyright__ = "Copyright (c) 2016, Intel Corporation  All rights reserved."
+
+import argparse
+import filecmp
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+class LzmaBenchmark:
+    """Runs LzmaCompress on a set of files and reports ratio and wall time."""
+
+    def __init__(self, args):
+        self.tool = args.tool
+        self.threads = args.threads
+        self.repeat = args.repeat
+        self.extra = ['--f86'] if args.f86 else []
+        self.workdir = tempfile.mkdtemp()
+        self.ok = True
+
+    def run_tool(self, args):
+        start = time.time()
+        subprocess.check_call([self.tool, '-q'] + self.extra + args)
+        return time.time() - start
+
+    def bench_file(self, path):
+        size = os.path.getsize(path)
+        encoded = os.path.join(self.workdir, 'encoded')
+        decoded = os.path.join(self.workdir, 'decoded')
+        result = {}
+        for threads in self.threads:
+            best = None
+            for i in range(self.repeat):
+                elapsed = self.run_tool(['-e', '--threads', str(threads),
+                                         '-o', encoded, path])
+                if best is None or elapsed < best:
+                    best = elapsed
+            self.run_tool(['-d', '-o', decoded, encoded])
+            if not filecmp.cmp(path, decoded, shallow=False):
+                print('%s: round trip with %d thread(s) failed' %
+                      (path, threads))
+                self.ok = False
+            output = open(encoded, 'rb').read()
+            result[threads] = (len(output), best, output)
+
+        baseline = result[self.threads[0]]
+        for threads in self.threads:
+            compressed, elapsed, output = result[threads]
+            print('%-40s %10d %10d %6.1f%% %8.3f %7.2fx %3d%s' %
+                  (os.path.basename(path)[-40:], size, compressed,
+                   100.0 * compressed / size, elapsed,
+                   baseline[1] / elapsed if elapsed else 0, threads,
+                   '' if output == baseline[2] else '  (output differs)'))
+
+    def run(self, files):
+        print('%-40s %10s %10s %7s %8s %8s %3s' %
+              ('File', 'Size', 'LZMA', 'Ratio', 'Time(s)', 'Speedup', 'Thr'))
+        try:
+            for path in files:
+                self.bench_file(path)
+        finally:
+            shutil.rmtree(self.workdir)
+        return 0 if self.ok else 1
+
+def parse_threads(value):
+    threads = [int(n) for n in value.split(',')]
+    if not threads or min(threads) < 1:
+        raise argparse.ArgumentTypeError('thread counts must be 1 or more')
+    return threads
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Benchmark LzmaCompress on FV images',
+        prog='LzmaBenchmark',
+        usage='%(prog)s [options] FILE...')
+    parser.add_argument('--version', action='version',
+                        version='%(prog)s ' + VersionNumber)
+    parser.add_argument('files', nargs='+', metavar='FILE',
+                        help='Files to compress, e.g. Build/<Platform>/<Target>/FV/*.Fv')
+    parser.add_argument('--tool', default='LzmaCompress',
+                        help='LzmaCompress executable (default: LzmaCompress on PATH)')
+    parser.add_argument('--threads', type=parse_threads, default=[1, 2],
+                        help='Comma separated encoder thread counts (default: 1,2)')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='Runs per setting, the best time is reported (default: 3)')
+    parser.add_argument('--f86', action='store_true',
+                        help='Enable the x86 converter, as LzmaF86Compress does')
+    args = parser.parse_args()
+    return LzmaBenchmark(args).run(args.files)
+
+if __name__ == "__main__":
+    sys.exit(main())
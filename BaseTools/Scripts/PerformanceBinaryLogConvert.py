@@ -0,0 +1,300 @@
+## @file
+#  Convert a binary performance log into Chrome trace events, collapsed stacks
+#  or CSV, and summarize its dispatch critical path
+#
+#  The input is the log published under gEdkiiPerformanceBinaryLogGuid, as
+#  saved by "dp -o FILE -f raw" or dumped from the memory of an emulator or a
+#  debugger. Start and end records are paired and nested the same way as Dp
+#  does on the target, but the names of the measured components are limited
+#  to the module, token and handle values recorded in the log.
+#
+#  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials are licensed and made
+#  available under the terms and conditions of the BSD License which
+#  accompanies this distribution. The full text of the license may be
+#  found at http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS"
+#  BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER
+#  EXPRESS OR IMPLIED.
+#
+
+from __future__ import print_function
+
+VersionNumber = '0.1'
+__copyright__ = "Copyright (c) 2016, Intel Corporation  All rights reserved."
+
+import argparse
+import json
+import struct
+import sys
+
+SIGNATURE = 0x474c4250          # 'PBLG'
+HEADER = struct.Struct('<IHHIIIIIIIIQQQ')
+STRING = struct.Struct('<II32s')
+RING = struct.Struct('<II')
+RECORD = struct.Struct('<IBBHHHIQQ')
+
+STRING_ID_NONE = 0x0000
+STRING_ID_OVERFLOW = 0xFFFF
+STRING_BUSY = 1
+RING_FREE = 0xFFFFFFFF
+RECORD_START = 1
+RECORD_END = 2
+
+DISPATCH_TOKENS = ('PEIM', 'StartImage:', 'LoadImage:', 'DB:Start:',
+                   'DB:Support:', 'ProtocolNotify:')
+
+class Gauge:
+    """A complete measurement, times in timer ticks since the timer started."""
+
+    def __init__(self, cpu, handle, token, module, start, identifier):
+        self.cpu = cpu
+        self.handle = handle
+        self.token = token
+        self.module = module
+        self.start = start
+        self.end = None
+        self.identifier = identifier
+        self.parent = None
+        self.self_duration = 0
+        if module:
+            self.name = module
+        elif handle:
+            self.name = '0x%x' % handle
+        else:
+            self.name = token
+
+    def duration(self):
+        return self.end - self.start
+
+    def frame(self):
+        if self.name == self.token:
+            return self.name
+        if self.token.endswith(':'):
+            return self.token + self.name
+        return self.token + ':' + self.name
+
+class PerformanceBinaryLog:
+    """Parses a binary performance log and pairs its records."""
+
+    def __init__(self, data):
+        if len(data) < HEADER.size:
+            raise ValueError('file is smaller than the log header')
+        (signature, revision, header_length, length, string_count,
+         string_offset, ring_count, ring_record_count, ring_offset,
+         ring_length, _, self.timer_start, self.timer_end,
+         self.frequency) = HEADER.unpack_from(data, 0)
+        if signature != SIGNATURE or header_length < HEADER.size:
+            raise ValueError('not a binary performance log')
+        if length > len(data):
+            raise ValueError('log is truncated, %d of %d bytes' %
+                             (len(data), length))
+        if (string_offset + string_count * STRING.size > length or
+                ring_offset + ring_count * ring_length > length or
+                ring_length < RING.size + ring_record_count * RECORD.size or
+                ring_record_count & (ring_record_count - 1)):
+            raise ValueError('log geometry is invalid')
+        if self.frequency == 0:
+            raise ValueError('log has no timer frequency')
+
+        self.strings = []
+        for index in range(string_count):
+            string_hash, _, name = STRING.unpack_from(
+                data, string_offset + index * STRING.size)
+            if string_hash <= STRING_BUSY:
+                self.strings.append('')
+            else:
+                self.strings.append(
+                    name.split(b'\0', 1)[0].decode('ascii', 'replace'))
+
+        self.gauges = []
+        for index in range(ring_count):
+            self.read_ring(data, ring_offset + index * ring_length,
+                           ring_record_count)
+        self.gauges = [g for g in self.gauges
+                       if g.end is not None and g.end >= g.start]
+        self.gauges.sort(key=lambda g: (g.cpu, g.start, -g.end))
+        self.nest()
+
+    def string(self, string_id):
+        if string_id == STRING_ID_OVERFLOW:
+            return '?'
+        if string_id == STRING_ID_NONE or string_id > len(self.strings):
+            return ''
+        return self.strings[string_id - 1]
+
+    def normalize(self, time_stamp):
+        if time_stamp == 1:
+            return 0
+        if self.timer_end >= self.timer_start:
+            return time_stamp - self.timer_start
+        return self.timer_start - time_stamp
+
+    def read_ring(self, data, offset, record_count):
+        cpu, write_count = RING.unpack_from(data, offset)
+        if cpu == RING_FREE:
+            return
+        count = min(write_count, record_count)
+        for sequence in range(write_count - count + 1, write_count + 1):
+            (record_sequence, record_type, _, token_id, module_id, _,
+             identifier, handle, time_stamp) = RECORD.unpack_from(
+                 data, offset + RING.size +
+                 ((sequence - 1) & (record_count - 1)) * RECORD.size)
+            if record_sequence != sequence:
+                continue
+            token = self.string(token_id)
+            module = self.string(module_id)
+            if record_type == RECORD_START:
+                self.gauges.append(Gauge(cpu, handle, token, module,
+                                         self.normalize(time_stamp),
+                                         identifier))
+            elif record_type == RECORD_END:
+                for gauge in reversed(self.gauges):
+                    if (gauge.end is None and gauge.cpu == cpu and
+                            gauge.handle == handle and
+                            gauge.identifier == identifier and
+                            gauge.token == token and gauge.module == module):
+                        gauge.end = self.normalize(time_stamp)
+                        break
+
+    def nest(self):
+        stack = []
+        for index, gauge in enumerate(self.gauges):
+            gauge.self_duration = gauge.duration()
+            if index > 0 and gauge.cpu != self.gauges[index - 1].cpu:
+                stack = []
+            while stack and stack[-1].end < gauge.end:
+                stack.pop()
+            if stack:
+                gauge.parent = stack[-1]
+                gauge.parent.self_duration -= min(gauge.duration(),
+                                                  gauge.parent.self_duration)
+            stack.append(gauge)
+
+    def us(self, ticks):
+        return ticks * 1000000.0 / self.frequency
+
+    def write_chrome(self, out):
+        events = []
+        for gauge in self.gauges:
+            events.append({
+                'name': gauge.name, 'cat': gauge.token, 'ph': 'X',
+                'pid': 1, 'tid': gauge.cpu,
+                'ts': round(self.us(gauge.start), 3),
+                'dur': round(self.us(gauge.duration()), 3),
+                'args': {'module': gauge.module,
+                         'handle': '0x%x' % gauge.handle,
+                         'id': gauge.identifier}})
+        json.dump({'displayTimeUnit': 'ms', 'traceEvents': events}, out,
+                  separators=(',', ':'))
+        out.write('\n')
+
+    def write_flame(self, out):
+        multi_cpu = len(set(g.cpu for g in self.gauges)) > 1
+        for gauge in self.gauges:
+            value = int(self.us(gauge.self_duration))
+            if value == 0:
+                continue
+            frames = []
+            current = gauge
+            while current is not None:
+                frames.append(current.frame().replace(';', '_'))
+                current = current.parent
+            if multi_cpu:
+                frames.append('CPU%d' % gauge.cpu)
+            out.write('%s %d\n' % (';'.join(reversed(frames)), value))
+
+    def write_csv(self, out):
+        index_of = dict((id(g), i) for i, g in enumerate(self.gauges))
+        out.write('Index,Cpu,Token,Module,Name,Handle,Identifier,'
+                  'Start,End,Duration,Self,Parent\n')
+        for index, gauge in enumerate(self.gauges):
+            out.write('%d,%d,%s,%s,%s,0x%x,%d,%.3f,%.3f,%.3f,%.3f,%s\n' % (
+                index, gauge.cpu, gauge.token, gauge.module, gauge.name,
+                gauge.handle, gauge.identifier, self.us(gauge.start),
+                self.us(gauge.end), self.us(gauge.duration()),
+                self.us(gauge.self_duration),
+                '' if gauge.parent is None else index_of[id(gauge.parent)]))
+
+    def print_critical_path(self, limit):
+        def outermost_unit(gauge):
+            if gauge.token not in DISPATCH_TOKENS:
+                return False
+            parent = gauge.parent
+            while parent is not None:
+                if parent.token in DISPATCH_TOKENS:
+                    return False
+                parent = parent.parent
+            return True
+
+        if not self.gauges:
+            return
+        cpu = self.gauges[0].cpu
+        for gauge in self.gauges:
+            if gauge.token == 'DXE' and not gauge.module:
+                cpu = gauge.cpu
+                break
+        path = [g for g in self.gauges if g.cpu == cpu and outermost_unit(g)]
+        if not path:
+            return
+        measured = sum(g.duration() for g in path)
+        span = max(g.end for g in path) - path[0].start
+        print('%d dispatch units take %d of the %d microseconds from the '
+              'first to the last (%d%%)' % (
+                  len(path), self.us(measured), self.us(span),
+                  100 * measured // span if span else 0))
+        print('Index   Start(us)   Time(us)  Span  Token            Name')
+        path.sort(key=lambda g: -g.duration())
+        for index, gauge in enumerate(path[:limit] if limit else path):
+            print('%5d: %10d %10d  %3d%%  %-15s  %s' % (
+                index + 1, self.us(gauge.start), self.us(gauge.duration()),
+                100 * gauge.duration() // span if span else 0,
+                gauge.token, gauge.name))
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert a binary performance log',
+        prog='PerformanceBinaryLogConvert',
+        usage='%(prog)s [options] FILE')
+    parser.add_argument('--version', action='version',
+                        version='%(prog)s ' + VersionNumber)
+    parser.add_argument('file', metavar='FILE',
+                        help='Binary performance log, e.g. saved by "dp -o FILE -f raw"')
+    parser.add_argument('-f', '--format', choices=['chrome', 'flame', 'csv'],
+                        default='chrome',
+                        help='Output format (default: chrome)')
+    parser.add_argument('-o', '--output', metavar='OUTPUT',
+                        help='Output file (default: standard output)')
+    parser.add_argument('-p', '--critical-path', type=int, metavar='COUNT',
+                        help='Print the COUNT longest units of the dispatch '
+                             'critical path instead of converting, 0 for all')
+    args = parser.parse_args()
+
+    try:
+        with open(args.file, 'rb') as f:
+            log = PerformanceBinaryLog(f.read())
+    except (IOError, ValueError, struct.error) as e:
+        print('%s: %s' % (args.file, e), file=sys.stderr)
+        return 1
+
+    if args.critical_path is not None:
+        log.print_critical_path(args.critical_path)
+        return 0
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    try:
+        if args.format == 'chrome':
+            log.write_chrome(out)
+        elif args.format == 'flame':
+            log.write_flame(out)
+        else:
+            log.write_csv(out)
+    finally:
+        if args.output:
+            out.close()
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -274,6 +274,49 @@ UINT32  mCrcTable[256] = {
   0x2D02EF8D
 };
 
+//
+// mCrcSliceTable[N][Byte] is mCrcTable[Byte] advanced over N + 1 further zero
+// bytes, so CalculateCrc32 can consume 8 bytes per step (slice-by-8).
+//
+UINT32  mCrcSliceTable[7][256];
+BOOLEAN mCrcSliceTableReady = FALSE;
+
+static
+VOID
+InitializeCrcSliceTable (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Derive the slice-by-8 tables from mCrcTable.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  UINTN   Index;
+  UINTN   Slice;
+  UINT32  Crc;
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = mCrcTable[Index];
+    for (Slice = 0; Slice < 7; Slice++) {
+      Crc = (Crc >> 8) ^ mCrcTable[(UINT8) Crc];
+      mCrcSliceTable[Slice][Index] = Crc;
+    }
+  }
+
+  mCrcSliceTableReady = TRUE;
+}
+
 EFI_STATUS
 CalculateCrc32 (
   IN  UINT8                             *Data,
@@ -301,6 +344,8 @@ Returns:
 --*/
 {
   UINT32  Crc;
+  UINT32  Low;
+  UINT32  High;
   UINTN   Index;
   UINT8   *Ptr;
 
@@ -308,8 +353,26 @@ Returns:
     return EFI_INVALID_PARAMETER;
   }
 
+  if (!mCrcSliceTableReady) {
+    InitializeCrcSliceTable ();
+  }
+
   Crc = 0xffffffff;
-  for (Index = 0, Ptr = Data; Index < DataSize; Index++, Ptr++) {
+  Ptr = Data;
+  for (Index = 0; Index + 8 <= DataSize; Index += 8, Ptr += 8) {
+    Low  = Crc ^ ((UINT32) Ptr[0] | ((UINT32) Ptr[1] << 8) | ((UINT32) Ptr[2] << 16) | ((UINT32) Ptr[3] << 24));
+    High = (UINT32) Ptr[4] | ((UINT32) Ptr[5] << 8) | ((UINT32) Ptr[6] << 16) | ((UINT32) Ptr[7] << 24);
+    Crc  = mCrcSliceTable[6][Low & 0xff] ^
+           mCrcSliceTable[5][(Low >> 8) & 0xff] ^
+           mCrcSliceTable[4][(Low >> 16) & 0xff] ^
+           mCrcSliceTable[3][Low >> 24] ^
+           mCrcSliceTable[2][High & 0xff] ^
+           mCrcSliceTable[1][(High >> 8) & 0xff] ^
+           mCrcSliceTable[0][(High >> 16) & 0xff] ^
+           mCrcTable[High >> 24];
+  }
+
+  for (; Index < DataSize; Index++, Ptr++) {
     Crc = (Crc >> 8) ^ mCrcTable[(UINT8) Crc ^ *Ptr];
   }
 
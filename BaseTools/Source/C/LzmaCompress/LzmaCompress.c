@@ -50,9 +50,57 @@ static ISzAlloc g_Alloc = { SzAlloc, SzFree };
 static Bool mQuietMode = False;
 static CONVERTER_TYPE mConType = NoConverter;
 
+//
+// Number of encoder threads. The LZMA SDK encoder runs the match finder in its
+// own thread when 2 threads are used, and does not use more than that.
+//
+#define MAX_NUM_THREADS 2
+static int mNumThreads = MAX_NUM_THREADS;
+
+//
+// Block-parallel format, see LZMA_PARALLEL_HEADER in MdeModulePkg/Include/Guid/LzmaDecompress.h.
+// The header is followed by BlockCount + 1 block offsets, and each block is a
+// LZMA stream with the same header as the whole file in the default format.
+//
+#define LZMA_PARALLEL_SIGNATURE   0x42505A4C
+#define LZMA_PARALLEL_HEADER_SIZE 16
+static UInt32 mBlockSize = 0;
+
+static void WriteUInt32(Byte *p, UInt32 value)
+{
+  int i;
+  for (i = 0; i < 4; i++)
+    p[i] = (Byte)(value >> (8 * i));
+}
+
+static UInt32 ReadUInt32(const Byte *p)
+{
+  return (UInt32)p[0] | ((UInt32)p[1] << 8) | ((UInt32)p[2] << 16) | ((UInt32)p[3] << 24);
+}
+
+//
+// ISeqInStream reading from a memory buffer
+//
+typedef struct {
+  ISeqInStream s;
+  const Byte   *Buffer;
+  size_t       Size;
+} CBufferInStream;
+
+static SRes BufferInStream_Read(void *p, void *buf, size_t *size)
+{
+  CBufferInStream *stream = (CBufferInStream *)p;
+  if (*size > stream->Size)
+    *size = stream->Size;
+  memcpy(buf, stream->Buffer, *size);
+  stream->Buffer += *size;
+  stream->Size -= *size;
+  return SZ_OK;
+}
+
 #define UTILITY_NAME "LzmaCompress"
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 2
+#define UTILITY_MINOR_VERSION 3
 #define INTEL_COPYRIGHT \
   "Copyright (c) 2009-2012, Intel Corporation. All rights reserved."
 void PrintHelp(char *buffer)
@@ -65,6 +113,10 @@ void PrintHelp(char *buffer)
              "  -d: decode file\n"
              "  -o FileName, --output FileName: specify the output filename\n"
              "  --f86: enable converter for x86 code\n"
+             "  --threads N: number of encoder threads, 1 or 2 (default 2)\n"
+             "  --block-size Size: use the block-parallel format, compress blocks\n"
+             "                     of Size bytes independently. When decoding,\n"
+             "                     the block size is read from the input\n"
              "  -v, --verbose: increase output messages\n"
              "  -q, --quiet: reduce output messages\n"
              "  --debug [0-9]: set debug level\n"
@@ -101,51 +153,59 @@ static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
 {
   SRes res;
   size_t inSize = (size_t)fileSize;
-  Byte *inBuffer = 0;
-  Byte *outBuffer = 0;
   Byte *filteredStream = 0;
-  size_t outSize;
+  CBufferInStream filteredInStream;
+  CLzmaEncHandle enc;
   CLzmaEncProps props;
+  Byte header[LZMA_HEADER_SIZE];
+  size_t headerSize = LZMA_PROPS_SIZE;
+  int i;
+
+  if (inSize == 0) {
+    return SZ_ERROR_INPUT_EOF;
+  }
+
+  enc = LzmaEnc_Create(&g_Alloc);
+  if (enc == 0)
+    return SZ_ERROR_MEM;
 
   LzmaEncProps_Init(&props);
+  props.numThreads = mNumThreads;
   LzmaEncProps_Normalize(&props);
 
-  if (inSize != 0) {
-    inBuffer = (Byte *)MyAlloc(inSize);
-    if (inBuffer == 0)
-      return SZ_ERROR_MEM;
-  } else {
-    return SZ_ERROR_INPUT_EOF;
-  }
-  
-  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
-    res = SZ_ERROR_READ;
+  res = LzmaEnc_SetProps(enc, &props);
+  if (res != SZ_OK)
     goto Done;
-  }
 
-  // we allocate 105% of original size + 64KB for output buffer
-  outSize = (size_t)fileSize / 20 * 21 + (1 << 16);
-  outBuffer = (Byte *)MyAlloc(outSize);
-  if (outBuffer == 0) {
-    res = SZ_ERROR_MEM;
+  res = LzmaEnc_WriteProperties(enc, header, &headerSize);
+  if (res != SZ_OK)
+    goto Done;
+
+  for (i = 0; i < 8; i++)
+    header[headerSize++] = (Byte)(fileSize >> (8 * i));
+
+  if (outStream->Write(outStream, header, headerSize) != headerSize) {
+    res = SZ_ERROR_WRITE;
     goto Done;
-  }
-  
-  {
-    int i;
-    for (i = 0; i < 8; i++)
-      outBuffer[i + LZMA_PROPS_SIZE] = (Byte)(fileSize >> (8 * i));
   }
 
   if (mConType != NoConverter)
   {
+    //
+    // The converter works on the whole image, so it is read into memory.
+    // Otherwise the input file is streamed to the encoder.
+    //
     filteredStream = (Byte *)MyAlloc(inSize);
     if (filteredStream == 0) {
       res = SZ_ERROR_MEM;
       goto Done;
     }
-    memcpy(filteredStream, inBuffer, inSize);
-    
+
+    if (SeqInStream_Read(inStream, filteredStream, inSize) != SZ_OK) {
+      res = SZ_ERROR_READ;
+      goto Done;
+    }
+
     if (mConType == X86Converter) {
       {
         UInt32 x86State;
@@ -153,29 +213,17 @@ static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
         x86_Convert(filteredStream, (SizeT) inSize, 0, &x86State, 1);
       }
     }
-  }
-
-  {
-    size_t outSizeProcessed = outSize - LZMA_HEADER_SIZE;
-    size_t outPropsSize = LZMA_PROPS_SIZE;
-    
-    res = LzmaEncode(outBuffer + LZMA_HEADER_SIZE, &outSizeProcessed,
-        mConType != NoConverter ? filteredStream : inBuffer, inSize,
-        &props, outBuffer, &outPropsSize, 0,
-        NULL, &g_Alloc, &g_Alloc);
-    
-    if (res != SZ_OK)
-      goto Done;
 
-    outSize = LZMA_HEADER_SIZE + outSizeProcessed;
+    filteredInStream.s.Read = BufferInStream_Read;
+    filteredInStream.Buffer = filteredStream;
+    filteredInStream.Size   = inSize;
+    inStream = &filteredInStream.s;
   }
 
-  if (outStream->Write(outStream, outBuffer, outSize) != outSize)
-    res = SZ_ERROR_WRITE;
+  res = LzmaEnc_Encode(enc, outStream, inStream, NULL, &g_Alloc, &g_Alloc);
 
 Done:
-  MyFree(outBuffer);
-  MyFree(inBuffer);
+  LzmaEnc_Destroy(enc, &g_Alloc, &g_Alloc);
   MyFree(filteredStream);
 
   return res;
@@ -245,6 +293,187 @@ Done:
   return res;
 }
 
+static SRes EncodeBlocks(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  Byte *inBuffer = 0;
+  Byte *outBuffer = 0;
+  size_t outCapacity;
+  size_t outSize;
+  size_t blockCount;
+  size_t blockIndex;
+  size_t position;
+  SizeT srcLen;
+  SizeT destLen;
+  SizeT propsSize;
+  CLzmaEncProps props;
+  int i;
+
+  if (inSize == 0) {
+    return SZ_ERROR_INPUT_EOF;
+  }
+
+  if (fileSize > 0xFFFFFFFF) {
+    return SZ_ERROR_PARAM;
+  }
+
+  blockCount = (inSize - 1) / mBlockSize + 1;
+
+  //
+  // Each block grows by at most a third plus 128 bytes, see the LZMA SDK documentation.
+  //
+  outSize = LZMA_PARALLEL_HEADER_SIZE + (blockCount + 1) * 4;
+  outCapacity = outSize + inSize + inSize / 3 + blockCount * (LZMA_HEADER_SIZE + 128);
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  outBuffer = (Byte *)MyAlloc(outCapacity);
+  if (inBuffer == 0 || outBuffer == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  LzmaEncProps_Init(&props);
+  props.numThreads = mNumThreads;
+  LzmaEncProps_Normalize(&props);
+
+  WriteUInt32(outBuffer, LZMA_PARALLEL_SIGNATURE);
+  WriteUInt32(outBuffer + 4, mBlockSize);
+  WriteUInt32(outBuffer + 8, (UInt32)blockCount);
+  WriteUInt32(outBuffer + 12, (UInt32)inSize);
+
+  position = 0;
+  for (blockIndex = 0; blockIndex < blockCount; blockIndex++) {
+    if (outSize > 0xFFFFFFFF) {
+      res = SZ_ERROR_PARAM;
+      goto Done;
+    }
+    WriteUInt32(outBuffer + LZMA_PARALLEL_HEADER_SIZE + blockIndex * 4, (UInt32)outSize);
+
+    srcLen = inSize - position;
+    if (srcLen > mBlockSize) {
+      srcLen = mBlockSize;
+    }
+
+    destLen = outCapacity - outSize - LZMA_HEADER_SIZE;
+    propsSize = LZMA_PROPS_SIZE;
+    res = LzmaEncode(outBuffer + outSize + LZMA_HEADER_SIZE, &destLen, inBuffer + position, srcLen,
+        &props, outBuffer + outSize, &propsSize, 0, NULL, &g_Alloc, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+
+    for (i = 0; i < 8; i++)
+      outBuffer[outSize + LZMA_PROPS_SIZE + i] = (Byte)((UInt64)srcLen >> (8 * i));
+
+    outSize += LZMA_HEADER_SIZE + destLen;
+    position += srcLen;
+  }
+
+  if (outSize > 0xFFFFFFFF) {
+    res = SZ_ERROR_PARAM;
+    goto Done;
+  }
+  WriteUInt32(outBuffer + LZMA_PARALLEL_HEADER_SIZE + blockCount * 4, (UInt32)outSize);
+
+  if (outStream->Write(outStream, outBuffer, outSize) != outSize)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+  MyFree(inBuffer);
+
+  return res;
+}
+
+static SRes DecodeBlocks(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  Byte *inBuffer = 0;
+  Byte *outBuffer = 0;
+  UInt32 blockSize;
+  UInt32 blockCount;
+  UInt32 decodedSize;
+  UInt32 blockIndex;
+  UInt32 blockStart;
+  UInt32 blockEnd;
+  size_t position;
+  SizeT outSize;
+  SizeT inSizePure;
+  ELzmaStatus status;
+
+  if (inSize < LZMA_PARALLEL_HEADER_SIZE)
+    return SZ_ERROR_INPUT_EOF;
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  if (inBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  blockSize = ReadUInt32(inBuffer + 4);
+  blockCount = ReadUInt32(inBuffer + 8);
+  decodedSize = ReadUInt32(inBuffer + 12);
+  if (ReadUInt32(inBuffer) != LZMA_PARALLEL_SIGNATURE || blockSize == 0 || decodedSize == 0 ||
+      blockCount != (decodedSize - 1) / blockSize + 1 ||
+      blockCount >= (inSize - LZMA_PARALLEL_HEADER_SIZE) / 4) {
+    res = SZ_ERROR_DATA;
+    goto Done;
+  }
+
+  outBuffer = (Byte *)MyAlloc(decodedSize);
+  if (outBuffer == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  res = SZ_OK;
+  position = 0;
+  for (blockIndex = 0; blockIndex < blockCount; blockIndex++) {
+    blockStart = ReadUInt32(inBuffer + LZMA_PARALLEL_HEADER_SIZE + blockIndex * 4);
+    blockEnd = ReadUInt32(inBuffer + LZMA_PARALLEL_HEADER_SIZE + (blockIndex + 1) * 4);
+    if (blockEnd > inSize || blockStart > blockEnd || blockEnd - blockStart < LZMA_HEADER_SIZE) {
+      res = SZ_ERROR_DATA;
+      goto Done;
+    }
+
+    outSize = decodedSize - position;
+    if (outSize > blockSize) {
+      outSize = blockSize;
+    }
+
+    inSizePure = blockEnd - blockStart - LZMA_HEADER_SIZE;
+    res = LzmaDecode(outBuffer + position, &outSize, inBuffer + blockStart + LZMA_HEADER_SIZE, &inSizePure,
+        inBuffer + blockStart, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+
+    position += outSize;
+  }
+
+  if (position != decodedSize) {
+    res = SZ_ERROR_DATA;
+    goto Done;
+  }
+
+  if (outStream->Write(outStream, outBuffer, decodedSize) != decodedSize)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+  MyFree(inBuffer);
+
+  return res;
+}
+
 int main2(int numArgs, const char *args[], char *rs)
 {
   CFileSeqInStream inStream;
@@ -275,6 +504,25 @@ int main2(int numArgs, const char *args[], char *rs)
       modeWasSet = True;
     } else if (strcmp(args[param], "--f86") == 0) {
       mConType = X86Converter;
+    } else if (strcmp(args[param], "--threads") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      mNumThreads = atoi(args[++param]);
+      if (mNumThreads < 1) {
+        return PrintUserError(rs);
+      }
+      if (mNumThreads > MAX_NUM_THREADS) {
+        mNumThreads = MAX_NUM_THREADS;
+      }
+    } else if (strcmp(args[param], "--block-size") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      mBlockSize = (UInt32)strtoul(args[++param], NULL, 0);
+      if (mBlockSize == 0) {
+        return PrintUserError(rs);
+      }
     } else if (strcmp(args[param], "-o") == 0 ||
                strcmp(args[param], "--output") == 0) {
       if (numArgs < (param + 2)) {
@@ -323,6 +571,10 @@ int main2(int numArgs, const char *args[], char *rs)
     return PrintUserError(rs);
   }
 
+  if (mBlockSize != 0 && mConType != NoConverter) {
+    return PrintError(rs, "--block-size can not be used with --f86");
+  }
+
   {
     size_t t4 = sizeof(UInt32);
     size_t t8 = sizeof(UInt64);
@@ -343,14 +595,22 @@ int main2(int numArgs, const char *args[], char *rs)
     if (!mQuietMode) {
       printf("Encoding\n");
     }
-    res = Encode(&outStream.s, &inStream.s, fileSize);
+    if (mBlockSize != 0) {
+      res = EncodeBlocks(&outStream.s, &inStream.s, fileSize);
+    } else {
+      res = Encode(&outStream.s, &inStream.s, fileSize);
+    }
   }
   else
   {
     if (!mQuietMode) {
       printf("Decoding\n");
     }
-    res = Decode(&outStream.s, &inStream.s, fileSize);
+    if (mBlockSize != 0) {
+      res = DecodeBlocks(&outStream.s, &inStream.s, fileSize);
+    } else {
+      res = Decode(&outStream.s, &inStream.s, fileSize);
+    }
   }
 
   File_Close(&outStream.file);
@@ -0,0 +1,377 @@
+/** @file
+  POSIX threads implementation of the multithreading library of the LZMA SDK
+  (Sdk/C/Threads.h), used in place of Sdk/C/Threads.c on non-Windows hosts.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <stdlib.h>
+
+#include "PosixThreads.h"
+#include "Sdk/C/Threads.h"
+
+typedef struct {
+  pthread_t         Thread;
+  THREAD_FUNC_RET_TYPE (THREAD_FUNC_CALL_TYPE *StartAddress)(void *);
+  void              *Parameter;
+  int               Joined;
+} POSIX_THREAD;
+
+typedef struct {
+  pthread_mutex_t   Mutex;
+  pthread_cond_t    Cond;
+  int               ManualReset;
+  int               Signaled;
+} POSIX_EVENT;
+
+typedef struct {
+  pthread_mutex_t   Mutex;
+  pthread_cond_t    Cond;
+  UInt32            Count;
+  UInt32            MaxCount;
+} POSIX_SEMAPHORE;
+
+//
+// Allocate a mutex and a condition variable at the start of an event or
+// semaphore object.
+//
+static
+void *
+CreateSyncObject (
+  size_t  Size
+  )
+{
+  pthread_mutex_t   *Mutex;
+  pthread_cond_t    *Cond;
+  void              *Object;
+
+  Object = calloc (1, Size);
+  if (Object == NULL) {
+    return NULL;
+  }
+
+  //
+  // POSIX_EVENT and POSIX_SEMAPHORE start with the same two fields
+  //
+  Mutex = &((POSIX_EVENT *) Object)->Mutex;
+  Cond  = &((POSIX_EVENT *) Object)->Cond;
+  if (pthread_mutex_init (Mutex, NULL) != 0) {
+    free (Object);
+    return NULL;
+  }
+
+  if (pthread_cond_init (Cond, NULL) != 0) {
+    pthread_mutex_destroy (Mutex);
+    free (Object);
+    return NULL;
+  }
+
+  return Object;
+}
+
+static
+WRes
+CloseSyncObject (
+  HANDLE  *Handle
+  )
+{
+  if (*Handle != NULL) {
+    pthread_cond_destroy (&((POSIX_EVENT *) *Handle)->Cond);
+    pthread_mutex_destroy (&((POSIX_EVENT *) *Handle)->Mutex);
+    free (*Handle);
+    *Handle = NULL;
+  }
+
+  return 0;
+}
+
+static
+void *
+ThreadStart (
+  void  *Context
+  )
+{
+  POSIX_THREAD  *Thread;
+
+  Thread = (POSIX_THREAD *) Context;
+  Thread->StartAddress (Thread->Parameter);
+  return NULL;
+}
+
+WRes
+Thread_Create (
+  CThread  *thread,
+  THREAD_FUNC_RET_TYPE (THREAD_FUNC_CALL_TYPE *startAddress)(void *),
+  LPVOID   parameter
+  )
+{
+  POSIX_THREAD  *Thread;
+  WRes          Res;
+
+  Thread = calloc (1, sizeof (POSIX_THREAD));
+  if (Thread == NULL) {
+    return 1;
+  }
+
+  Thread->StartAddress  = startAddress;
+  Thread->Parameter     = parameter;
+  Res = pthread_create (&Thread->Thread, NULL, ThreadStart, Thread);
+  if (Res != 0) {
+    free (Thread);
+    return Res;
+  }
+
+  thread->handle = Thread;
+  return 0;
+}
+
+WRes
+Thread_Wait (
+  CThread  *thread
+  )
+{
+  POSIX_THREAD  *Thread;
+  WRes          Res;
+
+  Thread = (POSIX_THREAD *) thread->handle;
+  if (Thread == NULL) {
+    return 1;
+  }
+
+  if (Thread->Joined) {
+    return 0;
+  }
+
+  Res = pthread_join (Thread->Thread, NULL);
+  if (Res == 0) {
+    Thread->Joined = 1;
+  }
+
+  return Res;
+}
+
+WRes
+Thread_Close (
+  CThread  *thread
+  )
+{
+  POSIX_THREAD  *Thread;
+
+  Thread = (POSIX_THREAD *) thread->handle;
+  if (Thread != NULL) {
+    if (!Thread->Joined) {
+      pthread_detach (Thread->Thread);
+    }
+
+    free (Thread);
+    thread->handle = NULL;
+  }
+
+  return 0;
+}
+
+static
+WRes
+Event_Create (
+  CEvent  *p,
+  int     manualReset,
+  int     initialSignaled
+  )
+{
+  POSIX_EVENT  *Event;
+
+  Event = CreateSyncObject (sizeof (POSIX_EVENT));
+  if (Event == NULL) {
+    return 1;
+  }
+
+  Event->ManualReset  = manualReset;
+  Event->Signaled     = initialSignaled ? 1 : 0;
+  p->handle           = Event;
+  return 0;
+}
+
+WRes
+ManualResetEvent_Create (
+  CManualResetEvent  *p,
+  int                initialSignaled
+  )
+{
+  return Event_Create (p, 1, initialSignaled);
+}
+
+WRes
+ManualResetEvent_CreateNotSignaled (
+  CManualResetEvent  *p
+  )
+{
+  return ManualResetEvent_Create (p, 0);
+}
+
+WRes
+AutoResetEvent_Create (
+  CAutoResetEvent  *p,
+  int              initialSignaled
+  )
+{
+  return Event_Create (p, 0, initialSignaled);
+}
+
+WRes
+AutoResetEvent_CreateNotSignaled (
+  CAutoResetEvent  *p
+  )
+{
+  return AutoResetEvent_Create (p, 0);
+}
+
+WRes
+Event_Set (
+  CEvent  *p
+  )
+{
+  POSIX_EVENT  *Event;
+
+  Event = (POSIX_EVENT *) p->handle;
+  pthread_mutex_lock (&Event->Mutex);
+  Event->Signaled = 1;
+  pthread_cond_broadcast (&Event->Cond);
+  pthread_mutex_unlock (&Event->Mutex);
+  return 0;
+}
+
+WRes
+Event_Reset (
+  CEvent  *p
+  )
+{
+  POSIX_EVENT  *Event;
+
+  Event = (POSIX_EVENT *) p->handle;
+  pthread_mutex_lock (&Event->Mutex);
+  Event->Signaled = 0;
+  pthread_mutex_unlock (&Event->Mutex);
+  return 0;
+}
+
+WRes
+Event_Wait (
+  CEvent  *p
+  )
+{
+  POSIX_EVENT  *Event;
+
+  Event = (POSIX_EVENT *) p->handle;
+  pthread_mutex_lock (&Event->Mutex);
+  while (!Event->Signaled) {
+    pthread_cond_wait (&Event->Cond, &Event->Mutex);
+  }
+
+  if (!Event->ManualReset) {
+    Event->Signaled = 0;
+  }
+
+  pthread_mutex_unlock (&Event->Mutex);
+  return 0;
+}
+
+WRes
+Event_Close (
+  CEvent  *p
+  )
+{
+  return CloseSyncObject (&p->handle);
+}
+
+WRes
+Semaphore_Create (
+  CSemaphore  *p,
+  UInt32      initiallyCount,
+  UInt32      maxCount
+  )
+{
+  POSIX_SEMAPHORE  *Semaphore;
+
+  Semaphore = CreateSyncObject (sizeof (POSIX_SEMAPHORE));
+  if (Semaphore == NULL) {
+    return 1;
+  }
+
+  Semaphore->Count    = initiallyCount;
+  Semaphore->MaxCount = maxCount;
+  p->handle           = Semaphore;
+  return 0;
+}
+
+WRes
+Semaphore_ReleaseN (
+  CSemaphore  *p,
+  UInt32      num
+  )
+{
+  POSIX_SEMAPHORE  *Semaphore;
+  WRes             Res;
+
+  Semaphore = (POSIX_SEMAPHORE *) p->handle;
+  Res       = 0;
+  pthread_mutex_lock (&Semaphore->Mutex);
+  if (Semaphore->Count + num > Semaphore->MaxCount) {
+    Res = 1;
+  } else {
+    Semaphore->Count += num;
+    pthread_cond_broadcast (&Semaphore->Cond);
+  }
+
+  pthread_mutex_unlock (&Semaphore->Mutex);
+  return Res;
+}
+
+WRes
+Semaphore_Release1 (
+  CSemaphore  *p
+  )
+{
+  return Semaphore_ReleaseN (p, 1);
+}
+
+WRes
+Semaphore_Wait (
+  CSemaphore  *p
+  )
+{
+  POSIX_SEMAPHORE  *Semaphore;
+
+  Semaphore = (POSIX_SEMAPHORE *) p->handle;
+  pthread_mutex_lock (&Semaphore->Mutex);
+  while (Semaphore->Count == 0) {
+    pthread_cond_wait (&Semaphore->Cond, &Semaphore->Mutex);
+  }
+
+  Semaphore->Count--;
+  pthread_mutex_unlock (&Semaphore->Mutex);
+  return 0;
+}
+
+WRes
+Semaphore_Close (
+  CSemaphore  *p
+  )
+{
+  return CloseSyncObject (&p->handle);
+}
+
+WRes
+CriticalSection_Init (
+  CCriticalSection  *p
+  )
+{
+  return pthread_mutex_init (p, NULL);
+}
@@ -0,0 +1,40 @@
+/** @file
+  Windows declarations used by the LZMA SDK's Threads.h, for hosts using
+  POSIX threads. The GNUmakefile includes this file ahead of every source,
+  so that the SDK sources build unmodified. PosixThreads.c implements the
+  functions declared in Threads.h on top of these declarations.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __POSIX_THREADS_H__
+#define __POSIX_THREADS_H__
+
+#ifndef _WIN32
+
+#include <pthread.h>
+
+//
+// A thread, event or semaphore handle points to the POSIX object allocated
+// by PosixThreads.c, it is NULL when no object is created.
+//
+typedef void *HANDLE;
+typedef void *LPVOID;
+
+typedef pthread_mutex_t CRITICAL_SECTION;
+
+#define DeleteCriticalSection(p)  pthread_mutex_destroy (p)
+#define EnterCriticalSection(p)   pthread_mutex_lock (p)
+#define LeaveCriticalSection(p)   pthread_mutex_unlock (p)
+
+#endif
+
+#endif
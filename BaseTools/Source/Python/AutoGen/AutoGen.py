@@ -18,6 +18,7 @@ import re
 import os.path as path
 import copy
 import uuid
+import hashlib
 
 import GenC
 import GenMake
@@ -146,6 +147,43 @@ ${tail_comments}
 ##   ${flags_item}${END}
 """)
 
+## Hash of each package, see GetPackageHash()
+gPackageHashDict = {}
+
+## Update a hash object with the name and the content of a file
+#
+#   @param      HashObj     The hash object
+#   @param      File        The path of the file
+#   @param      Name        The name of the file in the hash, which should not
+#                           depend on the location of the workspace
+#
+def UpdateFileHash(HashObj, File, Name):
+    HashObj.update(Name.replace('\\', '/') + '\n')
+    if os.path.isfile(File):
+        HashObj.update(open(File, 'rb').read())
+
+## Return the hash of the DEC file and of all files in the include directories of a package
+#
+#   @param      Package     The package object
+#
+#   @retval     string      The MD5 hex digest
+#
+def GetPackageHash(Package):
+    PackageDir = Package.MetaFile.Dir
+    IncludeList = [str(Include) for Include in Package.Includes]
+    Key = (str(Package.MetaFile), tuple(IncludeList))
+    if Key not in gPackageHashDict:
+        HashObj = hashlib.md5()
+        UpdateFileHash(HashObj, Package.MetaFile.Path, Package.MetaFile.Name)
+        for Include in IncludeList:
+            for Root, Dirs, Files in os.walk(Include):
+                Dirs.sort()
+                for File in sorted(Files):
+                    FullPath = os.path.join(Root, File)
+                    UpdateFileHash(HashObj, FullPath, os.path.relpath(FullPath, PackageDir))
+        gPackageHashDict[Key] = HashObj.hexdigest()
+    return gPackageHashDict[Key]
+
 ## Base class for AutoGen
 #
 #   This class just implements the cache mechanism of AutoGen objects.
@@ -1090,6 +1128,8 @@ class PlatformAutoGen(AutoGen):
         self._Version    = None
 
         self._BuildRule = None
+        self._BuildRuleFile = None
+        self._PlatformHash = None
         self._SourceDir = None
         self._BuildDir = None
         self._OutputDir = None
@@ -1793,6 +1833,21 @@ class PlatformAutoGen(AutoGen):
             self._EdkIIBuildOption = self._ExpandBuildOption(self.Platform.BuildOptions, EDKII_NAME)
         return self._EdkIIBuildOption
 
+    ## Return the hash of the platform wide inputs of module builds
+    #
+    #   Only the build rules are covered here; the tool flags and the PCD settings
+    #   are hashed per module by ModuleAutoGen.GenModuleHash().
+    #
+    #   @retval     string  The MD5 hex digest
+    #
+    def GenPlatformHash(self):
+        if self._PlatformHash == None:
+            HashObj = hashlib.md5()
+            self._GetBuildRule()
+            UpdateFileHash(HashObj, mws.join(self.WorkspaceDir, self._BuildRuleFile), 'build_rule.txt')
+            self._PlatformHash = HashObj.hexdigest()
+        return self._PlatformHash
+
     ## Parse build_rule.txt in Conf Directory.
     #
     #   @retval     BuildRule object
@@ -1804,6 +1859,7 @@ class PlatformAutoGen(AutoGen):
                 BuildRuleFile = self.Workspace.TargetTxt.TargetTxtDictionary[TAB_TAT_DEFINES_BUILD_RULE_CONF]
             if BuildRuleFile in [None, '']:
                 BuildRuleFile = gDefaultBuildRuleFile
+            self._BuildRuleFile = BuildRuleFile
             self._BuildRule = BuildRule(BuildRuleFile)
             if self._BuildRule._FileVersion == "":
                 self._BuildRule._FileVersion = AutoGenReqBuildRuleVerNum
@@ -2628,6 +2684,8 @@ class ModuleAutoGen(AutoGen):
         #  
         self._FixedAtBuildPcds         = []
         self.ConstPcd                  = {}
+
+        self._ModuleHash               = None
         return True
 
     def __repr__(self):
@@ -4037,6 +4095,150 @@ class ModuleAutoGen(AutoGen):
         self.IsCodeFileCreated = True
         return AutoGenList
 
+    ## Update a hash object with the settings of a PCD
+    #
+    #   @param      HashObj     The hash object
+    #   @param      Pcd         The PCD object
+    #
+    def _UpdatePcdHash(self, HashObj, Pcd):
+        HashObj.update("%s.%s|%s|%s|%s|%s\n" % (Pcd.TokenSpaceGuidCName, Pcd.TokenCName, Pcd.Type,
+                                                 Pcd.DatumType, Pcd.DefaultValue, Pcd.MaxDatumSize))
+        for SkuName in sorted(Pcd.SkuInfoList):
+            HashObj.update(str(Pcd.SkuInfoList[SkuName]) + "\n")
+        Key = (Pcd.TokenCName, Pcd.TokenSpaceGuidCName)
+        if Key in self.PlatformInfo.PcdTokenNumber:
+            HashObj.update("%s\n" % self.PlatformInfo.PcdTokenNumber[Key])
+
+    ## Return the hash of all the inputs of the module build
+    #
+    #   The hash covers the build rules, the tool chain and the build flags, the
+    #   INF file, the DEC and include files of the dependent packages, the source
+    #   and binary files, the PCD settings and the hashes of the library instances.
+    #   File names are hashed relative to the module or package directory, so the
+    #   hash is the same in any workspace.
+    #
+    #   @retval     string  The MD5 hex digest
+    #
+    def GenModuleHash(self):
+        if self._ModuleHash != None:
+            return self._ModuleHash
+
+        HashObj = hashlib.md5()
+        HashObj.update("%s %s %s\n" % (self.BuildTarget, self.ToolChain, self.Arch))
+        HashObj.update(self.PlatformInfo.GenPlatformHash())
+        for Tool in sorted(self.BuildOption):
+            for Attr in sorted(self.BuildOption[Tool]):
+                HashObj.update("%s_%s = %s\n" % (Tool, Attr, self.BuildOption[Tool][Attr]))
+
+        ModuleDir = self.MetaFile.Dir
+        UpdateFileHash(HashObj, self.MetaFile.Path, self.MetaFile.Name)
+        for Package in self.DependentPackageList:
+            HashObj.update(GetPackageHash(Package))
+        for File in sorted(self.SourceFileList + self.BinaryFileList, key=lambda File: File.Path):
+            UpdateFileHash(HashObj, File.Path, os.path.relpath(File.Path, ModuleDir))
+        for MakeType in sorted(self.CustomMakefile):
+            File = mws.join(self.WorkspaceDir, self.CustomMakefile[MakeType])
+            UpdateFileHash(HashObj, File, os.path.relpath(File, ModuleDir))
+
+        for Pcd in self.ModulePcdList + self.LibraryPcdList:
+            self._UpdatePcdHash(HashObj, Pcd)
+        # The PCD drivers carry the PCD database of the whole platform
+        if self.PcdIsDriver:
+            for Pcd in self.PlatformInfo.DynamicPcdList:
+                self._UpdatePcdHash(HashObj, Pcd)
+
+        for LibraryAutoGen in self.LibraryAutoGenList:
+            HashObj.update(LibraryAutoGen.GenModuleHash())
+
+        self._ModuleHash = HashObj.hexdigest()
+        return self._ModuleHash
+
+    ## Return the directory of the module outputs for the current hash in the binary cache
+    def _GetCacheDir(self):
+        return os.path.join(GlobalData.gBinCacheDir, "%s_%s" % (self.BuildTarget, self.ToolChain), self.Arch,
+                            self.SourceDir, self.MetaFile.BaseName, self.GenModuleHash())
+
+    ## Return the files copied by the module build to the common BIN_DIR directory
+    def _GetBinDirFileList(self):
+        BinDir = self.Macros["BIN_DIR"]
+        Prefix = self.Macros["MODULE_NAME_GUID"] + "."
+        if not os.path.isdir(BinDir):
+            return []
+        return [File for File in os.listdir(BinDir) if File.startswith(Prefix) and os.path.isfile(os.path.join(BinDir, File))]
+
+    ## Check whether the module can be skipped by the build cache
+    #
+    #   With --hash, a module whose hash is the one saved by its last successful
+    #   build is skipped. With --binary-cache, the outputs of a module whose hash
+    #   is in the binary cache are restored from the cache. In both cases, neither
+    #   AutoGen nor make is needed for the module.
+    #
+    #   @retval     True    The module outputs are up to date
+    #   @retval     False   The module must be built
+    #
+    def CanSkip(self):
+        if not GlobalData.gUseHashCache and not GlobalData.gBinCacheDir:
+            return False
+        if self.IsBinaryModule:
+            return False
+
+        Key = (str(self.MetaFile), self.Arch)
+        HashFile = os.path.join(self.BuildDir, self.Name + ".hash")
+        if GlobalData.gUseHashCache and os.path.isfile(HashFile):
+            if open(HashFile, 'r').read() == self.GenModuleHash():
+                GlobalData.gModuleCacheResult[Key] = "HASH"
+                return True
+
+        if GlobalData.gBinCacheDir:
+            CacheDir = self._GetCacheDir()
+            if os.path.isfile(os.path.join(CacheDir, self.Name + ".hash")):
+                for Root, Dirs, Files in os.walk(os.path.join(CacheDir, "BUILD")):
+                    DestDir = os.path.join(self.BuildDir, os.path.relpath(Root, os.path.join(CacheDir, "BUILD")))
+                    CreateDirectory(DestDir)
+                    for File in Files:
+                        CopyLongFilePath(os.path.join(Root, File), os.path.join(DestDir, File))
+                BinDir = self.Macros["BIN_DIR"]
+                CreateDirectory(BinDir)
+                for File in os.listdir(os.path.join(CacheDir, "BIN")):
+                    CopyLongFilePath(os.path.join(CacheDir, "BIN", File), os.path.join(BinDir, File))
+                SaveFileOnChange(HashFile, self.GenModuleHash(), False)
+                GlobalData.gModuleCacheResult[Key] = "CACHE"
+                return True
+
+        GlobalData.gModuleCacheResult[Key] = "MISS"
+        return False
+
+    ## Save the hash of the module after a successful build, and its outputs to the binary cache
+    def SaveToCache(self):
+        if not GlobalData.gUseHashCache and not GlobalData.gBinCacheDir:
+            return
+        if self.IsBinaryModule:
+            return
+
+        SaveFileOnChange(os.path.join(self.BuildDir, self.Name + ".hash"), self.GenModuleHash(), False)
+        if not GlobalData.gBinCacheDir:
+            return
+        CacheDir = self._GetCacheDir()
+        if os.path.isfile(os.path.join(CacheDir, self.Name + ".hash")):
+            return
+
+        for Root, Dirs, Files in os.walk(self.BuildDir):
+            DestDir = os.path.join(CacheDir, "BUILD", os.path.relpath(Root, self.BuildDir))
+            CreateDirectory(DestDir)
+            for File in Files:
+                CopyLongFilePath(os.path.join(Root, File), os.path.join(DestDir, File))
+        CreateDirectory(os.path.join(CacheDir, "BIN"))
+        for File in self._GetBinDirFileList():
+            CopyLongFilePath(os.path.join(self.Macros["BIN_DIR"], File), os.path.join(CacheDir, "BIN", File))
+        # the hash file marks the cache entry as complete, so it is written last
+        SaveFileOnChange(os.path.join(CacheDir, self.Name + ".hash"), self.GenModuleHash(), False)
+
+    ## Forget the hash of the last build, as the outputs of the module are cleaned
+    def RemoveHash(self):
+        HashFile = os.path.join(self.BuildDir, self.Name + ".hash")
+        if os.path.isfile(HashFile):
+            os.remove(HashFile)
+
     ## Summarize the ModuleAutoGen objects of all libraries used by this module
     def _GetLibraryAutoGenList(self):
         if self._LibraryAutoGenList == None:
@@ -1442,6 +1442,9 @@ class TopLevelMakefile(BuildFile):
         if GlobalData.gIgnoreSource:
             ExtraOption += " --ignore-sources"
 
+        if GlobalData.gThreadNumber > 1:
+            ExtraOption += " -n %d" % GlobalData.gThreadNumber
+
         if GlobalData.BuildOptionPcd:
             for index, option in enumerate(GlobalData.gCommand):
                 if "--pcd" == option and GlobalData.gCommand[index+1]:
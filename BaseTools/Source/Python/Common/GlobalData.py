@@ -66,6 +66,28 @@ gDatabasePath = ".cache/build.db"
 #
 gIgnoreSource = False
 
+#
+# Number of threads used by the build, also passed to GenFds
+#
+gThreadNumber = 1
+
+#
+# Build cache: gUseHashCache is set by --hash, gBinCacheDir by --binary-cache.
+# gModuleCacheResult maps (INF path, arch) of each module checked against the
+# cache to "HASH" (unchanged since its last build), "CACHE" (restored from the
+# binary cache) or "MISS" (built)
+#
+gUseHashCache = False
+gBinCacheDir = None
+gModuleCacheResult = {}
+
+#
+# Meta-data parse profile: {file path : [parsed, parse time, post-process time]}.
+# "parsed" is False if the parsed data of the file was loaded from the workspace
+# database. Printed at the end of build by --parse-profile
+#
+gParseProfile = {}
+
 #
 # FDF parser
 #
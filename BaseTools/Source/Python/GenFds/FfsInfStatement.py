@@ -17,6 +17,7 @@
 # Import Modules
 #
 import Rule
+import copy
 import Common.LongFilePathOs as os
 import StringIO
 from struct import *
@@ -450,9 +451,12 @@ class FfsInfStatement(FfsInfStatementClassObject):
                 self.Rule = "BINARY"
                 
         #
-        # Get the rule of how to generate Ffs file
+        # Get the rule of how to generate Ffs file. The rule is shared by all INFs
+        # and its section objects keep per module state while the sections are
+        # generated, so work on a private copy. This also keeps the FFS files
+        # independent of the order in which the INFs are processed.
         #
-        Rule = self.__GetRule__()
+        Rule = copy.deepcopy(self.__GetRule__())
         GenFdsGlobalVariable.VerboseLogger( "Packing binaries from inf file : %s" %self.InfFileName)
         #
         # Convert Fv File Type for PI1.1 SMM driver.
@@ -22,6 +22,7 @@ from struct import *
 
 import Ffs
 import AprioriSection
+from FvImageSection import FvImageSection
 from GenFdsGlobalVariable import GenFdsGlobalVariable
 from GenFds import GenFds
 from CommonDataClass.FdfClass import FvClassObject
@@ -66,6 +67,19 @@ class FV (FvClassObject):
     #   @retval string      Generated FV file path
     #
     def AddToBuffer (self, Buffer, BaseAddress=None, BlockSize= None, BlockNum=None, ErasePloarity='1', VtfDict=None, MacroDict = {}) :
+        #
+        # A FV nested in a FFS file generated by a worker thread is generated as a
+        # whole, since the large file flag stack is shared by all FFS files of a FV.
+        #
+        if not GenFdsGlobalVariable.InParallelWorker():
+            return self.__AddToBuffer__(Buffer, BaseAddress, BlockSize, BlockNum, ErasePloarity, VtfDict, MacroDict)
+        GenFdsGlobalVariable.ThreadState.Exclusive += 1
+        try:
+            return self.__AddToBuffer__(Buffer, BaseAddress, BlockSize, BlockNum, ErasePloarity, VtfDict, MacroDict)
+        finally:
+            GenFdsGlobalVariable.ThreadState.Exclusive -= 1
+
+    def __AddToBuffer__ (self, Buffer, BaseAddress, BlockSize, BlockNum, ErasePloarity, VtfDict, MacroDict) :
 
         if BaseAddress == None and self.UiFvName.upper() + 'fv' in GenFds.ImageBinDict.keys():
             return GenFds.ImageBinDict[self.UiFvName.upper() + 'fv']
@@ -111,8 +125,7 @@ class FV (FvClassObject):
                                            T_CHAR_LF)
 
         # Process Modules in FfsList
-        for FfsFile in self.FfsList :
-            FileName = FfsFile.GenFfs(MacroDict, FvParentAddr=BaseAddress)
+        for FileName in self.__GenFfsFileList__(MacroDict, BaseAddress):
             FfsFileList.append(FileName)
             self.FvInfFile.writelines("EFI_FILE_NAME = " + \
                                        FileName          + \
@@ -234,6 +247,53 @@ class FV (FvClassObject):
                             return True
         return False
 
+    ## __GenFfsFileList__()
+    #
+    #   Generate the FFS files in FfsList. With more than one GenFds thread, the
+    #   FFS files between two FFS files holding a nested FV or FD image are
+    #   generated concurrently; a FFS file holding a nested image is generated
+    #   alone, after the FFS files before it, as in the serial generation.
+    #
+    #   @param  self        The object pointer
+    #   @param  MacroDict   macro value pair
+    #   @param  BaseAddress base address of FV
+    #   @retval list        Generated FFS file names, in the order of FfsList
+    #
+    def __GenFfsFileList__(self, MacroDict, BaseAddress):
+        if GenFdsGlobalVariable.ThreadNumber < 2 or GenFdsGlobalVariable.InParallelWorker():
+            return [FfsFile.GenFfs(MacroDict, FvParentAddr=BaseAddress) for FfsFile in self.FfsList]
+
+        FileNameList = []
+        FuncList = []
+        for FfsFile in self.FfsList:
+            if not FV.__HasNestedImage__(FfsFile):
+                FuncList.append(lambda FfsFile=FfsFile: FfsFile.GenFfs(MacroDict, FvParentAddr=BaseAddress))
+                continue
+            FileNameList += GenFdsGlobalVariable.RunInParallel(FuncList)
+            FuncList = []
+            FileNameList.append(FfsFile.GenFfs(MacroDict, FvParentAddr=BaseAddress))
+        FileNameList += GenFdsGlobalVariable.RunInParallel(FuncList)
+        return FileNameList
+
+    ## __HasNestedImage__()
+    #
+    #   Check whether a FFS file statement or a section generates a FV or FD image
+    #
+    #   @param  Obj         FFS file statement or section object
+    #   @retval True        Obj contains a FV image section, a FV or a FD
+    #   @retval False       Obj does not contain any nested image
+    #
+    @staticmethod
+    def __HasNestedImage__(Obj):
+        if isinstance(Obj, FvImageSection):
+            return True
+        if getattr(Obj, 'FvName', None) != None or getattr(Obj, 'FdName', None) != None:
+            return True
+        for Section in getattr(Obj, 'SectionList', []):
+            if FV.__HasNestedImage__(Section):
+                return True
+        return False
+
     ## __InitializeInf__()
     #
     #   Initilize the inf file to create FV
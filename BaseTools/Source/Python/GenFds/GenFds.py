@@ -73,6 +73,11 @@ def main():
             
         if Options.FixedAddress != None:
             GenFdsGlobalVariable.FixedLoadAddress = True
+
+        if Options.ThreadNumber != None:
+            if Options.ThreadNumber < 1:
+                EdkLogger.error("GenFds", OPTION_VALUE_INVALID, "Invalid thread number: %d" % Options.ThreadNumber)
+            GenFdsGlobalVariable.ThreadNumber = Options.ThreadNumber
             
         if Options.quiet != None:
             EdkLogger.SetLevel(EdkLogger.QUIET)
@@ -424,11 +429,17 @@ def BuildOptionPcdValueFormat(TokenSpaceGuidCName, TokenCName, PcdDatumType, Val
 #  @param  NameGuid         The Guid name
 #
 def FindExtendTool(KeyStringList, CurrentArchList, NameGuid):
+    # the tool of a GUID is looked up once, tools_def.txt is not parsed again
+    if NameGuid in GenFdsGlobalVariable.GuidToolDefinition:
+        return GenFdsGlobalVariable.GuidToolDefinition[NameGuid]
+
+    ToolDef = ToolDefClassObject.ToolDefDict(GenFdsGlobalVariable.ConfDir)
+
     # if user not specify filter, try to deduce it from global data.
     if KeyStringList == None or KeyStringList == []:
         Target = GenFdsGlobalVariable.TargetName
         ToolChain = GenFdsGlobalVariable.ToolChainTag
-        ToolDb = ToolDefClassObject.ToolDefDict(GenFdsGlobalVariable.ConfDir).ToolsDefTxtDatabase
+        ToolDb = ToolDef.ToolsDefTxtDatabase
         if ToolChain not in ToolDb['TOOL_CHAIN_TAG']:
             EdkLogger.error("GenFds", GENFDS_ERROR, "Can not find external tool because tool tag %s is not defined in tools_def.txt!" % ToolChain)
         KeyStringList = [Target + '_' + ToolChain + '_' + CurrentArchList[0]]
@@ -436,16 +447,12 @@ def FindExtendTool(KeyStringList, CurrentArchList, NameGuid):
             if Target + '_' + ToolChain + '_' + Arch not in KeyStringList:
                 KeyStringList.append(Target + '_' + ToolChain + '_' + Arch)
 
-    if GenFdsGlobalVariable.GuidToolDefinition:
-        if NameGuid in GenFdsGlobalVariable.GuidToolDefinition.keys():
-            return GenFdsGlobalVariable.GuidToolDefinition[NameGuid]
-
-    ToolDefinition = ToolDefClassObject.ToolDefDict(GenFdsGlobalVariable.ConfDir).ToolsDefTxtDictionary
+    ToolDefinition = ToolDef.ToolsDefTxtDictionary
     ToolPathTmp = None
     ToolOption = None
-    for ToolDef in ToolDefinition.items():
-        if NameGuid == ToolDef[1]:
-            KeyList = ToolDef[0].split('_')
+    for ToolDefItem in ToolDefinition.items():
+        if NameGuid == ToolDefItem[1]:
+            KeyList = ToolDefItem[0].split('_')
             Key = KeyList[0] + \
                   '_' + \
                   KeyList[1] + \
@@ -503,6 +510,8 @@ def myOptionParser():
                       action="callback", callback=SingleCheckCallback)
     Parser.add_option("-D", "--define", action="append", type="string", dest="Macros", help="Macro: \"Name [= Value]\".")
     Parser.add_option("-s", "--specifyaddress", dest="FixedAddress", action="store_true", type=None, help="Specify driver load address.")
+    Parser.add_option("-n", "--thread-number", dest="ThreadNumber", action="callback", type="int", callback=SingleCheckCallback,
+                      help="Generate the FFS files of a FV with the specified number of threads. The FV content is the same as with one thread.")
     Parser.add_option("--conf", action="store", type="string", dest="ConfDirectory", help="Specify the customized Conf directory.")
     Parser.add_option("--ignore-sources", action="store_true", dest="IgnoreSources", default=False, help="Focus to a binary build and ignore all source files")
     Parser.add_option("--pcd", action="append", dest="OptionPcd", help="Set PCD value by command line. Format: \"PcdName=Value\" ")
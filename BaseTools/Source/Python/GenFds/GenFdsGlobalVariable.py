@@ -20,6 +20,7 @@ import sys
 import subprocess
 import struct
 import array
+import threading
 
 from Common.BuildToolError import *
 from Common import EdkLogger
@@ -84,6 +85,18 @@ class GenFdsGlobalVariable:
     LARGE_FILE_SIZE = 0x1000000
 
     SectionHeader = struct.Struct("3B 1B")
+
+    #
+    # Number of threads used to generate the FFS files of a FV. The worker threads
+    # run the GenFds code under ParallelLock and only release it while an external
+    # tool is running, so the tools run concurrently while the FDF objects, the
+    # workspace database and the global variables are used by one thread at a time.
+    # ThreadState.Exclusive is nonzero while a worker must keep the lock across
+    # tool calls, e.g. during the generation of a nested FV.
+    #
+    ThreadNumber = 1
+    ParallelLock = threading.Lock()
+    ThreadState = threading.local()
     
     ## LoadBuildRule
     #
@@ -585,6 +598,58 @@ class GenFdsGlobalVariable:
 
         GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to call " + ToolPath, returnValue)
 
+    ## InParallelWorker()
+    #
+    #   @retval True        The caller runs in a worker thread started by RunInParallel()
+    #   @retval False       The caller runs in the main thread
+    #
+    @staticmethod
+    def InParallelWorker():
+        return getattr(GenFdsGlobalVariable.ThreadState, 'Worker', False)
+
+    ## RunInParallel()
+    #
+    #   Call the functions with at most ThreadNumber worker threads. The functions
+    #   are started in list order and no new function is started once one of them
+    #   fails, so the error raised is the one the serial generation would report.
+    #
+    #   @param  FuncList    List of functions without argument
+    #   @retval list        Return values of the functions in the order of FuncList
+    #
+    @staticmethod
+    def RunInParallel(FuncList):
+        ResultList = [None] * len(FuncList)
+        ErrorList = [None] * len(FuncList)
+        PendingList = range(len(FuncList))
+
+        def Worker():
+            GenFdsGlobalVariable.ThreadState.Worker = True
+            GenFdsGlobalVariable.ThreadState.Exclusive = 0
+            GenFdsGlobalVariable.ParallelLock.acquire()
+            try:
+                while PendingList:
+                    Index = PendingList.pop(0)
+                    try:
+                        ResultList[Index] = FuncList[Index]()
+                    except:
+                        ErrorList[Index] = sys.exc_info()
+                        del PendingList[:]
+            finally:
+                GenFdsGlobalVariable.ParallelLock.release()
+
+        ThreadList = []
+        for Index in range(min(GenFdsGlobalVariable.ThreadNumber, len(FuncList))):
+            Thread = threading.Thread(target=Worker)
+            Thread.start()
+            ThreadList.append(Thread)
+        for Thread in ThreadList:
+            Thread.join()
+
+        for Error in ErrorList:
+            if Error != None:
+                raise Error[0], Error[1], Error[2]
+        return ResultList
+
     def CallExternalTool (cmd, errorMess, returnValue=[]):
 
         if type(cmd) not in (tuple, list):
@@ -604,14 +669,26 @@ class GenFdsGlobalVariable:
             if GenFdsGlobalVariable.SharpCounter % GenFdsGlobalVariable.SharpNumberPerLine == 0:
                 sys.stdout.write('\n')
 
+        #
+        # Let the other worker threads run while the tool is running. The pipes of
+        # a tool must not be inherited by the tools started by the other threads.
+        #
+        Concurrent = GenFdsGlobalVariable.InParallelWorker() and not GenFdsGlobalVariable.ThreadState.Exclusive
+        if Concurrent:
+            GenFdsGlobalVariable.ParallelLock.release()
         try:
-            PopenObject = subprocess.Popen(' '.join(cmd), stdout=subprocess.PIPE, stderr=subprocess.PIPE, shell=True)
-        except Exception, X:
-            EdkLogger.error("GenFds", COMMAND_FAILURE, ExtraData="%s: %s" % (str(X), cmd[0]))
-        (out, error) = PopenObject.communicate()
-
-        while PopenObject.returncode == None :
-            PopenObject.wait()
+            try:
+                PopenObject = subprocess.Popen(' '.join(cmd), stdout=subprocess.PIPE, stderr=subprocess.PIPE, shell=True,
+                                               close_fds=Concurrent and sys.platform != 'win32')
+            except Exception, X:
+                EdkLogger.error("GenFds", COMMAND_FAILURE, ExtraData="%s: %s" % (str(X), cmd[0]))
+            (out, error) = PopenObject.communicate()
+
+            while PopenObject.returncode == None :
+                PopenObject.wait()
+        finally:
+            if Concurrent:
+                GenFdsGlobalVariable.ParallelLock.acquire()
         if returnValue != [] and returnValue[0] != 0:
             #get command return value
             returnValue[0] = PopenObject.returncode
@@ -168,7 +168,8 @@ class TableFile(Table):
         Path VARCHAR,
         FullPath VARCHAR NOT NULL,
         Model INTEGER DEFAULT 0,
-        TimeStamp SINGLE NOT NULL
+        TimeStamp SINGLE NOT NULL,
+        Hash VARCHAR
         '''
     def __init__(self, Cursor):
         Table.__init__(self, Cursor, 'File')
@@ -183,9 +184,10 @@ class TableFile(Table):
     # @param FullPath:  FullPath of a File
     # @param Model:     Model of a File
     # @param TimeStamp: TimeStamp of a File
+    # @param Hash:      MD5 digest of the content of a File
     #
-    def Insert(self, Name, ExtName, Path, FullPath, Model, TimeStamp):
-        (Name, ExtName, Path, FullPath) = ConvertToSqlString((Name, ExtName, Path, FullPath))
+    def Insert(self, Name, ExtName, Path, FullPath, Model, TimeStamp, Hash=''):
+        (Name, ExtName, Path, FullPath, Hash) = ConvertToSqlString((Name, ExtName, Path, FullPath, Hash))
         return Table.Insert(
             self,
             Name,
@@ -193,7 +195,8 @@ class TableFile(Table):
             Path,
             FullPath,
             Model,
-            TimeStamp
+            TimeStamp,
+            Hash
             )
 
     ## InsertFile
@@ -262,6 +265,27 @@ class TableFile(Table):
     def SetFileTimeStamp(self, FileId, TimeStamp):
         self.Exec("update %s set TimeStamp=%s where ID='%s'" % (self.Table, TimeStamp, FileId))
 
+    ## Get the content hash of a given file
+    #
+    #   @param  FileId      ID of file
+    #
+    #   @retval hash        Hash value of given file in the table
+    #
+    def GetFileHash(self, FileId):
+        QueryScript = "select Hash from %s where ID = '%s'" % (self.Table, FileId)
+        RecordList = self.Exec(QueryScript)
+        if len(RecordList) == 0:
+            return None
+        return RecordList[0][0]
+
+    ## Update the content hash of a given file
+    #
+    #   @param  FileId      ID of file
+    #   @param  Hash        MD5 digest of the content of file
+    #
+    def SetFileHash(self, FileId, Hash):
+        self.Exec("update %s set Hash='%s' where ID='%s'" % (self.Table, Hash, FileId))
+
     ## Get list of file with given type
     #
     #   @param  FileType    Type value of file
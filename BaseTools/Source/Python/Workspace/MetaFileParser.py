@@ -204,6 +204,19 @@ class MetaFileParser(object):
     def _PostProcess(self):
         self._PostProcessed = True
 
+    ## Add the time spent on the file to the parse profile
+    #
+    #   @param  Parsed          True if the file was parsed, False if its data was
+    #                           loaded from the database
+    #   @param  ParseTime       Seconds spent on parsing the file
+    #   @param  PostProcessTime Seconds spent on post-processing the parsed data
+    #
+    def _UpdateProfile(self, Parsed, ParseTime=0, PostProcessTime=0):
+        Profile = GlobalData.gParseProfile.setdefault(str(self.MetaFile), [False, 0, 0])
+        Profile[0] = Profile[0] or Parsed
+        Profile[1] += ParseTime
+        Profile[2] += PostProcessTime
+
     ## Get the parse complete flag
     def _GetFinished(self):
         return self._Finished
@@ -233,10 +246,13 @@ class MetaFileParser(object):
         if not self._Finished:
             if self._RawTable.IsIntegrity():
                 self._Finished = True
+                self._UpdateProfile(False)
             else:
                 self._Table = self._RawTable
                 self._PostProcessed = False
+                StartTime = time.time()
                 self.Start()
+                self._UpdateProfile(True, ParseTime=time.time() - StartTime)
 
         # No specific ARCH or Platform given, use raw data
         if self._RawTable and (len(DataInfo) == 1 or DataInfo[1] == None):
@@ -244,7 +260,9 @@ class MetaFileParser(object):
 
         # Do post-process if necessary
         if not self._PostProcessed:
+            StartTime = time.time()
             self._PostProcess()
+            self._UpdateProfile(False, PostProcessTime=time.time() - StartTime)
 
         return self._FilterRecordList(self._Table.Query(*DataInfo), DataInfo[1])
 
@@ -1506,7 +1524,9 @@ class DscParser(MetaFileParser):
             Parser._Scope = self._Scope
             Parser._Enabled = self._Enabled
             # Parse the included file
+            StartTime = time.time()
             Parser.Start()
+            Parser._UpdateProfile(True, ParseTime=time.time() - StartTime)
 
             # update current status with sub-parser's status
             self._SectionName = Parser._SectionName
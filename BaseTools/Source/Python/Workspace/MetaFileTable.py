@@ -15,9 +15,11 @@
 # Import Modules
 #
 import uuid
+import hashlib
 
 import Common.EdkLogger as EdkLogger
 from Common.BuildToolError import FORMAT_INVALID
+from Common.LongFilePathSupport import OpenLongFilePath as open
 
 from MetaDataTable import Table, TableFile
 from MetaDataTable import ConvertToSqlString
@@ -49,19 +51,38 @@ class MetaFileTable(Table):
         Table.__init__(self, Cursor, TableName, FileId, Temporary)
         self.Create(not self.IsIntegrity())
 
+    ## Get the MD5 digest of the content of the meta file
+    def _GetFileHash(self):
+        File = open(str(self.MetaFile), 'rb')
+        try:
+            return hashlib.md5(File.read()).hexdigest()
+        finally:
+            File.close()
+
+    ## Check whether the parsed data in the table is still valid for the file
+    #
+    #   The data is valid if the table is complete and either the timestamp or,
+    #   when only the timestamp changed (touch, checkout, copy), the content hash
+    #   of the file is the same as when it was parsed.
+    #
     def IsIntegrity(self):
         try:
             TimeStamp = self.MetaFile.TimeStamp
             Result = self.Cur.execute("select ID from %s where ID<0" % (self.Table)).fetchall()
             if not Result:
-                # update the timestamp in database
-                self._FileIndexTable.SetFileTimeStamp(self.IdBase, TimeStamp)                
+                # update the timestamp and hash in database
+                self._FileIndexTable.SetFileTimeStamp(self.IdBase, TimeStamp)
+                self._FileIndexTable.SetFileHash(self.IdBase, self._GetFileHash())
                 return False
 
             if TimeStamp != self._FileIndexTable.GetFileTimeStamp(self.IdBase):
-                # update the timestamp in database
+                # update the timestamp and hash in database
+                Hash = self._GetFileHash()
+                OldHash = self._FileIndexTable.GetFileHash(self.IdBase)
                 self._FileIndexTable.SetFileTimeStamp(self.IdBase, TimeStamp)
-                return False
+                self._FileIndexTable.SetFileHash(self.IdBase, Hash)
+                if Hash != OldHash:
+                    return False
         except Exception, Exc:
             EdkLogger.debug(EdkLogger.DEBUG_5, str(Exc))
             return False
@@ -2940,8 +2940,9 @@ class WorkspaceDatabase(object):
             if self._CheckWhetherDbNeedRenew(RenewDb, DbPath):
                 os.remove(DbPath)
         
-        # create db with optimized parameters
-        self.Conn = sqlite3.connect(DbPath, isolation_level='DEFERRED')
+        # create db with optimized parameters. GenFds worker threads use the
+        # connection one at a time, under GenFdsGlobalVariable.ParallelLock
+        self.Conn = sqlite3.connect(DbPath, isolation_level='DEFERRED', check_same_thread=False)
         self.Conn.execute("PRAGMA synchronous=OFF")
         self.Conn.execute("PRAGMA temp_store=MEMORY")
         self.Conn.execute("PRAGMA count_changes=OFF")
@@ -109,6 +109,13 @@ gPcdTypeMap = {
   'DynamicExVpd'     : ('DEXVPD', 'DynamicEx'),
   }
 
+## The look up table to map the build cache result of a module to its description
+gCacheResultMap = {
+  'HASH'  : 'HIT (unchanged since last build)',
+  'CACHE' : 'HIT (restored from binary cache)',
+  'MISS'  : 'MISS'
+  }
+
 ## The look up table to map module type to driver type
 gDriverTypeMap = {
   'SEC'               : '0x3 (SECURITY_CORE)',
@@ -554,6 +561,7 @@ class ModuleReport(object):
         self.PciDeviceId = M.Module.Defines.get("PCI_DEVICE_ID", "")
         self.PciVendorId = M.Module.Defines.get("PCI_VENDOR_ID", "")
         self.PciClassCode = M.Module.Defines.get("PCI_CLASS_CODE", "")
+        self.CacheResult = GlobalData.gModuleCacheResult.get((str(M.MetaFile), M.Arch), "")
 
         self._BuildDir = M.BuildDir
         self.ModulePcdSet = {}
@@ -649,6 +657,8 @@ class ModuleReport(object):
             FileWrite(File, "SHA1 HASH:            %s *%s" % (self.Hash, self.ModuleName + ".efi"))
         if self.BuildTimeStamp:
             FileWrite(File, "Build Time Stamp:     %s" % self.BuildTimeStamp)
+        if self.CacheResult:
+            FileWrite(File, "Build Cache:          %s" % gCacheResultMap[self.CacheResult])
         if self.DriverType:
             FileWrite(File, "Driver Type:          %s" % self.DriverType)
         if self.UefiSpecVersion:
@@ -1692,6 +1702,13 @@ class PlatformReport(object):
         FileWrite(File, "Build Duration:       %s" % BuildDuration)
         FileWrite(File, "Report Content:       %s" % ", ".join(ReportType))
 
+        if GlobalData.gModuleCacheResult:
+            ResultList = GlobalData.gModuleCacheResult.values()
+            HashHit = ResultList.count("HASH")
+            CacheHit = ResultList.count("CACHE")
+            FileWrite(File, "Build Cache:          %d hit (%d unchanged, %d from binary cache), %d miss" % \
+                      (HashHit + CacheHit, HashHit, CacheHit, ResultList.count("MISS")))
+
         if GlobalData.MixedPcd:
             FileWrite(File, gSectionStart)
             FileWrite(File, "The following PCDs use different access methods:")
@@ -766,6 +766,9 @@ class Build():
         GlobalData.BuildOptionPcd     = BuildOptions.OptionPcd
         #Set global flag for build mode
         GlobalData.gIgnoreSource = BuildOptions.IgnoreSources
+        GlobalData.gUseHashCache = BuildOptions.UseHashCache
+        if BuildOptions.BinCacheDir:
+            GlobalData.gBinCacheDir = os.path.normpath(os.path.abspath(BuildOptions.BinCacheDir))
 
         if self.ConfDirectory:
             # Get alternate Conf location, if it is absolute, then just use the absolute directory name
@@ -903,6 +906,7 @@ class Build():
 
         if self.ThreadNumber == 0:
             self.ThreadNumber = 1
+        GlobalData.gThreadNumber = self.ThreadNumber
 
         if not self.PlatformFile:
             PlatformFile = self.TargetTxt.TargetTxtDictionary[DataType.TAB_TAT_DEFINES_ACTIVE_PLATFORM]
@@ -1652,6 +1656,8 @@ class Build():
                         Ma = ModuleAutoGen(Wa, Module, BuildTarget, ToolChain, Arch, self.PlatformFile)
                         if Ma == None:
                             continue
+                        if self.Target in ["clean", "cleanall"]:
+                            Ma.RemoveHash()
                         self.BuildModules.append(Ma)
                     self._BuildPa(self.Target, Pa)
 
@@ -1740,7 +1746,13 @@ class Build():
                     MaList.append(Ma)
                     self.BuildModules.append(Ma)
                     if not Ma.IsBinaryModule:
+                        if self.Target in ["", "all"] and Ma.CanSkip():
+                            continue
+                        if self.Target in ["clean", "cleanall"]:
+                            Ma.RemoveHash()
                         self._Build(self.Target, Ma, BuildModule=True)
+                        if self.Target in ["", "all"]:
+                            Ma.SaveToCache()
 
                 self.BuildReport.AddPlatformReport(Wa, MaList)
                 if MaList == []:
@@ -1849,6 +1861,11 @@ class Build():
                         
                         if Ma == None:
                             continue
+                        # The outputs of the module are up to date or restored from the build cache
+                        if self.Target in ["", "all"] and Ma.CanSkip():
+                            continue
+                        if self.Target in ["clean", "cleanall"]:
+                            Ma.RemoveHash()
                         # Not to auto-gen for targets 'clean', 'cleanlib', 'cleanall', 'run', 'fds'
                         if self.Target not in ['clean', 'cleanlib', 'cleanall', 'run', 'fds']:
                             # for target which must generate AutoGen code and makefile
@@ -1898,6 +1915,7 @@ class Build():
                 #
                 ExitFlag.set()
                 BuildTask.WaitForComplete()
+                BuiltModuleList = self.BuildModules
                 self.CreateAsBuiltInf()
 
                 #
@@ -1907,6 +1925,10 @@ class Build():
                 if BuildTask.HasError():
                     EdkLogger.error("build", BUILD_ERROR, "Failed to build module", ExtraData=GlobalData.gBuildingModule)
 
+                if self.Target in ["", "all"]:
+                    for Ma in BuiltModuleList:
+                        Ma.SaveToCache()
+
                 # Create MAP file when Load Fix Address is enabled.
                 if self.Target in ["", "all", "fds"]:
                     for Arch in Wa.ArchList:
@@ -2090,6 +2112,25 @@ def SingleCheckCallback(option, opt_str, value, parser):
     else:
         parser.error("Option %s only allows one instance in command line!" % option)
 
+## Print the meta-data files which took the most time to parse
+#
+#   @param  Count   The number of files to print
+#
+def PrintParseProfile(Count=20):
+    Profile = GlobalData.gParseProfile
+    if not Profile:
+        return
+    ParsedCount = len([File for File in Profile if Profile[File][0]])
+    TotalTime = sum([Profile[File][1] + Profile[File][2] for File in Profile])
+    EdkLogger.quiet("\nMeta-data parse profile: %d files, %d parsed, %d loaded from database, %.3f seconds" \
+                    % (len(Profile), ParsedCount, len(Profile) - ParsedCount, TotalTime))
+    EdkLogger.quiet("%10s %12s  %-8s %s" % ("Parse(ms)", "Process(ms)", "Source", "File"))
+    FileList = sorted(Profile, key=lambda File: Profile[File][1] + Profile[File][2], reverse=True)
+    for File in FileList[:Count]:
+        Parsed, ParseTime, PostProcessTime = Profile[File]
+        EdkLogger.quiet("%10.1f %12.1f  %-8s %s" % (ParseTime * 1000, PostProcessTime * 1000,
+                                                    "parsed" if Parsed else "database", File))
+
 ## Parse command line options
 #
 # Using standard Python module optparse to parse command line option of this tool.
@@ -2154,6 +2195,12 @@ def MyOptionParser():
     Parser.add_option("--ignore-sources", action="store_true", dest="IgnoreSources", default=False, help="Focus to a binary build and ignore all source files")
     Parser.add_option("--pcd", action="append", dest="OptionPcd", help="Set PCD value by command line. Format: \"PcdName=Value\" ")
     Parser.add_option("-l", "--cmd-len", action="store", type="int", dest="CommandLength", help="Specify the maximum line length of build command. Default is 4096.")
+    Parser.add_option("--hash", action="store_true", dest="UseHashCache", default=False,
+        help="Skip AutoGen and make for the modules whose inputs did not change since their last build.")
+    Parser.add_option("--binary-cache", action="store", type="string", dest="BinCacheDir",
+        help="Restore the outputs of the modules found in the specified build cache directory, and save the outputs of the modules built to it.")
+    Parser.add_option("--parse-profile", action="store_true", dest="ParseProfile", default=False,
+        help="Print the meta-data files which took the most time to parse, and how many were loaded from the workspace database.")
 
     (Opt, Args) = Parser.parse_args()
     return (Opt, Args)
@@ -2348,6 +2395,8 @@ def Main():
         if not BuildError:
             MyBuild.BuildReport.GenerateReport(BuildDurationStr)
         MyBuild.Db.Close()
+    if Option.ParseProfile:
+        PrintParseProfile()
     EdkLogger.SetLevel(EdkLogger.QUIET)
     EdkLogger.quiet("\n- %s -" % Conclusion)
     EdkLogger.quiet(time.strftime("Build end time: %H:%M:%S, %b.%d %Y", time.localtime()))
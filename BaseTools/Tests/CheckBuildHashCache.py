@@ -0,0 +1,107 @@
+## @file
+# Regression test of the module hash cache of build (--hash)
+#
+# Builds a one module platform with --hash, cleans it with --hash and checks
+# that the next --hash build builds the module again instead of skipping it.
+# The test runs only in a workspace set up by edksetup, with the build tools
+# and the tool chain of TOOL_CHAIN_TAG (GCC5 by default) available.
+#
+#  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials
+#  are licensed and made available under the terms and conditions of the BSD License
+#  which accompanies this distribution.  The full text of the license may be found at
+#  http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+
+##
+# Import Modules
+#
+import os
+import shutil
+import subprocess
+import unittest
+
+import TestTools
+
+Workspace = os.environ.get('WORKSPACE')
+ToolChain = os.environ.get('TOOL_CHAIN_TAG', 'GCC5')
+TestDir = os.path.join(TestTools.TestTempDir, 'BuildHashCache')
+
+Dsc = '''[Defines]
+  PLATFORM_NAME                  = BuildHashCache
+  PLATFORM_GUID                  = 3c1b8e2f-5a6d-4f0e-9b7c-2d8a1e4f6b90
+  PLATFORM_VERSION               = 0.1
+  DSC_SPECIFICATION              = 0x00010005
+  OUTPUT_DIRECTORY               = %(Output)s
+  SUPPORTED_ARCHITECTURES        = X64
+  BUILD_TARGETS                  = DEBUG
+  SKUID_IDENTIFIER               = DEFAULT
+
+[LibraryClasses]
+  UefiApplicationEntryPoint|MdePkg/Library/UefiApplicationEntryPoint/UefiApplicationEntryPoint.inf
+  UefiLib|MdePkg/Library/UefiLib/UefiLib.inf
+  PcdLib|MdePkg/Library/BasePcdLibNull/BasePcdLibNull.inf
+  BaseLib|MdePkg/Library/BaseLib/BaseLib.inf
+  BaseMemoryLib|MdePkg/Library/BaseMemoryLib/BaseMemoryLib.inf
+  PrintLib|MdePkg/Library/BasePrintLib/BasePrintLib.inf
+  DebugLib|MdePkg/Library/BaseDebugLibNull/BaseDebugLibNull.inf
+  MemoryAllocationLib|MdePkg/Library/UefiMemoryAllocationLib/UefiMemoryAllocationLib.inf
+  DevicePathLib|MdePkg/Library/UefiDevicePathLib/UefiDevicePathLib.inf
+  UefiBootServicesTableLib|MdePkg/Library/UefiBootServicesTableLib/UefiBootServicesTableLib.inf
+  UefiRuntimeServicesTableLib|MdePkg/Library/UefiRuntimeServicesTableLib/UefiRuntimeServicesTableLib.inf
+
+[Components]
+  MdeModulePkg/Application/HelloWorld/HelloWorld.inf
+'''
+
+def CanBuild():
+    if not Workspace or not os.path.isfile(os.path.join(Workspace, 'edksetup.sh')):
+        return False
+    for Path in os.environ.get('PATH', '').split(os.pathsep):
+        if os.path.isfile(os.path.join(Path, 'build')):
+            return True
+    return False
+
+@unittest.skipUnless(CanBuild(), 'requires a workspace set up by edksetup')
+class BuildHashCacheTests(unittest.TestCase):
+
+    def setUp(self):
+        if os.path.exists(TestDir):
+            shutil.rmtree(TestDir)
+        os.makedirs(TestDir)
+        Output = os.path.relpath(os.path.join(TestDir, 'Build'), Workspace)
+        self.DscFile = os.path.join(TestDir, 'BuildHashCache.dsc')
+        with open(self.DscFile, 'w') as File:
+            File.write(Dsc % {'Output': Output.replace(os.sep, '/')})
+        self.Efi = os.path.join(TestDir, 'Build', 'DEBUG_' + ToolChain, 'X64', 'MdeModulePkg', 'Application',
+                                'HelloWorld', 'HelloWorld', 'OUTPUT', 'HelloWorld.efi')
+
+    def tearDown(self):
+        shutil.rmtree(TestDir, ignore_errors=True)
+
+    def Build(self, *Targets):
+        Command = ['build', '-p', os.path.relpath(self.DscFile, Workspace), '-a', 'X64',
+                   '-b', 'DEBUG', '-t', ToolChain, '-n', '1', '--hash'] + list(Targets)
+        with open(os.devnull, 'w') as Null:
+            Status = subprocess.call(Command, cwd=Workspace, stdout=Null, stderr=Null)
+        self.assertEqual(Status, 0, ' '.join(Command) + ' failed')
+
+    def testCleanForcesRebuild(self):
+        self.Build()
+        self.assertTrue(os.path.isfile(self.Efi))
+
+        self.Build('clean')
+        self.assertFalse(os.path.isfile(self.Efi))
+
+        self.Build()
+        self.assertTrue(os.path.isfile(self.Efi), 'the module was skipped after clean')
+
+TheTestSuite = TestTools.MakeTheTestSuite(locals())
+
+if __name__ == '__main__':
+    allTests = TheTestSuite()
+    unittest.TextTestRunner().run(allTests)
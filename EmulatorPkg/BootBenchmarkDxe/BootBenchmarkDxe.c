@@ -0,0 +1,323 @@
+/*++ @file
+  Report the performance measurements of a boot of the emulator to the host.
+
+  At ReadyToBoot the measurements logged by the PEI and DXE performance
+  libraries are appended to the boot benchmark report of the host as one line
+  of JSON, and the emulator exits so the next boot of the benchmark can start.
+  Times are in nanoseconds since the host process started, so the time spent
+  by the host before SEC is part of the report. Nothing is done unless the host
+  was started for a boot benchmark, see EmulatorPkg/Unix/BootBenchmark.py.
+
+Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <PiDxe.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiDriverEntryPoint.h>
+#include <Library/EmuThunkLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/TimerLib.h>
+#include <Library/PrintLib.h>
+#include <Library/PeCoffGetEntryPointLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include <Protocol/LoadedImage.h>
+
+#define BENCHMARK_NAME_SIZE   64
+
+//
+// A line of the report holds three names and two 20 digit times, plus less
+// than 64 characters of JSON syntax, so it is never truncated.
+//
+#define BENCHMARK_LINE_SIZE   (3 * BENCHMARK_NAME_SIZE + 2 * 20 + 64)
+
+//
+// Performance counter and host time sampled at the same moment, used to map
+// the time stamps of the measurements into the lifetime of the host process.
+//
+UINT64    mFrequency;
+BOOLEAN   mCountUp;
+UINT64    mCounterNow;
+UINT64    mHostNow;
+
+
+/**
+  Convert a number of performance counter ticks into nanoseconds.
+
+  @param  Ticks   Number of ticks.
+
+  @return Ticks in nanoseconds.
+
+**/
+UINT64
+TicksToNanoSeconds (
+  IN  UINT64  Ticks
+  )
+{
+  UINT64  Remainder;
+  UINT64  Seconds;
+
+  Seconds = DivU64x64Remainder (Ticks, mFrequency, &Remainder);
+  return MultU64x32 (Seconds, 1000000000) +
+         DivU64x64Remainder (MultU64x32 (Remainder, 1000000000), mFrequency, NULL);
+}
+
+
+/**
+  Convert a time stamp of a measurement into the host time.
+
+  @param  TimeStamp   Performance counter value of the measurement, 1 for the
+                      start of the counter, 0 for not measured yet.
+
+  @return Nanoseconds since the host process started.
+
+**/
+UINT64
+TimeStampToHostTime (
+  IN  UINT64  TimeStamp
+  )
+{
+  UINT64  Ticks;
+
+  if (TimeStamp == 1) {
+    return 0;
+  }
+  if (TimeStamp == 0) {
+    return mHostNow;
+  }
+
+  Ticks = mCountUp ? mCounterNow - TimeStamp : TimeStamp - mCounterNow;
+  Ticks = TicksToNanoSeconds (Ticks);
+  return (Ticks < mHostNow) ? mHostNow - Ticks : 0;
+}
+
+
+/**
+  Copy an ASCII string into a buffer, replacing the characters that need to be
+  escaped in a JSON string.
+
+  @param  Destination   Buffer of BENCHMARK_NAME_SIZE characters.
+  @param  Source        String to copy, NULL for an empty string.
+
+**/
+VOID
+CopyJsonString (
+  OUT CHAR8        *Destination,
+  IN  CONST CHAR8  *Source
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Source != NULL && Source[Index] != '\0' && Index < BENCHMARK_NAME_SIZE - 1; Index++) {
+    if (Source[Index] < ' ' || Source[Index] > '~' || Source[Index] == '"' || Source[Index] == '\\') {
+      Destination[Index] = '_';
+    } else {
+      Destination[Index] = Source[Index];
+    }
+  }
+  Destination[Index] = '\0';
+}
+
+
+/**
+  Get the name of the measured component.
+
+  The handle of the entry of a PEIM is its FFS file, so it is named by the GUID
+  of the file. Other handles are named by the PDB file of their image, without
+  path and extension, as in the build output.
+
+  @param  Token     Token of the measurement.
+  @param  Handle    Handle of the measurement.
+  @param  Name      Buffer of BENCHMARK_NAME_SIZE characters for the name.
+
+**/
+VOID
+GetMeasurementName (
+  IN  CONST CHAR8  *Token,
+  IN  CONST VOID   *Handle,
+  OUT CHAR8        *Name
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_LOADED_IMAGE_PROTOCOL   *Image;
+  CHAR8                       *PdbFileName;
+  UINTN                       Start;
+  UINTN                       Index;
+
+  Name[0] = '\0';
+  if (Handle == NULL) {
+    return;
+  }
+
+  if (Token != NULL && AsciiStrCmp (Token, "PEIM") == 0) {
+    AsciiSPrint (Name, BENCHMARK_NAME_SIZE, "%g", Handle);
+    return;
+  }
+
+  Status = gBS->HandleProtocol ((EFI_HANDLE) Handle, &gEfiLoadedImageProtocolGuid, (VOID **) &Image);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  PdbFileName = PeCoffLoaderGetPdbPointer (Image->ImageBase);
+  if (PdbFileName == NULL) {
+    return;
+  }
+
+  Start = 0;
+  for (Index = 0; PdbFileName[Index] != '\0'; Index++) {
+    if (PdbFileName[Index] == '\\' || PdbFileName[Index] == '/') {
+      Start = Index + 1;
+    }
+  }
+
+  CopyJsonString (Name, PdbFileName + Start);
+  for (Index = 0; Name[Index] != '\0'; Index++) {
+    if (Name[Index] == '.') {
+      Name[Index] = '\0';
+      break;
+    }
+  }
+}
+
+
+/**
+  Append a string to the boot benchmark report of the host.
+
+  @param  String    String to append.
+
+  @return Status of the write.
+
+**/
+EFI_STATUS
+WriteReport (
+  IN  CONST CHAR8  *String
+  )
+{
+  return gEmuThunk->WriteBenchmarkReport ((UINT8 *) String, AsciiStrLen (String));
+}
+
+
+/**
+  Append the performance measurements to the boot benchmark report of the host,
+  then exit the emulator.
+
+  @param  Event     Event whose notification function is being invoked.
+  @param  Context   Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+OnReadyToBoot (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  EFI_STATUS    Status;
+  CHAR8         Line[BENCHMARK_LINE_SIZE];
+  CHAR8         TokenName[BENCHMARK_NAME_SIZE];
+  CHAR8         ModuleName[BENCHMARK_NAME_SIZE];
+  CHAR8         Name[BENCHMARK_NAME_SIZE];
+  UINTN         LogEntryKey;
+  CONST VOID    *Handle;
+  CONST CHAR8   *Token;
+  CONST CHAR8   *Module;
+  UINT64        StartTimeStamp;
+  UINT64        EndTimeStamp;
+  UINT32        Identifier;
+  UINT64        StartValue;
+  UINT64        EndValue;
+  UINTN         Count;
+
+  gBS->CloseEvent (Event);
+
+  mFrequency  = GetPerformanceCounterProperties (&StartValue, &EndValue);
+  mCountUp    = (BOOLEAN) (EndValue >= StartValue);
+  mCounterNow = GetPerformanceCounter ();
+  mHostNow    = gEmuThunk->GetHostElapsedTime ();
+  if (mFrequency == 0) {
+    return;
+  }
+
+  AsciiSPrint (Line, sizeof (Line), "{\"ReadyToBoot\":%ld,\"Gauges\":[", mHostNow);
+  Status = WriteReport (Line);
+  if (EFI_ERROR (Status)) {
+    //
+    // The host was not started for a boot benchmark.
+    //
+    return;
+  }
+
+  Count       = 0;
+  LogEntryKey = 0;
+  while ((LogEntryKey = GetPerformanceMeasurementEx (
+                          LogEntryKey,
+                          &Handle,
+                          &Token,
+                          &Module,
+                          &StartTimeStamp,
+                          &EndTimeStamp,
+                          &Identifier
+                          )) != 0) {
+    if (StartTimeStamp == 0) {
+      continue;
+    }
+
+    CopyJsonString (TokenName, Token);
+    CopyJsonString (ModuleName, Module);
+    GetMeasurementName (Token, Handle, Name);
+    AsciiSPrint (
+      Line,
+      sizeof (Line),
+      "%a{\"Token\":\"%a\",\"Module\":\"%a\",\"Name\":\"%a\",\"Start\":%ld,\"End\":%ld}",
+      (Count == 0) ? "" : ",",
+      TokenName,
+      ModuleName,
+      Name,
+      TimeStampToHostTime (StartTimeStamp),
+      TimeStampToHostTime (EndTimeStamp)
+      );
+    Status = WriteReport (Line);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Count++;
+  }
+
+  WriteReport ("]}\n");
+  gEmuThunk->Exit (0);
+}
+
+
+/**
+  Register the ReadyToBoot notification that reports the boot to the host.
+
+  @param  ImageHandle   The firmware allocated handle for the EFI image.
+  @param  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   The notification was registered.
+  @return Other         The notification could not be registered.
+
+**/
+EFI_STATUS
+EFIAPI
+InitializeBootBenchmark (
+  IN EFI_HANDLE           ImageHandle,
+  IN EFI_SYSTEM_TABLE     *SystemTable
+  )
+{
+  EFI_EVENT   Event;
+
+  return EfiCreateEventReadyToBootEx (TPL_CALLBACK, OnReadyToBoot, NULL, &Event);
+}
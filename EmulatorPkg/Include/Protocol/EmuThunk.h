@@ -214,6 +214,44 @@ EFI_STATUS
   OUT EMU_IO_THUNK_PROTOCOL   **Instance  OPTIONAL
   );
 
+/**
+  Return the wall clock time elapsed since the host process started.
+
+  The value is based on the same clock as QueryPerformanceCounter (), so the
+  difference of the two maps performance counter values into the lifetime of
+  the host process.
+
+  @return Time in nanoseconds since the host process started.
+
+**/
+typedef
+UINT64
+(EFIAPI *EMU_GET_HOST_ELAPSED_TIME) (
+  VOID
+  );
+
+/**
+  Append data to the boot benchmark report of the host.
+
+  The report is a file named by the EMU_BOOT_BENCHMARK environment variable of
+  the host process, it is used by EmulatorPkg/Unix/BootBenchmark.py to collect
+  the performance measurements of each boot.
+
+  @param  Buffer                Data to append to the report.
+  @param  NumberOfBytes         Number of bytes in Buffer.
+
+  @retval EFI_SUCCESS           The data was appended to the report.
+  @retval EFI_UNSUPPORTED       The host was not started for a boot benchmark.
+  @retval EFI_DEVICE_ERROR      The report could not be written.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EMU_WRITE_BENCHMARK_REPORT) (
+  IN UINT8     *Buffer,
+  IN UINTN     NumberOfBytes
+  );
+
 
 struct _EMU_THUNK_PROTOCOL {
   // Used for early debug printing
@@ -257,6 +295,12 @@ struct _EMU_THUNK_PROTOCOL {
   /// Generic System Services
   ///
   EMU_GET_NEXT_PROTOCOL             GetNextProtocol;
+
+  ///
+  /// Boot benchmark support
+  ///
+  EMU_GET_HOST_ELAPSED_TIME         GetHostElapsedTime;
+  EMU_WRITE_BENCHMARK_REPORT        WriteBenchmarkReport;
 };
 
 extern EFI_GUID gEmuThunkProtocolGuid;
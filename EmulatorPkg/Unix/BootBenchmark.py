@@ -0,0 +1,261 @@
+## @file
+#  Boot benchmark of the emulator
+#
+#  Boots the emulator headless a number of times and reports the time of each
+#  boot phase and driver, as measured by the PEI and DXE performance libraries,
+#  together with the wall clock time of the host process. The emulator must be
+#  built with -D BOOT_BENCHMARK so BootBenchmarkDxe reports each boot to the
+#  host and exits at ReadyToBoot. A report can be compared with a baseline to
+#  catch boot time regressions.
+#
+#  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+#
+#  This program and the accompanying materials are licensed and made
+#  available under the terms and conditions of the BSD License. The full text
+#  of the license may be found at http://opensource.org/licenses/bsd-license.php
+#
+#  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+
+from __future__ import print_function
+
+VersionNumber = '0.1'
+__copyright__ = "Copyright (c) 2016, Intel Corporation  All rights reserved."
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+REPORT_VERSION = 1
+
+#
+# Tokens of the measurements of a single driver, a gauge with any other token
+# and neither module nor name is a boot phase
+#
+DRIVER_TOKENS = ('PEIM', 'LoadImage:', 'StartImage:', 'DB:Support:',
+                 'DB:Start:')
+
+def ReadGuidXref(FileName):
+    """Map the upper case file GUIDs of Guid.xref to module names."""
+    Names = {}
+    if FileName and os.path.isfile(FileName):
+        with open(FileName) as File:
+            for Line in File:
+                Fields = Line.split()
+                if len(Fields) == 2:
+                    Names[Fields[0].upper()] = Fields[1]
+    return Names
+
+def RunBoot(Host, Timeout):
+    """Boot the emulator once, return its report and wall clock time in ms."""
+    Handle, ReportFile = tempfile.mkstemp(prefix='BootBenchmark')
+    os.close(Handle)
+    Environment = dict(os.environ)
+    Environment['EMU_BOOT_BENCHMARK'] = ReportFile
+    Environment.pop('DISPLAY', None)
+
+    try:
+        with open(os.devnull, 'r+') as Null:
+            Start = time.time()
+            Process = subprocess.Popen([Host], cwd=os.path.dirname(Host),
+                                       env=Environment, stdin=Null,
+                                       stdout=Null, stderr=Null)
+            Timer = threading.Timer(Timeout, Process.kill)
+            Timer.start()
+            Process.wait()
+            Timer.cancel()
+            WallClock = (time.time() - Start) * 1000.0
+
+        with open(ReportFile) as File:
+            Lines = File.read().splitlines()
+    finally:
+        os.remove(ReportFile)
+
+    if not Lines:
+        return None, WallClock
+    return json.loads(Lines[-1]), WallClock
+
+def AddSample(Samples, Key, Value):
+    Samples.setdefault(Key, []).append(Value)
+
+def CollectBoot(Report, WallClock, GuidNames, Phases, Drivers):
+    """Add the times of a boot in ms to the per phase and per driver samples."""
+    Gauges = Report['Gauges']
+    AddSample(Phases, 'Total', WallClock)
+    AddSample(Phases, 'ReadyToBoot', Report['ReadyToBoot'] / 1000000.0)
+    if Gauges:
+        AddSample(Phases, 'Host',
+                  min(Gauge['Start'] for Gauge in Gauges) / 1000000.0)
+
+    BootDrivers = {}
+    for Gauge in Gauges:
+        Duration = (Gauge['End'] - Gauge['Start']) / 1000000.0
+        if Gauge['Token'] in DRIVER_TOKENS:
+            Name = Gauge['Name']
+            if Gauge['Token'] == 'PEIM':
+                Name = GuidNames.get(Name.upper(), Name)
+            if Name:
+                Key = Gauge['Token'].rstrip(':') + ':' + Name
+                BootDrivers[Key] = BootDrivers.get(Key, 0.0) + Duration
+        elif not Gauge['Module'] and not Gauge['Name']:
+            AddSample(Phases, Gauge['Token'], Duration)
+
+    for Key in BootDrivers:
+        AddSample(Drivers, Key, BootDrivers[Key])
+
+def Percentile(Sorted, Percent):
+    """Percentile of sorted samples, interpolated between the closest ranks."""
+    Rank = (len(Sorted) - 1) * Percent / 100.0
+    Lower = int(Rank)
+    Upper = min(Lower + 1, len(Sorted) - 1)
+    return Sorted[Lower] + (Sorted[Upper] - Sorted[Lower]) * (Rank - Lower)
+
+def Statistics(Samples):
+    Sorted = sorted(Samples)
+    return {
+        'Count': len(Sorted),
+        'Min': round(Sorted[0], 3),
+        'Median': round(Percentile(Sorted, 50), 3),
+        'P90': round(Percentile(Sorted, 90), 3),
+        'Max': round(Sorted[-1], 3),
+        }
+
+def Benchmark(Args):
+    Host = os.path.abspath(os.path.join(Args.build_dir, 'Host'))
+    if not os.path.isfile(Host):
+        print('%s: emulator not found' % Host, file=sys.stderr)
+        return None
+    GuidXref = Args.guid_xref
+    if GuidXref is None:
+        GuidXref = os.path.join(Args.build_dir, '..', 'FV', 'Guid.xref')
+    GuidNames = ReadGuidXref(GuidXref)
+
+    Phases = {}
+    Drivers = {}
+    Failures = 0
+    for Index in range(Args.count):
+        Report, WallClock = RunBoot(Host, Args.timeout)
+        if Report is None:
+            Failures += 1
+            print('Boot %d: no report, is the emulator built with '
+                  '-D BOOT_BENCHMARK?' % (Index + 1), file=sys.stderr)
+            continue
+        CollectBoot(Report, WallClock, GuidNames, Phases, Drivers)
+        if not Args.quiet:
+            print('Boot %d: %.3f ms' % (Index + 1, WallClock))
+
+    if Failures == Args.count:
+        return None
+    return {
+        'Version': REPORT_VERSION,
+        'Boots': Args.count - Failures,
+        'Failures': Failures,
+        'Unit': 'ms',
+        'Phases': dict((Key, Statistics(Phases[Key])) for Key in Phases),
+        'Drivers': dict((Key, Statistics(Drivers[Key])) for Key in Drivers),
+        }
+
+def Compare(Report, Baseline, Threshold, MinimumDelta):
+    """Print the differences with a baseline, return the number of regressions."""
+    Regressions = 0
+    for Section in ('Phases', 'Drivers'):
+        Current = Report.get(Section, {})
+        Previous = Baseline.get(Section, {})
+        for Key in sorted(Current):
+            if Key not in Previous:
+                print('%-8s %-40s %10.3f ms  new' % (
+                      Section[:-1], Key, Current[Key]['Median']))
+                continue
+            Old = Previous[Key]['Median']
+            New = Current[Key]['Median']
+            Delta = New - Old
+            if abs(Delta) < MinimumDelta or abs(Delta) * 100.0 < Threshold * Old:
+                continue
+            if Delta > 0:
+                Regressions += 1
+                Change = 'REGRESSION'
+            else:
+                Change = 'improvement'
+            print('%-8s %-40s %10.3f ms -> %10.3f ms  %+.1f%%  %s' % (
+                  Section[:-1], Key, Old, New,
+                  (Delta * 100.0 / Old) if Old else 100.0, Change))
+        for Key in sorted(set(Previous) - set(Current)):
+            print('%-8s %-40s %10.3f ms  removed' % (
+                  Section[:-1], Key, Previous[Key]['Median']))
+    return Regressions
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Boot benchmark of the emulator',
+        prog='BootBenchmark',
+        usage='%(prog)s [options]')
+    parser.add_argument('--version', action='version',
+                        version='%(prog)s ' + VersionNumber)
+    parser.add_argument('-d', '--build-dir', default='.',
+                        help='Directory of the Host emulator, '
+                             'e.g. Build/Emulator/DEBUG_GCC48/X64')
+    parser.add_argument('-n', '--count', type=int, default=10,
+                        help='Number of boots (default: 10)')
+    parser.add_argument('-t', '--timeout', type=float, default=120,
+                        help='Time limit of a boot in seconds (default: 120)')
+    parser.add_argument('-g', '--guid-xref', metavar='FILE',
+                        help='Guid.xref of the build to name the PEIMs '
+                             '(default: BUILD_DIR/../FV/Guid.xref)')
+    parser.add_argument('-o', '--output', metavar='FILE',
+                        help='Write the JSON report to FILE '
+                             '(default: standard output)')
+    parser.add_argument('-i', '--input', metavar='FILE',
+                        help='Compare an existing report instead of booting')
+    parser.add_argument('-c', '--compare', metavar='BASELINE',
+                        help='Compare with the report BASELINE and fail when '
+                             'a median regressed')
+    parser.add_argument('--threshold', type=float, default=10,
+                        help='Change of a median in percent reported by the '
+                             'comparison (default: 10)')
+    parser.add_argument('--min-delta', type=float, default=1,
+                        help='Change of a median in ms below which the '
+                             'comparison ignores it (default: 1)')
+    parser.add_argument('-q', '--quiet', action='store_true',
+                        help='Do not print the time of each boot')
+    Args = parser.parse_args()
+
+    if Args.input:
+        if not Args.compare:
+            parser.error('--input requires --compare')
+        with open(Args.input) as File:
+            Report = json.load(File)
+    else:
+        if Args.count < 1:
+            parser.error('--count must be at least 1')
+        Report = Benchmark(Args)
+        if Report is None:
+            return 2
+        Text = json.dumps(Report, indent=2, sort_keys=True)
+        if Args.output:
+            with open(Args.output, 'w') as File:
+                File.write(Text + '\n')
+        elif not Args.compare:
+            print(Text)
+
+    if Args.compare:
+        with open(Args.compare) as File:
+            Baseline = json.load(File)
+        if Baseline.get('Version') != REPORT_VERSION:
+            print('%s: unsupported report version' % Args.compare,
+                  file=sys.stderr)
+            return 2
+        Regressions = Compare(Report, Baseline, Args.threshold,
+                              Args.min_delta)
+        print('%d regression(s) against %s' % (Regressions, Args.compare))
+        if Regressions:
+            return 1
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
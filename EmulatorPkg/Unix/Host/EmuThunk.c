@@ -40,6 +40,9 @@ void (*settimer_callback)(UINT64 delta);
 
 BOOLEAN gEmulatorInterruptEnabled = FALSE;
 
+UINT64  mHostStartTime;
+FILE    *mBenchmarkReport;
+
 
 UINTN
 SecWriteStdErr (
@@ -280,8 +283,11 @@ QueryPerformanceCounter (
 
   return (Start * sTimebaseInfo.numer) / sTimebaseInfo.denom;
 #else
-  // Need to figure out what to do for Linux?
-  return 0;
+  struct timespec  Now;
+
+  clock_gettime (CLOCK_MONOTONIC, &Now);
+
+  return MultU64x32 (Now.tv_sec, 1000000000) + Now.tv_nsec;
 #endif
 }
 
@@ -403,6 +409,44 @@ SecGetNextProtocol (
 }
 
 
+UINT64
+SecGetHostElapsedTime (
+  VOID
+  )
+{
+  return QueryPerformanceCounter () - mHostStartTime;
+}
+
+
+EFI_STATUS
+SecWriteBenchmarkReport (
+  IN UINT8     *Buffer,
+  IN UINTN     NumberOfBytes
+  )
+{
+  char  *FileName;
+
+  if (mBenchmarkReport == NULL) {
+    FileName = getenv ("EMU_BOOT_BENCHMARK");
+    if (FileName == NULL || *FileName == '\0') {
+      return EFI_UNSUPPORTED;
+    }
+
+    mBenchmarkReport = fopen (FileName, "a");
+    if (mBenchmarkReport == NULL) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  if (fwrite (Buffer, 1, (size_t)NumberOfBytes, mBenchmarkReport) != NumberOfBytes ||
+      fflush (mBenchmarkReport) != 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+
 EMU_THUNK_PROTOCOL gEmuThunkProtocol = {
   GasketSecWriteStdErr,
   GasketSecConfigStdIn,
@@ -425,7 +469,9 @@ EMU_THUNK_PROTOCOL gEmuThunkProtocol = {
   GasketSecGetTime,
   GasketSecSetTime,
   GasketSecSetTimer,
-  GasketSecGetNextProtocol
+  GasketSecGetNextProtocol,
+  GasketSecGetHostElapsedTime,
+  GasketSecWriteBenchmarkReport
 };
 
 
@@ -436,5 +482,8 @@ SecInitThunkProtocol (
 {
   // timezone and daylight lib globals depend on tzset be called 1st.
   tzset ();
+
+  // Start of the host process for GetHostElapsedTime ()
+  mHostStartTime = QueryPerformanceCounter ();
 }
 
@@ -161,6 +161,19 @@ GasketSecGetNextProtocol (
   OUT EMU_IO_THUNK_PROTOCOL   **Instance  OPTIONAL
   );
 
+UINT64
+EFIAPI
+GasketSecGetHostElapsedTime (
+  VOID
+  );
+
+EFI_STATUS
+EFIAPI
+GasketSecWriteBenchmarkReport (
+  IN UINT8     *Buffer,
+  IN UINTN     NumberOfBytes
+  );
+
 
 // PPIs produced by SEC
 
@@ -47,6 +47,7 @@ BUILD_OPTIONS=
 PLATFORMFILE=
 LAST_ARG=
 RUN_EMULATOR=no
+RUN_BENCHMARK=no
 CLEAN_TYPE=none
 TARGET_TOOLS=GCC44
 NETWORK_SUPPORT=
@@ -131,6 +132,11 @@ do
         shift
         break
         ;;
+      benchmark)
+        RUN_BENCHMARK=yes
+        shift
+        break
+        ;;
       clean|cleanall)
         CLEAN_TYPE=$arg
         shift
@@ -242,6 +248,15 @@ if [[ "$RUN_EMULATOR" == "yes" ]]; then
   exit
 fi
 
+if [[ "$RUN_BENCHMARK" == "yes" ]]; then
+  #
+  # Boot the emulator built with -D BOOT_BENCHMARK, the remaining arguments
+  # are passed to the benchmark script
+  #
+  python $WORKSPACE/EmulatorPkg/Unix/BootBenchmark.py -d $BUILD_ROOT_ARCH "$@"
+  exit $?
+fi
+
 case $CLEAN_TYPE in
   clean)
     build -p $WORKSPACE/EmulatorPkg/EmulatorPkg.dsc -a $PROCESSOR -b $BUILDTARGET -t $HOST_TOOLS -D UNIX_SEC_BUILD -n 3 clean
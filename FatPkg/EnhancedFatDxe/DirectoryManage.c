@@ -1402,6 +1402,11 @@ Returns:
     RemoveEntryList (&OFile->ChildLink);
   }
 
+  if (OFile->Extents != NULL) {
+    FreePool (OFile->Extents);
+  }
+
+  FatDiscardReadahead (OFile);
   FreePool (OFile);
   DirEnt->OFile = NULL;
   if (DirEnt->Invalid == TRUE) {
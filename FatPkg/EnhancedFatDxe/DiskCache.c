@@ -395,6 +395,17 @@ Returns:
 
     EntryPos    = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
     AlignedSize = AlignedPageCount << PageAlignment;
+    if (Task != NULL && IoMode == READ_DISK) {
+      //
+      // A non-blocking read completes after the Buffer could be updated with
+      // the dirty cache pages, so write them back to the disk first instead.
+      //
+      Status = FatWriteBackDataCache (Volume, EntryPos, AlignedSize);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
     Status      = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer, Task);
     if (EFI_ERROR (Status)) {
       return Status;
@@ -480,6 +491,60 @@ Returns:
   return Status;
 }
 
+EFI_STATUS
+FatWriteBackDataCache (
+  IN FAT_VOLUME         *Volume,
+  IN UINT64             Offset,
+  IN UINTN              BufferSize
+  )
+/*++
+
+Routine Description:
+
+  Write the dirty Data cache pages overlapping a range of the disk back to the
+  disk, so that a read of the range from the disk gets their contents.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Offset                - The starting byte offset of the range.
+  BufferSize            - Size of the range.
+
+Returns:
+
+  EFI_SUCCESS           - The dirty cache pages are written back successfully.
+  other                 - An error occurred when writing the data into the disk.
+
+--*/
+{
+  EFI_STATUS  Status;
+  UINTN       GroupIndex;
+  UINTN       StartPageNo;
+  UINTN       EndPageNo;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+
+  DiskCache = &Volume->DiskCache[CACHE_DATA];
+  if (!DiskCache->Dirty || BufferSize == 0 || Offset < DiskCache->BaseAddress) {
+    return EFI_SUCCESS;
+  }
+
+  StartPageNo = (UINTN) RShiftU64 (Offset - DiskCache->BaseAddress, DiskCache->PageAlignment);
+  EndPageNo   = (UINTN) RShiftU64 (Offset + BufferSize - 1 - DiskCache->BaseAddress, DiskCache->PageAlignment);
+  for (GroupIndex = 0; GroupIndex <= DiskCache->GroupMask; GroupIndex++) {
+    CacheTag = &DiskCache->CacheTag[GroupIndex];
+    if (CacheTag->RealSize > 0 && CacheTag->Dirty &&
+        CacheTag->PageNo >= StartPageNo && CacheTag->PageNo <= EndPageNo) {
+      Status = FatExchangeCachePage (Volume, CACHE_DATA, WRITE_DISK, CacheTag, NULL);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS
 FatInitializeDiskCache (
   IN FAT_VOLUME         *Volume
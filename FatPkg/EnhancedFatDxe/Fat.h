@@ -58,6 +58,7 @@ Revision History
 #define FAT_OFILE_SIGNATURE          SIGNATURE_32 ('f', 'a', 't', 'o')
 #define FAT_TASK_SIGNATURE           SIGNATURE_32 ('f', 'a', 't', 'T')
 #define FAT_SUBTASK_SIGNATURE        SIGNATURE_32 ('f', 'a', 't', 'S')
+#define FAT_READAHEAD_SIGNATURE      SIGNATURE_32 ('f', 'a', 't', 'R')
 
 #define ASSERT_VOLUME_LOCKED(a)      ASSERT_LOCKED (&FatFsLock)
 
@@ -124,6 +125,18 @@ Revision History
 #define FAT_MAX_DIRENTRY_COUNT  0xFFFF
 typedef CHAR8                   LC_ISO_639_2;
 
+//
+// Bytes of the FAT read at a time to build the free cluster bitmap,
+// and FAT entries written at a time to link a run of clusters
+//
+#define FAT_FREE_BITMAP_READ_SIZE  0x4000
+#define FAT_CLUSTER_RUN_ENTRIES    128
+
+//
+// Bytes read ahead of a file read sequentially
+//
+#define FAT_READAHEAD_SIZE         0x40000
+
 //
 // The fat types we support
 //
@@ -224,6 +237,7 @@ typedef struct {
   UINTN               Signature;
   EFI_FILE_IO_TOKEN   *FileIoToken;
   FAT_IFILE           *IFile;
+  BOOLEAN             Queuing;                // Set while the subtasks are submitted
   LIST_ENTRY          Subtasks;               // List of all FAT_SUBTASKs
   LIST_ENTRY          Link;                   // Link to other FAT_TASKs
 } FAT_TASK;
@@ -237,8 +251,33 @@ typedef struct {
   VOID                *Buffer;
   UINTN               BufferSize;
   LIST_ENTRY          Link;
+  struct _FAT_READAHEAD *Readahead;           // The readahead holding the data, if any
+  LIST_ENTRY          ReadaheadLink;          // Link to other FAT_SUBTASKs waiting for it
 } FAT_SUBTASK;
 
+//
+// Data of a file read from the disk ahead of a sequential reader
+//
+typedef struct _FAT_READAHEAD {
+  UINTN               Signature;
+  EFI_DISK_IO2_TOKEN  DiskIo2Token;
+  BOOLEAN             Pending;                // The read has not completed yet
+  BOOLEAN             Discarded;              // Free the readahead when the read completes
+  UINT64              Offset;                 // Disk position of the data
+  UINTN               BufferSize;
+  UINT8               *Buffer;
+  LIST_ENTRY          Waiters;                // List of the FAT_SUBTASKs waiting for the data
+} FAT_READAHEAD;
+
+//
+// FAT_EXTENT - A run of consecutive clusters of a file
+//
+typedef struct {
+  UINTN               Offset;   // Index of the first cluster of the run in the file
+  UINTN               Cluster;  // First cluster of the run
+  UINTN               Length;   // Number of clusters of the run
+} FAT_EXTENT;
+
 //
 // FAT_OFILE - Each opened file
 //
@@ -262,6 +301,21 @@ typedef struct _FAT_OFILE {
   UINTN               FileCluster;
   UINTN               FileCurrentCluster;
   UINTN               FileLastCluster;
+  //
+  // The runs of consecutive clusters of the file, mapped on demand from
+  // the start of the cluster chain and kept in step when the file grows
+  // or shrinks
+  //
+  FAT_EXTENT          *Extents;
+  UINTN               ExtentCount;    // Number of runs in Extents
+  UINTN               ExtentMax;      // Number of runs Extents can hold
+  UINTN               ExtentClusters; // Number of clusters mapped by the runs
+  UINTN               ExtentNext;     // Cluster following the mapped ones
+  //
+  // The data read ahead of a sequential reader of the file
+  //
+  FAT_READAHEAD       *Readahead;
+  UINTN               NextReadPosition; // Position following the last read
 
   //
   // Dirty is set if there have been any updates to the
@@ -345,6 +399,8 @@ typedef struct _FAT_VOLUME {
   FAT_INFO_SECTOR                 FatInfoSector;  // Free cluster info
   UINTN                           FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                         FreeInfoValid;  // If free cluster info is valid
+  UINT8                           *FreeBitmap;    // A bit set for each free cluster, built on first allocation
+  BOOLEAN                         FreeBitmapFailed; // If building the bitmap failed, the FAT is scanned instead
   //
   // Unpacked Fat BPB info
   //
@@ -808,6 +864,13 @@ FatVolumeFlushCache (
   IN FAT_TASK                *Task
   );
 
+EFI_STATUS
+FatWriteBackDataCache (
+  IN FAT_VOLUME              *Volume,
+  IN UINT64                  Offset,
+  IN UINTN                   BufferSize
+  );
+
 //
 // Flush.c
 //
@@ -918,6 +981,15 @@ FatWaitNonblockingTask (
   FAT_IFILE           *IFile
   );
 
+FAT_SUBTASK *
+FatCreateSubtask (
+  IN FAT_TASK         *Task,
+  IN BOOLEAN          Write,
+  IN UINT64           Offset,
+  IN VOID             *Buffer,
+  IN UINTN            BufferSize
+  );
+
 LIST_ENTRY *
 FatDestroySubtask (
   FAT_SUBTASK         *Subtask
@@ -1184,6 +1256,33 @@ FatSetVolumeEntry (
   IN CHAR16             *Name
   );
 
+//
+// ReadAhead.c
+//
+VOID
+FatStartReadahead (
+  IN FAT_OFILE          *OFile,
+  IN UINTN              Position
+  );
+
+VOID
+FatDiscardReadahead (
+  IN FAT_OFILE          *OFile
+  );
+
+BOOLEAN
+FatReadFromReadahead (
+  IN     FAT_OFILE      *OFile,
+  IN OUT UINTN          *Length,
+  OUT    UINT8          *Buffer,
+  IN     FAT_TASK       *Task
+  );
+
+EFI_STATUS
+FatQueueReadaheadSubtask (
+  IN FAT_SUBTASK        *Subtask
+  );
+
 //
 // Hash.c
 //
@@ -24,6 +24,12 @@ Revision History
 
 #include "Fat.h"
 
+//
+// Access the bit of a cluster in the free cluster bitmap of the volume
+//
+#define FAT_FREE_BITMAP_TEST(Bitmap, Index)   (((Bitmap)[(Index) / 8] & (1 << ((Index) % 8))) != 0)
+#define FAT_FREE_BITMAP_SET(Bitmap, Index)    ((Bitmap)[(Index) / 8] |= (UINT8) (1 << ((Index) % 8)))
+#define FAT_FREE_BITMAP_CLEAR(Bitmap, Index)  ((Bitmap)[(Index) / 8] &= (UINT8) ~(1 << ((Index) % 8)))
 
 STATIC
 VOID *
@@ -192,10 +198,16 @@ Returns:
     if (Index < Volume->FatInfoSector.FreeInfo.NextCluster) {
       Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
     }
+    if (Volume->FreeBitmap != NULL && Index <= Volume->MaxCluster + 1) {
+      FAT_FREE_BITMAP_SET (Volume->FreeBitmap, Index);
+    }
   } else if (Value != FAT_CLUSTER_FREE && OriginalVal == FAT_CLUSTER_FREE) {
     if (Volume->FatInfoSector.FreeInfo.ClusterCount != 0) {
       Volume->FatInfoSector.FreeInfo.ClusterCount -= 1;
     }
+    if (Volume->FreeBitmap != NULL && Index <= Volume->MaxCluster + 1) {
+      FAT_FREE_BITMAP_CLEAR (Volume->FreeBitmap, Index);
+    }
   }
   //
   // Make sure the entry is in memory
@@ -354,6 +366,373 @@ Returns:
   return Cluster;
 }
 
+STATIC
+EFI_STATUS
+FatBuildFreeBitmap (
+  IN FAT_VOLUME   *Volume
+  )
+/*++
+
+Routine Description:
+
+  Build the bitmap of the free clusters of the volume with a single pass
+  over the FAT, and recompute the free cluster info from it. The bitmap is
+  kept up to date by FatSetFatEntry () afterwards, so the free cluster info
+  stays valid and free clusters can be found without reading the FAT.
+  A failure is remembered, so the bitmap is not built again on every
+  allocation and the callers keep scanning the FAT.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+
+Returns:
+
+  EFI_SUCCESS           - The bitmap is built.
+  EFI_ABORTED           - Building the bitmap failed before.
+  EFI_OUT_OF_RESOURCES  - Can not allocate the bitmap.
+  other                 - An error occurred when reading the FAT.
+
+--*/
+{
+  UINT8       *Bitmap;
+  VOID        *Buffer;
+  UINTN       EntrySize;
+  UINTN       First;
+  UINTN       Count;
+  UINTN       Index;
+  UINTN       Entry;
+  UINTN       FreeCount;
+  UINTN       NextFree;
+  EFI_STATUS  Status;
+
+  if (Volume->FreeBitmapFailed) {
+    return EFI_ABORTED;
+  }
+
+  Bitmap = AllocateZeroPool ((Volume->MaxCluster + 2 + 7) / 8);
+  if (Bitmap == NULL) {
+    Volume->FreeBitmapFailed = TRUE;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  FreeCount = 0;
+  NextFree  = 0;
+  Status    = EFI_SUCCESS;
+  if (Volume->FatType == FAT12) {
+    //
+    // FAT12 entries straddle bytes, and the whole FAT is at most 6KB
+    //
+    for (Index = FAT_MIN_CLUSTER; Index <= Volume->MaxCluster + 1; Index++) {
+      if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
+        FAT_FREE_BITMAP_SET (Bitmap, Index);
+        FreeCount += 1;
+        if (NextFree == 0) {
+          NextFree = Index;
+        }
+      }
+    }
+
+    if (Volume->DiskError) {
+      Status = EFI_DEVICE_ERROR;
+    }
+  } else {
+    //
+    // Read the FAT in large pieces through the FAT cache
+    //
+    Buffer = AllocatePool (FAT_FREE_BITMAP_READ_SIZE);
+    if (Buffer == NULL) {
+      FreePool (Bitmap);
+      Volume->FreeBitmapFailed = TRUE;
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    EntrySize = (Volume->FatType == FAT16) ? sizeof (UINT16) : sizeof (UINT32);
+    for (First = 0; First <= Volume->MaxCluster + 1; First += Count) {
+      Count   = MIN (FAT_FREE_BITMAP_READ_SIZE / EntrySize, Volume->MaxCluster + 2 - First);
+      Status  = FatDiskIo (Volume, READ_FAT, Volume->FatPos + First * EntrySize, Count * EntrySize, Buffer, NULL);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      for (Index = 0; Index < Count; Index++) {
+        if (Volume->FatType == FAT16) {
+          Entry = ((UINT16 *) Buffer)[Index];
+        } else {
+          Entry = ((UINT32 *) Buffer)[Index] & FAT_CLUSTER_MASK_FAT32;
+        }
+
+        if (Entry == FAT_CLUSTER_FREE && First + Index >= FAT_MIN_CLUSTER) {
+          FAT_FREE_BITMAP_SET (Bitmap, First + Index);
+          FreeCount += 1;
+          if (NextFree == 0) {
+            NextFree = First + Index;
+          }
+        }
+      }
+    }
+
+    FreePool (Buffer);
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Bitmap);
+    Volume->FreeBitmapFailed = TRUE;
+    return Status;
+  }
+
+  Volume->FreeBitmap                          = Bitmap;
+  Volume->FreeInfoValid                       = TRUE;
+  Volume->FatInfoSector.FreeInfo.ClusterCount = (UINT32) FreeCount;
+  if (NextFree != 0) {
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) NextFree;
+  }
+
+  Volume->FatInfoSector.Signature           = FAT_INFO_SIGNATURE;
+  Volume->FatInfoSector.InfoBeginSignature  = FAT_INFO_BEGIN_SIGNATURE;
+  Volume->FatInfoSector.InfoEndSignature    = FAT_INFO_END_SIGNATURE;
+  return EFI_SUCCESS;
+}
+
+STATIC
+UINTN
+FatFindFreeCluster (
+  IN FAT_VOLUME   *Volume,
+  IN UINTN        Start
+  )
+/*++
+
+Routine Description:
+
+  Find the first free cluster at or after Start in the free cluster bitmap,
+  wrapping around to the beginning of the volume once.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Start                 - The cluster to start the search at.
+
+Returns:
+
+  The index of the free cluster, or FAT_CLUSTER_LAST if the volume is full.
+
+--*/
+{
+  UINTN Index;
+  UINTN End;
+  UINTN Pass;
+
+  if (Volume->FatInfoSector.FreeInfo.ClusterCount == 0) {
+    return (UINTN) FAT_CLUSTER_LAST;
+  }
+
+  End = Volume->MaxCluster + 2;
+  if (Start < FAT_MIN_CLUSTER || Start >= End) {
+    Start = FAT_MIN_CLUSTER;
+  }
+
+  for (Pass = 0; Pass < 2; Pass++) {
+    Index = Start;
+    while (Index < End) {
+      //
+      // Skip eight allocated clusters at a time
+      //
+      if ((Index % 8) == 0 && Volume->FreeBitmap[Index / 8] == 0) {
+        Index += 8;
+        continue;
+      }
+
+      if (FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Index)) {
+        return Index;
+      }
+
+      Index++;
+    }
+
+    End   = Start;
+    Start = FAT_MIN_CLUSTER;
+  }
+
+  return (UINTN) FAT_CLUSTER_LAST;
+}
+
+STATIC
+UINTN
+FatAllocateClusters (
+  IN  FAT_VOLUME  *Volume,
+  IN  UINTN       Preferred,
+  IN  UINTN       Count,
+  OUT UINTN       *RunLength
+  )
+/*++
+
+Routine Description:
+
+  Allocate a run of up to Count consecutive free clusters. The run starts at
+  the Preferred cluster if it is free, so a growing file stays contiguous,
+  and at the first free cluster from the free cluster hint otherwise.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Preferred             - The cluster the run should preferably start at, or 0.
+  Count                 - The number of clusters wanted.
+  RunLength             - The number of consecutive clusters allocated.
+
+Returns:
+
+  The index of the first cluster of the run, or FAT_CLUSTER_LAST if the
+  volume is full.
+
+--*/
+{
+  UINTN Cluster;
+  UINTN Run;
+
+  *RunLength = 1;
+  if (Volume->DiskError) {
+    return (UINTN) FAT_CLUSTER_LAST;
+  }
+  //
+  // Without the free cluster bitmap, allocate a cluster at a time
+  //
+  if (Volume->FreeBitmap == NULL && EFI_ERROR (FatBuildFreeBitmap (Volume))) {
+    return FatAllocateCluster (Volume);
+  }
+
+  if (Preferred >= FAT_MIN_CLUSTER && Preferred <= Volume->MaxCluster + 1 &&
+      FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Preferred)) {
+    Cluster = Preferred;
+  } else {
+    Cluster = FatFindFreeCluster (Volume, Volume->FatInfoSector.FreeInfo.NextCluster);
+    if (Cluster == (UINTN) FAT_CLUSTER_LAST) {
+      return Cluster;
+    }
+    //
+    // All the clusters from the hint up to this one are in use
+    //
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Cluster;
+  }
+
+  for (Run = 1; Run < Count; Run++) {
+    if (Cluster + Run > Volume->MaxCluster + 1 || !FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Cluster + Run)) {
+      break;
+    }
+  }
+
+  if (Cluster == Volume->FatInfoSector.FreeInfo.NextCluster) {
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) (Cluster + Run);
+  }
+
+  *RunLength = Run;
+  return Cluster;
+}
+
+STATIC
+EFI_STATUS
+FatSetClusterRun (
+  IN FAT_VOLUME   *Volume,
+  IN UINTN        Cluster,
+  IN UINTN        Count
+  )
+/*++
+
+Routine Description:
+
+  Chain a run of free consecutive clusters together and terminate the chain
+  at its last cluster. The FAT16 and FAT32 entries of the run are updated
+  through the FAT cache a block at a time, instead of one by one. If an error
+  occurs, the clusters chained so far are terminated at the last of them, so
+  that they can be freed as a chain.
+
+Arguments:
+
+  Volume                - FAT file system volume.
+  Cluster               - The first cluster of the run.
+  Count                 - The number of clusters of the run.
+
+Returns:
+
+  EFI_SUCCESS           - The run is chained successfully.
+  other                 - An error occurred when updating the FAT entries.
+
+--*/
+{
+  UINT32      Buffer[FAT_CLUSTER_RUN_ENTRIES];
+  UINTN       First;
+  UINT64      Pos;
+  UINTN       EntrySize;
+  UINTN       Chunk;
+  UINTN       Index;
+  UINTN       Next;
+  EFI_STATUS  Status;
+
+  if (Volume->FatType == FAT12 || Volume->FreeBitmap == NULL) {
+    for (Index = 0; Index < Count; Index++) {
+      Next    = (Index + 1 < Count) ? Cluster + Index + 1 : (UINTN) FAT_CLUSTER_LAST;
+      Status  = FatSetFatEntry (Volume, Cluster + Index, Next);
+      if (EFI_ERROR (Status)) {
+        if (Index != 0) {
+          FatSetFatEntry (Volume, Cluster + Index - 1, FAT_CLUSTER_LAST);
+        }
+
+        return Status;
+      }
+    }
+
+    return EFI_SUCCESS;
+  }
+  //
+  // If the volume's dirty bit is not set, set it now
+  //
+  if (!Volume->FatDirty) {
+    Volume->FatDirty = TRUE;
+    FatAccessVolumeDirty (Volume, WRITE_FAT, &Volume->DirtyValue);
+  }
+
+  EntrySize = (Volume->FatType == FAT16) ? sizeof (UINT16) : sizeof (UINT32);
+  First     = Cluster;
+  while (Count > 0) {
+    Chunk   = MIN (Count, FAT_CLUSTER_RUN_ENTRIES);
+    Pos     = Volume->FatPos + Cluster * EntrySize;
+    Status  = FatDiskIo (Volume, READ_FAT, Pos, Chunk * EntrySize, Buffer, NULL);
+    if (EFI_ERROR (Status)) {
+      goto Error;
+    }
+
+    for (Index = 0; Index < Chunk; Index++) {
+      Next = (Index + 1 < Count) ? Cluster + Index + 1 : (UINTN) FAT_CLUSTER_LAST;
+      if (Volume->FatType == FAT16) {
+        ((UINT16 *) Buffer)[Index] = (UINT16) Next;
+      } else {
+        Buffer[Index] = (Buffer[Index] & FAT_CLUSTER_UNMASK_FAT32) | (UINT32) (Next & FAT_CLUSTER_MASK_FAT32);
+      }
+    }
+
+    Status = FatDiskIo (Volume, WRITE_FAT, Pos, Chunk * EntrySize, Buffer, NULL);
+    if (EFI_ERROR (Status)) {
+      goto Error;
+    }
+
+    for (Index = 0; Index < Chunk; Index++) {
+      FAT_FREE_BITMAP_CLEAR (Volume->FreeBitmap, Cluster + Index);
+    }
+
+    Volume->FatInfoSector.FreeInfo.ClusterCount -= (UINT32) MIN (Chunk, Volume->FatInfoSector.FreeInfo.ClusterCount);
+    Cluster += Chunk;
+    Count   -= Chunk;
+  }
+
+  return EFI_SUCCESS;
+
+Error:
+  if (Cluster != First) {
+    FatSetFatEntry (Volume, Cluster - 1, FAT_CLUSTER_LAST);
+  }
+
+  return Status;
+}
+
 STATIC
 UINTN
 FatSizeToClusters (
@@ -387,6 +766,203 @@ Returns:
   return Clusters;
 }
 
+STATIC
+VOID
+FatCheckExtents (
+  IN FAT_OFILE            *OFile
+  )
+/*++
+
+Routine Description:
+
+  Discard the extent list of the open file if it no longer starts at the
+  first cluster of the file.
+
+Arguments:
+
+  OFile                 - The open file.
+
+Returns:
+
+  None.
+
+--*/
+{
+  if (OFile->ExtentCount != 0) {
+    if (OFile->Extents[0].Cluster == OFile->FileCluster) {
+      return;
+    }
+  } else if (OFile->ExtentNext == OFile->FileCluster) {
+    return;
+  }
+
+  OFile->ExtentCount    = 0;
+  OFile->ExtentClusters = 0;
+  OFile->ExtentNext     = OFile->FileCluster;
+}
+
+STATIC
+EFI_STATUS
+FatAddExtent (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                Cluster,
+  IN UINTN                Length
+  )
+/*++
+
+Routine Description:
+
+  Append a run of consecutive clusters to the extent list of the open file,
+  merging it with the last run if they are contiguous.
+
+Arguments:
+
+  OFile                 - The open file.
+  Cluster               - The first cluster of the run.
+  Length                - The number of clusters of the run.
+
+Returns:
+
+  EFI_SUCCESS           - The run is appended.
+  EFI_OUT_OF_RESOURCES  - Can not grow the extent list.
+
+--*/
+{
+  FAT_EXTENT  *Extent;
+  FAT_EXTENT  *Extents;
+  UINTN       ExtentMax;
+
+  if (OFile->ExtentCount != 0) {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    if (Extent->Cluster + Extent->Length == Cluster) {
+      Extent->Length        += Length;
+      OFile->ExtentClusters += Length;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (OFile->ExtentCount == OFile->ExtentMax) {
+    ExtentMax = (OFile->ExtentMax == 0) ? 8 : OFile->ExtentMax * 2;
+    Extents   = ReallocatePool (
+                  OFile->ExtentMax * sizeof (FAT_EXTENT),
+                  ExtentMax * sizeof (FAT_EXTENT),
+                  OFile->Extents
+                  );
+    if (Extents == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    OFile->Extents    = Extents;
+    OFile->ExtentMax  = ExtentMax;
+  }
+
+  Extent                = &OFile->Extents[OFile->ExtentCount];
+  Extent->Offset        = OFile->ExtentClusters;
+  Extent->Cluster       = Cluster;
+  Extent->Length        = Length;
+  OFile->ExtentCount   += 1;
+  OFile->ExtentClusters += Length;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+FatMapClusters (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                Count
+  )
+/*++
+
+Routine Description:
+
+  Run the cluster chain of the open file from the end of its extent list,
+  until the list maps the first Count clusters of the file or the end of
+  the chain is reached.
+
+Arguments:
+
+  OFile                 - The open file.
+  Count                 - The number of clusters to map.
+
+Returns:
+
+  EFI_SUCCESS           - The clusters are mapped.
+  EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+  EFI_OUT_OF_RESOURCES  - Can not grow the extent list.
+
+--*/
+{
+  FAT_VOLUME  *Volume;
+  UINTN       Cluster;
+  EFI_STATUS  Status;
+
+  Volume = OFile->Volume;
+  while (OFile->ExtentClusters < Count) {
+    Cluster = OFile->ExtentNext;
+    if (FAT_END_OF_FAT_CHAIN (Cluster) || (Cluster == FAT_CLUSTER_FREE && OFile->ExtentCount == 0)) {
+      break;
+    }
+
+    if (Cluster < FAT_MIN_CLUSTER || Cluster > Volume->MaxCluster + 1 || OFile->ExtentClusters > Volume->MaxCluster) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatMapClusters: cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Status = FatAddExtent (OFile, Cluster, 1);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    OFile->ExtentNext = FatGetFatEntry (Volume, Cluster);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FatTrimExtents (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                Count
+  )
+/*++
+
+Routine Description:
+
+  Cut the extent list of the open file after its first Count clusters,
+  once the rest of the cluster chain has been released.
+
+Arguments:
+
+  OFile                 - The open file.
+  Count                 - The number of clusters left in the file.
+
+Returns:
+
+  None.
+
+--*/
+{
+  FAT_EXTENT  *Extent;
+
+  FatCheckExtents (OFile);
+  if (OFile->ExtentClusters < Count) {
+    return;
+  }
+
+  while (OFile->ExtentCount != 0 && OFile->Extents[OFile->ExtentCount - 1].Offset >= Count) {
+    OFile->ExtentCount -= 1;
+  }
+
+  if (OFile->ExtentCount != 0) {
+    Extent          = &OFile->Extents[OFile->ExtentCount - 1];
+    Extent->Length  = MIN (Extent->Length, Count - Extent->Offset);
+  }
+
+  OFile->ExtentClusters = Count;
+  OFile->ExtentNext     = (OFile->ExtentCount == 0) ? OFile->FileCluster : (UINTN) FAT_CLUSTER_LAST;
+}
+
 EFI_STATUS
 FatShrinkEof (
   IN FAT_OFILE            *OFile
@@ -417,6 +993,7 @@ Returns:
   Volume  = OFile->Volume;
   ASSERT_VOLUME_LOCKED (Volume);
 
+  FatDiscardReadahead (OFile);
   NewSize = FatSizeToClusters (Volume, OFile->FileSize);
 
   //
@@ -459,6 +1036,7 @@ Returns:
   OFile->FileCurrentCluster = OFile->FileCluster;
   OFile->FileLastCluster    = LastCluster;
   OFile->Dirty              = TRUE;
+  FatTrimExtents (OFile, NewSize);
   //
   // Free the remaining cluster chain
   //
@@ -497,6 +1075,7 @@ Returns:
   UINTN       NewSize;
   UINTN       LastCluster;
   UINTN       NewCluster;
+  UINTN       RunLength;
   UINTN       ClusterCount;
 
   //
@@ -552,18 +1131,45 @@ Returns:
     // Loop until we've allocated enough space
     //
     LastCluster = OFile->FileLastCluster;
+    FatCheckExtents (OFile);
 
     while (CurSize < NewSize) {
-      NewCluster = FatAllocateCluster (Volume);
+      //
+      // Allocate a run of clusters, continuing the file's last one if possible
+      //
+      NewCluster = FatAllocateClusters (
+                     Volume,
+                     (LastCluster != 0) ? LastCluster + 1 : 0,
+                     NewSize - CurSize,
+                     &RunLength
+                     );
       if (FAT_END_OF_FAT_CHAIN (NewCluster)) {
         if (LastCluster != FAT_CLUSTER_FREE) {
-          FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
           OFile->FileLastCluster = LastCluster;
         }
 
         Status = EFI_VOLUME_FULL;
         goto Done;
       }
+      //
+      // The run is chained and terminated before it is linked to the file,
+      // so the cluster list is always complete
+      //
+      Status = FatSetClusterRun (Volume, NewCluster, RunLength);
+      if (EFI_ERROR (Status)) {
+        //
+        // The clusters chained before the error are not linked to the file
+        //
+        if (FatGetFatEntry (Volume, NewCluster) != FAT_CLUSTER_FREE) {
+          FatFreeClusters (Volume, NewCluster);
+        }
+
+        if (LastCluster != FAT_CLUSTER_FREE) {
+          OFile->FileLastCluster = LastCluster;
+        }
+
+        goto Done;
+      }
 
       if (LastCluster != 0) {
         FatSetFatEntry (Volume, LastCluster, NewCluster);
@@ -571,14 +1177,26 @@ Returns:
         OFile->FileCluster        = NewCluster;
         OFile->FileCurrentCluster = NewCluster;
       }
+      //
+      // Keep the extent list in step if it maps the whole cluster chain
+      //
+      if (FAT_END_OF_FAT_CHAIN (OFile->ExtentNext) || OFile->ExtentNext == FAT_CLUSTER_FREE) {
+        if (EFI_ERROR (FatAddExtent (OFile, NewCluster, RunLength))) {
+          //
+          // Map the cluster chain again from its start when needed
+          //
+          OFile->ExtentCount    = 0;
+          OFile->ExtentClusters = 0;
+          OFile->ExtentNext     = OFile->FileCluster;
+        } else {
+          OFile->ExtentNext     = (UINTN) FAT_CLUSTER_LAST;
+        }
+      }
 
-      LastCluster = NewCluster;
-      CurSize += 1;
+      LastCluster = NewCluster + RunLength - 1;
+      CurSize += RunLength;
     }
-    //
-    // Terminate the cluster list
-    //
-    FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
+
     OFile->FileLastCluster = LastCluster;
   }
 
@@ -591,6 +1209,189 @@ Done:
   return Status;
 }
 
+STATIC
+EFI_STATUS
+FatWalkClusterChain (
+  IN  FAT_OFILE           *OFile,
+  IN  UINTN               Position,
+  IN  UINTN               PosLimit,
+  OUT UINTN               *Run
+  )
+/*++
+
+Routine Description:
+
+  Seek OFile to requested position by running its cluster chain, and
+  calculate the number of consecutive bytes from the position in the file.
+
+Arguments:
+
+  OFile                 - The open file.
+  Position              - The file's position which will be accessed.
+  PosLimit              - The maximum length current reading/writing may access
+  Run                   - The number of consecutive bytes from the position.
+
+Returns:
+
+  EFI_SUCCESS           - Set the info successfully.
+  EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+
+--*/
+{
+  FAT_VOLUME  *Volume;
+  UINTN       ClusterSize;
+  UINTN       Cluster;
+  UINTN       StartPos;
+
+  Volume      = OFile->Volume;
+  ClusterSize = Volume->ClusterSize;
+
+  //
+  // Run the file's cluster chain to find the current position
+  // If possible, run from the current cluster rather than
+  // start from beginning
+  // Assumption: OFile->Position is always consistent with
+  // OFile->FileCurrentCluster.
+  // OFile->Position is not modified outside this function;
+  // OFile->FileCurrentCluster is modified outside this function
+  // to be the same as OFile->FileCluster
+  // when OFile->FileCluster is updated, so make a check of this
+  // and invalidate the original OFile->Position in this case
+  //
+  Cluster     = OFile->FileCurrentCluster;
+  StartPos    = OFile->Position;
+  if (Position < StartPos || OFile->FileCluster == Cluster) {
+    StartPos  = 0;
+    Cluster   = OFile->FileCluster;
+  }
+
+  while (StartPos + ClusterSize <= Position) {
+    StartPos += ClusterSize;
+    if (Cluster == FAT_CLUSTER_FREE || (Cluster >= FAT_CLUSTER_SPECIAL)) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Cluster = FatGetFatEntry (Volume, Cluster);
+  }
+
+  if (Cluster < FAT_MIN_CLUSTER) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  OFile->PosDisk            = Volume->FirstClusterPos +
+                              LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
+                              Position - StartPos;
+  OFile->FileCurrentCluster = Cluster;
+  OFile->Position           = StartPos;
+
+  //
+  // Compute the number of consecutive clusters in the file
+  //
+  *Run = StartPos + ClusterSize - Position;
+  if (!FAT_END_OF_FAT_CHAIN (Cluster)) {
+    while ((FatGetFatEntry (Volume, Cluster) == Cluster + 1) && *Run < PosLimit) {
+      *Run    += ClusterSize;
+      Cluster += 1;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+FatLocateExtent (
+  IN  FAT_OFILE           *OFile,
+  IN  UINTN               Position,
+  IN  UINTN               PosLimit,
+  OUT UINTN               *Run
+  )
+/*++
+
+Routine Description:
+
+  Seek OFile to requested position with a binary search of its extent list,
+  mapping the clusters the access needs first, and calculate the number of
+  consecutive bytes from the position in the file.
+
+Arguments:
+
+  OFile                 - The open file.
+  Position              - The file's position which will be accessed.
+  PosLimit              - The maximum length current reading/writing may access
+  Run                   - The number of consecutive bytes from the position.
+
+Returns:
+
+  EFI_SUCCESS           - Set the info successfully.
+  EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+  EFI_OUT_OF_RESOURCES  - Can not grow the extent list.
+
+--*/
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  UINTN       ClusterSize;
+  UINTN       ClusterIndex;
+  UINTN       Cluster;
+  UINTN       StartPos;
+  UINTN       Remaining;
+  UINTN       Low;
+  UINTN       High;
+  UINTN       Middle;
+  EFI_STATUS  Status;
+
+  Volume        = OFile->Volume;
+  ClusterSize   = Volume->ClusterSize;
+  ClusterIndex  = Position >> Volume->ClusterAlignment;
+
+  FatCheckExtents (OFile);
+  Status = FatMapClusters (OFile, ClusterIndex + 1 + ((PosLimit > 0) ? (PosLimit - 1) >> Volume->ClusterAlignment : 0));
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (ClusterIndex >= OFile->ExtentClusters) {
+    DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
+    return EFI_VOLUME_CORRUPTED;
+  }
+  //
+  // Find the last run starting at or before the cluster
+  //
+  Low   = 0;
+  High  = OFile->ExtentCount - 1;
+  while (Low < High) {
+    Middle = (Low + High + 1) / 2;
+    if (OFile->Extents[Middle].Offset <= ClusterIndex) {
+      Low = Middle;
+    } else {
+      High = Middle - 1;
+    }
+  }
+
+  Extent    = &OFile->Extents[Low];
+  Cluster   = Extent->Cluster + ClusterIndex - Extent->Offset;
+  StartPos  = ClusterIndex << Volume->ClusterAlignment;
+
+  OFile->PosDisk            = Volume->FirstClusterPos +
+                              LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
+                              Position - StartPos;
+  OFile->FileCurrentCluster = Cluster;
+  OFile->Position           = StartPos;
+
+  //
+  // The rest of the run is consecutive on the disk
+  //
+  *Run      = StartPos + ClusterSize - Position;
+  Remaining = Extent->Offset + Extent->Length - ClusterIndex - 1;
+  if (*Run < PosLimit) {
+    *Run += MIN (Remaining, (PosLimit - *Run + ClusterSize - 1) >> Volume->ClusterAlignment) << Volume->ClusterAlignment;
+  }
+
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS
 FatOFilePosition (
   IN FAT_OFILE            *OFile,
@@ -618,13 +1419,10 @@ Returns:
 --*/
 {
   FAT_VOLUME  *Volume;
-  UINTN       ClusterSize;
-  UINTN       Cluster;
-  UINTN       StartPos;
   UINTN       Run;
+  EFI_STATUS  Status;
 
-  Volume      = OFile->Volume;
-  ClusterSize = Volume->ClusterSize;
+  Volume = OFile->Volume;
 
   ASSERT_VOLUME_LOCKED (Volume);
 
@@ -637,53 +1435,16 @@ Returns:
     Run             = OFile->FileSize - Position;
   } else {
     //
-    // Run the file's cluster chain to find the current position
-    // If possible, run from the current cluster rather than
-    // start from beginning
-    // Assumption: OFile->Position is always consistent with
-    // OFile->FileCurrentCluster.
-    // OFile->Position is not modified outside this function;
-    // OFile->FileCurrentCluster is modified outside this function
-    // to be the same as OFile->FileCluster
-    // when OFile->FileCluster is updated, so make a check of this
-    // and invalidate the original OFile->Position in this case
+    // Look the position up in the extent list of the file, and run the
+    // cluster chain only if the list can not be grown
     //
-    Cluster     = OFile->FileCurrentCluster;
-    StartPos    = OFile->Position;
-    if (Position < StartPos || OFile->FileCluster == Cluster) {
-      StartPos  = 0;
-      Cluster   = OFile->FileCluster;
+    Status = FatLocateExtent (OFile, Position, PosLimit, &Run);
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      Status = FatWalkClusterChain (OFile, Position, PosLimit, &Run);
     }
 
-    while (StartPos + ClusterSize <= Position) {
-      StartPos += ClusterSize;
-      if (Cluster == FAT_CLUSTER_FREE || (Cluster >= FAT_CLUSTER_SPECIAL)) {
-        DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
-        return EFI_VOLUME_CORRUPTED;
-      }
-
-      Cluster = FatGetFatEntry (Volume, Cluster);
-    }
-
-    if (Cluster < FAT_MIN_CLUSTER) {
-      return EFI_VOLUME_CORRUPTED;
-    }
-
-    OFile->PosDisk            = Volume->FirstClusterPos +
-                                LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
-                                Position - StartPos;
-    OFile->FileCurrentCluster = Cluster;
-    OFile->Position           = StartPos;
-
-    //
-    // Compute the number of consecutive clusters in the file
-    //
-    Run = StartPos + ClusterSize - Position;
-    if (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-      while ((FatGetFatEntry (Volume, Cluster) == Cluster + 1) && Run < PosLimit) {
-        Run     += ClusterSize;
-        Cluster += 1;
-      }
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
   }
 
@@ -797,6 +1558,13 @@ Returns:
   // If we don't have valid info, compute it now
   //
   if (!Volume->FreeInfoValid) {
+    //
+    // Building the free cluster bitmap computes the info with fewer reads,
+    // and keeps it valid from then on
+    //
+    if (Volume->FreeBitmap == NULL && !EFI_ERROR (FatBuildFreeBitmap (Volume))) {
+      return;
+    }
 
     Volume->FreeInfoValid                        = TRUE;
     Volume->FatInfoSector.FreeInfo.ClusterCount  = 0;
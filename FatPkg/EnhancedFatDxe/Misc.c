@@ -162,6 +162,7 @@ Returns:
 {
   EFI_STATUS          Status;
   LIST_ENTRY          *Link;
+  LIST_ENTRY          *NextLink;
   FAT_SUBTASK         *Subtask;
 
   //
@@ -174,18 +175,25 @@ Returns:
     return EFI_SUCCESS;
   }
 
+  //
+  // A subtask may complete before the next one is submitted, keep the task
+  // until all of them are.
+  //
   EfiAcquireLock (&FatTaskLock);
+  Task->Queuing = TRUE;
   InsertTailList (&IFile->Tasks, &Task->Link);
   EfiReleaseLock (&FatTaskLock);
 
   Status = EFI_SUCCESS;
-  for ( Link = GetFirstNode (&Task->Subtasks)
-      ; !IsNull (&Task->Subtasks, Link)
-      ; Link = GetNextNode (&Task->Subtasks, Link)
-      ) {
-    Subtask = CR (Link, FAT_SUBTASK, Link, FAT_SUBTASK_SIGNATURE);
-    if (Subtask->Write) {
-      
+  for (Link = GetFirstNode (&Task->Subtasks); !IsNull (&Task->Subtasks, Link); Link = NextLink) {
+    NextLink  = GetNextNode (&Task->Subtasks, Link);
+    Subtask   = CR (Link, FAT_SUBTASK, Link, FAT_SUBTASK_SIGNATURE);
+    if (Subtask->Readahead != NULL) {
+      //
+      // The data is being read ahead already
+      //
+      Status = FatQueueReadaheadSubtask (Subtask);
+    } else if (Subtask->Write) {
       Status = IFile->OFile->Volume->DiskIo2->WriteDiskEx (
                                                 IFile->OFile->Volume->DiskIo2,
                                                 IFile->OFile->Volume->MediaId,
@@ -209,8 +217,22 @@ Returns:
     }
   }
 
-  if (EFI_ERROR (Status)) {
-    EfiAcquireLock (&FatTaskLock);
+  EfiAcquireLock (&FatTaskLock);
+  Task->Queuing = FALSE;
+  if (!EFI_ERROR (Status)) {
+    //
+    // Complete the task if all the subtasks completed while being submitted.
+    //
+    if (IsListEmpty (&Task->Subtasks)) {
+      if (Task->FileIoToken != NULL) {
+        Task->FileIoToken->Status = EFI_SUCCESS;
+        gBS->SignalEvent (Task->FileIoToken->Event);
+      }
+
+      RemoveEntryList (&Task->Link);
+      FreePool (Task);
+    }
+  } else {
     //
     // Remove all the remaining subtasks when failure.
     // We shouldn't remove all the tasks because the non-blocking requests have
@@ -231,10 +253,9 @@ Returns:
       //
       Task->FileIoToken = NULL;
     }
-
-    EfiReleaseLock (&FatTaskLock);
   }
 
+  EfiReleaseLock (&FatTaskLock);
   return Status;
 }
 
@@ -325,7 +346,7 @@ Arguments:
   // Task->FileIoToken is NULL which means the task will be ignored (just recycle the subtask and task memory).
   //
   if (Task->FileIoToken != NULL) {
-    if (IsListEmpty (&Task->Subtasks) || EFI_ERROR (Status)) {
+    if ((IsListEmpty (&Task->Subtasks) && !Task->Queuing) || EFI_ERROR (Status)) {
       Task->FileIoToken->Status = Status;
       gBS->SignalEvent (Task->FileIoToken->Event);
       //
@@ -335,12 +356,70 @@ Arguments:
     }
   }
 
-  if (IsListEmpty (&Task->Subtasks)) {
+  if (IsListEmpty (&Task->Subtasks) && !Task->Queuing) {
     RemoveEntryList (&Task->Link);
     FreePool (Task);
   }
 }
 
+FAT_SUBTASK *
+FatCreateSubtask (
+  IN FAT_TASK         *Task,
+  IN BOOLEAN          Write,
+  IN UINT64           Offset,
+  IN VOID             *Buffer,
+  IN UINTN            BufferSize
+  )
+/*++
+
+Routine Description:
+
+  Create a subtask accessing the disk and add it to the subtask list of the task.
+
+Arguments:
+
+  Task                  - The task the subtask belongs to.
+  Write                 - Whether the subtask writes to the disk or reads from it.
+  Offset                - The starting byte offset on the disk.
+  Buffer                - Buffer containing the data.
+  BufferSize            - Size of Buffer.
+
+Returns:
+
+  FAT_SUBTASK *         - The subtask, or NULL if it can not be created.
+
+--*/
+{
+  FAT_SUBTASK         *Subtask;
+  EFI_STATUS          Status;
+
+  Subtask = AllocateZeroPool (sizeof (*Subtask));
+  if (Subtask == NULL) {
+    return NULL;
+  }
+
+  Subtask->Signature  = FAT_SUBTASK_SIGNATURE;
+  Subtask->Task       = Task;
+  Subtask->Write      = Write;
+  Subtask->Offset     = Offset;
+  Subtask->Buffer     = Buffer;
+  Subtask->BufferSize = BufferSize;
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  FatOnAccessComplete,
+                  Subtask,
+                  &Subtask->DiskIo2Token.Event
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (Subtask);
+    return NULL;
+  }
+
+  InsertTailList (&Task->Subtasks, &Subtask->Link);
+  return Subtask;
+}
+
 EFI_STATUS
 FatDiskIo (
   IN     FAT_VOLUME       *Volume,
@@ -402,28 +481,9 @@ Returns:
         //
         // Non-blocking access
         //
-        Subtask = AllocateZeroPool (sizeof (*Subtask));
+        Subtask = FatCreateSubtask (Task, (BOOLEAN) (IoMode == WRITE_DISK), Offset, Buffer, BufferSize);
         if (Subtask == NULL) {
-          Status        = EFI_OUT_OF_RESOURCES;
-        } else {
-          Subtask->Signature  = FAT_SUBTASK_SIGNATURE;
-          Subtask->Task       = Task;
-          Subtask->Write      = (BOOLEAN) (IoMode == WRITE_DISK);
-          Subtask->Offset     = Offset;
-          Subtask->Buffer     = Buffer;
-          Subtask->BufferSize = BufferSize;
-          Status = gBS->CreateEvent (
-                          EVT_NOTIFY_SIGNAL,
-                          TPL_NOTIFY,
-                          FatOnAccessComplete,
-                          Subtask,
-                          &Subtask->DiskIo2Token.Event
-                          );
-          if (!EFI_ERROR (Status)) {
-            InsertTailList (&Task->Subtasks, &Subtask->Link);
-          } else {
-            FreePool (Subtask);
-          }
+          Status = EFI_OUT_OF_RESOURCES;
         }
       }
     }
@@ -563,6 +623,12 @@ Returns:
     FreePool (Volume->CacheBuffer);
   }
   //
+  // Free the free cluster bitmap
+  //
+  if (Volume->FreeBitmap != NULL) {
+    FreePool (Volume->FreeBitmap);
+  }
+  //
   // Free directory cache
   //
   FatCleanupODirCache (Volume);
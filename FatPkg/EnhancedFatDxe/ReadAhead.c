@@ -0,0 +1,369 @@
+/*++
+
+Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials are licensed and made available
+under the terms and conditions of the BSD License which accompanies this
+distribution. The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+
+Module Name:
+
+  ReadAhead.c
+
+Abstract:
+
+  Routines reading the data of a file ahead of a sequential reader
+
+Revision History
+
+--*/
+
+#include "Fat.h"
+
+STATIC
+VOID
+FatFreeReadahead (
+  IN FAT_READAHEAD    *Readahead
+  )
+/*++
+
+Routine Description:
+
+  Free the readahead.
+
+Arguments:
+
+  Readahead             - The readahead to be freed.
+
+Returns:
+
+  None.
+
+--*/
+{
+  gBS->CloseEvent (Readahead->DiskIo2Token.Event);
+  FreePool (Readahead);
+}
+
+STATIC
+VOID
+EFIAPI
+FatOnReadaheadComplete (
+  IN  EFI_EVENT                Event,
+  IN  VOID                     *Context
+  )
+/*++
+
+Routine Description:
+
+  Invoke a notification event when the read of a readahead completes.
+  Copy the data to the subtasks waiting for it and complete them.
+
+Arguments:
+
+  Event                 - Event whose notification function is being invoked.
+  Context               - The readahead.
+
+--*/
+{
+  FAT_READAHEAD          *Readahead;
+  FAT_SUBTASK            *Subtask;
+  EFI_STATUS             Status;
+
+  ASSERT (EfiGetCurrentTpl () == FatTaskLock.Tpl);
+
+  Readahead = (FAT_READAHEAD *) Context;
+  Status    = Readahead->DiskIo2Token.TransactionStatus;
+  ASSERT (Readahead->Signature == FAT_READAHEAD_SIGNATURE);
+
+  Readahead->Pending = FALSE;
+  while (!IsListEmpty (&Readahead->Waiters)) {
+    Subtask = CR (GetFirstNode (&Readahead->Waiters), FAT_SUBTASK, ReadaheadLink, FAT_SUBTASK_SIGNATURE);
+    RemoveEntryList (&Subtask->ReadaheadLink);
+    if (!EFI_ERROR (Status)) {
+      CopyMem (Subtask->Buffer, Readahead->Buffer + (UINTN) (Subtask->Offset - Readahead->Offset), Subtask->BufferSize);
+    }
+    //
+    // The subtask completes as if it had been read from the disk
+    //
+    Subtask->DiskIo2Token.TransactionStatus = Status;
+    gBS->SignalEvent (Subtask->DiskIo2Token.Event);
+  }
+
+  if (Readahead->Discarded) {
+    FatFreeReadahead (Readahead);
+  }
+}
+
+VOID
+FatDiscardReadahead (
+  IN FAT_OFILE          *OFile
+  )
+/*++
+
+Routine Description:
+
+  Discard the data read ahead for the open file, as it is being changed.
+  A readahead still reading is freed when it completes.
+
+Arguments:
+
+  OFile                 - The open file.
+
+Returns:
+
+  None.
+
+--*/
+{
+  FAT_READAHEAD *Readahead;
+  BOOLEAN       Pending;
+
+  Readahead = OFile->Readahead;
+  if (Readahead == NULL) {
+    return;
+  }
+
+  OFile->Readahead = NULL;
+  EfiAcquireLock (&FatTaskLock);
+  Pending = Readahead->Pending;
+  Readahead->Discarded = TRUE;
+  EfiReleaseLock (&FatTaskLock);
+
+  if (!Pending) {
+    FatFreeReadahead (Readahead);
+  }
+}
+
+VOID
+FatStartReadahead (
+  IN FAT_OFILE          *OFile,
+  IN UINTN              Position
+  )
+/*++
+
+Routine Description:
+
+  Start reading the data of the open file following Position from the disk,
+  up to the end of the run of consecutive clusters holding Position. Nothing
+  is done if the device does not support non-blocking reads, if a readahead
+  is still reading, or if the data at Position was read ahead already.
+
+Arguments:
+
+  OFile                 - The open file.
+  Position              - The file's position the next sequential read starts at.
+
+Returns:
+
+  None.
+
+--*/
+{
+  FAT_VOLUME    *Volume;
+  FAT_READAHEAD *Readahead;
+  UINTN         BufferSize;
+  BOOLEAN       Pending;
+  EFI_STATUS    Status;
+
+  Volume = OFile->Volume;
+  if (Volume->DiskIo2 == NULL || OFile->ODir != NULL || Position >= OFile->FileSize) {
+    return;
+  }
+
+  Readahead = OFile->Readahead;
+  if (Readahead != NULL) {
+    EfiAcquireLock (&FatTaskLock);
+    Pending = Readahead->Pending;
+    EfiReleaseLock (&FatTaskLock);
+    if (Pending) {
+      return;
+    }
+  }
+
+  Status = FatOFilePosition (OFile, Position, FAT_READAHEAD_SIZE);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  if (Readahead != NULL &&
+      OFile->PosDisk >= Readahead->Offset &&
+      OFile->PosDisk < Readahead->Offset + Readahead->BufferSize) {
+    return;
+  }
+
+  FatDiscardReadahead (OFile);
+  BufferSize = MIN (OFile->PosRem, FAT_READAHEAD_SIZE);
+  BufferSize = MIN (BufferSize, OFile->FileSize - Position);
+
+  //
+  // The disk has to hold the contents of the dirty cache pages of the range
+  //
+  Status = FatWriteBackDataCache (Volume, OFile->PosDisk, BufferSize);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Readahead = AllocateZeroPool (sizeof (FAT_READAHEAD) + BufferSize);
+  if (Readahead == NULL) {
+    return;
+  }
+
+  Readahead->Signature  = FAT_READAHEAD_SIGNATURE;
+  Readahead->Offset     = OFile->PosDisk;
+  Readahead->BufferSize = BufferSize;
+  Readahead->Buffer     = (UINT8 *) (Readahead + 1);
+  InitializeListHead (&Readahead->Waiters);
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  FatOnReadaheadComplete,
+                  Readahead,
+                  &Readahead->DiskIo2Token.Event
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (Readahead);
+    return;
+  }
+
+  Readahead->Pending  = TRUE;
+  OFile->Readahead    = Readahead;
+  Status = Volume->DiskIo2->ReadDiskEx (
+                              Volume->DiskIo2,
+                              Volume->MediaId,
+                              Readahead->Offset,
+                              &Readahead->DiskIo2Token,
+                              BufferSize,
+                              Readahead->Buffer
+                              );
+  if (EFI_ERROR (Status)) {
+    OFile->Readahead = NULL;
+    FatFreeReadahead (Readahead);
+  }
+}
+
+BOOLEAN
+FatReadFromReadahead (
+  IN     FAT_OFILE      *OFile,
+  IN OUT UINTN          *Length,
+  OUT    UINT8          *Buffer,
+  IN     FAT_TASK       *Task
+  )
+/*++
+
+Routine Description:
+
+  Read the data at the current disk position of the open file from its
+  readahead. The data is copied if the readahead completed; a non-blocking
+  read gets a subtask completing with the readahead otherwise.
+
+Arguments:
+
+  OFile                 - The open file.
+  Length                - On input, the number of bytes to read; on output,
+                          the number of bytes read from the readahead.
+  Buffer                - Buffer receiving the data.
+  Task                  - The task of a non-blocking read, or NULL.
+
+Returns:
+
+  TRUE                  - The data is read from the readahead.
+  FALSE                 - The data has to be read from the disk.
+
+--*/
+{
+  FAT_READAHEAD *Readahead;
+  FAT_SUBTASK   *Subtask;
+  UINTN         Skip;
+  UINTN         Size;
+  BOOLEAN       Pending;
+
+  Readahead = OFile->Readahead;
+  if (Readahead == NULL ||
+      OFile->PosDisk < Readahead->Offset ||
+      OFile->PosDisk >= Readahead->Offset + Readahead->BufferSize) {
+    return FALSE;
+  }
+
+  Skip  = (UINTN) (OFile->PosDisk - Readahead->Offset);
+  Size  = MIN (*Length, Readahead->BufferSize - Skip);
+
+  EfiAcquireLock (&FatTaskLock);
+  Pending = Readahead->Pending;
+  EfiReleaseLock (&FatTaskLock);
+
+  if (!Pending) {
+    if (EFI_ERROR (Readahead->DiskIo2Token.TransactionStatus)) {
+      return FALSE;
+    }
+
+    CopyMem (Buffer, Readahead->Buffer + Skip, Size);
+  } else {
+    //
+    // A blocking read does not wait for the readahead, which may complete
+    // at a TPL that is blocked while the volume is locked
+    //
+    if (Task == NULL) {
+      return FALSE;
+    }
+
+    Subtask = FatCreateSubtask (Task, FALSE, OFile->PosDisk, Buffer, Size);
+    if (Subtask == NULL) {
+      return FALSE;
+    }
+
+    Subtask->Readahead = Readahead;
+  }
+
+  *Length = Size;
+  return TRUE;
+}
+
+EFI_STATUS
+FatQueueReadaheadSubtask (
+  IN FAT_SUBTASK        *Subtask
+  )
+/*++
+
+Routine Description:
+
+  Queue a subtask reading its data from a readahead. The subtask waits for
+  the readahead if it is still reading, and completes right away otherwise.
+
+Arguments:
+
+  Subtask               - The subtask to be queued.
+
+Returns:
+
+  EFI_SUCCESS           - The subtask is queued.
+  other                 - The read of the readahead failed.
+
+--*/
+{
+  FAT_READAHEAD *Readahead;
+  EFI_STATUS    Status;
+
+  Readahead = Subtask->Readahead;
+  EfiAcquireLock (&FatTaskLock);
+  if (Readahead->Pending) {
+    InsertTailList (&Readahead->Waiters, &Subtask->ReadaheadLink);
+    EfiReleaseLock (&FatTaskLock);
+    return EFI_SUCCESS;
+  }
+
+  EfiReleaseLock (&FatTaskLock);
+
+  Status = Readahead->DiskIo2Token.TransactionStatus;
+  if (!EFI_ERROR (Status)) {
+    CopyMem (Subtask->Buffer, Readahead->Buffer + (UINTN) (Subtask->Offset - Readahead->Offset), Subtask->BufferSize);
+    Subtask->DiskIo2Token.TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Subtask->DiskIo2Token.Event);
+  }
+
+  return Status;
+}
@@ -244,11 +244,13 @@ Returns:
   FAT_VOLUME  *Volume;
   UINT64      EndPosition;
   FAT_TASK    *Task;
+  BOOLEAN     Sequential;
 
-  IFile  = IFILE_FROM_FHAND (FHand);
-  OFile  = IFile->OFile;
-  Volume = OFile->Volume;
-  Task   = NULL;
+  IFile       = IFILE_FROM_FHAND (FHand);
+  OFile       = IFile->OFile;
+  Volume      = OFile->Volume;
+  Task        = NULL;
+  Sequential  = FALSE;
 
   //
   // Write to a directory is unsupported
@@ -344,6 +346,10 @@ Returns:
 
       Status = FatAccessOFile (OFile, IoMode, (UINTN) IFile->Position, BufferSize, Buffer, Task);
       IFile->Position += *BufferSize;
+      if (IoMode == READ_DATA && !EFI_ERROR (Status)) {
+        Sequential              = (BOOLEAN) (OFile->NextReadPosition == IFile->Position - *BufferSize);
+        OFile->NextReadPosition = (UINTN) IFile->Position;
+      }
     }
   }
 
@@ -355,6 +361,15 @@ Returns:
     }
   }
 
+  if (Sequential && Token != NULL && !EFI_ERROR (Status)) {
+    //
+    // Read the data following a sequential non-blocking read before it is
+    // asked for. A blocking read cannot wait for the readahead while the
+    // volume is locked, so it would read the same data from the disk again.
+    //
+    FatStartReadahead (OFile, (UINTN) IFile->Position);
+  }
+
 Done:
   //
   // On EFI_SUCCESS case, not calling FatCleanupVolume():
@@ -536,6 +551,10 @@ Returns:
   Volume      = OFile->Volume;
   ASSERT_VOLUME_LOCKED (Volume);
 
+  if (IoMode == WRITE_DATA) {
+    FatDiscardReadahead (OFile);
+  }
+
   Status = EFI_SUCCESS;
   while (BufferSize > 0) {
     //
@@ -551,11 +570,13 @@ Returns:
     Len = BufferSize > OFile->PosRem ? OFile->PosRem : BufferSize;
 
     //
-    // Write the data
+    // Read the data from the readahead, or access the disk
     //
-    Status = FatDiskIo (Volume, IoMode, OFile->PosDisk, Len, UserBuffer, Task);
-    if (EFI_ERROR (Status)) {
-      break;
+    if (IoMode != READ_DATA || !FatReadFromReadahead (OFile, &Len, UserBuffer, Task)) {
+      Status = FatDiskIo (Volume, IoMode, OFile->PosDisk, Len, UserBuffer, Task);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
     }
     //
     // Data was successfully accessed
@@ -1125,6 +1125,7 @@ GetSmramProfileData (
   SMRAM_PROFILE_PARAMETER_GET_PROFILE_INFO      *CommGetProfileInfo;
   SMRAM_PROFILE_PARAMETER_GET_PROFILE_DATA_BY_OFFSET *CommGetProfileData;
   SMRAM_PROFILE_PARAMETER_RECORDING_STATE       *CommRecordingState;
+  SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO *CommGetFragmentationInfo;
   UINTN                                         ProfileSize;
   VOID                                          *ProfileBuffer;
   EFI_SMM_COMMUNICATION_PROTOCOL                *SmmCommunication;
@@ -1150,7 +1151,8 @@ GetSmramProfileData (
                       sizeof (UINTN) +
                       MAX (sizeof (SMRAM_PROFILE_PARAMETER_GET_PROFILE_INFO),
                            MAX (sizeof (SMRAM_PROFILE_PARAMETER_GET_PROFILE_DATA_BY_OFFSET),
-                                sizeof (SMRAM_PROFILE_PARAMETER_RECORDING_STATE)));
+                                MAX (sizeof (SMRAM_PROFILE_PARAMETER_RECORDING_STATE),
+                                     sizeof (SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO))));
   MinimalSizeNeeded += MAX (sizeof (MEMORY_PROFILE_CONTEXT),
                             MAX (sizeof (MEMORY_PROFILE_DRIVER_INFO),
                                  MAX (sizeof (MEMORY_PROFILE_ALLOC_INFO),
@@ -1305,6 +1307,32 @@ GetSmramProfileData (
     DestroyContextSummaryData (MemoryProfileContextSummaryData);
   }
 
+  //
+  // Dump fragmentation information, older SMM cores do not support it.
+  //
+  CommHeader = (EFI_SMM_COMMUNICATE_HEADER *) &CommBuffer[0];
+  CopyMem (&CommHeader->HeaderGuid, &gEdkiiMemoryProfileGuid, sizeof (gEdkiiMemoryProfileGuid));
+  CommHeader->MessageLength = sizeof (SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO);
+
+  CommGetFragmentationInfo = (SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO *) &CommBuffer[OFFSET_OF (EFI_SMM_COMMUNICATE_HEADER, Data)];
+  ZeroMem (CommGetFragmentationInfo, sizeof (*CommGetFragmentationInfo));
+  CommGetFragmentationInfo->Header.Command      = SMRAM_PROFILE_COMMAND_GET_FRAGMENTATION_INFO;
+  CommGetFragmentationInfo->Header.DataLength   = sizeof (*CommGetFragmentationInfo);
+  CommGetFragmentationInfo->Header.ReturnStatus = (UINT64)-1;
+
+  CommSize = sizeof (EFI_GUID) + sizeof (UINTN) + CommHeader->MessageLength;
+  Status = SmmCommunication->Communicate (SmmCommunication, CommBuffer, &CommSize);
+  if (!EFI_ERROR (Status) && (CommGetFragmentationInfo->Header.ReturnStatus == 0)) {
+    Print (L"SmramFragmentation:\n");
+    Print (L"  FreePageSize        - 0x%016lx\n", CommGetFragmentationInfo->FreePageSize);
+    Print (L"  LargestFreePageSize - 0x%016lx\n", CommGetFragmentationInfo->LargestFreePageSize);
+    Print (L"  FreePageRangeCount  - 0x%016lx\n", CommGetFragmentationInfo->FreePageRangeCount);
+    Print (L"  FreePoolSize        - 0x%016lx\n", CommGetFragmentationInfo->FreePoolSize);
+    Print (L"  FreePoolBlockCount  - 0x%016lx\n", CommGetFragmentationInfo->FreePoolBlockCount);
+    Print (L"  CachedPoolSize      - 0x%016lx\n", CommGetFragmentationInfo->CachedPoolSize);
+  }
+  Status = EFI_SUCCESS;
+
   Print (L"======= SmramProfile end =======\n\n\n");
 
 Done:
@@ -10,8 +10,11 @@
 
   Step #2 - Dispatch. Remove driver from the mScheduledQueue and load and
             start it. After mScheduledQueue is drained check the
-            mDiscoveredList to see if any item has a Depex that is ready to
-            be placed on the mScheduledQueue.
+            mDepexDirtyQueue to see if any item has a Depex that is ready to
+            be placed on the mScheduledQueue. A driver is put on the
+            mDepexDirtyQueue when it is discovered, when it is scheduled on
+            request, and when a protocol its Depex references is installed or
+            uninstalled, so only those Depex are evaluated again.
 
   Step #3 - Adding to the mScheduledQueue requires that you process Before
             and After dependencies. This is done recursively as the call to add
@@ -57,7 +60,43 @@ LIST_ENTRY  mScheduledQueue = INITIALIZE_LIST_HEAD_VARIABLE (mScheduledQueue);
 LIST_ENTRY  mFvHandleList = INITIALIZE_LIST_HEAD_VARIABLE (mFvHandleList);           // list of KNOWN_HANDLE
 
 //
-// Lock for mDiscoveredList, mScheduledQueue, gDispatcherRunning.
+// Queue of drivers whose Depex must be evaluated again, in the order they were
+// discovered so drivers are scheduled in the same order as when every Depex of
+// the mDiscoveredList is evaluated. List of EFI_CORE_DRIVER_ENTRY
+//
+LIST_ENTRY  mDepexDirtyQueue = INITIALIZE_LIST_HEAD_VARIABLE (mDepexDirtyQueue);
+
+//
+// Drivers with a BEFORE or AFTER Depex, in the order they were discovered.
+// List of EFI_CORE_DRIVER_ENTRY
+//
+LIST_ENTRY  mBeforeAfterList = INITIALIZE_LIST_HEAD_VARIABLE (mBeforeAfterList);
+
+//
+// Drivers put on the mDepexDirtyQueue when any protocol is installed: drivers
+// without Depex that wait for the architectural protocols, and drivers whose
+// Depex could not be read yet. List of EFI_CORE_DRIVER_ENTRY
+//
+LIST_ENTRY  mDepexAnyProtocolList = INITIALIZE_LIST_HEAD_VARIABLE (mDepexAnyProtocolList);
+
+//
+// The protocols referenced by the Depex of the drivers not scheduled yet,
+// hashed by protocol GUID. List of DEPEX_PROTOCOL_WAIT
+//
+#define DEPEX_WAIT_TABLE_SIZE   64
+
+LIST_ENTRY  mDepexWaitTable[DEPEX_WAIT_TABLE_SIZE];
+BOOLEAN     mDepexWaitTableInitialized = FALSE;
+
+//
+// Number of drivers discovered and dispatched
+//
+UINTN       mDiscoveredCount = 0;
+UINTN       mDispatchedCount = 0;
+
+//
+// Lock for mDiscoveredList, mScheduledQueue, gDispatcherRunning and the
+// dependency graph: mDepexDirtyQueue, mDepexAnyProtocolList, mDepexWaitTable.
 //
 EFI_LOCK  mDispatcherLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 
@@ -229,6 +268,281 @@ CoreReleaseDispatcherLock (
 }
 
 
+/**
+  Computes the mDepexWaitTable bucket index of a protocol GUID.
+
+  @param  Protocol              The protocol GUID, may be unaligned.
+
+  @return The bucket index, less than DEPEX_WAIT_TABLE_SIZE
+
+**/
+UINTN
+CoreDepexWaitHash (
+  IN CONST EFI_GUID   *Protocol
+  )
+{
+  CONST UINT32        *Data;
+  UINT32              Hash;
+
+  Data = (CONST UINT32 *)Protocol;
+  Hash = ReadUnaligned32 (&Data[0]) ^ ReadUnaligned32 (&Data[1]) ^
+         ReadUnaligned32 (&Data[2]) ^ ReadUnaligned32 (&Data[3]);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return (UINTN)(Hash & (DEPEX_WAIT_TABLE_SIZE - 1));
+}
+
+
+/**
+  Find the next opcode of a Depex that has a GUID operand.
+
+  EFI_DEP_REPLACE_TRUE is a PUSH whose protocol was found, so it is returned
+  as EFI_DEP_PUSH.
+
+  @param  DriverEntry           The driver whose Depex is parsed.
+  @param  Iterator              On input, the opcode to start the search from.
+                                On output, the opcode after the one found.
+  @param  Guid                  The GUID operand of the opcode found.
+
+  @return EFI_DEP_PUSH, EFI_DEP_BEFORE or EFI_DEP_AFTER, or EFI_DEP_END if
+          there is no such opcode left.
+
+**/
+UINT8
+CoreGetNextDepexGuid (
+  IN     EFI_CORE_DRIVER_ENTRY  *DriverEntry,
+  IN OUT UINT8                  **Iterator,
+  OUT    EFI_GUID               **Guid
+  )
+{
+  UINT8                         *End;
+  UINT8                         Opcode;
+
+  End = (UINT8 *)DriverEntry->Depex + DriverEntry->DepexSize;
+  while (*Iterator < End) {
+    Opcode = **Iterator;
+    if (Opcode == EFI_DEP_END) {
+      break;
+    }
+    if (Opcode != EFI_DEP_PUSH && Opcode != EFI_DEP_REPLACE_TRUE &&
+        Opcode != EFI_DEP_BEFORE && Opcode != EFI_DEP_AFTER) {
+      *Iterator += 1;
+      continue;
+    }
+    if ((UINTN)(End - *Iterator) < 1 + sizeof (EFI_GUID)) {
+      break;
+    }
+    *Guid = (EFI_GUID *)(*Iterator + 1);
+    *Iterator += 1 + sizeof (EFI_GUID);
+    return (UINT8)((Opcode == EFI_DEP_REPLACE_TRUE) ? EFI_DEP_PUSH : Opcode);
+  }
+
+  *Iterator = End;
+  return EFI_DEP_END;
+}
+
+
+/**
+  Put a driver on the mDepexDirtyQueue so the next pass of the dispatcher
+  evaluates its Depex. The queue is kept in the order the drivers were
+  discovered. The caller must hold mDispatcherLock.
+
+  @param  DriverEntry           The driver to put on the queue.
+
+**/
+VOID
+CoreInsertOnDepexDirtyQueue (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  LIST_ENTRY                  *Link;
+  EFI_CORE_DRIVER_ENTRY       *Entry;
+
+  if (DriverEntry->DepexDirty) {
+    return;
+  }
+
+  //
+  // Most drivers are queued in discovery order, so search from the tail
+  //
+  for (Link = mDepexDirtyQueue.BackLink; Link != &mDepexDirtyQueue; Link = Link->BackLink) {
+    Entry = CR (Link, EFI_CORE_DRIVER_ENTRY, DepexDirtyLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    if (Entry->DiscoveredIndex < DriverEntry->DiscoveredIndex) {
+      break;
+    }
+  }
+  InsertHeadList (Link, &DriverEntry->DepexDirtyLink);
+  DriverEntry->DepexDirty = TRUE;
+}
+
+
+/**
+  Add or remove a driver from the mDepexAnyProtocolList. The caller must hold
+  mDispatcherLock.
+
+  @param  DriverEntry           The driver.
+  @param  WaitAnyProtocol       TRUE if the driver must be woken up when any
+                                protocol is installed.
+
+**/
+VOID
+CoreSetWaitAnyProtocol (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry,
+  IN  BOOLEAN                 WaitAnyProtocol
+  )
+{
+  if (DriverEntry->WaitAnyProtocol == WaitAnyProtocol) {
+    return;
+  }
+  if (WaitAnyProtocol) {
+    InsertTailList (&mDepexAnyProtocolList, &DriverEntry->AnyProtocolLink);
+  } else {
+    RemoveEntryList (&DriverEntry->AnyProtocolLink);
+  }
+  DriverEntry->WaitAnyProtocol = WaitAnyProtocol;
+}
+
+
+/**
+  Add the protocols referenced by the Depex of a driver to the mDepexWaitTable,
+  so the driver is woken up when one of them is installed or uninstalled.
+
+  @param  DriverEntry           The driver whose Depex was read.
+
+**/
+VOID
+CoreAddDepexWaits (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  UINT8                       *Iterator;
+  EFI_GUID                    *Guid;
+  DEPEX_PROTOCOL_WAIT         *Waits;
+  UINTN                       Count;
+  UINTN                       Index;
+
+  if (DriverEntry->DepexWaits != NULL) {
+    return;
+  }
+
+  Count    = 0;
+  Iterator = DriverEntry->Depex;
+  while (CoreGetNextDepexGuid (DriverEntry, &Iterator, &Guid) == EFI_DEP_PUSH) {
+    Count++;
+  }
+  if (Count == 0) {
+    return;
+  }
+
+  Waits = AllocatePool (Count * sizeof (DEPEX_PROTOCOL_WAIT));
+  if (Waits == NULL) {
+    //
+    // Fall back to evaluating the Depex whenever any protocol is installed
+    //
+    CoreAcquireDispatcherLock ();
+    CoreSetWaitAnyProtocol (DriverEntry, TRUE);
+    CoreReleaseDispatcherLock ();
+    return;
+  }
+
+  CoreAcquireDispatcherLock ();
+
+  if (!mDepexWaitTableInitialized) {
+    for (Index = 0; Index < DEPEX_WAIT_TABLE_SIZE; Index++) {
+      InitializeListHead (&mDepexWaitTable[Index]);
+    }
+    mDepexWaitTableInitialized = TRUE;
+  }
+
+  Index    = 0;
+  Iterator = DriverEntry->Depex;
+  while (CoreGetNextDepexGuid (DriverEntry, &Iterator, &Guid) == EFI_DEP_PUSH) {
+    Waits[Index].Signature   = DEPEX_PROTOCOL_WAIT_SIGNATURE;
+    Waits[Index].Protocol    = Guid;
+    Waits[Index].DriverEntry = DriverEntry;
+    InsertTailList (&mDepexWaitTable[CoreDepexWaitHash (Guid)], &Waits[Index].Link);
+    Index++;
+  }
+  DriverEntry->DepexWaits     = Waits;
+  DriverEntry->DepexWaitCount = Count;
+
+  CoreReleaseDispatcherLock ();
+}
+
+
+/**
+  Remove a driver that left the Dependent state from the dependency graph, it
+  does not need to be woken up anymore.
+
+  @param  DriverEntry           The driver.
+
+**/
+VOID
+CoreRemoveDepexWaits (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  DEPEX_PROTOCOL_WAIT         *Waits;
+  UINTN                       Index;
+
+  CoreAcquireDispatcherLock ();
+
+  Waits = DriverEntry->DepexWaits;
+  for (Index = 0; Index < DriverEntry->DepexWaitCount; Index++) {
+    RemoveEntryList (&Waits[Index].Link);
+  }
+  DriverEntry->DepexWaits     = NULL;
+  DriverEntry->DepexWaitCount = 0;
+  CoreSetWaitAnyProtocol (DriverEntry, FALSE);
+
+  CoreReleaseDispatcherLock ();
+
+  if (Waits != NULL) {
+    CoreFreePool (Waits);
+  }
+}
+
+
+/**
+  Wake up the drivers whose Depex references a protocol after an interface of
+  the protocol was installed or uninstalled, so the next pass of the dispatcher
+  evaluates their Depex again.
+
+  @param  Protocol              The GUID of the protocol.
+
+**/
+VOID
+CoreDispatcherProtocolNotify (
+  IN EFI_GUID   *Protocol
+  )
+{
+  LIST_ENTRY                  *Bucket;
+  LIST_ENTRY                  *Link;
+  DEPEX_PROTOCOL_WAIT         *Wait;
+  EFI_CORE_DRIVER_ENTRY       *DriverEntry;
+
+  CoreAcquireDispatcherLock ();
+
+  if (mDepexWaitTableInitialized) {
+    Bucket = &mDepexWaitTable[CoreDepexWaitHash (Protocol)];
+    for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+      Wait = CR (Link, DEPEX_PROTOCOL_WAIT, Link, DEPEX_PROTOCOL_WAIT_SIGNATURE);
+      if (CompareGuid (Wait->Protocol, Protocol)) {
+        CoreInsertOnDepexDirtyQueue (Wait->DriverEntry);
+      }
+    }
+  }
+
+  for (Link = mDepexAnyProtocolList.ForwardLink; Link != &mDepexAnyProtocolList; Link = Link->ForwardLink) {
+    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, AnyProtocolLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    CoreInsertOnDepexDirtyQueue (DriverEntry);
+  }
+
+  CoreReleaseDispatcherLock ();
+}
+
+
 /**
   Read Depex and pre-process the Depex for Before and After. If Section Extraction
   protocol returns an error via ReadSection defer the reading of the Depex.
@@ -288,6 +602,18 @@ CoreGetDepexSectionAndPreProccess (
     //
     CorePreProcessDepex (DriverEntry);
     DriverEntry->DepexProtocolError = FALSE;
+
+    //
+    // Add the driver to the dependency graph of the protocols or the driver
+    // it waits for
+    //
+    if (DriverEntry->Before || DriverEntry->After) {
+      CoreAcquireDispatcherLock ();
+      InsertTailList (&mBeforeAfterList, &DriverEntry->BeforeAfterLink);
+      CoreReleaseDispatcherLock ();
+    } else {
+      CoreAddDepexWaits (DriverEntry);
+    }
   }
 
   return Status;
@@ -332,6 +658,7 @@ CoreSchedule (
       CoreAcquireDispatcherLock ();
       DriverEntry->Unrequested  = FALSE;
       DriverEntry->Dependent    = TRUE;
+      CoreInsertOnDepexDirtyQueue (DriverEntry);
       CoreReleaseDispatcherLock ();
 
       DEBUG ((DEBUG_DISPATCH, "Schedule FFS(%g) - EFI_SUCCESS\n", DriverName));
@@ -433,7 +760,6 @@ CoreDispatcher (
 {
   EFI_STATUS                      Status;
   EFI_STATUS                      ReturnStatus;
-  LIST_ENTRY                      *Link;
   EFI_CORE_DRIVER_ENTRY           *DriverEntry;
   BOOLEAN                         ReadyToRun;
   EFI_EVENT                       DxeDispatchEvent;
@@ -526,6 +852,7 @@ CoreDispatcher (
 
       DriverEntry->Scheduled    = FALSE;
       DriverEntry->Initialized  = TRUE;
+      DriverEntry->DispatchIndex = ++mDispatchedCount;
       RemoveEntryList (&DriverEntry->ScheduledLink);
 
       CoreReleaseDispatcherLock ();
@@ -568,11 +895,25 @@ CoreDispatcher (
     }
 
     //
-    // Search DriverList for items to place on Scheduled Queue
+    // Search the drivers woken up by a protocol change for items to place on
+    // Scheduled Queue. The Depex of the other drivers can not have changed.
     //
     ReadyToRun = FALSE;
-    for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-      DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    while (TRUE) {
+      CoreAcquireDispatcherLock ();
+      if (IsListEmpty (&mDepexDirtyQueue)) {
+        CoreReleaseDispatcherLock ();
+        break;
+      }
+      DriverEntry = CR (
+                      mDepexDirtyQueue.ForwardLink,
+                      EFI_CORE_DRIVER_ENTRY,
+                      DepexDirtyLink,
+                      EFI_CORE_DRIVER_ENTRY_SIGNATURE
+                      );
+      RemoveEntryList (&DriverEntry->DepexDirtyLink);
+      DriverEntry->DepexDirty = FALSE;
+      CoreReleaseDispatcherLock ();
 
       if (DriverEntry->DepexProtocolError){
         //
@@ -585,6 +926,7 @@ CoreDispatcher (
         if (CoreIsSchedulable (DriverEntry)) {
           CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
           ReadyToRun = TRUE;
+          continue;
         }
       } else {
         if (DriverEntry->Unrequested) {
@@ -593,6 +935,18 @@ CoreDispatcher (
           DEBUG ((DEBUG_DISPATCH, "  RESULT = FALSE\n"));
         }
       }
+
+      //
+      // A driver without Depex waits for the architectural protocols, and a
+      // Depex that could not be read is retried, when any protocol is installed
+      //
+      CoreAcquireDispatcherLock ();
+      CoreSetWaitAnyProtocol (
+        DriverEntry,
+        (BOOLEAN)(DriverEntry->DepexProtocolError ||
+                  (DriverEntry->Dependent && DriverEntry->Depex == NULL))
+        );
+      CoreReleaseDispatcherLock ();
     }
   } while (ReadyToRun);
 
@@ -629,8 +983,8 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
   //
   // Process Before Dependency
   //
-  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+  for (Link = mBeforeAfterList.ForwardLink; Link != &mBeforeAfterList; Link = Link->ForwardLink) {
+    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, BeforeAfterLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
     if (DriverEntry->Before && DriverEntry->Dependent && DriverEntry != InsertedDriverEntry) {
       DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
       DEBUG ((DEBUG_DISPATCH, "  BEFORE FFS(%g) = ", &DriverEntry->BeforeAfterGuid));
@@ -657,11 +1011,13 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
 
   CoreReleaseDispatcherLock ();
 
+  CoreRemoveDepexWaits (InsertedDriverEntry);
+
   //
   // Process After Dependency
   //
-  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+  for (Link = mBeforeAfterList.ForwardLink; Link != &mBeforeAfterList; Link = Link->ForwardLink) {
+    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, BeforeAfterLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
     if (DriverEntry->After && DriverEntry->Dependent && DriverEntry != InsertedDriverEntry) {
       DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
       DEBUG ((DEBUG_DISPATCH, "  AFTER FFS(%g) = ", &DriverEntry->BeforeAfterGuid));
@@ -913,8 +1269,16 @@ CoreAddToDriverList (
 
   CoreAcquireDispatcherLock ();
 
+  DriverEntry->DiscoveredIndex = ++mDiscoveredCount;
   InsertTailList (&mDiscoveredList, &DriverEntry->Link);
 
+  //
+  // The Depex of a new driver is evaluated on the next pass of the dispatcher
+  //
+  if (!DriverEntry->Before && !DriverEntry->After) {
+    CoreInsertOnDepexDirtyQueue (DriverEntry);
+  }
+
   CoreReleaseDispatcherLock ();
 
   return EFI_SUCCESS;
@@ -1342,6 +1706,7 @@ CoreFwVolEventProtocolNotify (
           DriverEntry->Scheduled = TRUE;
           InsertTailList (&mScheduledQueue, &DriverEntry->ScheduledLink);
           CoreReleaseDispatcherLock ();
+          CoreRemoveDepexWaits (DriverEntry);
           DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
           DEBUG ((DEBUG_DISPATCH, "  RESULT = TRUE (Apriori)\n"));
           break;
@@ -1401,3 +1766,70 @@ CoreDisplayDiscoveredNotDispatched (
     }
   }
 }
+
+/**
+  Dump the dispatch graph of the discovered drivers: one NODE line per driver
+  with its dispatch order and state, and one EDGE line per protocol, BEFORE or
+  AFTER reference of its Depex. Only used in Debug Builds.
+
+  The lines are printed with DEBUG_DISPATCH in the format:
+    DISPATCH_GRAPH NODE <FileName> <DispatchIndex|-> <State>
+    DISPATCH_GRAPH EDGE <FileName> PROTOCOL <ProtocolGuid> Installed|Missing
+    DISPATCH_GRAPH EDGE <FileName> BEFORE|AFTER <FileName> -
+
+**/
+VOID
+CoreDumpDispatchGraph (
+  VOID
+  )
+{
+  LIST_ENTRY                    *Link;
+  EFI_CORE_DRIVER_ENTRY         *DriverEntry;
+  CHAR8                         *State;
+  CHAR8                         *Kind;
+  CHAR8                         *Status;
+  UINT8                         *Iterator;
+  UINT8                         Opcode;
+  EFI_GUID                      *Guid;
+  VOID                          *Interface;
+
+  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
+    DriverEntry = CR(Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+
+    if (DriverEntry->DispatchIndex != 0) {
+      State = "Dispatched";
+    } else if (DriverEntry->Initialized) {
+      State = "LoadError";
+    } else if (DriverEntry->Untrusted) {
+      State = "Untrusted";
+    } else if (DriverEntry->Scheduled) {
+      State = "Scheduled";
+    } else if (DriverEntry->Unrequested) {
+      State = "Unrequested";
+    } else if (DriverEntry->DepexProtocolError) {
+      State = "DepexError";
+    } else {
+      State = "Dependent";
+    }
+    if (DriverEntry->DispatchIndex != 0) {
+      DEBUG ((DEBUG_DISPATCH, "DISPATCH_GRAPH NODE %g %d %a\n", &DriverEntry->FileName, (UINT32)DriverEntry->DispatchIndex, State));
+    } else {
+      DEBUG ((DEBUG_DISPATCH, "DISPATCH_GRAPH NODE %g - %a\n", &DriverEntry->FileName, State));
+    }
+
+    if (DriverEntry->Depex == NULL) {
+      continue;
+    }
+    Iterator = DriverEntry->Depex;
+    while ((Opcode = CoreGetNextDepexGuid (DriverEntry, &Iterator, &Guid)) != EFI_DEP_END) {
+      if (Opcode == EFI_DEP_PUSH) {
+        Kind   = "PROTOCOL";
+        Status = EFI_ERROR (CoreLocateProtocol (Guid, NULL, &Interface)) ? "Missing" : "Installed";
+      } else {
+        Kind   = (Opcode == EFI_DEP_BEFORE) ? "BEFORE" : "AFTER";
+        Status = "-";
+      }
+      DEBUG ((DEBUG_DISPATCH, "DISPATCH_GRAPH EDGE %g %a %g %a\n", &DriverEntry->FileName, Kind, Guid, Status));
+    }
+  }
+}
@@ -53,6 +53,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/TcgService.h>
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
+#include <Protocol/ProtocolDatabaseStatistics.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -70,6 +71,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Guid/VectorHandoffTable.h>
 #include <Ppi/VectorHandoffInfo.h>
 #include <Guid/MemoryProfile.h>
+#include <Guid/HobIndexTable.h>
 
 #include <Library/DxeCoreEntryPoint.h>
 #include <Library/DebugLib.h>
@@ -169,12 +171,23 @@ typedef struct {
 } KNOWN_HANDLE;
 
 
-#define EFI_CORE_DRIVER_ENTRY_SIGNATURE SIGNATURE_32('d','r','v','r')
+#define DEPEX_PROTOCOL_WAIT_SIGNATURE SIGNATURE_32('d','p','x','w')
 typedef struct {
+  UINTN                           Signature;
+  LIST_ENTRY                      Link;             // mDepexWaitTable bucket
+  EFI_GUID                        *Protocol;        // Operand of a PUSH in the Depex
+  struct _EFI_CORE_DRIVER_ENTRY   *DriverEntry;
+} DEPEX_PROTOCOL_WAIT;
+
+#define EFI_CORE_DRIVER_ENTRY_SIGNATURE SIGNATURE_32('d','r','v','r')
+typedef struct _EFI_CORE_DRIVER_ENTRY {
   UINTN                           Signature;
   LIST_ENTRY                      Link;             // mDriverList
 
   LIST_ENTRY                      ScheduledLink;    // mScheduledQueue
+  LIST_ENTRY                      DepexDirtyLink;   // mDepexDirtyQueue
+  LIST_ENTRY                      BeforeAfterLink;  // mBeforeAfterList
+  LIST_ENTRY                      AnyProtocolLink;  // mDepexAnyProtocolList
 
   EFI_HANDLE                      FvHandle;
   EFI_GUID                        FileName;
@@ -198,6 +211,16 @@ typedef struct {
   EFI_HANDLE                      ImageHandle;
   BOOLEAN                         IsFvImage;
 
+  //
+  // Dependency graph of the dispatcher
+  //
+  UINTN                           DiscoveredIndex;  // Order of discovery, from 1
+  UINTN                           DispatchIndex;    // Order of dispatch, 0 if not dispatched
+  DEPEX_PROTOCOL_WAIT             *DepexWaits;      // Protocols the Depex waits for
+  UINTN                           DepexWaitCount;
+  BOOLEAN                         DepexDirty;       // On mDepexDirtyQueue
+  BOOLEAN                         WaitAnyProtocol;  // On mDepexAnyProtocolList
+
 } EFI_CORE_DRIVER_ENTRY;
 
 //
@@ -2183,6 +2206,32 @@ CoreDisplayDiscoveredNotDispatched (
   );
 
 
+/**
+  Dump the dispatch graph of the discovered drivers: one NODE line per driver
+  with its dispatch order and state, and one EDGE line per protocol, BEFORE or
+  AFTER reference of its Depex. Only used in Debug Builds.
+
+**/
+VOID
+CoreDumpDispatchGraph (
+  VOID
+  );
+
+
+/**
+  Wake up the drivers whose Depex references a protocol after an interface of
+  the protocol was installed or uninstalled, so the next pass of the dispatcher
+  evaluates their Depex again.
+
+  @param  Protocol              The GUID of the protocol.
+
+**/
+VOID
+CoreDispatcherProtocolNotify (
+  IN EFI_GUID   *Protocol
+  );
+
+
 /**
   Place holder function until all the Boot Services and Runtime Services are
   available.
@@ -2506,6 +2555,22 @@ CloseSectionStream (
   IN  BOOLEAN                                   FreeStreamBuffer
   );
 
+/**
+  Returns the size of the memory allocated for the decoded (decompressed or
+  GUIDed extracted) sections of a section stream, which is released when the
+  stream is closed.
+
+  @param  SectionStreamHandle    Indicates the stream.
+
+  @return The size in bytes of the decoded sections of the stream, or 0 if the
+          stream is not found.
+
+**/
+UINTN
+GetSectionStreamDecodedSize (
+  IN  UINTN                                     SectionStreamHandle
+  );
+
 /**
   Creates and initializes the DebugImageInfo Table.  Also creates the configuration
   table and registers it into the system table.
@@ -2523,6 +2588,22 @@ CoreInitializeDebugImageInfoTable (
   );
 
 
+/**
+  Creates the GUID HOB index table of a HOB list and installs it into the EFI
+  System Table's Configuration Table.
+
+  The table is optional. If it can not be allocated, HOB Library instances fall
+  back to walking the HOB list.
+
+  @param  HobStart               Pointer to the beginning of the HOB list.
+
+**/
+VOID
+CoreInstallHobIndexTable (
+  IN VOID  *HobStart
+  );
+
+
 /**
   Update the CRC32 in the Debug Table.
   Since the CRC32 service is made available by the Runtime driver, we have to
@@ -2773,6 +2854,26 @@ MemoryProfileInstallProtocol (
   VOID
   );
 
+/**
+  Initialize the hash table of the protocol database. It must be called
+  before any protocol entry is looked up.
+
+**/
+VOID
+CoreInitializeHandleServices (
+  VOID
+  );
+
+/**
+  Install the protocol database statistics protocol.
+  The protocol is only produced when DEBUG_CODE is enabled.
+
+**/
+VOID
+CoreInstallProtocolDatabaseStatistics (
+  VOID
+  );
+
 /**
   Register image to memory profile.
 
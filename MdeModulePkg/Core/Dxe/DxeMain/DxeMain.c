@@ -266,6 +266,11 @@ DxeMain (
   //
   InitializeDebugAgent (DEBUG_AGENT_INIT_DXE_CORE, HobStart, NULL);
 
+  //
+  // Initialize the protocol database
+  //
+  CoreInitializeHandleServices ();
+
   //
   // Initialize Memory Services
   //
@@ -331,6 +336,11 @@ DxeMain (
   Status = CoreInstallConfigurationTable (&gEfiHobListGuid, HobStart);
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Install the GUID HOB index of the HOB List, now that the HOB List is at its final location
+  //
+  CoreInstallHobIndexTable (HobStart);
+
   //
   // Install Memory Type Information Table into the EFI System Tables's Configuration Table
   //
@@ -396,6 +406,8 @@ DxeMain (
 
   MemoryProfileInstallProtocol ();
 
+  CoreInstallProtocolDatabaseStatistics ();
+
   CoreInitializePropertiesTable ();
   CoreInitializeMemoryAttributesTable ();
 
@@ -489,6 +501,7 @@ DxeMain (
   //
   DEBUG_CODE_BEGIN ();
     CoreDisplayDiscoveredNotDispatched ();
+    CoreDumpDispatchGraph ();
   DEBUG_CODE_END ();
 
   //
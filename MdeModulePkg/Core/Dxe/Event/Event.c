@@ -168,6 +168,7 @@ CoreDispatchEventNotifies (
 {
   IEVENT          *Event;
   LIST_ENTRY      *Head;
+  EFI_EVENT_NOTIFY NotifyFunction;
 
   CoreAcquireEventLock ();
   ASSERT (gEventQueueLock.OwnerTpl == Priority);
@@ -194,10 +195,19 @@ CoreDispatchEventNotifies (
     CoreReleaseEventLock ();
 
     //
-    // Notify this event
+    // Notify this event, protocol notifications are measured so the time spent
+    // in them can be attributed to the callbacks by performance tools. The
+    // notification function may close the event, so it is not used after it.
     //
     ASSERT (Event->NotifyFunction != NULL);
-    Event->NotifyFunction (Event, Event->NotifyContext);
+    if ((Event->ExFlag & EVT_EXFLAG_EVENT_PROTOCOL_NOTIFICATION) != 0) {
+      NotifyFunction = Event->NotifyFunction;
+      PERF_START ((VOID *) (UINTN) NotifyFunction, "ProtocolNotify:", NULL, 0);
+      NotifyFunction (Event, Event->NotifyContext);
+      PERF_END ((VOID *) (UINTN) NotifyFunction, "ProtocolNotify:", NULL, 0);
+    } else {
+      Event->NotifyFunction (Event, Event->NotifyContext);
+    }
 
     //
     // Check for next pending event
@@ -48,7 +48,9 @@ FV_DEVICE mFvDevice = {
   0,
   0,
   FALSE,
-  FALSE
+  FALSE,
+  { NULL, NULL },
+  0
 };
 
 
@@ -467,6 +469,7 @@ FvCheck (
   //
   Status = EFI_SUCCESS;
   InitializeListHead (&FvDevice->FfsFileListHeader);
+  InitializeListHead (&FvDevice->SectionCacheList);
 
   //
   // Build FFS list
@@ -578,6 +581,7 @@ FvCheck (
 
       FfsFileEntry->FfsHeader = CacheFfsHeader;
       FfsFileEntry->FileCached = FileCached;
+      InitializeListHead (&FfsFileEntry->CacheLink);
       FileCached = FALSE;
       InsertTailList (&FvDevice->FfsFileListHeader, &FfsFileEntry->Link);
     }
@@ -762,6 +766,8 @@ FwVolDriverInit (
   IN EFI_SYSTEM_TABLE             *SystemTable
   )
 {
+  EFI_EVENT                       Event;
+
   gEfiFwVolBlockEvent = EfiCreateProtocolNotifyEvent (
                           &gEfiFirmwareVolumeBlockProtocolGuid,
                           TPL_CALLBACK,
@@ -769,6 +775,10 @@ FwVolDriverInit (
                           NULL,
                           &gEfiFwVolBlockNotifyReg
                           );
+
+  DEBUG_CODE (
+    EfiCreateEventReadyToBootEx (TPL_CALLBACK, FvReportSectionCacheStatistics, NULL, &Event);
+  );
   return EFI_SUCCESS;
 }
 
@@ -27,8 +27,16 @@ typedef struct {
   EFI_FFS_FILE_HEADER             *FfsHeader;
   UINTN                           StreamHandle;
   BOOLEAN                         FileCached;
+  //
+  // Link in the section cache list of the FV while StreamHandle is open,
+  // and the size of the decoded sections held by the stream
+  //
+  LIST_ENTRY                      CacheLink;
+  UINTN                           CachedSize;
 } FFS_FILE_LIST_ENTRY;
 
+#define FFS_FILE_LIST_ENTRY_FROM_CACHE_LINK(a) BASE_CR (a, FFS_FILE_LIST_ENTRY, CacheLink)
+
 typedef struct {
   UINTN                                   Signature;
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL      *Fvb;
@@ -47,6 +55,13 @@ typedef struct {
   UINT8                                   ErasePolarity;
   BOOLEAN                                 IsFfs3Fv;
   BOOLEAN                                 IsMemoryMapped;
+
+  //
+  // Files with an open section stream, least recently read first, and the
+  // total size of their decoded sections
+  //
+  LIST_ENTRY                              SectionCacheList;
+  UINTN                                   SectionCacheSize;
 } FV_DEVICE;
 
 #define FV_DEVICE_FROM_THIS(a) CR(a, FV_DEVICE, Fv, FV2_DEVICE_SIGNATURE)
@@ -354,6 +369,22 @@ GetFileState (
   );
 
 
+/**
+  Reports the hits and misses of the section caches of all FVs once, at ready
+  to boot.
+
+  @param  Event                  The ready to boot event.
+  @param  Context                Not used.
+
+**/
+VOID
+EFIAPI
+FvReportSectionCacheStatistics (
+  IN EFI_EVENT                      Event,
+  IN VOID                           *Context
+  );
+
+
 /**
   Set the FFS file state.
 
@@ -29,6 +29,13 @@ Required Alignment             Alignment Value in FFS         Alignment Value in
 **/
 UINT8 mFvAttributes[] = {0, 4, 7, 9, 10, 12, 15, 16};
 
+//
+// Number of section reads of all FVs that found the section stream of the
+// file open, and that had to open it
+//
+UINT32 mFvSectionCacheHits   = 0;
+UINT32 mFvSectionCacheMisses = 0;
+
 /**
   Convert the FFS File Attributes to FV File Attributes
 
@@ -396,6 +403,71 @@ FvReadFile (
 
 
 
+/**
+  Reports the hits and misses of the section caches of all FVs once, at ready
+  to boot.
+
+  @param  Event                  The ready to boot event.
+  @param  Context                Not used.
+
+**/
+VOID
+EFIAPI
+FvReportSectionCacheStatistics (
+  IN EFI_EVENT                      Event,
+  IN VOID                           *Context
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "FV section cache: %d hits, %d misses\n",
+    mFvSectionCacheHits,
+    mFvSectionCacheMisses
+    ));
+  CoreCloseEvent (Event);
+}
+
+/**
+  Accounts the decoded sections of a file in the section cache of the FV, and
+  closes the section streams of the least recently read files while the
+  decoded sections of the FV exceed PcdFwVolSectionCacheSize.
+
+  @param  FvDevice               Cached FV device.
+  @param  FfsEntry               The file whose section stream was just read.
+
+**/
+VOID
+UpdateSectionCache (
+  IN FV_DEVICE                      *FvDevice,
+  IN FFS_FILE_LIST_ENTRY            *FfsEntry
+  )
+{
+  FFS_FILE_LIST_ENTRY               *LruEntry;
+
+  //
+  // Reading a section may have decoded more encapsulations of the file, so
+  // update its size and move it to the most recently read end of the list.
+  //
+  if (!IsListEmpty (&FfsEntry->CacheLink)) {
+    RemoveEntryList (&FfsEntry->CacheLink);
+    FvDevice->SectionCacheSize -= FfsEntry->CachedSize;
+  }
+  FfsEntry->CachedSize = GetSectionStreamDecodedSize (FfsEntry->StreamHandle);
+  FvDevice->SectionCacheSize += FfsEntry->CachedSize;
+  InsertTailList (&FvDevice->SectionCacheList, &FfsEntry->CacheLink);
+
+  while (FvDevice->SectionCacheSize > PcdGet32 (PcdFwVolSectionCacheSize)) {
+    LruEntry = FFS_FILE_LIST_ENTRY_FROM_CACHE_LINK (GetFirstNode (&FvDevice->SectionCacheList));
+    RemoveEntryList (&LruEntry->CacheLink);
+    InitializeListHead (&LruEntry->CacheLink);
+    FvDevice->SectionCacheSize -= LruEntry->CachedSize;
+    LruEntry->CachedSize = 0;
+
+    CloseSectionStream (LruEntry->StreamHandle, FALSE);
+    LruEntry->StreamHandle = 0;
+  }
+}
+
 /**
   Locates a section in a given FFS File and
   copies it to the supplied buffer (not including section header).
@@ -484,43 +556,49 @@ FvReadFileSection (
   }
 
   //
-  // Use FfsEntry to cache Section Extraction Protocol Information
+  // Use FfsEntry to cache Section Extraction Protocol Information. The stream
+  // keeps the sections decoded so far, so reading another section of the file
+  // does not decode it again.
   //
-  if (FfsEntry->StreamHandle == 0) {
+  if (FfsEntry->StreamHandle != 0) {
+    mFvSectionCacheHits++;
+  } else {
+    mFvSectionCacheMisses++;
     Status = OpenSectionStream (
                FileSize,
                FileBuffer,
                &FfsEntry->StreamHandle
                );
-    if (EFI_ERROR (Status)) {
-      goto Done;
-    }
   }
 
-  //
-  // If SectionType == 0 We need the whole section stream
-  //
-  Status = GetSection (
-             FfsEntry->StreamHandle,
-             (SectionType == 0) ? NULL : &SectionType,
-             NULL,
-             (SectionType == 0) ? 0 : SectionInstance,
-             Buffer,
-             BufferSize,
-             AuthenticationStatus,
-             FvDevice->IsFfs3Fv
-             );
-
   if (!EFI_ERROR (Status)) {
     //
-    // Inherit the authentication status.
+    // If SectionType == 0 We need the whole section stream
     //
-    *AuthenticationStatus |= FvDevice->AuthenticationStatus;
-  }
+    Status = GetSection (
+               FfsEntry->StreamHandle,
+               (SectionType == 0) ? NULL : &SectionType,
+               NULL,
+               (SectionType == 0) ? 0 : SectionInstance,
+               Buffer,
+               BufferSize,
+               AuthenticationStatus,
+               FvDevice->IsFfs3Fv
+               );
 
-  //
-  // Close of stream defered to close of FfsHeader list to allow SEP to cache data
-  //
+    if (!EFI_ERROR (Status)) {
+      //
+      // Inherit the authentication status.
+      //
+      *AuthenticationStatus |= FvDevice->AuthenticationStatus;
+    }
+
+    //
+    // Close of stream is defered to the eviction of the file from the section
+    // cache, or to close of FfsHeader list, to allow SEP to cache data
+    //
+    UpdateSectionCache (FvDevice, FfsEntry);
+  }
 
 Done:
   return Status;
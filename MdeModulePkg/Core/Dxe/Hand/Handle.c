@@ -21,8 +21,10 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 // gHandleList           - A list of all the handles in the system
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
+// mProtocolHashTable    - The entries of mProtocolDatabase hashed by protocol GUID
 //
 LIST_ENTRY      mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
+LIST_ENTRY      mProtocolHashTable[PROTOCOL_HASH_TABLE_SIZE];
 LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
@@ -85,6 +87,52 @@ CoreValidateHandle (
 
 
 
+/**
+  Computes the mProtocolHashTable bucket index of a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return The bucket index, less than PROTOCOL_HASH_TABLE_SIZE
+
+**/
+UINTN
+CoreProtocolHash (
+  IN EFI_GUID   *Protocol
+  )
+{
+  UINT32              *Data;
+  UINT32              Hash;
+
+  Data = (UINT32 *)Protocol;
+  Hash = ReadUnaligned32 (&Data[0]) ^ ReadUnaligned32 (&Data[1]) ^
+         ReadUnaligned32 (&Data[2]) ^ ReadUnaligned32 (&Data[3]);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return (UINTN)(Hash & (PROTOCOL_HASH_TABLE_SIZE - 1));
+}
+
+
+
+/**
+  Initialize the hash table of the protocol database. It must be called
+  before any protocol entry is looked up.
+
+**/
+VOID
+CoreInitializeHandleServices (
+  VOID
+  )
+{
+  UINTN               Index;
+
+  for (Index = 0; Index < PROTOCOL_HASH_TABLE_SIZE; Index++) {
+    InitializeListHead (&mProtocolHashTable[Index]);
+  }
+}
+
+
+
 /**
   Finds the protocol entry for the requested protocol.
   The gProtocolDatabaseLock must be owned
@@ -102,21 +150,26 @@ CoreFindProtocolEntry (
   )
 {
   LIST_ENTRY          *Link;
+  LIST_ENTRY          *Bucket;
   PROTOCOL_ENTRY      *Item;
   PROTOCOL_ENTRY      *ProtEntry;
+  UINTN               ChainLength;
 
   ASSERT_LOCKED(&gProtocolDatabaseLock);
 
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket of the GUID for the matching entry
   //
 
-  ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
+  ProtEntry   = NULL;
+  ChainLength = 0;
+  Bucket      = &mProtocolHashTable[CoreProtocolHash (Protocol)];
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    ChainLength++;
+    Item = CR(Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
 
       //
@@ -124,6 +177,10 @@ CoreFindProtocolEntry (
       //
 
       ProtEntry = Item;
+      DEBUG_CODE (
+        ProtEntry->LookupCount++;
+        ProtEntry->LookupChainLength += ChainLength;
+      );
       break;
     }
   }
@@ -143,11 +200,14 @@ CoreFindProtocolEntry (
       CopyGuid ((VOID *)&ProtEntry->ProtocolID, Protocol);
       InitializeListHead (&ProtEntry->Protocols);
       InitializeListHead (&ProtEntry->Notify);
+      ProtEntry->LookupCount       = 0;
+      ProtEntry->LookupChainLength = 0;
 
       //
-      // Add it to protocol database
+      // Add it to protocol database and to the hash bucket of its GUID
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertTailList (Bucket, &ProtEntry->HashLink);
     }
   }
 
@@ -779,6 +839,9 @@ CoreUninstallProtocolInterface (
     //
     // Remove the protocol interface from the handle
     //
+    if (Handle->LastProtocol == Prot) {
+      Handle->LastProtocol = NULL;
+    }
     RemoveEntryList (&Prot->Link);
 
     //
@@ -904,13 +967,30 @@ CoreGetProtocolInterface (
 
   Handle = (IHANDLE *)UserHandle;
 
+  //
+  // Check the protocol interface last returned for this handle first
+  //
+  Prot = Handle->LastProtocol;
+  if (Prot != NULL && CompareGuid (&Prot->Protocol->ProtocolID, Protocol)) {
+    return Prot;
+  }
+
+  //
+  // Resolve the GUID through the protocol database, so the protocol
+  // interfaces of the handle can be matched by entry instead of by GUID
+  //
+  ProtEntry = CoreFindProtocolEntry (Protocol, FALSE);
+  if (ProtEntry == NULL) {
+    return NULL;
+  }
+
   //
   // Look at each protocol interface for a match
   //
   for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
     Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-    ProtEntry = Prot->Protocol;
-    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
+    if (Prot->Protocol == ProtEntry) {
+      Handle->LastProtocol = Prot;
       return Prot;
     }
   }
@@ -1551,3 +1631,107 @@ CoreConnectHandlesByKey (
 
   CoreFreePool(HandleBuffer);
 }
+
+/**
+  Retrieve the lookup statistics of all protocol GUIDs in the protocol database.
+
+  @param  This                   The EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL instance.
+  @param  BufferSize             On input, the size in bytes of Buffer.
+                                 On output, the size in bytes of the data returned in Buffer,
+                                 or the size required if Buffer is too small.
+  @param  Buffer                 Array of EDKII_PROTOCOL_DATABASE_STATISTICS_ENTRY.
+  @param  BucketCount            Optional. Number of hash buckets in the protocol database.
+
+  @retval EFI_SUCCESS            The statistics were returned in Buffer.
+  @retval EFI_INVALID_PARAMETER  BufferSize is NULL, or Buffer is NULL and *BufferSize is not 0.
+  @retval EFI_BUFFER_TOO_SMALL   Buffer is too small. *BufferSize is updated with the required size.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreGetProtocolDatabaseStatistics (
+  IN     EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL  *This,
+  IN OUT UINTN                                        *BufferSize,
+  OUT    EDKII_PROTOCOL_DATABASE_STATISTICS_ENTRY     *Buffer,
+  OUT    UINTN                                        *BucketCount OPTIONAL
+  )
+{
+  LIST_ENTRY          *Link;
+  LIST_ENTRY          *ProtLink;
+  PROTOCOL_ENTRY      *ProtEntry;
+  UINTN               Count;
+  UINTN               Size;
+
+  if (BufferSize == NULL || (Buffer == NULL && *BufferSize != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (BucketCount != NULL) {
+    *BucketCount = PROTOCOL_HASH_TABLE_SIZE;
+  }
+
+  CoreAcquireProtocolLock ();
+
+  Count = 0;
+  for (Link = mProtocolDatabase.ForwardLink; Link != &mProtocolDatabase; Link = Link->ForwardLink) {
+    Count++;
+  }
+
+  Size = Count * sizeof (EDKII_PROTOCOL_DATABASE_STATISTICS_ENTRY);
+  if (*BufferSize < Size) {
+    *BufferSize = Size;
+    CoreReleaseProtocolLock ();
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  for (Link = mProtocolDatabase.ForwardLink; Link != &mProtocolDatabase; Link = Link->ForwardLink) {
+    ProtEntry = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+
+    CopyGuid (&Buffer->ProtocolGuid, &ProtEntry->ProtocolID);
+    Buffer->LookupCount       = ProtEntry->LookupCount;
+    Buffer->LookupChainLength = ProtEntry->LookupChainLength;
+    Buffer->HashBucket        = (UINT32)CoreProtocolHash (&ProtEntry->ProtocolID);
+    Buffer->InterfaceCount    = 0;
+    for (ProtLink = ProtEntry->Protocols.ForwardLink; ProtLink != &ProtEntry->Protocols; ProtLink = ProtLink->ForwardLink) {
+      Buffer->InterfaceCount++;
+    }
+    Buffer++;
+  }
+
+  *BufferSize = Size;
+  CoreReleaseProtocolLock ();
+
+  return EFI_SUCCESS;
+}
+
+EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL mProtocolDatabaseStatistics = {
+  EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL_REVISION,
+  CoreGetProtocolDatabaseStatistics
+};
+
+/**
+  Install the protocol database statistics protocol.
+  The protocol is only produced when DEBUG_CODE is enabled.
+
+**/
+VOID
+CoreInstallProtocolDatabaseStatistics (
+  VOID
+  )
+{
+  EFI_HANDLE    Handle;
+  EFI_STATUS    Status;
+
+  if (!DebugCodeEnabled ()) {
+    return;
+  }
+
+  Handle = NULL;
+  Status = CoreInstallMultipleProtocolInterfaces (
+             &Handle,
+             &gEdkiiProtocolDatabaseStatisticsProtocolGuid,
+             &mProtocolDatabaseStatistics,
+             NULL
+             );
+  ASSERT_EFI_ERROR (Status);
+}
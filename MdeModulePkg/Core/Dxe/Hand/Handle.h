@@ -30,12 +30,19 @@ typedef struct {
   UINTN               LocateRequest;
   /// The Handle Database Key value when this handle was last created or modified
   UINT64              Key;
+  /// The PROTOCOL_INTERFACE last returned by CoreGetProtocolInterface() for this handle
+  struct _PROTOCOL_INTERFACE  *LastProtocol;
 } IHANDLE;
 
 #define ASSERT_IS_HANDLE(a)  ASSERT((a)->Signature == EFI_HANDLE_SIGNATURE)
 
 #define PROTOCOL_ENTRY_SIGNATURE        SIGNATURE_32('p','r','t','e')
 
+///
+/// Number of buckets in the protocol GUID hash table, must be a power of 2
+///
+#define PROTOCOL_HASH_TABLE_SIZE        128
+
 ///
 /// PROTOCOL_ENTRY - each different protocol has 1 entry in the protocol
 /// database.  Each handler that supports this protocol is listed, along
@@ -51,6 +58,12 @@ typedef struct {
   LIST_ENTRY          Protocols;     
   /// Registerd notification handlers
   LIST_ENTRY          Notify;                 
+  /// Link Entry inserted to the mProtocolHashTable bucket of ProtocolID
+  LIST_ENTRY          HashLink;
+  /// Number of times this entry was found by CoreFindProtocolEntry(), counted in DEBUG_CODE only
+  UINT64              LookupCount;
+  /// Sum of the hash bucket positions this entry was found at, counted in DEBUG_CODE only
+  UINT64              LookupChainLength;
 } PROTOCOL_ENTRY;
 
 
@@ -60,7 +73,7 @@ typedef struct {
 /// PROTOCOL_INTERFACE - each protocol installed on a handle is tracked
 /// with a protocol interface structure
 ///
-typedef struct {
+typedef struct _PROTOCOL_INTERFACE {
   UINTN                       Signature;
   /// Link on IHANDLE.Protocols
   LIST_ENTRY                  Link;   
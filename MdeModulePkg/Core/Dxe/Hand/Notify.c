@@ -37,6 +37,11 @@ CoreNotifyProtocolEntry (
     ProtNotify = CR(Link, PROTOCOL_NOTIFY, Link, PROTOCOL_NOTIFY_SIGNATURE);
     CoreSignalEvent (ProtNotify->Event);
   }
+
+  //
+  // Wake up the drivers whose Depex waits for this protocol
+  //
+  CoreDispatcherProtocolNotify (&ProtEntry->ProtocolID);
 }
 
 
@@ -85,6 +90,11 @@ CoreRemoveInterfaceFromProtocol (
     // Remove the protocol interface entry
     //
     RemoveEntryList (&Prot->ByProtocol);
+
+    //
+    // A NOT in a Depex may become TRUE
+    //
+    CoreDispatcherProtocolNotify (&ProtEntry->ProtocolID);
   }
 
   return Prot;
@@ -36,7 +36,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 
 #define MEMORY_MAP_SIGNATURE   SIGNATURE_32('m','m','a','p')
-typedef struct {
+typedef struct _MEMORY_MAP {
   UINTN           Signature;
   LIST_ENTRY      Link;
   BOOLEAN         FromPages;
@@ -47,6 +47,17 @@ typedef struct {
 
   UINT64          VirtualStart;
   UINT64          Attribute;
+
+  //
+  // Red-black tree linkage of the address ordered memory map index.
+  // IndexMaxFreeSize is the size in bytes of the largest EfiConventionalMemory
+  // descriptor in the subtree rooted at this entry.
+  //
+  struct _MEMORY_MAP  *IndexParent;
+  struct _MEMORY_MAP  *IndexLeft;
+  struct _MEMORY_MAP  *IndexRight;
+  BOOLEAN             IndexRed;
+  UINT64              IndexMaxFreeSize;
 } MEMORY_MAP;
 
 //
@@ -126,6 +137,103 @@ CoreFreePoolI (
 
 
 
+/**
+  Internal function.  Links a memory map descriptor into the memory map index.
+  Caller must have the memory lock held
+
+  @param  Entry                  The descriptor to insert. Its Start, End and Type
+                                 fields must already be set.
+
+**/
+VOID
+CoreMemoryMapIndexInsert (
+  IN MEMORY_MAP       *Entry
+  );
+
+
+/**
+  Internal function.  Unlinks a memory map descriptor from the memory map index.
+  Caller must have the memory lock held
+
+  @param  Entry                  The descriptor to remove
+
+**/
+VOID
+CoreMemoryMapIndexRemove (
+  IN MEMORY_MAP       *Entry
+  );
+
+
+/**
+  Internal function.  Moves the index linkage of a descriptor to a copy of it.
+  Caller must have the memory lock held
+
+  @param  OldEntry               The descriptor currently linked into the index
+  @param  NewEntry               The copy of OldEntry that replaces it
+
+**/
+VOID
+CoreMemoryMapIndexReplace (
+  IN MEMORY_MAP       *OldEntry,
+  IN MEMORY_MAP       *NewEntry
+  );
+
+
+/**
+  Internal function.  Refreshes the index after the Start or End of a linked
+  descriptor was adjusted in place without changing its order in the index.
+  Caller must have the memory lock held
+
+  @param  Entry                  The descriptor that was updated
+
+**/
+VOID
+CoreMemoryMapIndexUpdate (
+  IN MEMORY_MAP       *Entry
+  );
+
+
+/**
+  Internal function.  Finds the descriptor with the highest Start that is less
+  than or equal to Address.
+  Caller must have the memory lock held
+
+  @param  Address                The address to look up
+
+  @return The descriptor found, or NULL if all descriptors start above Address.
+          The caller must check End to know whether Address is covered.
+
+**/
+MEMORY_MAP *
+CoreMemoryMapIndexLookup (
+  IN UINT64           Address
+  );
+
+
+/**
+  Internal function.  Finds the highest free range below MaxAddress and
+  above MinAddress that is large enough for NumberOfBytes once the end has
+  been aligned down to Alignment.
+  Caller must have the memory lock held
+
+  @param  MaxAddress             The address that the range must be below. Must
+                                 be the last byte of a page.
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+
+  @return The last byte of the range found, or 0 if no range was found
+
+**/
+UINT64
+CoreMemoryMapIndexFindFreeRange (
+  IN UINT64           MaxAddress,
+  IN UINT64           MinAddress,
+  IN UINT64           NumberOfBytes,
+  IN UINTN            Alignment
+  );
+
+
 /**
   Enter critical section by gaining lock on gMemoryLock.
 
@@ -0,0 +1,620 @@
+/** @file
+  Address ordered index of the UEFI memory map.
+
+  The memory map descriptors in gMemoryMap are additionally linked into a
+  red-black tree keyed by their Start address.  Every node caches the size of
+  the largest EfiConventionalMemory descriptor in its subtree, so that the page
+  allocator can locate the descriptor covering an address, the neighbors of a
+  range and the highest free range satisfying a request in logarithmic time
+  rather than walking the whole gMemoryMap list.
+
+  The tree linkage is embedded in MEMORY_MAP, so maintaining the index never
+  allocates memory.  gMemoryMap itself is left untouched and remains the source
+  of the memory map returned by GetMemoryMap().
+
+Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DxeMain.h"
+#include "Imem.h"
+
+//
+// Root of the memory map index
+//
+MEMORY_MAP  *mMemoryMapIndexRoot = NULL;
+
+/**
+  Return the size of a descriptor if it describes free memory.
+
+  @param  Entry                  The descriptor to check
+
+  @return The size in bytes of Entry if it is EfiConventionalMemory, or 0.
+
+**/
+UINT64
+MemoryMapIndexFreeSize (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  if (Entry->Type != EfiConventionalMemory) {
+    return 0;
+  }
+  return Entry->End - Entry->Start + 1;
+}
+
+/**
+  Recompute the cached largest free size of a node from its own size and
+  the cached values of its children.
+
+  @param  Entry                  The node to recompute
+
+**/
+VOID
+MemoryMapIndexRecompute (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  UINT64  MaxFreeSize;
+
+  MaxFreeSize = MemoryMapIndexFreeSize (Entry);
+  if (Entry->IndexLeft != NULL && Entry->IndexLeft->IndexMaxFreeSize > MaxFreeSize) {
+    MaxFreeSize = Entry->IndexLeft->IndexMaxFreeSize;
+  }
+  if (Entry->IndexRight != NULL && Entry->IndexRight->IndexMaxFreeSize > MaxFreeSize) {
+    MaxFreeSize = Entry->IndexRight->IndexMaxFreeSize;
+  }
+  Entry->IndexMaxFreeSize = MaxFreeSize;
+}
+
+/**
+  Recompute the cached largest free size of a node and all its ancestors.
+
+  @param  Entry                  The node to start from, may be NULL
+
+**/
+VOID
+MemoryMapIndexRecomputeToRoot (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  for (; Entry != NULL; Entry = Entry->IndexParent) {
+    MemoryMapIndexRecompute (Entry);
+  }
+}
+
+/**
+  Replace the child pointer that refers to OldChild in the parent of OldChild.
+
+  @param  Parent                 The parent of OldChild, or NULL if OldChild is
+                                 the root
+  @param  OldChild               The child being replaced
+  @param  NewChild               The replacing child, may be NULL
+
+**/
+VOID
+MemoryMapIndexReplaceChild (
+  IN MEMORY_MAP       *Parent,
+  IN MEMORY_MAP       *OldChild,
+  IN MEMORY_MAP       *NewChild
+  )
+{
+  if (Parent == NULL) {
+    mMemoryMapIndexRoot = NewChild;
+  } else if (Parent->IndexLeft == OldChild) {
+    Parent->IndexLeft = NewChild;
+  } else {
+    Parent->IndexRight = NewChild;
+  }
+}
+
+/**
+  Rotate the subtree rooted at Pivot to the left.
+
+  @param  Pivot                  The node to rotate around. Pivot->IndexRight
+                                 must not be NULL.
+
+**/
+VOID
+MemoryMapIndexRotateLeft (
+  IN MEMORY_MAP       *Pivot
+  )
+{
+  MEMORY_MAP  *RightChild;
+
+  RightChild = Pivot->IndexRight;
+
+  Pivot->IndexRight = RightChild->IndexLeft;
+  if (RightChild->IndexLeft != NULL) {
+    RightChild->IndexLeft->IndexParent = Pivot;
+  }
+  RightChild->IndexParent = Pivot->IndexParent;
+  MemoryMapIndexReplaceChild (Pivot->IndexParent, Pivot, RightChild);
+  RightChild->IndexLeft = Pivot;
+  Pivot->IndexParent    = RightChild;
+
+  //
+  // The rotated subtree holds the same descriptors, only the two nodes
+  // that changed children need their cached size refreshed.
+  //
+  MemoryMapIndexRecompute (Pivot);
+  MemoryMapIndexRecompute (RightChild);
+}
+
+/**
+  Rotate the subtree rooted at Pivot to the right.
+
+  @param  Pivot                  The node to rotate around. Pivot->IndexLeft
+                                 must not be NULL.
+
+**/
+VOID
+MemoryMapIndexRotateRight (
+  IN MEMORY_MAP       *Pivot
+  )
+{
+  MEMORY_MAP  *LeftChild;
+
+  LeftChild = Pivot->IndexLeft;
+
+  Pivot->IndexLeft = LeftChild->IndexRight;
+  if (LeftChild->IndexRight != NULL) {
+    LeftChild->IndexRight->IndexParent = Pivot;
+  }
+  LeftChild->IndexParent = Pivot->IndexParent;
+  MemoryMapIndexReplaceChild (Pivot->IndexParent, Pivot, LeftChild);
+  LeftChild->IndexRight = Pivot;
+  Pivot->IndexParent    = LeftChild;
+
+  MemoryMapIndexRecompute (Pivot);
+  MemoryMapIndexRecompute (LeftChild);
+}
+
+/**
+  Check if a node is black, treating NULL leaves as black.
+
+  @param  Entry                  The node to check, may be NULL
+
+  @return TRUE if Entry is NULL or black.
+
+**/
+BOOLEAN
+MemoryMapIndexIsBlack (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  return (BOOLEAN) (Entry == NULL || !Entry->IndexRed);
+}
+
+/**
+  Internal function.  Links a memory map descriptor into the memory map index.
+  Caller must have the memory lock held
+
+  @param  Entry                  The descriptor to insert. Its Start, End and Type
+                                 fields must already be set.
+
+**/
+VOID
+CoreMemoryMapIndexInsert (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  MEMORY_MAP  *Parent;
+  MEMORY_MAP  *GrandParent;
+  MEMORY_MAP  *Uncle;
+  MEMORY_MAP  *Node;
+
+  ASSERT_LOCKED (&gMemoryLock);
+
+  //
+  // Find the leaf position of the new descriptor
+  //
+  Parent = NULL;
+  Node   = mMemoryMapIndexRoot;
+  while (Node != NULL) {
+    Parent = Node;
+    Node = (Entry->Start < Node->Start) ? Node->IndexLeft : Node->IndexRight;
+  }
+
+  Entry->IndexParent = Parent;
+  Entry->IndexLeft   = NULL;
+  Entry->IndexRight  = NULL;
+  Entry->IndexRed    = TRUE;
+  if (Parent == NULL) {
+    mMemoryMapIndexRoot = Entry;
+  } else if (Entry->Start < Parent->Start) {
+    Parent->IndexLeft = Entry;
+  } else {
+    Parent->IndexRight = Entry;
+  }
+  MemoryMapIndexRecomputeToRoot (Entry);
+
+  //
+  // Restore the red-black properties.  Rotations keep the cached sizes
+  // of the rotated nodes up to date, and do not change the set of nodes
+  // below the rotated subtree root, so ancestors need no refresh.
+  //
+  Node = Entry;
+  while (Node != mMemoryMapIndexRoot && Node->IndexParent->IndexRed) {
+    Parent      = Node->IndexParent;
+    GrandParent = Parent->IndexParent;
+    if (Parent == GrandParent->IndexLeft) {
+      Uncle = GrandParent->IndexRight;
+      if (!MemoryMapIndexIsBlack (Uncle)) {
+        Parent->IndexRed      = FALSE;
+        Uncle->IndexRed       = FALSE;
+        GrandParent->IndexRed = TRUE;
+        Node = GrandParent;
+      } else {
+        if (Node == Parent->IndexRight) {
+          Node = Parent;
+          MemoryMapIndexRotateLeft (Node);
+          Parent = Node->IndexParent;
+        }
+        Parent->IndexRed      = FALSE;
+        GrandParent->IndexRed = TRUE;
+        MemoryMapIndexRotateRight (GrandParent);
+      }
+    } else {
+      Uncle = GrandParent->IndexLeft;
+      if (!MemoryMapIndexIsBlack (Uncle)) {
+        Parent->IndexRed      = FALSE;
+        Uncle->IndexRed       = FALSE;
+        GrandParent->IndexRed = TRUE;
+        Node = GrandParent;
+      } else {
+        if (Node == Parent->IndexLeft) {
+          Node = Parent;
+          MemoryMapIndexRotateRight (Node);
+          Parent = Node->IndexParent;
+        }
+        Parent->IndexRed      = FALSE;
+        GrandParent->IndexRed = TRUE;
+        MemoryMapIndexRotateLeft (GrandParent);
+      }
+    }
+  }
+  mMemoryMapIndexRoot->IndexRed = FALSE;
+}
+
+/**
+  Internal function.  Unlinks a memory map descriptor from the memory map index.
+  Caller must have the memory lock held
+
+  @param  Entry                  The descriptor to remove
+
+**/
+VOID
+CoreMemoryMapIndexRemove (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  MEMORY_MAP  *Child;
+  MEMORY_MAP  *Parent;
+  MEMORY_MAP  *Successor;
+  MEMORY_MAP  *Sibling;
+  BOOLEAN     UnlinkedRed;
+
+  ASSERT_LOCKED (&gMemoryLock);
+
+  if (Entry->IndexLeft == NULL || Entry->IndexRight == NULL) {
+    //
+    // At most one child, splice Entry out directly
+    //
+    Child  = (Entry->IndexLeft != NULL) ? Entry->IndexLeft : Entry->IndexRight;
+    Parent = Entry->IndexParent;
+    UnlinkedRed = Entry->IndexRed;
+    if (Child != NULL) {
+      Child->IndexParent = Parent;
+    }
+    MemoryMapIndexReplaceChild (Parent, Entry, Child);
+  } else {
+    //
+    // Two children, move the in-order successor into Entry's place
+    //
+    Successor = Entry->IndexRight;
+    while (Successor->IndexLeft != NULL) {
+      Successor = Successor->IndexLeft;
+    }
+    Child       = Successor->IndexRight;
+    UnlinkedRed = Successor->IndexRed;
+    if (Successor->IndexParent == Entry) {
+      Parent = Successor;
+    } else {
+      Parent = Successor->IndexParent;
+      Parent->IndexLeft = Child;
+      if (Child != NULL) {
+        Child->IndexParent = Parent;
+      }
+      Successor->IndexRight = Entry->IndexRight;
+      Entry->IndexRight->IndexParent = Successor;
+    }
+    Successor->IndexLeft = Entry->IndexLeft;
+    Entry->IndexLeft->IndexParent = Successor;
+    Successor->IndexParent = Entry->IndexParent;
+    Successor->IndexRed    = Entry->IndexRed;
+    MemoryMapIndexReplaceChild (Entry->IndexParent, Entry, Successor);
+  }
+
+  Entry->IndexParent = NULL;
+  Entry->IndexLeft   = NULL;
+  Entry->IndexRight  = NULL;
+
+  //
+  // Refresh cached sizes from the lowest changed node before rebalancing
+  //
+  MemoryMapIndexRecomputeToRoot (Parent);
+
+  if (UnlinkedRed) {
+    return;
+  }
+
+  //
+  // A black node was unlinked; Child carries an extra black
+  //
+  while (Child != mMemoryMapIndexRoot && MemoryMapIndexIsBlack (Child)) {
+    if (Child == Parent->IndexLeft) {
+      Sibling = Parent->IndexRight;
+      if (Sibling->IndexRed) {
+        Sibling->IndexRed = FALSE;
+        Parent->IndexRed  = TRUE;
+        MemoryMapIndexRotateLeft (Parent);
+        Sibling = Parent->IndexRight;
+      }
+      if (MemoryMapIndexIsBlack (Sibling->IndexLeft) && MemoryMapIndexIsBlack (Sibling->IndexRight)) {
+        Sibling->IndexRed = TRUE;
+        Child  = Parent;
+        Parent = Child->IndexParent;
+      } else {
+        if (MemoryMapIndexIsBlack (Sibling->IndexRight)) {
+          Sibling->IndexLeft->IndexRed = FALSE;
+          Sibling->IndexRed = TRUE;
+          MemoryMapIndexRotateRight (Sibling);
+          Sibling = Parent->IndexRight;
+        }
+        Sibling->IndexRed = Parent->IndexRed;
+        Parent->IndexRed  = FALSE;
+        Sibling->IndexRight->IndexRed = FALSE;
+        MemoryMapIndexRotateLeft (Parent);
+        Child = mMemoryMapIndexRoot;
+      }
+    } else {
+      Sibling = Parent->IndexLeft;
+      if (Sibling->IndexRed) {
+        Sibling->IndexRed = FALSE;
+        Parent->IndexRed  = TRUE;
+        MemoryMapIndexRotateRight (Parent);
+        Sibling = Parent->IndexLeft;
+      }
+      if (MemoryMapIndexIsBlack (Sibling->IndexLeft) && MemoryMapIndexIsBlack (Sibling->IndexRight)) {
+        Sibling->IndexRed = TRUE;
+        Child  = Parent;
+        Parent = Child->IndexParent;
+      } else {
+        if (MemoryMapIndexIsBlack (Sibling->IndexLeft)) {
+          Sibling->IndexRight->IndexRed = FALSE;
+          Sibling->IndexRed = TRUE;
+          MemoryMapIndexRotateLeft (Sibling);
+          Sibling = Parent->IndexLeft;
+        }
+        Sibling->IndexRed = Parent->IndexRed;
+        Parent->IndexRed  = FALSE;
+        Sibling->IndexLeft->IndexRed = FALSE;
+        MemoryMapIndexRotateRight (Parent);
+        Child = mMemoryMapIndexRoot;
+      }
+    }
+  }
+  if (Child != NULL) {
+    Child->IndexRed = FALSE;
+  }
+}
+
+/**
+  Internal function.  Moves the index linkage of a descriptor to a copy of it.
+  Caller must have the memory lock held
+
+  @param  OldEntry               The descriptor currently linked into the index
+  @param  NewEntry               The copy of OldEntry that replaces it
+
+**/
+VOID
+CoreMemoryMapIndexReplace (
+  IN MEMORY_MAP       *OldEntry,
+  IN MEMORY_MAP       *NewEntry
+  )
+{
+  ASSERT_LOCKED (&gMemoryLock);
+
+  NewEntry->IndexParent      = OldEntry->IndexParent;
+  NewEntry->IndexLeft        = OldEntry->IndexLeft;
+  NewEntry->IndexRight       = OldEntry->IndexRight;
+  NewEntry->IndexRed         = OldEntry->IndexRed;
+  NewEntry->IndexMaxFreeSize = OldEntry->IndexMaxFreeSize;
+
+  MemoryMapIndexReplaceChild (OldEntry->IndexParent, OldEntry, NewEntry);
+  if (NewEntry->IndexLeft != NULL) {
+    NewEntry->IndexLeft->IndexParent = NewEntry;
+  }
+  if (NewEntry->IndexRight != NULL) {
+    NewEntry->IndexRight->IndexParent = NewEntry;
+  }
+
+  OldEntry->IndexParent = NULL;
+  OldEntry->IndexLeft   = NULL;
+  OldEntry->IndexRight  = NULL;
+}
+
+/**
+  Internal function.  Refreshes the index after the Start or End of a linked
+  descriptor was adjusted in place without changing its order in the index.
+  Caller must have the memory lock held
+
+  @param  Entry                  The descriptor that was updated
+
+**/
+VOID
+CoreMemoryMapIndexUpdate (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  ASSERT_LOCKED (&gMemoryLock);
+
+  MemoryMapIndexRecomputeToRoot (Entry);
+}
+
+/**
+  Internal function.  Finds the descriptor with the highest Start that is less
+  than or equal to Address.
+  Caller must have the memory lock held
+
+  @param  Address                The address to look up
+
+  @return The descriptor found, or NULL if all descriptors start above Address.
+          The caller must check End to know whether Address is covered.
+
+**/
+MEMORY_MAP *
+CoreMemoryMapIndexLookup (
+  IN UINT64           Address
+  )
+{
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Found;
+
+  ASSERT_LOCKED (&gMemoryLock);
+
+  Found = NULL;
+  Node  = mMemoryMapIndexRoot;
+  while (Node != NULL) {
+    if (Node->Start <= Address) {
+      Found = Node;
+      Node  = Node->IndexRight;
+    } else {
+      Node  = Node->IndexLeft;
+    }
+  }
+  return Found;
+}
+
+/**
+  Search a subtree for the highest free range that satisfies a request.
+
+  Descriptors do not overlap, so visiting the subtree from the highest to the
+  lowest Start also visits the candidate range ends in descending order, and
+  the first descriptor that fits is the best one.  Subtrees whose largest free
+  descriptor is too small are skipped entirely.
+
+  @param  Node                   The root of the subtree to search
+  @param  MaxAddress             The address that the range must be below
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+  @param  Target                 Receives the last byte of the range found
+
+  @retval TRUE                   A range was found and returned in Target.
+  @retval FALSE                  No range in the subtree satisfies the request.
+
+**/
+BOOLEAN
+MemoryMapIndexFindFreeRange (
+  IN  MEMORY_MAP      *Node,
+  IN  UINT64          MaxAddress,
+  IN  UINT64          MinAddress,
+  IN  UINT64          NumberOfBytes,
+  IN  UINTN           Alignment,
+  OUT UINT64          *Target
+  )
+{
+  UINT64          DescStart;
+  UINT64          DescEnd;
+
+  if (Node == NULL || Node->IndexMaxFreeSize < NumberOfBytes) {
+    return FALSE;
+  }
+
+  //
+  // Everything at or above a descriptor that starts past the max allowed
+  // address is out of range
+  //
+  if (Node->Start < MaxAddress) {
+    if (MemoryMapIndexFindFreeRange (Node->IndexRight, MaxAddress, MinAddress, NumberOfBytes, Alignment, Target)) {
+      return TRUE;
+    }
+
+    //
+    // If desc is below min allowed address, so is everything to its left
+    //
+    if (Node->End < MinAddress) {
+      return FALSE;
+    }
+
+    if (Node->Type == EfiConventionalMemory) {
+      DescStart = Node->Start;
+      DescEnd   = Node->End;
+
+      //
+      // If desc ends past max allowed address, clip the end
+      //
+      if (DescEnd >= MaxAddress) {
+        DescEnd = MaxAddress;
+      }
+
+      DescEnd = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
+
+      //
+      // Compute the number of bytes we can used from this descriptor, and see
+      // it's enough to satisfy the request.  The start of the allocated range
+      // must not be below the min address allowed.  An aligned end above the
+      // descriptor end means the alignment clipping wrapped around zero.
+      //
+      if (DescEnd >= DescStart && DescEnd <= Node->End &&
+          DescEnd - DescStart + 1 >= NumberOfBytes &&
+          (DescEnd - NumberOfBytes + 1) >= MinAddress) {
+        *Target = DescEnd;
+        return TRUE;
+      }
+    }
+  }
+
+  return MemoryMapIndexFindFreeRange (Node->IndexLeft, MaxAddress, MinAddress, NumberOfBytes, Alignment, Target);
+}
+
+/**
+  Internal function.  Finds the highest free range below MaxAddress and
+  above MinAddress that is large enough for NumberOfBytes once the end has
+  been aligned down to Alignment.
+  Caller must have the memory lock held
+
+  @param  MaxAddress             The address that the range must be below. Must
+                                 be the last byte of a page.
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+
+  @return The last byte of the range found, or 0 if no range was found
+
+**/
+UINT64
+CoreMemoryMapIndexFindFreeRange (
+  IN UINT64           MaxAddress,
+  IN UINT64           MinAddress,
+  IN UINT64           NumberOfBytes,
+  IN UINTN            Alignment
+  )
+{
+  UINT64  Target;
+
+  ASSERT_LOCKED (&gMemoryLock);
+
+  Target = 0;
+  MemoryMapIndexFindFreeRange (mMemoryMapIndexRoot, MaxAddress, MinAddress, NumberOfBytes, Alignment, &Target);
+  return Target;
+}
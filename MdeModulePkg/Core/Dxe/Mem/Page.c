@@ -141,6 +141,7 @@ RemoveMemoryMapEntry (
 {
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
+  CoreMemoryMapIndexRemove (Entry);
 
   if (Entry->FromPages) {
     //
@@ -170,7 +171,6 @@ CoreAddRange (
   IN UINT64                   Attribute
   )
 {
-  LIST_ENTRY        *Link;
   MEMORY_MAP        *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -214,32 +214,28 @@ CoreAddRange (
   //
 
   // Two memory descriptors can only be merged if they have the same Type
-  // and the same Attribute
+  // and the same Attribute.  The descriptors do not overlap, so the only
+  // candidates are the neighbors of the range in the memory map index.
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
+  while (Start != 0) {
+    Entry = CoreMemoryMapIndexLookup (Start - 1);
+    if (Entry == NULL || Entry->End + 1 != Start ||
+        Entry->Type != Type || Entry->Attribute != Attribute) {
+      break;
     }
+    Start = Entry->Start;
+    RemoveMemoryMapEntry (Entry);
+  }
 
-    if (Entry->End + 1 == Start) {
-
-      Start = Entry->Start;
-      RemoveMemoryMapEntry (Entry);
-
-    } else if (Entry->Start == End + 1) {
-
-      End = Entry->End;
-      RemoveMemoryMapEntry (Entry);
+  while (End != MAX_UINT64) {
+    Entry = CoreMemoryMapIndexLookup (End + 1);
+    if (Entry == NULL || Entry->Start != End + 1 ||
+        Entry->Type != Type || Entry->Attribute != Attribute) {
+      break;
     }
+    End = Entry->End;
+    RemoveMemoryMapEntry (Entry);
   }
 
   //
@@ -254,6 +250,7 @@ CoreAddRange (
   mMapStack[mMapDepth].VirtualStart  = 0;
   mMapStack[mMapDepth].Attribute     = Attribute;
   InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  CoreMemoryMapIndexInsert (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -361,6 +358,7 @@ CoreFreeMemoryMapStack (
 
       CopyMem (Entry , &mMapStack[mMapDepth], sizeof (MEMORY_MAP));
       Entry->FromPages = TRUE;
+      CoreMemoryMapIndexReplace (&mMapStack[mMapDepth], Entry);
 
       //
       // Find insertion location
@@ -712,7 +710,6 @@ CoreConvertPagesEx (
   UINT64          RangeEnd;
   UINT64          Attribute;
   EFI_MEMORY_TYPE MemType;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
 
   Entry = NULL;
@@ -738,15 +735,9 @@ CoreConvertPagesEx (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    Entry = CoreMemoryMapIndexLookup (Start);
 
-      if (Entry->Start <= Start && Entry->End > Start) {
-        break;
-      }
-    }
-
-    if (Link == &gMemoryMap) {
+    if (Entry == NULL || Entry->End <= Start) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -812,6 +803,7 @@ CoreConvertPagesEx (
       // Clip start
       //
       Entry->Start = RangeEnd + 1;
+      CoreMemoryMapIndexUpdate (Entry);
 
     } else if (Entry->End == RangeEnd) {
 
@@ -819,6 +811,7 @@ CoreConvertPagesEx (
       // Clip end
       //
       Entry->End = Start - 1;
+      CoreMemoryMapIndexUpdate (Entry);
 
     } else {
 
@@ -842,9 +835,11 @@ CoreConvertPagesEx (
 
       Entry->End = Start - 1;
       ASSERT (Entry->Start < Entry->End);
+      CoreMemoryMapIndexUpdate (Entry);
 
       Entry = &mMapStack[mMapDepth];
       InsertTailList (&gMemoryMap, &Entry->Link);
+      CoreMemoryMapIndexInsert (Entry);
 
       mMapDepth += 1;
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -987,11 +982,6 @@ CoreFindFreePagesI (
 {
   UINT64          NumberOfBytes;
   UINT64          Target;
-  UINT64          DescStart;
-  UINT64          DescEnd;
-  UINT64          DescNumberOfBytes;
-  LIST_ENTRY      *Link;
-  MEMORY_MAP      *Entry;
 
   if ((MaxAddress < EFI_PAGE_MASK) ||(NumberOfPages == 0)) {
     return 0;
@@ -1020,64 +1010,11 @@ CoreFindFreePagesI (
   }
 
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
-  Target = 0;
 
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
-    }
-
-    DescStart = Entry->Start;
-    DescEnd = Entry->End;
-
-    //
-    // If desc is past max allowed address or below min allowed address, skip it
-    //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
-    }
-
-    //
-    // If desc ends past max allowed address, clip the end
-    //
-    if (DescEnd >= MaxAddress) {
-      DescEnd = MaxAddress;
-    }
-
-    DescEnd = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
-
-    // Skip if DescEnd is less than DescStart after alignment clipping
-    if (DescEnd < DescStart) {
-      continue;
-    }
-
-    //
-    // Compute the number of bytes we can used from this
-    // descriptor, and see it's enough to satisfy the request
-    //
-    DescNumberOfBytes = DescEnd - DescStart + 1;
-
-    if (DescNumberOfBytes >= NumberOfBytes) {
-      //
-      // If the start of the allocated range is below the min address allowed, skip it
-      //
-      if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
-      }
-
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        Target = DescEnd;
-      }
-    }
-  }
+  //
+  // Find the highest free descriptor end that can hold the request
+  //
+  Target = CoreMemoryMapIndexFindFreeRange (MaxAddress, MinAddress, NumberOfBytes, Alignment);
 
   //
   // If this is a grow down, adjust target to be the allocation base
@@ -1369,7 +1306,6 @@ CoreInternalFreePages (
   )
 {
   EFI_STATUS      Status;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
   UINTN           Alignment;
 
@@ -1381,14 +1317,8 @@ CoreInternalFreePages (
   //
   // Find the entry that the covers the range
   //
-  Entry = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR(Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if (Entry->Start <= Memory && Entry->End > Memory) {
-        break;
-    }
-  }
-  if (Link == &gMemoryMap) {
+  Entry = CoreMemoryMapIndexLookup (Memory);
+  if (Entry == NULL || Entry->End <= Memory) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
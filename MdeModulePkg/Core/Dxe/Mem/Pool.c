@@ -51,8 +51,10 @@ typedef struct {
 // blocks between bins by splitting them up, while not wasting too much memory
 // as we would in a strict power-of-2 sequence
 //
+#define MAX_POOL_SIZE_ENTRY   29824
+
 STATIC CONST UINT16 mPoolSizeTable[] = {
-  128, 256, 384, 640, 1024, 1664, 2688, 4352, 7040, 11392, 18432, 29824
+  128, 256, 384, 640, 1024, 1664, 2688, 4352, 7040, 11392, 18432, MAX_POOL_SIZE_ENTRY
 };
 
 #define SIZE_TO_LIST(a)   (GetPoolIndexFromSize (a))
@@ -62,6 +64,14 @@ STATIC CONST UINT16 mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE     (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Every entry of mPoolSizeTable is a multiple of POOL_INDEX_GRANULARITY, so
+// a size rounded up to that granularity maps to exactly one pool list.
+//
+#define POOL_INDEX_SHIFT        7
+#define POOL_INDEX_GRANULARITY  (1 << POOL_INDEX_SHIFT)
+#define POOL_INDEX_TABLE_SIZE   ((MAX_POOL_SIZE_ENTRY >> POOL_INDEX_SHIFT) + 1)
+
 //
 // Globals
 //
@@ -85,6 +95,17 @@ POOL            mPoolHead[EfiMaxMemoryType];
 //
 LIST_ENTRY      mPoolHeadList = INITIALIZE_LIST_HEAD_VARIABLE (mPoolHeadList);
 
+//
+// Pool header of the OS/OEM specific memory type that was looked up last.
+//
+POOL            *mLastPoolHead = NULL;
+
+//
+// Pool list index for each size in units of POOL_INDEX_GRANULARITY,
+// filled in by CoreInitializePool ().
+//
+UINT8           mPoolIndexTable[POOL_INDEX_TABLE_SIZE];
+
 /**
   Get pool size table index from the specified size.
 
@@ -99,14 +120,10 @@ GetPoolIndexFromSize (
   UINTN   Size
   )
 {
-  UINTN   Index;
-
-  for (Index = 0; Index < MAX_POOL_LIST; Index++) {
-    if (mPoolSizeTable [Index] >= Size) {
-      return Index;
-    }
+  if (Size > LIST_TO_SIZE (MAX_POOL_LIST - 1)) {
+    return MAX_POOL_LIST;
   }
-  return MAX_POOL_LIST;
+  return mPoolIndexTable[(Size + POOL_INDEX_GRANULARITY - 1) >> POOL_INDEX_SHIFT];
 }
 
 /**
@@ -120,6 +137,22 @@ CoreInitializePool (
 {
   UINTN  Type;
   UINTN  Index;
+  UINTN  Slot;
+
+  ASSERT (LIST_TO_SIZE (MAX_POOL_LIST - 1) == ((POOL_INDEX_TABLE_SIZE - 1) << POOL_INDEX_SHIFT));
+
+  //
+  // Build the size to pool list lookup table, so that an allocation does
+  // not need to scan mPoolSizeTable
+  //
+  Index = 0;
+  for (Slot = 0; Slot < POOL_INDEX_TABLE_SIZE; Slot++) {
+    while (LIST_TO_SIZE (Index) < (Slot << POOL_INDEX_SHIFT)) {
+      Index++;
+    }
+    ASSERT ((LIST_TO_SIZE (Index) % POOL_INDEX_GRANULARITY) == 0);
+    mPoolIndexTable[Slot] = (UINT8) Index;
+  }
 
   for (Type=0; Type < EfiMaxMemoryType; Type++) {
     mPoolHead[Type].Signature  = 0;
@@ -160,9 +193,17 @@ LookupPoolHead (
   //
   if ((UINT32) MemoryType >= MEMORY_TYPE_OEM_RESERVED_MIN) {
 
+    //
+    // OS loaders typically allocate repeatedly from a single custom type
+    //
+    if (mLastPoolHead != NULL && mLastPoolHead->MemoryType == MemoryType) {
+      return mLastPoolHead;
+    }
+
     for (Link = mPoolHeadList.ForwardLink; Link != &mPoolHeadList; Link = Link->ForwardLink) {
       Pool = CR(Link, POOL, Link, POOL_SIGNATURE);
       if (Pool->MemoryType == MemoryType) {
+        mLastPoolHead = Pool;
         return Pool;
       }
     }
@@ -180,6 +221,7 @@ LookupPoolHead (
     }
 
     InsertHeadList (&mPoolHeadList, &Pool->Link);
+    mLastPoolHead = Pool;
 
     return Pool;
   }
@@ -692,6 +734,9 @@ CoreFreePoolI (
   //
   if (((UINT32) Pool->MemoryType >= MEMORY_TYPE_OEM_RESERVED_MIN) && Pool->Used == 0) {
     RemoveEntryList (&Pool->Link);
+    if (mLastPoolHead == Pool) {
+      mLastPoolHead = NULL;
+    }
     CoreFreePoolI (Pool, NULL);
   }
 
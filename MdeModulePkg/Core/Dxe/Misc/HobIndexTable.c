@@ -0,0 +1,103 @@
+/** @file
+  Build the GUID HOB index table and install it into the configuration table.
+
+  The HOB list is read-only once the DXE Core has installed it, so the index is
+  built once and never updated. Drivers linked with DxeIndexedHobLib use it to
+  find GUID extension HOBs without walking the HOB list.
+
+Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "DxeMain.h"
+
+#define HOB_INDEX_MIN_BUCKET_COUNT  16
+
+/**
+  Creates the GUID HOB index table of a HOB list and installs it into the EFI
+  System Table's Configuration Table.
+
+  The table is optional. If it can not be allocated, HOB Library instances fall
+  back to walking the HOB list.
+
+  @param  HobStart               Pointer to the beginning of the HOB list.
+
+**/
+VOID
+CoreInstallHobIndexTable (
+  IN VOID  *HobStart
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PEI_HOB_POINTERS  Hob;
+  HOB_INDEX_TABLE       *Table;
+  UINT32                EntryCount;
+  UINT32                BucketCount;
+  UINT32                Index;
+  UINT32                Bucket;
+
+  //
+  // Count the GUID extension HOBs to size the table.
+  //
+  EntryCount = 0;
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) {
+      EntryCount++;
+    }
+  }
+
+  BucketCount = HOB_INDEX_MIN_BUCKET_COUNT;
+  while (BucketCount < EntryCount) {
+    BucketCount <<= 1;
+  }
+
+  Table = AllocatePool (
+            sizeof (HOB_INDEX_TABLE) +
+            sizeof (UINT32) * BucketCount +
+            sizeof (HOB_INDEX_ENTRY) * EntryCount
+            );
+  if (Table == NULL) {
+    return;
+  }
+
+  Table->Signature   = HOB_INDEX_TABLE_SIGNATURE;
+  Table->BucketCount = BucketCount;
+  Table->EntryCount  = EntryCount;
+  Table->Reserved    = 0;
+  Table->HobList     = HobStart;
+  Table->Entries     = (HOB_INDEX_ENTRY *) (Table + 1);
+  Table->Buckets     = (UINT32 *) (Table->Entries + EntryCount);
+  SetMem32 (Table->Buckets, sizeof (UINT32) * BucketCount, HOB_INDEX_END);
+
+  Index = 0;
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) {
+      Table->Entries[Index].Hob      = Hob.Guid;
+      Table->Entries[Index].Next     = HOB_INDEX_END;
+      Table->Entries[Index].Reserved = 0;
+      Index++;
+    }
+  }
+  Table->HobListEnd = Hob.Raw;
+
+  //
+  // Chain the entries from the last one, so that every bucket is in HOB list order.
+  //
+  for (Index = EntryCount; Index > 0; Index--) {
+    Bucket = HOB_INDEX_GUID_HASH (&Table->Entries[Index - 1].Hob->Name, BucketCount);
+    Table->Entries[Index - 1].Next = Table->Buckets[Bucket];
+    Table->Buckets[Bucket]         = Index - 1;
+  }
+
+  Status = CoreInstallConfigurationTable (&gEdkiiHobIndexTableGuid, Table);
+  if (EFI_ERROR (Status)) {
+    CoreFreePool (Table);
+  }
+}
@@ -1414,6 +1414,75 @@ CloseSectionStream (
 }
 
 
+/**
+  Worker function.  Sums the size of the buffers of the encapsulated streams
+  below a section stream.
+
+  @param  StreamNode             Indicates the stream.
+
+  @return The size in bytes of the buffers of all encapsulated streams.
+
+**/
+UINTN
+GetEncapsulatedStreamSize (
+  IN  CORE_SECTION_STREAM_NODE                  *StreamNode
+  )
+{
+  LIST_ENTRY                                    *Link;
+  CORE_SECTION_CHILD_NODE                       *ChildNode;
+  CORE_SECTION_STREAM_NODE                      *ChildStream;
+  UINTN                                         Size;
+
+  Size = 0;
+  for (Link = GetFirstNode (&StreamNode->Children);
+       !IsNull (&StreamNode->Children, Link);
+       Link = GetNextNode (&StreamNode->Children, Link)) {
+    ChildNode = CHILD_SECTION_NODE_FROM_LINK (Link);
+    if (ChildNode->EncapsulatedStreamHandle != NULL_STREAM_HANDLE) {
+      //
+      // The stream handle is the address of the stream node.
+      //
+      ChildStream = (CORE_SECTION_STREAM_NODE *) ChildNode->EncapsulatedStreamHandle;
+      ASSERT (ChildStream->Signature == CORE_SECTION_STREAM_SIGNATURE);
+      Size += ChildStream->StreamLength + GetEncapsulatedStreamSize (ChildStream);
+    }
+  }
+
+  return Size;
+}
+
+
+/**
+  Returns the size of the memory allocated for the decoded (decompressed or
+  GUIDed extracted) sections of a section stream, which is released when the
+  stream is closed.
+
+  @param  SectionStreamHandle    Indicates the stream.
+
+  @return The size in bytes of the decoded sections of the stream, or 0 if the
+          stream is not found.
+
+**/
+UINTN
+GetSectionStreamDecodedSize (
+  IN  UINTN                                     SectionStreamHandle
+  )
+{
+  CORE_SECTION_STREAM_NODE                      *StreamNode;
+  EFI_TPL                                       OldTpl;
+  UINTN                                         Size;
+
+  Size = 0;
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  if (!EFI_ERROR (FindStreamNode (SectionStreamHandle, &StreamNode))) {
+    Size = GetEncapsulatedStreamSize (StreamNode);
+  }
+  CoreRestoreTpl (OldTpl);
+
+  return Size;
+}
+
+
 /**
   The ExtractSection() function processes the input section and
   allocates a buffer from the pool in which it returns the section
@@ -251,3 +251,53 @@ PeimDispatchReadiness (
     }
   }
 }
+
+/**
+
+  Get the GUID hash buckets of the PPIs a dependency expression pushes, the
+  only PPIs whose installation can change the result of its evaluation.
+
+  @param DependencyExpression   Pointer to a dependency expression.
+
+  @return One bit per GUID hash bucket of the PPI database. All bits are set
+          if the dependency expression is not well-formed.
+
+**/
+UINT32
+PeimDepexPpiMask (
+  IN VOID               *DependencyExpression
+  )
+{
+  DEPENDENCY_EXPRESSION_OPERAND  *Iterator;
+  EFI_GUID                       PpiGuid;
+  UINT32                         PpiMask;
+  UINTN                          Count;
+
+  Iterator = DependencyExpression;
+  PpiMask  = 0;
+
+  for (Count = 0; Count < MAX_GRAMMAR_SIZE * 2; Count++) {
+    switch (*(Iterator++)) {
+      case (EFI_DEP_PUSH):
+        CopyMem (&PpiGuid, Iterator, sizeof (EFI_GUID));
+        PpiMask |= 1u << PpiGuidHash (&PpiGuid);
+        Iterator = Iterator + sizeof (EFI_GUID);
+        break;
+
+      case (EFI_DEP_AND):
+      case (EFI_DEP_OR):
+      case (EFI_DEP_NOT):
+      case (EFI_DEP_TRUE):
+      case (EFI_DEP_FALSE):
+        break;
+
+      case (EFI_DEP_END):
+        return PpiMask;
+
+      default:
+        return MAX_UINT32;
+    }
+  }
+
+  return MAX_UINT32;
+}
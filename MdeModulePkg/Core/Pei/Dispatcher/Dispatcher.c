@@ -1264,6 +1264,18 @@ DepexSatisfied (
   EFI_STATUS           Status;
   VOID                 *DepexData;
   EFI_FV_FILE_INFO     FileInfo;
+  PEIM_DEPEX_WAIT      *DepexWait;
+  BOOLEAN              Satisfied;
+
+  //
+  // A DEPEX that evaluated to FALSE can only change when one of the PPIs it
+  // pushes is installed, skip it until a PPI of their hash buckets is.
+  //
+  DepexWait = &Private->Fv[Private->CurrentPeimFvCount].PeimDepexWait[PeimCount];
+  if ((DepexWait->PpiMask != 0) &&
+      !PpiInstalledSince (Private, DepexWait->PpiMask, DepexWait->PpiGeneration)) {
+    return FALSE;
+  }
 
   Status = PeiServicesFfsGetFileInfo (FileHandle, &FileInfo);
   if (EFI_ERROR (Status)) {
@@ -1298,9 +1310,16 @@ DepexSatisfied (
   }
 
   //
-  // Evaluate a given DEPEX
+  // Evaluate a given DEPEX, and remember the PPIs it waits for if FALSE
   //
-  return PeimDispatchReadiness (&Private->Ps, DepexData);
+  Satisfied = PeimDispatchReadiness (&Private->Ps, DepexData);
+  if (Satisfied) {
+    DepexWait->PpiMask = 0;
+  } else {
+    DepexWait->PpiMask       = PeimDepexPpiMask (DepexData);
+    DepexWait->PpiGeneration = Private->PpiData.PpiGeneration;
+  }
+  return Satisfied;
 }
 
 /**
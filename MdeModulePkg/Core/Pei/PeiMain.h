@@ -65,34 +65,79 @@ typedef union {
 } PEI_PPI_LIST_POINTERS;
 
 ///
-/// PPI database structure which contains two link: PpiList and NotifyList. PpiList
-/// is in head of PpiListPtrs array and notify is in end of PpiListPtrs.
+/// Number of buckets of the GUID hash index of a PPI or notify list, must be a power of 2
+/// not larger than 32 as PEIM_DEPEX_WAIT.PpiMask has one bit per bucket.
+///
+#define PPI_HASH_BUCKETS    32
+
+///
+/// End of a hash chain of a PPI or notify list.
+///
+#define PPI_HASH_END        (-1)
+
+///
+/// Entry of a PPI or notify list.
+///
+typedef struct {
+  PEI_PPI_LIST_POINTERS   Pointer;
+  ///
+  /// Index of the next entry with the same GUID hash, in ascending order, or PPI_HASH_END.
+  ///
+  INTN                    HashNext;
+} PEI_PPI_LIST_ENTRY;
+
+///
+/// List of installed PPIs, of callback notifies or of dispatch notifies.
+/// The entries are kept in the order they were installed.
 ///
 typedef struct {
   ///
-  /// index of end of PpiList link list.
+  /// Number of entries in use.
   ///
-  INTN                    PpiListEnd;
+  INTN                    CurrentCount;
   ///
-  /// index of end of notify link list.
+  /// Number of entries already processed by ProcessNotifyList().
+  /// It is not used by the callback notify list.
   ///
-  INTN                    NotifyListEnd;
+  INTN                    LastDispatchedCount;
   ///
-  /// index of the dispatched notify list.
+  /// Index of the first entry of each GUID hash bucket, or PPI_HASH_END.
   ///
-  INTN                    DispatchListEnd;
+  INTN                    HashHead[PPI_HASH_BUCKETS];
   ///
-  /// index of last installed Ppi description in PpiList link list.
+  /// First entry of the list in the entry buffer of the PPI database.
   ///
-  INTN                    LastDispatchedInstall;
+  PEI_PPI_LIST_ENTRY      *Entries;
+} PEI_PPI_LIST;
+
+///
+/// PPI database structure which contains three lists: the installed PPIs,
+/// the callback notifies and the dispatch notifies. The entries of the three
+/// lists share one buffer, where they follow each other in this order.
+///
+typedef struct {
+  PEI_PPI_LIST            PpiList;
+  PEI_PPI_LIST            CallbackNotifyList;
+  PEI_PPI_LIST            DispatchNotifyList;
   ///
-  /// index of last dispatched notify in Notify link list.
-  /// 
-  INTN                    LastDispatchedNotify;
+  /// Number of entries of the buffer used by the three lists.
   ///
-  /// Ppi database has the PcdPeiCoreMaxPpiSupported number of entries.
+  INTN                    EntryCount;
   ///
-  PEI_PPI_LIST_POINTERS   *PpiListPtrs;
+  /// Number of entries of the buffer. It is PcdPeiCoreMaxPpiSupported until
+  /// permanent memory is installed, the buffer grows as needed after that.
+  ///
+  INTN                    MaxEntryCount;
+  PEI_PPI_LIST_ENTRY      *Entries;
+  ///
+  /// Incremented each time a PPI is installed or reinstalled.
+  ///
+  UINT32                  PpiGeneration;
+  ///
+  /// Value of PpiGeneration when a PPI of each GUID hash bucket of the PpiList
+  /// was last installed or reinstalled.
+  ///
+  UINT32                  PpiBucketGeneration[PPI_HASH_BUCKETS];
 } PEI_PPI_DATABASE;
 
 
@@ -106,6 +151,23 @@ typedef struct {
 #define PEIM_STATE_REGISITER_FOR_SHADOW   0x02
 #define PEIM_STATE_DONE                   0x03
 
+///
+/// The PPIs a PEIM waits for after its DEPEX evaluated to FALSE. The DEPEX
+/// is not evaluated again until a PPI of one of these GUID hash buckets is
+/// installed or reinstalled.
+///
+typedef struct {
+  ///
+  /// One bit per GUID hash bucket of the PPIs pushed by the DEPEX, 0 if the
+  /// PEIM does not wait.
+  ///
+  UINT32                              PpiMask;
+  ///
+  /// PEI_PPI_DATABASE.PpiGeneration when the DEPEX evaluated to FALSE.
+  ///
+  UINT32                              PpiGeneration;
+} PEIM_DEPEX_WAIT;
+
 typedef struct {
   EFI_FIRMWARE_VOLUME_HEADER          *FvHeader;
   EFI_PEI_FIRMWARE_VOLUME_PPI         *FvPpi;
@@ -117,6 +179,10 @@ typedef struct {
   //
   // Ponter to the buffer with the PcdPeiCoreMaxPeimPerFv number of Entries.
   //
+  PEIM_DEPEX_WAIT                     *PeimDepexWait;
+  //
+  // Ponter to the buffer with the PcdPeiCoreMaxPeimPerFv number of Entries.
+  //
   EFI_PEI_FILE_HANDLE                 *FvFileHandles;
   BOOLEAN                             ScanFv;
   UINT32                              AuthenticationStatus;
@@ -352,6 +418,22 @@ PeimDispatchReadiness (
   IN VOID               *DependencyExpression
   );
 
+/**
+
+  Get the GUID hash buckets of the PPIs a dependency expression pushes, the
+  only PPIs whose installation can change the result of its evaluation.
+
+  @param DependencyExpression   Pointer to a dependency expression.
+
+  @return One bit per GUID hash bucket of the PPI database. All bits are set
+          if the dependency expression is not well-formed.
+
+**/
+UINT32
+PeimDepexPpiMask (
+  IN VOID               *DependencyExpression
+  );
+
 /**
   Conduct PEIM dispatch.
 
@@ -435,6 +517,40 @@ ConvertPpiPointers (
   IN PEI_CORE_INSTANCE           *PrivateData
   );
 
+/**
+
+  Get the hash bucket of a GUID in a PPI or notify list.
+
+  @param Guid            Pointer to the GUID.
+
+  @return The index of the hash bucket, less than PPI_HASH_BUCKETS.
+
+**/
+UINTN
+PpiGuidHash (
+  IN CONST EFI_GUID  *Guid
+  );
+
+/**
+
+  Check if a PPI of some GUID hash buckets was installed or reinstalled since
+  a given generation of the PPI database.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param PpiMask         One bit per GUID hash bucket.
+  @param PpiGeneration   The generation of the PPI database to compare with.
+
+  @retval TRUE           A PPI of one of the buckets was installed or reinstalled.
+  @retval FALSE          None of the buckets changed.
+
+**/
+BOOLEAN
+PpiInstalledSince (
+  IN PEI_CORE_INSTANCE   *PrivateData,
+  IN UINT32              PpiMask,
+  IN UINT32              PpiGeneration
+  );
+
 /**
 
   Install PPI services. It is implementation of EFI_PEI_SERVICE.InstallPpi.
@@ -542,9 +658,9 @@ ProcessNotifyList (
   @param PrivateData        PeiCore's private data structure
   @param NotifyType         Type of notify to fire.
   @param InstallStartIndex  Install Beginning index.
-  @param InstallStopIndex   Install Ending index.
-  @param NotifyStartIndex   Notify Beginning index.
-  @param NotifyStopIndex    Notify Ending index.
+  @param InstallStopIndex   Install Ending index, not included.
+  @param NotifyStartIndex   Notify Beginning index in the notify list of NotifyType.
+  @param NotifyStopIndex    Notify Ending index in the notify list of NotifyType, not included.
 
 **/
 VOID
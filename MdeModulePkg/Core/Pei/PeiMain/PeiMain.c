@@ -185,10 +185,14 @@ PeiCore (
         OldCoreData->HobList.Raw = (VOID *)(OldCoreData->HobList.Raw + OldCoreData->HeapOffset);
         OldCoreData->UnknownFvInfo        = (PEI_CORE_UNKNOW_FORMAT_FV_INFO *) ((UINT8 *) OldCoreData->UnknownFvInfo + OldCoreData->HeapOffset);
         OldCoreData->CurrentFvFileHandles = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->CurrentFvFileHandles + OldCoreData->HeapOffset);
-        OldCoreData->PpiData.PpiListPtrs  = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.PpiListPtrs + OldCoreData->HeapOffset);
+        OldCoreData->PpiData.Entries                    = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.Entries + OldCoreData->HeapOffset);
+        OldCoreData->PpiData.PpiList.Entries            = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.PpiList.Entries + OldCoreData->HeapOffset);
+        OldCoreData->PpiData.CallbackNotifyList.Entries = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.CallbackNotifyList.Entries + OldCoreData->HeapOffset);
+        OldCoreData->PpiData.DispatchNotifyList.Entries = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.DispatchNotifyList.Entries + OldCoreData->HeapOffset);
         OldCoreData->Fv                   = (PEI_CORE_FV_HANDLE *) ((UINT8 *) OldCoreData->Fv + OldCoreData->HeapOffset);
         for (Index = 0; Index < PcdGet32 (PcdPeiCoreMaxFvSupported); Index ++) {
           OldCoreData->Fv[Index].PeimState     = (UINT8 *) OldCoreData->Fv[Index].PeimState + OldCoreData->HeapOffset;
+          OldCoreData->Fv[Index].PeimDepexWait = (PEIM_DEPEX_WAIT *) ((UINT8 *) OldCoreData->Fv[Index].PeimDepexWait + OldCoreData->HeapOffset);
           OldCoreData->Fv[Index].FvFileHandles = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->Fv[Index].FvFileHandles + OldCoreData->HeapOffset);
         }
         OldCoreData->FileGuid             = (EFI_GUID *) ((UINT8 *) OldCoreData->FileGuid + OldCoreData->HeapOffset);
@@ -197,10 +201,14 @@ PeiCore (
         OldCoreData->HobList.Raw = (VOID *)(OldCoreData->HobList.Raw - OldCoreData->HeapOffset);
         OldCoreData->UnknownFvInfo        = (PEI_CORE_UNKNOW_FORMAT_FV_INFO *) ((UINT8 *) OldCoreData->UnknownFvInfo - OldCoreData->HeapOffset);
         OldCoreData->CurrentFvFileHandles = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->CurrentFvFileHandles - OldCoreData->HeapOffset);
-        OldCoreData->PpiData.PpiListPtrs  = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.PpiListPtrs - OldCoreData->HeapOffset);
+        OldCoreData->PpiData.Entries                    = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.Entries - OldCoreData->HeapOffset);
+        OldCoreData->PpiData.PpiList.Entries            = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.PpiList.Entries - OldCoreData->HeapOffset);
+        OldCoreData->PpiData.CallbackNotifyList.Entries = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.CallbackNotifyList.Entries - OldCoreData->HeapOffset);
+        OldCoreData->PpiData.DispatchNotifyList.Entries = (PEI_PPI_LIST_ENTRY *) ((UINT8 *) OldCoreData->PpiData.DispatchNotifyList.Entries - OldCoreData->HeapOffset);
         OldCoreData->Fv                   = (PEI_CORE_FV_HANDLE *) ((UINT8 *) OldCoreData->Fv - OldCoreData->HeapOffset);
         for (Index = 0; Index < PcdGet32 (PcdPeiCoreMaxFvSupported); Index ++) {
           OldCoreData->Fv[Index].PeimState     = (UINT8 *) OldCoreData->Fv[Index].PeimState - OldCoreData->HeapOffset;
+          OldCoreData->Fv[Index].PeimDepexWait = (PEIM_DEPEX_WAIT *) ((UINT8 *) OldCoreData->Fv[Index].PeimDepexWait - OldCoreData->HeapOffset);
           OldCoreData->Fv[Index].FvFileHandles = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->Fv[Index].FvFileHandles - OldCoreData->HeapOffset);
         }
         OldCoreData->FileGuid             = (EFI_GUID *) ((UINT8 *) OldCoreData->FileGuid - OldCoreData->HeapOffset);
@@ -319,16 +327,17 @@ PeiCore (
     //
     // Initialize PEI Core Private Data Buffer
     //
-    PrivateData.PpiData.PpiListPtrs  = AllocateZeroPool (sizeof (PEI_PPI_LIST_POINTERS) * PcdGet32 (PcdPeiCoreMaxPpiSupported));
-    ASSERT (PrivateData.PpiData.PpiListPtrs != NULL);
     PrivateData.Fv                   = AllocateZeroPool (sizeof (PEI_CORE_FV_HANDLE) * PcdGet32 (PcdPeiCoreMaxFvSupported));
     ASSERT (PrivateData.Fv != NULL);
     PrivateData.Fv[0].PeimState      = AllocateZeroPool (sizeof (UINT8) * PcdGet32 (PcdPeiCoreMaxPeimPerFv) * PcdGet32 (PcdPeiCoreMaxFvSupported));
     ASSERT (PrivateData.Fv[0].PeimState != NULL);
+    PrivateData.Fv[0].PeimDepexWait  = AllocateZeroPool (sizeof (PEIM_DEPEX_WAIT) * PcdGet32 (PcdPeiCoreMaxPeimPerFv) * PcdGet32 (PcdPeiCoreMaxFvSupported));
+    ASSERT (PrivateData.Fv[0].PeimDepexWait != NULL);
     PrivateData.Fv[0].FvFileHandles  = AllocateZeroPool (sizeof (EFI_PEI_FILE_HANDLE) * PcdGet32 (PcdPeiCoreMaxPeimPerFv) * PcdGet32 (PcdPeiCoreMaxFvSupported));
     ASSERT (PrivateData.Fv[0].FvFileHandles != NULL);
     for (Index = 1; Index < PcdGet32 (PcdPeiCoreMaxFvSupported); Index ++) {
       PrivateData.Fv[Index].PeimState     = PrivateData.Fv[Index - 1].PeimState + PcdGet32 (PcdPeiCoreMaxPeimPerFv);
+      PrivateData.Fv[Index].PeimDepexWait = PrivateData.Fv[Index - 1].PeimDepexWait + PcdGet32 (PcdPeiCoreMaxPeimPerFv);
       PrivateData.Fv[Index].FvFileHandles = PrivateData.Fv[Index - 1].FvFileHandles + PcdGet32 (PcdPeiCoreMaxPeimPerFv);
     }
     PrivateData.UnknownFvInfo        = AllocateZeroPool (sizeof (PEI_CORE_UNKNOW_FORMAT_FV_INFO) * PcdGet32 (PcdPeiCoreMaxFvSupported));
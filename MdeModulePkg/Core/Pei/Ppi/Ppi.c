@@ -1,7 +1,7 @@
 /** @file
   EFI PEI Core PPI services
-  
-Copyright (c) 2006 - 2014, Intel Corporation. All rights reserved.<BR>
+
+Copyright (c) 2006 - 2016, Intel Corporation. All rights reserved.<BR>
 This program and the accompanying materials
 are licensed and made available under the terms and conditions of the BSD License
 which accompanies this distribution.  The full text of the license may be found at
@@ -14,12 +14,275 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include "PeiMain.h"
 
+/**
+
+  Compare two GUIDs.
+
+  Don't use CompareGuid function here for performance reasons.
+  Instead we compare the GUID as INT32 at a time and branch
+  on the first failed comparison.
+
+  @param Guid1           Pointer to the first GUID.
+  @param Guid2           Pointer to the second GUID.
+
+  @retval TRUE           The GUIDs are identical.
+  @retval FALSE          The GUIDs are different.
+
+**/
+BOOLEAN
+IsPpiGuidEqual (
+  IN CONST EFI_GUID  *Guid1,
+  IN CONST EFI_GUID  *Guid2
+  )
+{
+  return (BOOLEAN) ((((INT32 *)Guid1)[0] == ((INT32 *)Guid2)[0]) &&
+                    (((INT32 *)Guid1)[1] == ((INT32 *)Guid2)[1]) &&
+                    (((INT32 *)Guid1)[2] == ((INT32 *)Guid2)[2]) &&
+                    (((INT32 *)Guid1)[3] == ((INT32 *)Guid2)[3]));
+}
+
+/**
+
+  Get the hash bucket of a GUID in a PPI or notify list.
+
+  @param Guid            Pointer to the GUID.
+
+  @return The index of the hash bucket, less than PPI_HASH_BUCKETS.
+
+**/
+UINTN
+PpiGuidHash (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINT32  Hash;
+
+  Hash  = ((UINT32 *)Guid)[0] ^ ((UINT32 *)Guid)[1] ^ ((UINT32 *)Guid)[2] ^ ((UINT32 *)Guid)[3];
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return Hash & (PPI_HASH_BUCKETS - 1);
+}
+
+/**
+
+  Record that a PPI was installed or reinstalled, so the PEIMs whose DEPEX
+  waits for a PPI of its GUID hash bucket are evaluated again.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param Guid            Pointer to the GUID of the PPI.
+
+**/
+VOID
+PpiUpdateGeneration (
+  IN PEI_CORE_INSTANCE   *PrivateData,
+  IN CONST EFI_GUID      *Guid
+  )
+{
+  PrivateData->PpiData.PpiGeneration++;
+  PrivateData->PpiData.PpiBucketGeneration[PpiGuidHash (Guid)] = PrivateData->PpiData.PpiGeneration;
+}
+
+/**
+
+  Check if a PPI of some GUID hash buckets was installed or reinstalled since
+  a given generation of the PPI database.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param PpiMask         One bit per GUID hash bucket.
+  @param PpiGeneration   The generation of the PPI database to compare with.
+
+  @retval TRUE           A PPI of one of the buckets was installed or reinstalled.
+  @retval FALSE          None of the buckets changed.
+
+**/
+BOOLEAN
+PpiInstalledSince (
+  IN PEI_CORE_INSTANCE   *PrivateData,
+  IN UINT32              PpiMask,
+  IN UINT32              PpiGeneration
+  )
+{
+  UINTN   Bucket;
+
+  if (PrivateData->PpiData.PpiGeneration == PpiGeneration) {
+    return FALSE;
+  }
+
+  for (Bucket = 0; Bucket < PPI_HASH_BUCKETS; Bucket++) {
+    if (((PpiMask & (1u << Bucket)) != 0) &&
+        (PrivateData->PpiData.PpiBucketGeneration[Bucket] > PpiGeneration)) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/**
+
+  Link an entry of a PPI or notify list into the hash bucket of its GUID.
+  The entries of a bucket are kept in ascending order.
+
+  @param List            Pointer to the PPI or notify list.
+  @param Index           Index of the entry to link.
+
+**/
+VOID
+PpiListHashInsert (
+  IN OUT PEI_PPI_LIST  *List,
+  IN     INTN          Index
+  )
+{
+  INTN  *Link;
+
+  //
+  // The GUID is at the same offset in the PPI and the notify descriptors.
+  //
+  Link = &List->HashHead[PpiGuidHash (List->Entries[Index].Pointer.Ppi->Guid)];
+  while ((*Link != PPI_HASH_END) && (*Link < Index)) {
+    Link = &List->Entries[*Link].HashNext;
+  }
+  List->Entries[Index].HashNext = *Link;
+  *Link = Index;
+}
+
+/**
+
+  Unlink an entry of a PPI or notify list from the hash bucket of its GUID.
+
+  @param List            Pointer to the PPI or notify list.
+  @param Index           Index of the entry to unlink.
+
+**/
+VOID
+PpiListHashRemove (
+  IN OUT PEI_PPI_LIST  *List,
+  IN     INTN          Index
+  )
+{
+  INTN  *Link;
+
+  Link = &List->HashHead[PpiGuidHash (List->Entries[Index].Pointer.Ppi->Guid)];
+  while (*Link != Index) {
+    ASSERT (*Link != PPI_HASH_END);
+    Link = &List->Entries[*Link].HashNext;
+  }
+  *Link = List->Entries[Index].HashNext;
+}
+
+/**
+
+  Reserve entries at the end of a PPI or notify list.
+
+  The lists following List in the entry buffer of the PPI database are moved
+  up to make room. The buffer keeps the PcdPeiCoreMaxPpiSupported entries it
+  was created with until permanent memory is installed. After that, it is
+  moved to a larger buffer when it is full. The old buffer is a memory pool
+  HOB, so it is not freed.
+
+  The caller must fill all the reserved entries before the lists are used again.
+
+  @param PrivateData     Pointer to the PEI Core data.
+  @param List            Pointer to the PPI or notify list.
+  @param Count           Number of entries to be added.
+
+  @retval EFI_SUCCESS           Count entries are reserved at the end of the list.
+  @retval EFI_OUT_OF_RESOURCES  The buffer is full and can not grow.
+
+**/
+EFI_STATUS
+PpiListReserve (
+  IN     PEI_CORE_INSTANCE  *PrivateData,
+  IN OUT PEI_PPI_LIST       *List,
+  IN     INTN               Count
+  )
+{
+  PEI_PPI_DATABASE    *PpiData;
+  PEI_PPI_LIST        *Lists[3];
+  PEI_PPI_LIST_ENTRY  *Entries;
+  PEI_PPI_LIST_ENTRY  *End;
+  INTN                NewMaxCount;
+  UINTN               Index;
+
+  if (Count == 0) {
+    return EFI_SUCCESS;
+  }
+
+  PpiData  = &PrivateData->PpiData;
+  Lists[0] = &PpiData->PpiList;
+  Lists[1] = &PpiData->CallbackNotifyList;
+  Lists[2] = &PpiData->DispatchNotifyList;
+
+  if (PpiData->EntryCount + Count > PpiData->MaxEntryCount) {
+    if (!PrivateData->PeiMemoryInstalled) {
+      //
+      // PcdPeiCoreMaxPpiSupported can be set to a larger value in DSC to satisfy
+      // more PPI requirement before permanent memory is installed.
+      //
+      DEBUG ((EFI_D_ERROR, "ERROR -> PPI database is full, increase PcdPeiCoreMaxPpiSupported\n"));
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    NewMaxCount = MAX (PpiData->MaxEntryCount * 2, PpiData->EntryCount + Count);
+    Entries = AllocateZeroPool (sizeof (PEI_PPI_LIST_ENTRY) * NewMaxCount);
+    if (Entries == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    CopyMem (Entries, PpiData->Entries, sizeof (PEI_PPI_LIST_ENTRY) * PpiData->EntryCount);
+    for (Index = 0; Index < sizeof (Lists) / sizeof (Lists[0]); Index++) {
+      Lists[Index]->Entries = Entries + (Lists[Index]->Entries - PpiData->Entries);
+    }
+    PpiData->Entries       = Entries;
+    PpiData->MaxEntryCount = NewMaxCount;
+  }
+
+  //
+  // The entries hold indexes within their own list only, so the lists following
+  // List can be moved as a whole.
+  //
+  End = List->Entries + List->CurrentCount;
+  CopyMem (End + Count, End, sizeof (PEI_PPI_LIST_ENTRY) * (PpiData->Entries + PpiData->EntryCount - End));
+  for (Index = 0; Lists[Index] != List; Index++) {
+    ASSERT (Index < sizeof (Lists) / sizeof (Lists[0]) - 1);
+  }
+  for (Index++; Index < sizeof (Lists) / sizeof (Lists[0]); Index++) {
+    Lists[Index]->Entries += Count;
+  }
+  PpiData->EntryCount += Count;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Initialize an empty PPI or notify list.
+
+  @param List            Pointer to the PPI or notify list.
+  @param Entries         First entry of the list in the entry buffer.
+
+**/
+VOID
+InitializePpiList (
+  OUT PEI_PPI_LIST        *List,
+  IN  PEI_PPI_LIST_ENTRY  *Entries
+  )
+{
+  UINTN  Index;
+
+  List->CurrentCount        = 0;
+  List->LastDispatchedCount = 0;
+  List->Entries             = Entries;
+
+  for (Index = 0; Index < PPI_HASH_BUCKETS; Index++) {
+    List->HashHead[Index] = PPI_HASH_END;
+  }
+}
+
 /**
 
   Initialize PPI services.
 
   @param PrivateData     Pointer to the PEI Core data.
-  @param OldCoreData     Pointer to old PEI Core data. 
+  @param OldCoreData     Pointer to old PEI Core data.
                          NULL if being run in non-permament memory mode.
 
 **/
@@ -30,9 +293,14 @@ InitializePpiServices (
   )
 {
   if (OldCoreData == NULL) {
-    PrivateData->PpiData.NotifyListEnd = PcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
-    PrivateData->PpiData.DispatchListEnd = PcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
-    PrivateData->PpiData.LastDispatchedNotify = PcdGet32 (PcdPeiCoreMaxPpiSupported)-1;
+    PrivateData->PpiData.EntryCount    = 0;
+    PrivateData->PpiData.MaxEntryCount = PcdGet32 (PcdPeiCoreMaxPpiSupported);
+    PrivateData->PpiData.Entries       = AllocateZeroPool (sizeof (PEI_PPI_LIST_ENTRY) * PrivateData->PpiData.MaxEntryCount);
+    ASSERT (PrivateData->PpiData.Entries != NULL);
+
+    InitializePpiList (&PrivateData->PpiData.PpiList, PrivateData->PpiData.Entries);
+    InitializePpiList (&PrivateData->PpiData.CallbackNotifyList, PrivateData->PpiData.Entries);
+    InitializePpiList (&PrivateData->PpiData.DispatchNotifyList, PrivateData->PpiData.Entries);
   }
 }
 
@@ -44,7 +312,7 @@ InitializePpiServices (
   @param TempBottom      Base of old temporary memory
   @param TempTop         Top of old temporary memory
   @param Offset          Offset of new memory to old temporary memory.
-  @param OffsetPositive  Positive flag of Offset value. 
+  @param OffsetPositive  Positive flag of Offset value.
 
 **/
 VOID
@@ -103,69 +371,93 @@ ConvertSinglePpiPointer (
 
 /**
 
-  Migrate PPI Pointers from the temporary memory stack to PEI installed memory.
+  Migrate the PPI Pointers of a PPI or notify list from the temporary memory stack
+  to PEI installed memory.
+
+  The hash index of the list does not need to be converted, as it holds indexes
+  of entries and depends on the GUID values only.
 
-  @param SecCoreData     Points to a data structure containing SEC to PEI handoff data, such as the size 
+  @param SecCoreData     Points to a data structure containing SEC to PEI handoff data, such as the size
                          and location of temporary RAM, the stack location and the BFV location.
   @param PrivateData     Pointer to PeiCore's private data structure.
+  @param List            Pointer to the PPI or notify list.
 
 **/
 VOID
-ConvertPpiPointers (
+ConvertPpiListPointers (
   IN CONST EFI_SEC_PEI_HAND_OFF  *SecCoreData,
-  IN PEI_CORE_INSTANCE           *PrivateData
+  IN PEI_CORE_INSTANCE           *PrivateData,
+  IN PEI_PPI_LIST                *List
   )
 {
-  UINT8                 Index;
+  INTN                  Index;
   UINT8                 IndexHole;
 
-  for (Index = 0; Index < PcdGet32 (PcdPeiCoreMaxPpiSupported); Index++) {
-    if (Index < PrivateData->PpiData.PpiListEnd || Index > PrivateData->PpiData.NotifyListEnd) {
-      //
-      // Convert PPI pointer in old Heap
-      //
-      ConvertSinglePpiPointer (
-        &PrivateData->PpiData.PpiListPtrs[Index],
-        (UINTN)SecCoreData->PeiTemporaryRamBase,
-        (UINTN)SecCoreData->PeiTemporaryRamBase + SecCoreData->PeiTemporaryRamSize,
-        PrivateData->HeapOffset,
-        PrivateData->HeapOffsetPositive
-        );
-        
-      //
-      // Convert PPI pointer in old Stack
-      //
+  for (Index = 0; Index < List->CurrentCount; Index++) {
+    //
+    // Convert PPI pointer in old Heap
+    //
+    ConvertSinglePpiPointer (
+      &List->Entries[Index].Pointer,
+      (UINTN)SecCoreData->PeiTemporaryRamBase,
+      (UINTN)SecCoreData->PeiTemporaryRamBase + SecCoreData->PeiTemporaryRamSize,
+      PrivateData->HeapOffset,
+      PrivateData->HeapOffsetPositive
+      );
+
+    //
+    // Convert PPI pointer in old Stack
+    //
+    ConvertSinglePpiPointer (
+      &List->Entries[Index].Pointer,
+      (UINTN)SecCoreData->StackBase,
+      (UINTN)SecCoreData->StackBase + SecCoreData->StackSize,
+      PrivateData->StackOffset,
+      PrivateData->StackOffsetPositive
+      );
+
+    //
+    // Convert PPI pointer in old TempRam Hole
+    //
+    for (IndexHole = 0; IndexHole < HOLE_MAX_NUMBER; IndexHole ++) {
+      if (PrivateData->HoleData[IndexHole].Size == 0) {
+        continue;
+      }
+
       ConvertSinglePpiPointer (
-        &PrivateData->PpiData.PpiListPtrs[Index],
-        (UINTN)SecCoreData->StackBase,
-        (UINTN)SecCoreData->StackBase + SecCoreData->StackSize,
-        PrivateData->StackOffset,
-        PrivateData->StackOffsetPositive
+        &List->Entries[Index].Pointer,
+        (UINTN)PrivateData->HoleData[IndexHole].Base,
+        (UINTN)PrivateData->HoleData[IndexHole].Base + PrivateData->HoleData[IndexHole].Size,
+        PrivateData->HoleData[IndexHole].Offset,
+        PrivateData->HoleData[IndexHole].OffsetPositive
         );
-        
-      //
-      // Convert PPI pointer in old TempRam Hole
-      //
-      for (IndexHole = 0; IndexHole < HOLE_MAX_NUMBER; IndexHole ++) {
-        if (PrivateData->HoleData[IndexHole].Size == 0) {
-          continue;
-        }
-        
-        ConvertSinglePpiPointer (
-          &PrivateData->PpiData.PpiListPtrs[Index],
-          (UINTN)PrivateData->HoleData[IndexHole].Base,
-          (UINTN)PrivateData->HoleData[IndexHole].Base + PrivateData->HoleData[IndexHole].Size,
-          PrivateData->HoleData[IndexHole].Offset,
-          PrivateData->HoleData[IndexHole].OffsetPositive
-          );
-      }
     }
   }
 }
 
 /**
 
-  This function installs an interface in the PEI PPI database by GUID. 
+  Migrate PPI Pointers from the temporary memory stack to PEI installed memory.
+
+  @param SecCoreData     Points to a data structure containing SEC to PEI handoff data, such as the size
+                         and location of temporary RAM, the stack location and the BFV location.
+  @param PrivateData     Pointer to PeiCore's private data structure.
+
+**/
+VOID
+ConvertPpiPointers (
+  IN CONST EFI_SEC_PEI_HAND_OFF  *SecCoreData,
+  IN PEI_CORE_INSTANCE           *PrivateData
+  )
+{
+  ConvertPpiListPointers (SecCoreData, PrivateData, &PrivateData->PpiData.PpiList);
+  ConvertPpiListPointers (SecCoreData, PrivateData, &PrivateData->PpiData.CallbackNotifyList);
+  ConvertPpiListPointers (SecCoreData, PrivateData, &PrivateData->PpiData.DispatchNotifyList);
+}
+
+/**
+
+  This function installs an interface in the PEI PPI database by GUID.
   The purpose of the service is to publish an interface that other parties
   can use to call additional PEIMs.
 
@@ -186,8 +478,11 @@ PeiInstallPpi (
   )
 {
   PEI_CORE_INSTANCE *PrivateData;
+  PEI_PPI_LIST      *List;
+  INTN              Count;
   INTN              Index;
   INTN              LastCallbackInstall;
+  EFI_STATUS        Status;
 
 
   if (PpiList == NULL) {
@@ -195,49 +490,40 @@ PeiInstallPpi (
   }
 
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
-
-  Index = PrivateData->PpiData.PpiListEnd;
-  LastCallbackInstall = Index;
+  List        = &PrivateData->PpiData.PpiList;
 
   //
-  // This is loop installs all PPI descriptors in the PpiList.  It is terminated
-  // by the EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST being set in the last
+  // Check all PPI descriptors in the PpiList first, so that none is installed
+  // if one of them is not valid. The list is terminated by the
+  // EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST being set in the last
   // EFI_PEI_PPI_DESCRIPTOR in the list.
   //
-
-  for (;;) {
-    //
-    // Since PpiData is used for NotifyList and PpiList, max resource
-    // is reached if the Install reaches the NotifyList
-    // PcdPeiCoreMaxPpiSupported can be set to a larger value in DSC to satisfy more PPI requirement.
-    //
-    if (Index == PrivateData->PpiData.NotifyListEnd + 1) {
-      return  EFI_OUT_OF_RESOURCES;
-    }
-    //
-    // Check if it is a valid PPI.
-    // If not, rollback list to exclude all in this list.
-    // Try to indicate which item failed.
-    //
-    if ((PpiList->Flags & EFI_PEI_PPI_DESCRIPTOR_PPI) == 0) {
-      PrivateData->PpiData.PpiListEnd = LastCallbackInstall;
-      DEBUG((EFI_D_ERROR, "ERROR -> InstallPpi: %g %p\n", PpiList->Guid, PpiList->Ppi));
+  for (Count = 0; ; Count++) {
+    if ((PpiList[Count].Flags & EFI_PEI_PPI_DESCRIPTOR_PPI) == 0) {
+      DEBUG((EFI_D_ERROR, "ERROR -> InstallPpi: %g %p\n", PpiList[Count].Guid, PpiList[Count].Ppi));
       return  EFI_INVALID_PARAMETER;
     }
 
-    DEBUG((EFI_D_INFO, "Install PPI: %g\n", PpiList->Guid));
-    PrivateData->PpiData.PpiListPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR*) PpiList;
-    PrivateData->PpiData.PpiListEnd++;
-
-    //
-    // Continue until the end of the PPI List.
-    //
-    if ((PpiList->Flags & EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST) ==
+    if ((PpiList[Count].Flags & EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST) ==
         EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST) {
+      Count++;
       break;
     }
-    PpiList++;
-    Index++;
+  }
+
+  Status = PpiListReserve (PrivateData, List, Count);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  LastCallbackInstall = List->CurrentCount;
+
+  for (Index = 0; Index < Count; Index++) {
+    DEBUG((EFI_D_INFO, "Install PPI: %g\n", PpiList[Index].Guid));
+    List->Entries[List->CurrentCount].Pointer.Ppi = (EFI_PEI_PPI_DESCRIPTOR *) &PpiList[Index];
+    PpiListHashInsert (List, List->CurrentCount);
+    PpiUpdateGeneration (PrivateData, PpiList[Index].Guid);
+    List->CurrentCount++;
   }
 
   //
@@ -247,9 +533,9 @@ PeiInstallPpi (
     PrivateData,
     EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK,
     LastCallbackInstall,
-    PrivateData->PpiData.PpiListEnd,
-    PrivateData->PpiData.DispatchListEnd,
-    PrivateData->PpiData.NotifyListEnd
+    List->CurrentCount,
+    0,
+    PrivateData->PpiData.CallbackNotifyList.CurrentCount
     );
 
 
@@ -258,9 +544,9 @@ PeiInstallPpi (
 
 /**
 
-  This function reinstalls an interface in the PEI PPI database by GUID. 
-  The purpose of the service is to publish an interface that other parties can 
-  use to replace an interface of the same name in the protocol database with a 
+  This function reinstalls an interface in the PEI PPI database by GUID.
+  The purpose of the service is to publish an interface that other parties can
+  use to replace an interface of the same name in the protocol database with a
   different interface.
 
   @param PeiServices            An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
@@ -282,6 +568,7 @@ PeiReInstallPpi (
   )
 {
   PEI_CORE_INSTANCE   *PrivateData;
+  PEI_PPI_LIST        *List;
   INTN                Index;
 
 
@@ -294,17 +581,18 @@ PeiReInstallPpi (
   }
 
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
+  List        = &PrivateData->PpiData.PpiList;
 
   //
-  // Find the old PPI instance in the database.  If we can not find it,
-  // return the EFI_NOT_FOUND error.
+  // Find the old PPI instance in the hash bucket of its GUID.  If we can not
+  // find it, return the EFI_NOT_FOUND error.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiListEnd; Index++) {
-    if (OldPpi == PrivateData->PpiData.PpiListPtrs[Index].Ppi) {
+  for (Index = List->HashHead[PpiGuidHash (OldPpi->Guid)]; Index != PPI_HASH_END; Index = List->Entries[Index].HashNext) {
+    if (OldPpi == List->Entries[Index].Pointer.Ppi) {
       break;
     }
   }
-  if (Index == PrivateData->PpiData.PpiListEnd) {
+  if (Index == PPI_HASH_END) {
     return EFI_NOT_FOUND;
   }
 
@@ -312,8 +600,12 @@ PeiReInstallPpi (
   // Remove the old PPI from the database, add the new one.
   //
   DEBUG((EFI_D_INFO, "Reinstall PPI: %g\n", NewPpi->Guid));
-  ASSERT (Index < (INTN)(PcdGet32 (PcdPeiCoreMaxPpiSupported)));
-  PrivateData->PpiData.PpiListPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) NewPpi;
+  ASSERT (Index < List->CurrentCount);
+  PpiListHashRemove (List, Index);
+  List->Entries[Index].Pointer.Ppi = (EFI_PEI_PPI_DESCRIPTOR *) NewPpi;
+  PpiListHashInsert (List, Index);
+  PpiUpdateGeneration (PrivateData, OldPpi->Guid);
+  PpiUpdateGeneration (PrivateData, NewPpi->Guid);
 
   //
   // Dispatch any callback level notifies for the newly installed PPI.
@@ -323,8 +615,8 @@ PeiReInstallPpi (
     EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK,
     Index,
     Index+1,
-    PrivateData->PpiData.DispatchListEnd,
-    PrivateData->PpiData.NotifyListEnd
+    0,
+    PrivateData->PpiData.CallbackNotifyList.CurrentCount
     );
 
 
@@ -358,29 +650,24 @@ PeiLocatePpi (
   )
 {
   PEI_CORE_INSTANCE   *PrivateData;
+  PEI_PPI_LIST        *List;
   INTN                Index;
   EFI_GUID            *CheckGuid;
   EFI_PEI_PPI_DESCRIPTOR  *TempPtr;
 
 
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
+  List        = &PrivateData->PpiData.PpiList;
 
   //
-  // Search the data base for the matching instance of the GUIDed PPI.
+  // Search the hash bucket of the GUID for the matching instance of the GUIDed PPI.
+  // The bucket is in the order the PPIs were installed.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiListEnd; Index++) {
-    TempPtr = PrivateData->PpiData.PpiListPtrs[Index].Ppi;
+  for (Index = List->HashHead[PpiGuidHash (Guid)]; Index != PPI_HASH_END; Index = List->Entries[Index].HashNext) {
+    TempPtr = List->Entries[Index].Pointer.Ppi;
     CheckGuid = TempPtr->Guid;
 
-    //
-    // Don't use CompareGuid function here for performance reasons.
-    // Instead we compare the GUID as INT32 at a time and branch
-    // on the first failed comparison.
-    //
-    if ((((INT32 *)Guid)[0] == ((INT32 *)CheckGuid)[0]) &&
-        (((INT32 *)Guid)[1] == ((INT32 *)CheckGuid)[1]) &&
-        (((INT32 *)Guid)[2] == ((INT32 *)CheckGuid)[2]) &&
-        (((INT32 *)Guid)[3] == ((INT32 *)CheckGuid)[3])) {
+    if (IsPpiGuidEqual (Guid, CheckGuid)) {
       if (Instance == 0) {
 
         if (PpiDescriptor != NULL) {
@@ -403,8 +690,8 @@ PeiLocatePpi (
 
 /**
 
-  This function installs a notification service to be called back when a given 
-  interface is installed or reinstalled. The purpose of the service is to publish 
+  This function installs a notification service to be called back when a given
+  interface is installed or reinstalled. The purpose of the service is to publish
   an interface that other parties can use to call additional PPIs that may materialize later.
 
   @param PeiServices        An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
@@ -423,11 +710,14 @@ PeiNotifyPpi (
   )
 {
   PEI_CORE_INSTANCE                *PrivateData;
+  PEI_PPI_LIST                     *CallbackList;
+  PEI_PPI_LIST                     *DispatchList;
+  PEI_PPI_LIST                     *List;
+  INTN                             Count;
   INTN                             Index;
-  INTN                             NotifyIndex;
   INTN                             LastCallbackNotify;
-  EFI_PEI_NOTIFY_DESCRIPTOR        *NotifyPtr;
   UINTN                            NotifyDispatchCount;
+  EFI_STATUS                       Status;
 
 
   NotifyDispatchCount = 0;
@@ -436,72 +726,58 @@ PeiNotifyPpi (
     return EFI_INVALID_PARAMETER;
   }
 
-  PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
-
-  Index = PrivateData->PpiData.NotifyListEnd;
-  LastCallbackNotify = Index;
+  PrivateData  = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
+  CallbackList = &PrivateData->PpiData.CallbackNotifyList;
+  DispatchList = &PrivateData->PpiData.DispatchNotifyList;
 
   //
-  // This is loop installs all Notify descriptors in the NotifyList.  It is
-  // terminated by the EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST being set in the last
+  // Check all Notify descriptors in the NotifyList first, so that none is
+  // installed if one of them is not valid. The list is terminated by the
+  // EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST being set in the last
   // EFI_PEI_NOTIFY_DESCRIPTOR in the list.
   //
-
-  for (;;) {
-    //
-    // Since PpiData is used for NotifyList and InstallList, max resource
-    // is reached if the Install reaches the PpiList
-    // PcdPeiCoreMaxPpiSupported can be set to a larger value in DSC to satisfy more Notify PPIs requirement.
-    //
-    if (Index == PrivateData->PpiData.PpiListEnd - 1) {
-      return  EFI_OUT_OF_RESOURCES;
-    }
-
-    //
-    // If some of the PPI data is invalid restore original Notify PPI database value
-    //
-    if ((NotifyList->Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_TYPES) == 0) {
-        PrivateData->PpiData.NotifyListEnd = LastCallbackNotify;
-        DEBUG((EFI_D_ERROR, "ERROR -> InstallNotify: %g %p\n", NotifyList->Guid, NotifyList->Notify));
+  for (Count = 0; ; Count++) {
+    if ((NotifyList[Count].Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_TYPES) == 0) {
+      DEBUG((EFI_D_ERROR, "ERROR -> InstallNotify: %g %p\n", NotifyList[Count].Guid, NotifyList[Count].Notify));
       return  EFI_INVALID_PARAMETER;
     }
 
-    if ((NotifyList->Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH) != 0) {
+    if ((NotifyList[Count].Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH) != 0) {
       NotifyDispatchCount ++;
     }
 
-    PrivateData->PpiData.PpiListPtrs[Index].Notify = (EFI_PEI_NOTIFY_DESCRIPTOR *) NotifyList;
-
-    PrivateData->PpiData.NotifyListEnd--;
-    DEBUG((EFI_D_INFO, "Register PPI Notify: %g\n", NotifyList->Guid));
-    if ((NotifyList->Flags & EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST) ==
+    if ((NotifyList[Count].Flags & EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST) ==
         EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST) {
+      Count++;
       break;
     }
-    //
-    // Go the next descriptor. Remember the NotifyList moves down.
-    //
-    NotifyList++;
-    Index--;
   }
 
+  Status = PpiListReserve (PrivateData, CallbackList, Count - NotifyDispatchCount);
+  if (!EFI_ERROR (Status)) {
+    Status = PpiListReserve (PrivateData, DispatchList, NotifyDispatchCount);
+  }
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  LastCallbackNotify = CallbackList->CurrentCount;
+
   //
-  // If there is Dispatch Notify PPI installed put them on the bottom
+  // Dispatch notifies go to the dispatch notify list, they are processed by
+  // ProcessNotifyList() after the current PEIM returns.
   //
-  if (NotifyDispatchCount > 0) {
-    for (NotifyIndex = LastCallbackNotify; NotifyIndex > PrivateData->PpiData.NotifyListEnd; NotifyIndex--) {
-      if ((PrivateData->PpiData.PpiListPtrs[NotifyIndex].Notify->Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH) != 0) {
-        NotifyPtr = PrivateData->PpiData.PpiListPtrs[NotifyIndex].Notify;
-
-        for (Index = NotifyIndex; Index < PrivateData->PpiData.DispatchListEnd; Index++){
-          PrivateData->PpiData.PpiListPtrs[Index].Notify = PrivateData->PpiData.PpiListPtrs[Index + 1].Notify;
-        }
-        PrivateData->PpiData.PpiListPtrs[Index].Notify = NotifyPtr;
-        PrivateData->PpiData.DispatchListEnd--;
-      }
+  for (Index = 0; Index < Count; Index++) {
+    if ((NotifyList[Index].Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH) != 0) {
+      List = DispatchList;
+    } else {
+      List = CallbackList;
     }
 
-    LastCallbackNotify -= NotifyDispatchCount;
+    List->Entries[List->CurrentCount].Pointer.Notify = (EFI_PEI_NOTIFY_DESCRIPTOR *) &NotifyList[Index];
+    PpiListHashInsert (List, List->CurrentCount);
+    List->CurrentCount++;
+    DEBUG((EFI_D_INFO, "Register PPI Notify: %g\n", NotifyList[Index].Guid));
   }
 
   //
@@ -511,9 +787,9 @@ PeiNotifyPpi (
     PrivateData,
     EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK,
     0,
-    PrivateData->PpiData.PpiListEnd,
+    PrivateData->PpiData.PpiList.CurrentCount,
     LastCallbackNotify,
-    PrivateData->PpiData.NotifyListEnd
+    CallbackList->CurrentCount
     );
 
   return  EFI_SUCCESS;
@@ -532,27 +808,32 @@ ProcessNotifyList (
   IN PEI_CORE_INSTANCE  *PrivateData
   )
 {
+  PEI_PPI_LIST            *PpiList;
+  PEI_PPI_LIST            *DispatchList;
   INTN                    TempValue;
 
+  PpiList      = &PrivateData->PpiData.PpiList;
+  DispatchList = &PrivateData->PpiData.DispatchNotifyList;
+
   while (TRUE) {
     //
     // Check if the PEIM that was just dispatched resulted in any
     // Notifies getting installed.  If so, go process any dispatch
     // level Notifies that match the previouly installed PPIs.
     // Use "while" instead of "if" since DispatchNotify can modify
-    // DispatchListEnd (with NotifyPpi) so we have to iterate until the same.
+    // the dispatch notify list (with NotifyPpi) so we have to iterate until the same.
     //
-    while (PrivateData->PpiData.LastDispatchedNotify != PrivateData->PpiData.DispatchListEnd) {
-      TempValue = PrivateData->PpiData.DispatchListEnd;
+    while (DispatchList->LastDispatchedCount != DispatchList->CurrentCount) {
+      TempValue = DispatchList->CurrentCount;
       DispatchNotify (
         PrivateData,
         EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH,
         0,
-        PrivateData->PpiData.LastDispatchedInstall,
-        PrivateData->PpiData.LastDispatchedNotify,
-        PrivateData->PpiData.DispatchListEnd
+        PpiList->LastDispatchedCount,
+        DispatchList->LastDispatchedCount,
+        DispatchList->CurrentCount
         );
-      PrivateData->PpiData.LastDispatchedNotify = TempValue;
+      DispatchList->LastDispatchedCount = TempValue;
     }
 
 
@@ -561,22 +842,22 @@ ProcessNotifyList (
     // PPIs getting installed.  If so, go process any dispatch
     // level Notifies that match the installed PPIs.
     // Use "while" instead of "if" since DispatchNotify can modify
-    // PpiListEnd (with InstallPpi) so we have to iterate until the same.
+    // the PPI list (with InstallPpi) so we have to iterate until the same.
     //
-    while (PrivateData->PpiData.LastDispatchedInstall != PrivateData->PpiData.PpiListEnd) {
-      TempValue = PrivateData->PpiData.PpiListEnd;
+    while (PpiList->LastDispatchedCount != PpiList->CurrentCount) {
+      TempValue = PpiList->CurrentCount;
       DispatchNotify (
         PrivateData,
         EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH,
-        PrivateData->PpiData.LastDispatchedInstall,
-        PrivateData->PpiData.PpiListEnd,
-        PcdGet32 (PcdPeiCoreMaxPpiSupported)-1,
-        PrivateData->PpiData.DispatchListEnd
+        PpiList->LastDispatchedCount,
+        PpiList->CurrentCount,
+        0,
+        DispatchList->CurrentCount
         );
-      PrivateData->PpiData.LastDispatchedInstall = TempValue;
+      PpiList->LastDispatchedCount = TempValue;
     }
 
-    if (PrivateData->PpiData.LastDispatchedNotify == PrivateData->PpiData.DispatchListEnd) {
+    if (DispatchList->LastDispatchedCount == DispatchList->CurrentCount) {
       break;
     }
   }
@@ -587,12 +868,16 @@ ProcessNotifyList (
 
   Dispatch notifications.
 
+  The notifies are called in the order they were registered, and for each notify,
+  the matching PPIs in the order they were installed. Only the hash buckets of the
+  GUIDs are searched, so the PPIs or the notifies with other GUIDs are not compared.
+
   @param PrivateData        PeiCore's private data structure
   @param NotifyType         Type of notify to fire.
   @param InstallStartIndex  Install Beginning index.
-  @param InstallStopIndex   Install Ending index.
-  @param NotifyStartIndex   Notify Beginning index.
-  @param NotifyStopIndex    Notify Ending index.
+  @param InstallStopIndex   Install Ending index, not included.
+  @param NotifyStartIndex   Notify Beginning index in the notify list of NotifyType.
+  @param NotifyStopIndex    Notify Ending index in the notify list of NotifyType, not included.
 
 **/
 VOID
@@ -605,31 +890,73 @@ DispatchNotify (
   IN INTN                NotifyStopIndex
   )
 {
-  INTN                   Index1;
-  INTN                   Index2;
-  EFI_GUID                *SearchGuid;
-  EFI_GUID                *CheckGuid;
+  PEI_PPI_LIST                *PpiList;
+  PEI_PPI_LIST                *NotifyList;
+  INTN                        Index1;
+  INTN                        Index2;
+  INTN                        Next;
+  EFI_GUID                    *SearchGuid;
+  EFI_GUID                    *CheckGuid;
   EFI_PEI_NOTIFY_DESCRIPTOR   *NotifyDescriptor;
 
+  PpiList = &PrivateData->PpiData.PpiList;
+  if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH) {
+    NotifyList = &PrivateData->PpiData.DispatchNotifyList;
+  } else {
+    NotifyList = &PrivateData->PpiData.CallbackNotifyList;
+  }
+
   //
-  // Remember that Installs moves up and Notifies moves down.
+  // A notify may install PPIs or notifies, which can move the entries of the
+  // lists to larger buffers, so the entries are always accessed through the lists.
   //
-  for (Index1 = NotifyStartIndex; Index1 > NotifyStopIndex; Index1--) {
-    NotifyDescriptor = PrivateData->PpiData.PpiListPtrs[Index1].Notify;
+  if (InstallStopIndex - InstallStartIndex == 1) {
+    //
+    // Only one PPI is installed, search the notifies in the hash bucket of its GUID.
+    //
+    SearchGuid = PpiList->Entries[InstallStartIndex].Pointer.Ppi->Guid;
+    for (Index1 = NotifyList->HashHead[PpiGuidHash (SearchGuid)]; Index1 != PPI_HASH_END; Index1 = Next) {
+      if (Index1 >= NotifyStopIndex) {
+        break;
+      }
+      Next = NotifyList->Entries[Index1].HashNext;
+      if (Index1 < NotifyStartIndex) {
+        continue;
+      }
+
+      NotifyDescriptor = NotifyList->Entries[Index1].Pointer.Notify;
+      SearchGuid       = PpiList->Entries[InstallStartIndex].Pointer.Ppi->Guid;
+      if (IsPpiGuidEqual (SearchGuid, NotifyDescriptor->Guid)) {
+        DEBUG ((EFI_D_INFO, "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
+          SearchGuid,
+          NotifyDescriptor->Notify
+          ));
+        NotifyDescriptor->Notify (
+                            (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
+                            NotifyDescriptor,
+                            (PpiList->Entries[InstallStartIndex].Pointer.Ppi)->Ppi
+                            );
+      }
+    }
+    return;
+  }
+
+  for (Index1 = NotifyStartIndex; Index1 < NotifyStopIndex; Index1++) {
+    NotifyDescriptor = NotifyList->Entries[Index1].Pointer.Notify;
 
     CheckGuid = NotifyDescriptor->Guid;
 
-    for (Index2 = InstallStartIndex; Index2 < InstallStopIndex; Index2++) {
-      SearchGuid = PrivateData->PpiData.PpiListPtrs[Index2].Ppi->Guid;
-      //
-      // Don't use CompareGuid function here for performance reasons.
-      // Instead we compare the GUID as INT32 at a time and branch
-      // on the first failed comparison.
-      //
-      if ((((INT32 *)SearchGuid)[0] == ((INT32 *)CheckGuid)[0]) &&
-          (((INT32 *)SearchGuid)[1] == ((INT32 *)CheckGuid)[1]) &&
-          (((INT32 *)SearchGuid)[2] == ((INT32 *)CheckGuid)[2]) &&
-          (((INT32 *)SearchGuid)[3] == ((INT32 *)CheckGuid)[3])) {
+    for (Index2 = PpiList->HashHead[PpiGuidHash (CheckGuid)]; Index2 != PPI_HASH_END; Index2 = Next) {
+      if (Index2 >= InstallStopIndex) {
+        break;
+      }
+      Next = PpiList->Entries[Index2].HashNext;
+      if (Index2 < InstallStartIndex) {
+        continue;
+      }
+
+      SearchGuid = PpiList->Entries[Index2].Pointer.Ppi->Guid;
+      if (IsPpiGuidEqual (SearchGuid, CheckGuid)) {
         DEBUG ((EFI_D_INFO, "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
           SearchGuid,
           NotifyDescriptor->Notify
@@ -637,10 +964,9 @@ DispatchNotify (
         NotifyDescriptor->Notify (
                             (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
                             NotifyDescriptor,
-                            (PrivateData->PpiData.PpiListPtrs[Index2].Ppi)->Ppi
+                            (PpiList->Entries[Index2].Pointer.Ppi)->Ppi
                             );
       }
     }
   }
 }
-
@@ -632,6 +632,7 @@ SmmMain (
   }
 
   RegisterSmramProfileHandler ();
+  RegisterSmiHandlerLatencyHandler ();
   SmramProfileInstallProtocol ();
 
   SmmCoreInstallLoadedImage ();
@@ -37,6 +37,7 @@
 #include <Guid/EventGroup.h>
 #include <Guid/EventLegacyBios.h>
 #include <Guid/MemoryProfile.h>
+#include <Guid/SmiHandlerLatency.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -971,6 +972,15 @@ RegisterSmramProfileHandler (
   VOID
   );
 
+/**
+  Register the SMI handler of the SMI handler latency communication.
+
+**/
+VOID
+RegisterSmiHandlerLatencyHandler (
+  VOID
+  );
+
 /**
   SMRAM profile ready to lock callback function.
 
@@ -1017,9 +1027,22 @@ extern LIST_ENTRY  mSmmMemoryMap;
 //
 #define MAX_POOL_INDEX  (MAX_POOL_SHIFT - MIN_POOL_SHIFT + 1)
 
+//
+// A pool block of MAX_POOL_SIZE << 1 bytes is one page. Free pool blocks are
+// coalesced with their buddies, and a page is freed once it is free as a whole.
+//
+// Freed blocks of the POOL_CACHE_INDEX_COUNT smallest sizes are first kept in a
+// cache of up to POOL_CACHE_DEPTH blocks per size without being coalesced, so
+// that blocks that are allocated and freed repeatedly are not split and merged
+// every time. The cache is flushed when an allocation fails.
+//
+#define POOL_CACHE_INDEX_COUNT  3
+#define POOL_CACHE_DEPTH        16
+
 typedef struct {
   UINTN        Size;
   BOOLEAN      Available;
+  BOOLEAN      Cached;     // Valid if Available is TRUE, the block is on mSmmPoolCache
 } POOL_HEADER;
 
 typedef struct {
@@ -1028,5 +1051,6 @@ typedef struct {
 } FREE_POOL_HEADER;
 
 extern LIST_ENTRY  mSmmPoolLists[MAX_POOL_INDEX];
+extern LIST_ENTRY  mSmmPoolCache[POOL_CACHE_INDEX_COUNT];
 
 #endif
@@ -15,6 +15,8 @@
 #include "PiSmmCore.h"
 
 LIST_ENTRY  mSmmPoolLists[MAX_POOL_INDEX];
+LIST_ENTRY  mSmmPoolCache[POOL_CACHE_INDEX_COUNT];
+UINTN       mSmmPoolCacheCount[POOL_CACHE_INDEX_COUNT];
 //
 // To cache the SMRAM base since when Loading modules At fixed address feature is enabled, 
 // all module is assigned an offset relative the SMRAM base in build time.
@@ -45,6 +47,10 @@ SmmInitializeMemoryServices (
   for (Index = sizeof (mSmmPoolLists) / sizeof (*mSmmPoolLists); Index > 0;) {
     InitializeListHead (&mSmmPoolLists[--Index]);
   }
+  for (Index = 0; Index < POOL_CACHE_INDEX_COUNT; Index++) {
+    InitializeListHead (&mSmmPoolCache[Index]);
+    mSmmPoolCacheCount[Index] = 0;
+  }
   CurrentSmramRangesIndex = 0;
   //
   // If Loading Module At fixed Address feature is enabled, cache the SMRAM base here
@@ -121,7 +127,11 @@ InternalAllocPoolByIndex (
   ASSERT (PoolIndex <= MAX_POOL_INDEX);
   Status = EFI_SUCCESS;
   Hdr = NULL;
-  if (PoolIndex == MAX_POOL_INDEX) {
+  if ((PoolIndex < POOL_CACHE_INDEX_COUNT) && !IsListEmpty (&mSmmPoolCache[PoolIndex])) {
+    Hdr = BASE_CR (GetFirstNode (&mSmmPoolCache[PoolIndex]), FREE_POOL_HEADER, Link);
+    RemoveEntryList (&Hdr->Link);
+    mSmmPoolCacheCount[PoolIndex]--;
+  } else if (PoolIndex == MAX_POOL_INDEX) {
     Status = SmmInternalAllocatePages (AllocateAnyPages, EfiRuntimeServicesData, EFI_SIZE_TO_PAGES (MAX_POOL_SIZE << 1), &Address);
     if (EFI_ERROR (Status)) {
       return EFI_OUT_OF_RESOURCES;
@@ -135,6 +145,7 @@ InternalAllocPoolByIndex (
     if (!EFI_ERROR (Status)) {
       Hdr->Header.Size >>= 1;
       Hdr->Header.Available = TRUE;
+      Hdr->Header.Cached = FALSE;
       InsertHeadList (&mSmmPoolLists[PoolIndex], &Hdr->Link);
       Hdr = (FREE_POOL_HEADER*)((UINT8*)Hdr + Hdr->Header.Size);
     }
@@ -143,6 +154,7 @@ InternalAllocPoolByIndex (
   if (!EFI_ERROR (Status)) {
     Hdr->Header.Size = MIN_POOL_SIZE << PoolIndex;
     Hdr->Header.Available = FALSE;
+    Hdr->Header.Cached = FALSE;
   }
 
   *FreePoolHdr = Hdr;
@@ -152,29 +164,103 @@ InternalAllocPoolByIndex (
 /**
   Internal Function. Free a pool by specified PoolIndex.
 
+  The pool is coalesced with its free buddies. If the whole page the pool was
+  split from becomes free, the page is freed.
+
   @param  FreePoolHdr           The pool to free.
+  @param  UseCache              TRUE to keep the pool in the cache if it is small
+                                and the cache is not full.
 
   @retval EFI_SUCCESS           Pool successfully freed.
 
 **/
 EFI_STATUS
 InternalFreePoolByIndex (
-  IN FREE_POOL_HEADER  *FreePoolHdr
+  IN FREE_POOL_HEADER  *FreePoolHdr,
+  IN BOOLEAN           UseCache
   )
 {
-  UINTN  PoolIndex;
+  UINTN             PoolIndex;
+  UINTN             Size;
+  FREE_POOL_HEADER  *Buddy;
 
   ASSERT ((FreePoolHdr->Header.Size & (FreePoolHdr->Header.Size - 1)) == 0);
   ASSERT (((UINTN)FreePoolHdr & (FreePoolHdr->Header.Size - 1)) == 0);
   ASSERT (FreePoolHdr->Header.Size >= MIN_POOL_SIZE);
 
   PoolIndex = (UINTN) (HighBitSet32 ((UINT32)FreePoolHdr->Header.Size) - MIN_POOL_SHIFT);
-  FreePoolHdr->Header.Available = TRUE;
   ASSERT (PoolIndex < MAX_POOL_INDEX);
+
+  if (UseCache && (PoolIndex < POOL_CACHE_INDEX_COUNT) && (mSmmPoolCacheCount[PoolIndex] < POOL_CACHE_DEPTH)) {
+    FreePoolHdr->Header.Available = TRUE;
+    FreePoolHdr->Header.Cached = TRUE;
+    InsertHeadList (&mSmmPoolCache[PoolIndex], &FreePoolHdr->Link);
+    mSmmPoolCacheCount[PoolIndex]++;
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The buddy of a block is the other half of the block it was split from.
+  // Cached blocks are not coalesced until the cache is flushed.
+  //
+  Size = FreePoolHdr->Header.Size;
+  while (Size < (MAX_POOL_SIZE << 1)) {
+    Buddy = (FREE_POOL_HEADER *) ((UINTN) FreePoolHdr ^ Size);
+    if (!Buddy->Header.Available || Buddy->Header.Cached || (Buddy->Header.Size != Size)) {
+      break;
+    }
+    RemoveEntryList (&Buddy->Link);
+    FreePoolHdr = MIN (FreePoolHdr, Buddy);
+    Size <<= 1;
+    PoolIndex++;
+  }
+
+  if (Size == (MAX_POOL_SIZE << 1)) {
+    ASSERT (((UINTN) FreePoolHdr & EFI_PAGE_MASK) == 0);
+    return SmmInternalFreePages (
+             (EFI_PHYSICAL_ADDRESS) (UINTN) FreePoolHdr,
+             EFI_SIZE_TO_PAGES (Size)
+             );
+  }
+
+  FreePoolHdr->Header.Size = Size;
+  FreePoolHdr->Header.Available = TRUE;
+  FreePoolHdr->Header.Cached = FALSE;
   InsertHeadList (&mSmmPoolLists[PoolIndex], &FreePoolHdr->Link);
   return EFI_SUCCESS;
 }
 
+/**
+  Internal Function. Coalesce all pools in the cache with their buddies.
+
+  @retval TRUE                  At least one pool was flushed from the cache.
+  @retval FALSE                 The cache was empty.
+
+**/
+BOOLEAN
+InternalFlushPoolCache (
+  VOID
+  )
+{
+  UINTN             PoolIndex;
+  FREE_POOL_HEADER  *Hdr;
+  BOOLEAN           Flushed;
+
+  Flushed = FALSE;
+  for (PoolIndex = 0; PoolIndex < POOL_CACHE_INDEX_COUNT; PoolIndex++) {
+    while (!IsListEmpty (&mSmmPoolCache[PoolIndex])) {
+      Hdr = BASE_CR (GetFirstNode (&mSmmPoolCache[PoolIndex]), FREE_POOL_HEADER, Link);
+      RemoveEntryList (&Hdr->Link);
+      mSmmPoolCacheCount[PoolIndex]--;
+      Hdr->Header.Available = FALSE;
+      Hdr->Header.Cached = FALSE;
+      InternalFreePoolByIndex (Hdr, FALSE);
+      Flushed = TRUE;
+    }
+  }
+  return Flushed;
+}
+
 /**
   Allocate pool of a particular type.
 
@@ -211,6 +297,9 @@ SmmInternalAllocatePool (
   if (Size > MAX_POOL_SIZE) {
     Size = EFI_SIZE_TO_PAGES (Size);
     Status = SmmInternalAllocatePages (AllocateAnyPages, PoolType, Size, &Address);
+    if (EFI_ERROR (Status) && InternalFlushPoolCache ()) {
+      Status = SmmInternalAllocatePages (AllocateAnyPages, PoolType, Size, &Address);
+    }
     if (EFI_ERROR (Status)) {
       return Status;
     }
@@ -218,6 +307,7 @@ SmmInternalAllocatePool (
     PoolHdr = (POOL_HEADER*)(UINTN)Address;
     PoolHdr->Size = EFI_PAGES_TO_SIZE (Size);
     PoolHdr->Available = FALSE;
+    PoolHdr->Cached = FALSE;
     *Buffer = PoolHdr + 1;
     return Status;
   }
@@ -229,6 +319,9 @@ SmmInternalAllocatePool (
   }
 
   Status = InternalAllocPoolByIndex (PoolIndex, &FreePoolHdr);
+  if (EFI_ERROR (Status) && InternalFlushPoolCache ()) {
+    Status = InternalAllocPoolByIndex (PoolIndex, &FreePoolHdr);
+  }
   if (!EFI_ERROR(Status)) {
     *Buffer = &FreePoolHdr->Header + 1;
   }
@@ -304,7 +397,7 @@ SmmInternalFreePool (
              EFI_SIZE_TO_PAGES (FreePoolHdr->Header.Size)
              );
   }
-  return InternalFreePoolByIndex (FreePoolHdr);
+  return InternalFreePoolByIndex (FreePoolHdr, TRUE);
 }
 
 /**
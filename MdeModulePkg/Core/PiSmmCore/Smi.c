@@ -1,7 +1,11 @@
 /** @file
   SMI management.
 
-  Copyright (c) 2009 - 2013, Intel Corporation. All rights reserved.<BR>
+  The SMI entries are found through a hash table keyed by the handler type GUID.
+  When PcdSmiHandlerLatencyHistogramEnable is TRUE, the time every SMI handler
+  takes is recorded into a histogram of the handler.
+
+  Copyright (c) 2009 - 2016, Intel Corporation. All rights reserved.<BR>
   This program and the accompanying materials are licensed and made available 
   under the terms and conditions of the BSD License which accompanies this 
   distribution.  The full text of the license may be found at        
@@ -23,6 +27,7 @@
  typedef struct {
   UINTN       Signature;
   LIST_ENTRY  AllEntries;  // All entries
+  LIST_ENTRY  HashLink;    // Link on mSmiEntryHash
 
   EFI_GUID    HandlerType; // Type of interrupt
   LIST_ENTRY  SmiHandlers; // All handlers
@@ -35,10 +40,116 @@
   LIST_ENTRY                    Link;        // Link on SMI_ENTRY.SmiHandlers
   EFI_SMM_HANDLER_ENTRY_POINT2  Handler;     // The smm handler's entry point
   SMI_ENTRY                     *SmiEntry;
+  SMI_HANDLER_LATENCY_DATA      *Latency;    // NULL unless PcdSmiHandlerLatencyHistogramEnable is TRUE
 } SMI_HANDLER;
 
+//
+// The number of hash buckets of the SMI entries, must be a power of two
+//
+#define SMI_ENTRY_HASH_BUCKETS  64
+
 LIST_ENTRY  mRootSmiHandlerList = INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiHandlerList);
 LIST_ENTRY  mSmiEntryList       = INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryList);
+LIST_ENTRY  mSmiEntryHash[SMI_ENTRY_HASH_BUCKETS];
+BOOLEAN     mSmiEntryHashInitialized = FALSE;
+
+//
+// The SMI entry found by the last SmiManage() call. SMM communications, such as
+// the variable and FTW requests, usually repeat the same handler type.
+//
+SMI_ENTRY   *mSmiEntryLastManaged = NULL;
+
+//
+// The SMI handler being called by SmiHandlerCall(), or NULL if it unregistered itself
+//
+SMI_HANDLER *mSmiHandlerRunning = NULL;
+
+/**
+  Get the hash bucket of a handler type.
+
+  @param  HandlerType            The type of the interrupt
+
+  @return The hash bucket of HandlerType in mSmiEntryHash.
+
+**/
+LIST_ENTRY *
+SmiEntryHashBucket (
+  IN CONST EFI_GUID  *HandlerType
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+
+  if (!mSmiEntryHashInitialized) {
+    for (Index = 0; Index < SMI_ENTRY_HASH_BUCKETS; Index++) {
+      InitializeListHead (&mSmiEntryHash[Index]);
+    }
+    mSmiEntryHashInitialized = TRUE;
+  }
+
+  Hash  = ReadUnaligned32 ((CONST UINT32 *) HandlerType) ^
+          ReadUnaligned32 ((CONST UINT32 *) HandlerType + 1) ^
+          ReadUnaligned32 ((CONST UINT32 *) HandlerType + 2) ^
+          ReadUnaligned32 ((CONST UINT32 *) HandlerType + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return &mSmiEntryHash[Hash & (SMI_ENTRY_HASH_BUCKETS - 1)];
+}
+
+/**
+  Call a SMI handler, and record the time it takes if
+  PcdSmiHandlerLatencyHistogramEnable is TRUE.
+
+  @param  SmiHandler     The SMI handler to call.
+  @param  Context        Points to an optional context buffer.
+  @param  CommBuffer     Points to the optional communication buffer.
+  @param  CommBufferSize Points to the size of the optional communication buffer.
+
+  @return The status returned by the SMI handler.
+
+**/
+EFI_STATUS
+SmiHandlerCall (
+  IN     SMI_HANDLER     *SmiHandler,
+  IN     CONST VOID      *Context         OPTIONAL,
+  IN OUT VOID            *CommBuffer      OPTIONAL,
+  IN OUT UINTN           *CommBufferSize  OPTIONAL
+  )
+{
+  EFI_STATUS                Status;
+  UINT64                    StartTicks;
+  UINT64                    Ticks;
+  SMI_HANDLER               *PreviousRunning;
+  SMI_HANDLER_LATENCY_DATA  *Latency;
+
+  if (!FeaturePcdGet (PcdSmiHandlerLatencyHistogramEnable)) {
+    return SmiHandler->Handler ((EFI_HANDLE) SmiHandler, Context, CommBuffer, CommBufferSize);
+  }
+
+  PreviousRunning    = mSmiHandlerRunning;
+  mSmiHandlerRunning = SmiHandler;
+  StartTicks = AsmReadTsc ();
+  Status = SmiHandler->Handler ((EFI_HANDLE) SmiHandler, Context, CommBuffer, CommBufferSize);
+  Ticks = AsmReadTsc () - StartTicks;
+  if (mSmiHandlerRunning != SmiHandler) {
+    //
+    // The handler unregistered itself and SmiHandler has been freed.
+    //
+    mSmiHandlerRunning = PreviousRunning;
+    return Status;
+  }
+  mSmiHandlerRunning = PreviousRunning;
+
+  Latency = SmiHandler->Latency;
+  Latency->Count++;
+  Latency->TotalTicks += Ticks;
+  if (Ticks > Latency->MaxTicks) {
+    Latency->MaxTicks = Ticks;
+  }
+  Latency->Histogram[(Ticks == 0) ? 0 : HighBitSet64 (Ticks)]++;
+
+  return Status;
+}
 
 /**
   Finds the SMI entry for the requested handler type.
@@ -57,18 +168,20 @@ SmmCoreFindSmiEntry (
   )
 {
   LIST_ENTRY  *Link;
+  LIST_ENTRY  *Bucket;
   SMI_ENTRY   *Item;
   SMI_ENTRY   *SmiEntry;
 
   //
-  // Search the SMI entry list for the matching GUID
+  // Search the hash bucket of the GUID for the matching SMI entry
   //
   SmiEntry = NULL;
-  for (Link = mSmiEntryList.ForwardLink;
-       Link != &mSmiEntryList;
+  Bucket   = SmiEntryHashBucket (HandlerType);
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR (Link, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+    Item = CR (Link, SMI_ENTRY, HashLink, SMI_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->HandlerType, HandlerType)) {
       //
       // This is the SMI entry
@@ -93,9 +206,10 @@ SmmCoreFindSmiEntry (
       InitializeListHead (&SmiEntry->SmiHandlers);
 
       //
-      // Add it to SMI entry list
+      // Add it to SMI entry list and to the hash bucket of the GUID
       //
       InsertTailList (&mSmiEntryList, &SmiEntry->AllEntries);
+      InsertTailList (Bucket, &SmiEntry->HashLink);
     }
   }
   return SmiEntry;
@@ -143,12 +257,16 @@ SmiManage (
     //
     // Non-root SMI handler
     //
-    SmiEntry = SmmCoreFindSmiEntry ((EFI_GUID *) HandlerType, FALSE);
-    if (SmiEntry == NULL) {
-      //
-      // There is no handler registered for this interrupt source
-      //
-      return Status;
+    SmiEntry = mSmiEntryLastManaged;
+    if ((SmiEntry == NULL) || !CompareGuid (&SmiEntry->HandlerType, HandlerType)) {
+      SmiEntry = SmmCoreFindSmiEntry ((EFI_GUID *) HandlerType, FALSE);
+      if (SmiEntry == NULL) {
+        //
+        // There is no handler registered for this interrupt source
+        //
+        return Status;
+      }
+      mSmiEntryLastManaged = SmiEntry;
     }
 
     Head = &SmiEntry->SmiHandlers;
@@ -157,8 +275,8 @@ SmiManage (
   for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
     SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
 
-    Status = SmiHandler->Handler (
-               (EFI_HANDLE) SmiHandler,
+    Status = SmiHandlerCall (
+               SmiHandler,
                Context,
                CommBuffer,
                CommBufferSize
@@ -250,6 +368,14 @@ SmiHandlerRegister (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  if (FeaturePcdGet (PcdSmiHandlerLatencyHistogramEnable)) {
+    SmiHandler->Latency = AllocateZeroPool (sizeof (SMI_HANDLER_LATENCY_DATA));
+    if (SmiHandler->Latency == NULL) {
+      FreePool (SmiHandler);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
   SmiHandler->Signature = SMI_HANDLER_SIGNATURE;
   SmiHandler->Handler = Handler;
 
@@ -309,7 +435,14 @@ SmiHandlerUnRegister (
 
   SmiEntry = SmiHandler->SmiEntry;
 
+  if (mSmiHandlerRunning == SmiHandler) {
+    mSmiHandlerRunning = NULL;
+  }
+
   RemoveEntryList (&SmiHandler->Link);
+  if (SmiHandler->Latency != NULL) {
+    FreePool (SmiHandler->Latency);
+  }
   FreePool (SmiHandler);
 
   if (SmiEntry == NULL) {
@@ -324,9 +457,299 @@ SmiHandlerUnRegister (
     // No handler registered for this interrupt now, remove the SMI_ENTRY
     //
     RemoveEntryList (&SmiEntry->AllEntries);
+    RemoveEntryList (&SmiEntry->HashLink);
+    if (mSmiEntryLastManaged == SmiEntry) {
+      mSmiEntryLastManaged = NULL;
+    }
 
     FreePool (SmiEntry);
   }
 
   return EFI_SUCCESS;
 }
+
+/**
+  Copy the part of a chunk of the SMI handler latency data that falls into the
+  requested window of the data.
+
+  @param  Chunk          The chunk to copy.
+  @param  ChunkSize      The size of the chunk.
+  @param  Buffer         The buffer receiving the requested window.
+  @param  BufferSize     The size of the requested window.
+  @param  Offset         The offset of the requested window in the data.
+  @param  Position       On input, the offset of the chunk in the data.
+                         On output, the offset of the next chunk.
+
+  @return The number of bytes copied.
+
+**/
+UINT64
+SmiHandlerLatencyCopyChunk (
+  IN     VOID    *Chunk,
+  IN     UINTN   ChunkSize,
+  OUT    UINT8   *Buffer,
+  IN     UINT64  BufferSize,
+  IN     UINT64  Offset,
+  IN OUT UINT64  *Position
+  )
+{
+  UINT64  Start;
+  UINT64  End;
+
+  Start = MAX (*Position, Offset);
+  End   = MIN (*Position + ChunkSize, Offset + BufferSize);
+  *Position += ChunkSize;
+  if (Start >= End) {
+    return 0;
+  }
+
+  CopyMem (Buffer + (Start - Offset), (UINT8 *) Chunk + (Start - (*Position - ChunkSize)), (UINTN) (End - Start));
+  return End - Start;
+}
+
+/**
+  Walk all SMI handlers and get the size of the SMI handler latency data, or
+  copy a window of it.
+
+  @param  Buffer         The buffer receiving the requested window, or NULL to get the size only.
+  @param  BufferSize     The size of the requested window.
+  @param  Offset         The offset of the requested window in the data.
+  @param  Copied         Returns the number of bytes copied. Optional if Buffer is NULL.
+
+  @return The size of the SMI handler latency data.
+
+**/
+UINT64
+SmiHandlerLatencyWalk (
+  OUT VOID    *Buffer      OPTIONAL,
+  IN  UINT64  BufferSize,
+  IN  UINT64  Offset,
+  OUT UINT64  *Copied      OPTIONAL
+  )
+{
+  SMI_HANDLER_LATENCY_HEADER  Header;
+  SMI_HANDLER_LATENCY_RECORD  Record;
+  LIST_ENTRY                  *EntryLink;
+  LIST_ENTRY                  *Link;
+  LIST_ENTRY                  *Head;
+  SMI_ENTRY                   *SmiEntry;
+  SMI_HANDLER                 *SmiHandler;
+  UINT64                      Position;
+  UINT64                      CopiedSize;
+
+  Header.Signature   = SMI_HANDLER_LATENCY_SIGNATURE;
+  Header.RecordCount = 0;
+
+  //
+  // The records are walked twice, to count them for the header and to copy them.
+  //
+  for (EntryLink = &mSmiEntryList; ; EntryLink = EntryLink->ForwardLink) {
+    if (EntryLink == &mSmiEntryList) {
+      Head = &mRootSmiHandlerList;
+    } else {
+      SmiEntry = CR (EntryLink, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+      Head     = &SmiEntry->SmiHandlers;
+    }
+    for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+      Header.RecordCount++;
+    }
+    if (EntryLink->ForwardLink == &mSmiEntryList) {
+      break;
+    }
+  }
+
+  if (Buffer == NULL) {
+    return sizeof (Header) + (UINT64) Header.RecordCount * sizeof (Record);
+  }
+
+  Position   = 0;
+  CopiedSize = SmiHandlerLatencyCopyChunk (&Header, sizeof (Header), Buffer, BufferSize, Offset, &Position);
+
+  for (EntryLink = &mSmiEntryList; ; EntryLink = EntryLink->ForwardLink) {
+    if (EntryLink == &mSmiEntryList) {
+      SmiEntry = NULL;
+      Head     = &mRootSmiHandlerList;
+    } else {
+      SmiEntry = CR (EntryLink, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+      Head     = &SmiEntry->SmiHandlers;
+    }
+    for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+      SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
+      ZeroMem (&Record, sizeof (Record));
+      if (SmiEntry != NULL) {
+        CopyGuid (&Record.HandlerType, &SmiEntry->HandlerType);
+      }
+      Record.Handler = (PHYSICAL_ADDRESS) (UINTN) SmiHandler->Handler;
+      CopyMem (&Record.Latency, SmiHandler->Latency, sizeof (Record.Latency));
+      CopiedSize += SmiHandlerLatencyCopyChunk (&Record, sizeof (Record), Buffer, BufferSize, Offset, &Position);
+    }
+    if (EntryLink->ForwardLink == &mSmiEntryList) {
+      break;
+    }
+  }
+
+  if (Copied != NULL) {
+    *Copied = CopiedSize;
+  }
+  return Position;
+}
+
+/**
+  Clear the latency histograms of all SMI handlers.
+
+**/
+VOID
+SmiHandlerLatencyReset (
+  VOID
+  )
+{
+  LIST_ENTRY                  *EntryLink;
+  LIST_ENTRY                  *Link;
+  LIST_ENTRY                  *Head;
+  SMI_ENTRY                   *SmiEntry;
+  SMI_HANDLER                 *SmiHandler;
+
+  for (EntryLink = &mSmiEntryList; ; EntryLink = EntryLink->ForwardLink) {
+    if (EntryLink == &mSmiEntryList) {
+      Head = &mRootSmiHandlerList;
+    } else {
+      SmiEntry = CR (EntryLink, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+      Head     = &SmiEntry->SmiHandlers;
+    }
+    for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+      SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
+      ZeroMem (SmiHandler->Latency, sizeof (*SmiHandler->Latency));
+    }
+    if (EntryLink->ForwardLink == &mSmiEntryList) {
+      break;
+    }
+  }
+}
+
+/**
+  Dispatch function of the SMI handler latency communication.
+
+  Caution: This function may receive untrusted input.
+  Communicate buffer and buffer size are external input, so this function will do basic validation.
+
+  @param DispatchHandle  The unique handle assigned to this handler by SmiHandlerRegister().
+  @param Context         Points to an optional handler context which was specified when the
+                         handler was registered.
+  @param CommBuffer      A pointer to a collection of data in memory that will
+                         be conveyed from a non-SMM environment into an SMM environment.
+  @param CommBufferSize  The size of the CommBuffer.
+
+  @retval EFI_SUCCESS Command is handled successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+SmiHandlerLatencyHandler (
+  IN EFI_HANDLE  DispatchHandle,
+  IN CONST VOID  *Context         OPTIONAL,
+  IN OUT VOID    *CommBuffer      OPTIONAL,
+  IN OUT UINTN   *CommBufferSize  OPTIONAL
+  )
+{
+  SMI_HANDLER_LATENCY_PARAMETER_HEADER              *ParameterHeader;
+  SMI_HANDLER_LATENCY_PARAMETER_GET_INFO            *ParameterGetInfo;
+  SMI_HANDLER_LATENCY_PARAMETER_GET_DATA_BY_OFFSET  *ParameterGetData;
+  SMI_HANDLER_LATENCY_PARAMETER_GET_DATA_BY_OFFSET  GetData;
+  UINTN                                             TempCommBufferSize;
+
+  //
+  // If input is invalid, stop processing this SMI
+  //
+  if (CommBuffer == NULL || CommBufferSize == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  TempCommBufferSize = *CommBufferSize;
+
+  if (TempCommBufferSize < sizeof (SMI_HANDLER_LATENCY_PARAMETER_HEADER)) {
+    DEBUG ((EFI_D_ERROR, "SmiHandlerLatencyHandler: SMM communication buffer size invalid!\n"));
+    return EFI_SUCCESS;
+  }
+
+  if (!SmmIsBufferOutsideSmmValid ((UINTN) CommBuffer, TempCommBufferSize)) {
+    DEBUG ((EFI_D_ERROR, "SmiHandlerLatencyHandler: SMM communication buffer in SMRAM or overflow!\n"));
+    return EFI_SUCCESS;
+  }
+
+  ParameterHeader = (SMI_HANDLER_LATENCY_PARAMETER_HEADER *) CommBuffer;
+  ParameterHeader->ReturnStatus = (UINT64)-1;
+
+  switch (ParameterHeader->Command) {
+  case SMI_HANDLER_LATENCY_COMMAND_GET_INFO:
+    if (TempCommBufferSize != sizeof (SMI_HANDLER_LATENCY_PARAMETER_GET_INFO)) {
+      DEBUG ((EFI_D_ERROR, "SmiHandlerLatencyHandler: SMM communication buffer size invalid!\n"));
+      return EFI_SUCCESS;
+    }
+    ParameterGetInfo = (SMI_HANDLER_LATENCY_PARAMETER_GET_INFO *) CommBuffer;
+    ParameterGetInfo->DataSize = SmiHandlerLatencyWalk (NULL, 0, 0, NULL);
+    ParameterGetInfo->Header.ReturnStatus = 0;
+    break;
+
+  case SMI_HANDLER_LATENCY_COMMAND_GET_DATA_BY_OFFSET:
+    if (TempCommBufferSize != sizeof (SMI_HANDLER_LATENCY_PARAMETER_GET_DATA_BY_OFFSET)) {
+      DEBUG ((EFI_D_ERROR, "SmiHandlerLatencyHandler: SMM communication buffer size invalid!\n"));
+      return EFI_SUCCESS;
+    }
+    ParameterGetData = (SMI_HANDLER_LATENCY_PARAMETER_GET_DATA_BY_OFFSET *) CommBuffer;
+    CopyMem (&GetData, ParameterGetData, sizeof (GetData));
+
+    //
+    // Sanity check
+    //
+    if (!SmmIsBufferOutsideSmmValid ((UINTN) GetData.DataBuffer, (UINTN) GetData.DataSize)) {
+      DEBUG ((EFI_D_ERROR, "SmiHandlerLatencyHandler: SMM DataBuffer in SMRAM or overflow!\n"));
+      ParameterGetData->Header.ReturnStatus = (UINT64) (INT64) (INTN) EFI_ACCESS_DENIED;
+      break;
+    }
+
+    SmiHandlerLatencyWalk (
+      (VOID *) (UINTN) GetData.DataBuffer,
+      GetData.DataSize,
+      GetData.DataOffset,
+      &GetData.DataSize
+      );
+    GetData.DataOffset += GetData.DataSize;
+    CopyMem (ParameterGetData, &GetData, sizeof (GetData));
+    ParameterGetData->Header.ReturnStatus = 0;
+    break;
+
+  case SMI_HANDLER_LATENCY_COMMAND_RESET:
+    SmiHandlerLatencyReset ();
+    ParameterHeader->ReturnStatus = 0;
+    break;
+
+  default:
+    break;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Register the SMI handler of the SMI handler latency communication.
+
+**/
+VOID
+RegisterSmiHandlerLatencyHandler (
+  VOID
+  )
+{
+  EFI_STATUS    Status;
+  EFI_HANDLE    DispatchHandle;
+
+  if (!FeaturePcdGet (PcdSmiHandlerLatencyHistogramEnable)) {
+    return;
+  }
+
+  Status = SmiHandlerRegister (
+             SmiHandlerLatencyHandler,
+             &gEdkiiSmiHandlerLatencyGuid,
+             &DispatchHandle
+             );
+  ASSERT_EFI_ERROR (Status);
+}
@@ -77,6 +77,12 @@ GLOBAL_REMOVE_IF_UNREFERENCED MEMORY_PROFILE_CONTEXT_DATA mSmramProfileContext =
 };
 GLOBAL_REMOVE_IF_UNREFERENCED MEMORY_PROFILE_CONTEXT_DATA *mSmramProfileContextPtr = NULL;
 
+//
+// The free pool lists followed by the small pool cache lists, the blocks in
+// the cache are free from the profile point of view.
+//
+#define SMRAM_FREE_POOL_LIST_COUNT  (MAX_POOL_INDEX + POOL_CACHE_INDEX_COUNT)
+
 BOOLEAN mSmramReadyToLock;
 BOOLEAN mSmramProfileGettingStatus = FALSE;
 BOOLEAN mSmramProfileRecordingEnable = MEMORY_PROFILE_RECORDING_DISABLE;
@@ -1064,6 +1070,26 @@ GetProfileMemoryIndex (
   return MemoryType;
 }
 
+/**
+  Return the free pool list of the given index, the indexes after the free
+  pool lists select the small pool cache lists.
+
+  @param Index          Index of the list, less than SMRAM_FREE_POOL_LIST_COUNT.
+
+  @return The head of the free pool list.
+
+**/
+LIST_ENTRY *
+GetSmramFreePoolList (
+  IN UINTN  Index
+  )
+{
+  if (Index < MAX_POOL_INDEX) {
+    return &mSmmPoolLists[Index];
+  }
+  return &mSmmPoolCache[Index - MAX_POOL_INDEX];
+}
+
 /**
   Update SMRAM profile FreeMemoryPages information
 
@@ -1638,8 +1664,8 @@ SmramProfileGetDataSize (
        Node = Node->BackLink) {
     Index++;
   }
-  for (PoolListIndex = 0; PoolListIndex < MAX_POOL_INDEX; PoolListIndex++) {
-    FreePoolList = &mSmmPoolLists[PoolListIndex];
+  for (PoolListIndex = 0; PoolListIndex < SMRAM_FREE_POOL_LIST_COUNT; PoolListIndex++) {
+    FreePoolList = GetSmramFreePoolList (PoolListIndex);
     for (Node = FreePoolList->BackLink;
          Node != FreePoolList;
          Node = Node->BackLink) {
@@ -1785,8 +1811,8 @@ SmramProfileCopyData (
            Node = Node->BackLink) {
         Index++;
       }
-      for (PoolListIndex = 0; PoolListIndex < MAX_POOL_INDEX; PoolListIndex++) {
-        FreePoolList = &mSmmPoolLists[MAX_POOL_INDEX - PoolListIndex - 1];
+      for (PoolListIndex = 0; PoolListIndex < SMRAM_FREE_POOL_LIST_COUNT; PoolListIndex++) {
+        FreePoolList = GetSmramFreePoolList (SMRAM_FREE_POOL_LIST_COUNT - PoolListIndex - 1);
         for (Node = FreePoolList->BackLink;
              Node != FreePoolList;
              Node = Node->BackLink) {
@@ -1827,8 +1853,8 @@ SmramProfileCopyData (
     }
     Offset += sizeof (MEMORY_PROFILE_DESCRIPTOR);
   }
-  for (PoolListIndex = 0; PoolListIndex < MAX_POOL_INDEX; PoolListIndex++) {
-    FreePoolList = &mSmmPoolLists[MAX_POOL_INDEX - PoolListIndex - 1];
+  for (PoolListIndex = 0; PoolListIndex < SMRAM_FREE_POOL_LIST_COUNT; PoolListIndex++) {
+    FreePoolList = GetSmramFreePoolList (SMRAM_FREE_POOL_LIST_COUNT - PoolListIndex - 1);
     for (Node = FreePoolList->BackLink;
          Node != FreePoolList;
          Node = Node->BackLink) {
@@ -2260,6 +2286,62 @@ Done:
   mSmramProfileGettingStatus = SmramProfileGettingStatus;
 }
 
+/**
+  SMRAM profile handler to get the fragmentation information of free SMRAM.
+
+  @param SmramProfileParameterGetFragmentationInfo  The parameter of SMM profile get fragmentation info.
+
+**/
+VOID
+SmramProfileHandlerGetFragmentationInfo (
+  IN SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO *SmramProfileParameterGetFragmentationInfo
+  )
+{
+  SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO    FragmentationInfo;
+  LIST_ENTRY                                        *FreeList;
+  LIST_ENTRY                                        *Node;
+  FREE_PAGE_LIST                                    *Pages;
+  FREE_POOL_HEADER                                  *Pool;
+  UINTN                                             PoolListIndex;
+  UINT64                                            Size;
+
+  ZeroMem (&FragmentationInfo, sizeof (FragmentationInfo));
+  CopyMem (&FragmentationInfo.Header, &SmramProfileParameterGetFragmentationInfo->Header, sizeof (FragmentationInfo.Header));
+
+  FreeList = &mSmmMemoryMap;
+  for (Node = FreeList->ForwardLink;
+       Node != FreeList;
+       Node = Node->ForwardLink) {
+    Pages = BASE_CR (Node, FREE_PAGE_LIST, Link);
+    Size = EFI_PAGES_TO_SIZE ((UINT64) Pages->NumberOfPages);
+    FragmentationInfo.FreePageSize += Size;
+    FragmentationInfo.FreePageRangeCount++;
+    if (Size > FragmentationInfo.LargestFreePageSize) {
+      FragmentationInfo.LargestFreePageSize = Size;
+    }
+  }
+
+  for (PoolListIndex = 0; PoolListIndex < SMRAM_FREE_POOL_LIST_COUNT; PoolListIndex++) {
+    FreeList = GetSmramFreePoolList (PoolListIndex);
+    for (Node = FreeList->ForwardLink;
+         Node != FreeList;
+         Node = Node->ForwardLink) {
+      Pool = BASE_CR (Node, FREE_POOL_HEADER, Link);
+      if (!Pool->Header.Available) {
+        continue;
+      }
+      FragmentationInfo.FreePoolSize += Pool->Header.Size;
+      FragmentationInfo.FreePoolBlockCount++;
+      if (PoolListIndex >= MAX_POOL_INDEX) {
+        FragmentationInfo.CachedPoolSize += Pool->Header.Size;
+      }
+    }
+  }
+
+  FragmentationInfo.Header.ReturnStatus = 0;
+  CopyMem (SmramProfileParameterGetFragmentationInfo, &FragmentationInfo, sizeof (FragmentationInfo));
+}
+
 /**
   SMRAM profile handler to register SMM image.
 
@@ -2444,6 +2526,14 @@ SmramProfileHandler (
     mSmramProfileRecordingEnable = ParameterRecordingState->RecordingState;
     ParameterRecordingState->Header.ReturnStatus = 0;
     break;
+  case SMRAM_PROFILE_COMMAND_GET_FRAGMENTATION_INFO:
+    DEBUG ((EFI_D_ERROR, "SmramProfileHandlerGetFragmentationInfo\n"));
+    if (TempCommBufferSize != sizeof (SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO)) {
+      DEBUG ((EFI_D_ERROR, "SmramProfileHandler: SMM communication buffer size invalid!\n"));
+      return EFI_SUCCESS;
+    }
+    SmramProfileHandlerGetFragmentationInfo ((SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO *) (UINTN) CommBuffer);
+    break;
 
   default:
     break;
@@ -2588,9 +2678,9 @@ DumpFreePoolList (
 
   DEBUG ((EFI_D_INFO, "======= SmramProfile begin =======\n"));
 
-  for (PoolListIndex = 0; PoolListIndex < MAX_POOL_INDEX; PoolListIndex++) {
+  for (PoolListIndex = 0; PoolListIndex < SMRAM_FREE_POOL_LIST_COUNT; PoolListIndex++) {
     DEBUG ((EFI_D_INFO, "FreePoolList (%d):\n", PoolListIndex));
-    FreePoolList = &mSmmPoolLists[PoolListIndex];
+    FreePoolList = GetSmramFreePoolList (PoolListIndex);
     for (Node = FreePoolList->BackLink, Index = 0;
          Node != FreePoolList;
          Node = Node->BackLink, Index++) {
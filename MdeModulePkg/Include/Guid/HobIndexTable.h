@@ -0,0 +1,82 @@
+/** @file
+  GUID and data structure of the GUID HOB index table.
+
+  The DXE Core builds this table once from the HOB list and installs it into the
+  EFI System Table's Configuration Table. The GUID extension HOBs are chained
+  into hash buckets keyed by their GUID name, so that a HOB Library instance can
+  find a GUID HOB without walking the whole HOB list. The table and the HOB list
+  are read-only after they are installed.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _HOB_INDEX_TABLE_H_
+#define _HOB_INDEX_TABLE_H_
+
+#define EDKII_HOB_INDEX_TABLE_GUID \
+  { 0x9254cc72, 0x208e, 0x4370, { 0xa0, 0x7e, 0x11, 0xc4, 0x39, 0xd4, 0x0b, 0x22 } }
+
+#define HOB_INDEX_TABLE_SIGNATURE  SIGNATURE_32 ('H','O','B','I')
+
+///
+/// Marks the end of a hash chain.
+///
+#define HOB_INDEX_END              MAX_UINT32
+
+///
+/// Get the hash bucket of a GUID name. BucketCount must be a power of two.
+///
+#define HOB_INDEX_GUID_HASH(Guid, BucketCount) \
+  ((((CONST UINT32 *) (Guid))[0] ^ ((CONST UINT32 *) (Guid))[1] ^ \
+    ((CONST UINT32 *) (Guid))[2] ^ ((CONST UINT32 *) (Guid))[3]) & ((BucketCount) - 1))
+
+typedef struct {
+  ///
+  /// The GUID extension HOB.
+  ///
+  EFI_HOB_GUID_TYPE       *Hob;
+  ///
+  /// Index of the next entry in the same bucket, or HOB_INDEX_END.
+  ///
+  UINT32                  Next;
+  UINT32                  Reserved;
+} HOB_INDEX_ENTRY;
+
+typedef struct {
+  UINT32                  Signature;
+  ///
+  /// Number of hash buckets, a power of two.
+  ///
+  UINT32                  BucketCount;
+  ///
+  /// Number of GUID extension HOBs in the HOB list.
+  ///
+  UINT32                  EntryCount;
+  UINT32                  Reserved;
+  ///
+  /// The first HOB and the end of list HOB of the indexed HOB list.
+  ///
+  VOID                    *HobList;
+  VOID                    *HobListEnd;
+  ///
+  /// BucketCount indexes of the first entry of each bucket, or HOB_INDEX_END.
+  ///
+  UINT32                  *Buckets;
+  ///
+  /// EntryCount entries in HOB list order. The entries of a bucket are chained
+  /// in HOB list order as well.
+  ///
+  HOB_INDEX_ENTRY         *Entries;
+} HOB_INDEX_TABLE;
+
+extern EFI_GUID gEdkiiHobIndexTableGuid;
+
+#endif
@@ -29,7 +29,34 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define LZMAF86_CUSTOM_DECOMPRESS_GUID  \
   { 0xD42AE6BD, 0x1352, 0x4bfb, { 0x90, 0x9A, 0xCA, 0x72, 0xA6, 0xEA, 0xE8, 0x89 } }
 
+///
+/// The Global ID used to identify a section of an FFS file of type 
+/// EFI_SECTION_GUID_DEFINED, whose contents have been split into blocks that
+/// are compressed independently using LZMA, so they can be decompressed in parallel.
+///
+#define LZMA_PARALLEL_CUSTOM_DECOMPRESS_GUID  \
+  { 0x42310E55, 0x4AEC, 0x46D4, { 0x80, 0x5F, 0xDE, 0xF6, 0x71, 0x05, 0x75, 0xB7 } }
+
+#define LZMA_PARALLEL_SIGNATURE  SIGNATURE_32 ('L', 'Z', 'P', 'B')
+
+///
+/// Header of the data of a LZMA block-parallel GUIDed section.
+///
+/// The header is followed by BlockCount + 1 UINT32 offsets of the compressed
+/// blocks, relative to the start of the header. The last offset is the end of
+/// the last block. Each block is a complete LZMA stream, as in a LZMA GUIDed
+/// section, that decodes to BlockSize bytes. The last block decodes to the
+/// remainder of DecodedSize.
+///
+typedef struct {
+  UINT32  Signature;
+  UINT32  BlockSize;
+  UINT32  BlockCount;
+  UINT32  DecodedSize;
+} LZMA_PARALLEL_HEADER;
+
 extern GUID gLzmaCustomDecompressGuid;
 extern GUID gLzmaF86CustomDecompressGuid;
+extern GUID gLzmaParallelCustomDecompressGuid;
 
 #endif
@@ -403,6 +403,7 @@ struct _EDKII_MEMORY_PROFILE_PROTOCOL {
 #define SMRAM_PROFILE_COMMAND_GET_PROFILE_DATA_BY_OFFSET 0x5
 #define SMRAM_PROFILE_COMMAND_GET_RECORDING_STATE        0x6
 #define SMRAM_PROFILE_COMMAND_SET_RECORDING_STATE        0x7
+#define SMRAM_PROFILE_COMMAND_GET_FRAGMENTATION_INFO     0x8
 
 typedef struct {
   UINT32                            Command;
@@ -455,6 +456,22 @@ typedef struct {
   UINT64                            NumberOfPage;
 } SMRAM_PROFILE_PARAMETER_UNREGISTER_IMAGE;
 
+typedef struct {
+  SMRAM_PROFILE_PARAMETER_HEADER    Header;
+  //
+  // Free page ranges in the SMRAM memory map.
+  //
+  UINT64                            FreePageSize;
+  UINT64                            LargestFreePageSize;
+  UINT64                            FreePageRangeCount;
+  //
+  // Free pool blocks, including the ones held in the small pool cache.
+  //
+  UINT64                            FreePoolSize;
+  UINT64                            FreePoolBlockCount;
+  UINT64                            CachedPoolSize;
+} SMRAM_PROFILE_PARAMETER_GET_FRAGMENTATION_INFO;
+
 
 #define EDKII_MEMORY_PROFILE_GUID { \
   0x821c9a09, 0x541a, 0x40f6, { 0x9f, 0x43, 0xa, 0xd1, 0x93, 0xa1, 0x2c, 0xfe } \
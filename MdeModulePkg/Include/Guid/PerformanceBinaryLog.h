@@ -0,0 +1,123 @@
+/** @file
+  Binary performance log data structures.
+
+  When PcdPerformanceBinaryLogEnable is TRUE, the performance library instances
+  append fixed-size start and end records into per-processor rings instead of
+  pairing the measurements when they are recorded. The PEI log is passed to DXE
+  in a GUID HOB and the DXE log, also used by SMM, is installed as a
+  configuration table, both with the gEdkiiPerformanceBinaryLogGuid GUID.
+
+  Consumers pair the start and end records of a measurement offline, by
+  matching Handle, TokenId, ModuleId and Identifier in time stamp order.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _PERFORMANCE_BINARY_LOG_H_
+#define _PERFORMANCE_BINARY_LOG_H_
+
+#define EDKII_PERFORMANCE_BINARY_LOG_GUID { \
+  0x5e9c9fa9, 0xe503, 0x4a74, { 0x82, 0xe6, 0xd5, 0xb2, 0x46, 0x17, 0x12, 0x62 } \
+}
+
+extern EFI_GUID gEdkiiPerformanceBinaryLogGuid;
+
+//
+// Layout of a binary performance log:
+//
+// +-----------------------------------+
+// | PERFORMANCE_BINARY_LOG_HEADER     |
+// +-----------------------------------+ <- StringTableOffset
+// | PERFORMANCE_BINARY_LOG_STRING     |
+// | ... (StringCount)                 |
+// +-----------------------------------+ <- RingOffset
+// | PERFORMANCE_BINARY_LOG_RING       |
+// | PERFORMANCE_BINARY_LOG_RECORD     |
+// | ... (RingRecordCount)             |
+// +-----------------------------------+ <- RingOffset + RingLength
+// | ... (RingCount)                   |
+// +-----------------------------------+ <- Length
+//
+#define PERFORMANCE_BINARY_LOG_SIGNATURE  SIGNATURE_32 ('P', 'B', 'L', 'G')
+#define PERFORMANCE_BINARY_LOG_REVISION   0x0001
+
+typedef struct {
+  UINT32                            Signature;
+  UINT16                            Revision;
+  UINT16                            HeaderLength;
+  UINT32                            Length;             ///< Length of the whole log in bytes.
+  UINT32                            StringCount;        ///< Number of string table slots, a power of 2.
+  UINT32                            StringTableOffset;
+  UINT32                            RingCount;
+  UINT32                            RingRecordCount;    ///< Number of records of each ring, a power of 2.
+  UINT32                            RingOffset;
+  UINT32                            RingLength;         ///< Length of a ring including its header.
+  UINT32                            Reserved;
+  UINT64                            TimerStartValue;    ///< Performance counter properties of the time stamps.
+  UINT64                            TimerEndValue;
+  UINT64                            TimerFrequency;
+} PERFORMANCE_BINARY_LOG_HEADER;
+
+//
+// The Token and Module strings of the records are interned into an open
+// addressing hash table. String ID N refers to the slot N - 1.
+//
+#define PERFORMANCE_BINARY_LOG_STRING_SIZE         32
+#define PERFORMANCE_BINARY_LOG_STRING_LENGTH       (PERFORMANCE_BINARY_LOG_STRING_SIZE - 1)
+#define PERFORMANCE_BINARY_LOG_MAX_STRING_COUNT    0x8000
+
+#define PERFORMANCE_BINARY_LOG_STRING_ID_NONE      0x0000   ///< NULL or empty string.
+#define PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW  0xFFFF   ///< The string table was full.
+
+//
+// Values of Hash for the slots not holding a string yet.
+//
+#define PERFORMANCE_BINARY_LOG_STRING_FREE         0
+#define PERFORMANCE_BINARY_LOG_STRING_BUSY         1
+
+typedef struct {
+  UINT32                            Hash;
+  UINT32                            Reserved;
+  CHAR8                             Name[PERFORMANCE_BINARY_LOG_STRING_SIZE];
+} PERFORMANCE_BINARY_LOG_STRING;
+
+//
+// Each processor claims a ring by writing its APIC ID into CpuId, the records
+// are appended at WriteCount modulo RingRecordCount so the ring keeps the
+// RingRecordCount most recent records.
+//
+#define PERFORMANCE_BINARY_LOG_RING_FREE           0xFFFFFFFF
+
+typedef struct {
+  UINT32                            CpuId;
+  UINT32                            WriteCount;
+} PERFORMANCE_BINARY_LOG_RING;
+
+#define PERFORMANCE_BINARY_LOG_RECORD_START        0x01
+#define PERFORMANCE_BINARY_LOG_RECORD_END          0x02
+
+typedef struct {
+  //
+  // The WriteCount value that reserved this record, written last. A record
+  // whose Sequence does not match its position was not completely written.
+  //
+  UINT32                            Sequence;
+  UINT8                             Type;
+  UINT8                             Reserved1;
+  UINT16                            TokenId;
+  UINT16                            ModuleId;
+  UINT16                            Reserved2;
+  UINT32                            Identifier;
+  UINT64                            Handle;
+  UINT64                            TimeStamp;
+} PERFORMANCE_BINARY_LOG_RECORD;
+
+#endif
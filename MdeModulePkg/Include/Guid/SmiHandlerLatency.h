@@ -0,0 +1,102 @@
+/** @file
+  SMI handler latency histogram data structures.
+
+  When PcdSmiHandlerLatencyHistogramEnable is TRUE, the SMM Core measures the
+  execution time of every SMI handler it calls in time stamp counter ticks. The
+  measurements are retrieved by a SMM communication with the
+  gEdkiiSmiHandlerLatencyGuid header GUID.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _SMI_HANDLER_LATENCY_H_
+#define _SMI_HANDLER_LATENCY_H_
+
+#define EDKII_SMI_HANDLER_LATENCY_GUID { \
+  0x6f38324c, 0x78e5, 0x4f73, { 0xbc, 0x5d, 0x9b, 0xe7, 0x36, 0x32, 0x2d, 0x28 } \
+}
+
+extern EFI_GUID gEdkiiSmiHandlerLatencyGuid;
+
+//
+// Bucket N of a histogram counts the calls that took [2^N, 2^(N+1)) ticks.
+// Bucket 0 also counts the calls that took 0 ticks.
+//
+#define SMI_HANDLER_LATENCY_BUCKETS  64
+
+typedef struct {
+  UINT64                            Count;
+  UINT64                            TotalTicks;
+  UINT64                            MaxTicks;
+  UINT64                            Histogram[SMI_HANDLER_LATENCY_BUCKETS];
+} SMI_HANDLER_LATENCY_DATA;
+
+#define SMI_HANDLER_LATENCY_SIGNATURE  SIGNATURE_32 ('S','H','L','H')
+
+//
+// Latency data layout:
+//
+// +--------------------------------+
+// | SMI_HANDLER_LATENCY_HEADER     |
+// +--------------------------------+
+// | SMI_HANDLER_LATENCY_RECORD(1)  |
+// +--------------------------------+
+// | SMI_HANDLER_LATENCY_RECORD(n)  |
+// +--------------------------------+
+//
+typedef struct {
+  UINT32                            Signature;
+  UINT32                            RecordCount;
+} SMI_HANDLER_LATENCY_HEADER;
+
+typedef struct {
+  //
+  // Zero GUID for a root SMI handler.
+  //
+  EFI_GUID                          HandlerType;
+  PHYSICAL_ADDRESS                  Handler;
+  SMI_HANDLER_LATENCY_DATA          Latency;
+} SMI_HANDLER_LATENCY_RECORD;
+
+//
+// SMI handler latency command
+//
+#define SMI_HANDLER_LATENCY_COMMAND_GET_INFO            0x1
+#define SMI_HANDLER_LATENCY_COMMAND_GET_DATA_BY_OFFSET  0x2
+#define SMI_HANDLER_LATENCY_COMMAND_RESET               0x3
+
+typedef struct {
+  UINT32                            Command;
+  UINT32                            DataLength;
+  UINT64                            ReturnStatus;
+} SMI_HANDLER_LATENCY_PARAMETER_HEADER;
+
+typedef struct {
+  SMI_HANDLER_LATENCY_PARAMETER_HEADER  Header;
+  UINT64                                DataSize;
+} SMI_HANDLER_LATENCY_PARAMETER_GET_INFO;
+
+typedef struct {
+  SMI_HANDLER_LATENCY_PARAMETER_HEADER  Header;
+  //
+  // On input, data buffer size.
+  // On output, actual data size copied.
+  //
+  UINT64                                DataSize;
+  PHYSICAL_ADDRESS                      DataBuffer;
+  //
+  // On input, data offset to copy.
+  // On output, next time data offset to copy.
+  //
+  UINT64                                DataOffset;
+} SMI_HANDLER_LATENCY_PARAMETER_GET_DATA_BY_OFFSET;
+
+#endif
@@ -0,0 +1,170 @@
+/** @file
+  Provides services to format and append records into a binary performance log.
+
+  The append service takes no lock: every processor appends into its own ring
+  and interns its strings with compare-and-exchange operations, so it may be
+  called from PEI, DXE, SMM and from application processors.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php.
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _PERFORMANCE_BINARY_LOG_LIB_H_
+#define _PERFORMANCE_BINARY_LOG_LIB_H_
+
+#include <Guid/PerformanceBinaryLog.h>
+
+//
+// Geometry of a binary performance log captured when it is initialized or
+// opened. The services only trust these fields, never the log header, so the
+// log itself may live in memory writable by less privileged code.
+//
+typedef struct {
+  PERFORMANCE_BINARY_LOG_HEADER     *Header;
+  PERFORMANCE_BINARY_LOG_STRING     *Strings;
+  UINT8                             *Rings;
+  UINT32                            StringCount;
+  UINT32                            RingCount;
+  UINT32                            RingRecordCount;
+  UINT32                            RingLength;
+} PERFORMANCE_BINARY_LOG_CONTEXT;
+
+/**
+  Return the size of a binary performance log.
+
+  @param[in] StringCount        Number of string table slots, a power of 2.
+  @param[in] RingCount          Number of rings.
+  @param[in] RingRecordCount    Number of records of each ring, a power of 2.
+
+  @return The size of the log in bytes, or 0 if the geometry is invalid.
+
+**/
+UINTN
+EFIAPI
+PerformanceBinaryLogGetSize (
+  IN UINT32                         StringCount,
+  IN UINT32                         RingCount,
+  IN UINT32                         RingRecordCount
+  );
+
+/**
+  Format an empty binary performance log in a buffer.
+
+  @param[out] Context           Context of the new log.
+  @param[in]  Buffer            Buffer to hold the log.
+  @param[in]  BufferSize        Size of Buffer in bytes.
+  @param[in]  StringCount       Number of string table slots, a power of 2.
+  @param[in]  RingCount         Number of rings.
+  @param[in]  RingRecordCount   Number of records of each ring, a power of 2.
+
+  @retval RETURN_SUCCESS            The log is formatted.
+  @retval RETURN_INVALID_PARAMETER  The geometry is invalid.
+  @retval RETURN_BUFFER_TOO_SMALL   Buffer can not hold the log.
+
+**/
+RETURN_STATUS
+EFIAPI
+PerformanceBinaryLogInitialize (
+  OUT PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN  VOID                            *Buffer,
+  IN  UINTN                           BufferSize,
+  IN  UINT32                          StringCount,
+  IN  UINT32                          RingCount,
+  IN  UINT32                          RingRecordCount
+  );
+
+/**
+  Validate an existing binary performance log and capture its geometry.
+
+  @param[out] Context           Context of the log.
+  @param[in]  Buffer            Buffer holding the log.
+  @param[in]  BufferSize        Size of Buffer in bytes.
+
+  @retval RETURN_SUCCESS            The log is valid.
+  @retval RETURN_VOLUME_CORRUPTED   Buffer does not hold a valid log.
+
+**/
+RETURN_STATUS
+EFIAPI
+PerformanceBinaryLogOpen (
+  OUT PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN  VOID                            *Buffer,
+  IN  UINTN                           BufferSize
+  );
+
+/**
+  Return the ID of a string in the string table of a log, adding it if needed.
+
+  @param[in] Context            Context of the log.
+  @param[in] String             Null-terminated ASCII string, only its first
+                                PERFORMANCE_BINARY_LOG_STRING_LENGTH characters
+                                are significant.
+
+  @return PERFORMANCE_BINARY_LOG_STRING_ID_NONE if String is NULL or empty,
+          PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW if the table is full,
+          the ID of the string otherwise.
+
+**/
+UINT16
+EFIAPI
+PerformanceBinaryLogInternString (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN CONST CHAR8                           *String  OPTIONAL
+  );
+
+/**
+  Append a record into the ring of the executing processor.
+
+  @param[in] Context            Context of the log.
+  @param[in] Type               PERFORMANCE_BINARY_LOG_RECORD_START or PERFORMANCE_BINARY_LOG_RECORD_END.
+  @param[in] Handle             Pointer to environment specific context used
+                                to identify the component being measured.
+  @param[in] Token              Pointer to a Null-terminated ASCII string
+                                that identifies the component being measured.
+  @param[in] Module             Pointer to a Null-terminated ASCII string
+                                that identifies the module being measured.
+  @param[in] TimeStamp          64-bit time stamp, 0 to use the current time stamp.
+  @param[in] Identifier         32-bit identifier.
+
+  @retval RETURN_SUCCESS            The record is appended.
+  @retval RETURN_INVALID_PARAMETER  Type is not valid.
+
+**/
+RETURN_STATUS
+EFIAPI
+PerformanceBinaryLogAppend (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN UINT8                                 Type,
+  IN CONST VOID                            *Handle,  OPTIONAL
+  IN CONST CHAR8                           *Token,   OPTIONAL
+  IN CONST CHAR8                           *Module,  OPTIONAL
+  IN UINT64                                TimeStamp,
+  IN UINT32                                Identifier
+  );
+
+/**
+  Append the records of a log into another one.
+
+  The records of every ring of Source are appended, oldest first, into the
+  ring of Destination owned by the same processor, and their strings are
+  interned into the string table of Destination.
+
+  @param[in] Destination        Context of the log to append into.
+  @param[in] Source             Context of the log to append from.
+
+**/
+VOID
+EFIAPI
+PerformanceBinaryLogMerge (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Destination,
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Source
+  );
+
+#endif
@@ -0,0 +1,90 @@
+/** @file
+  Protocol Database Statistics Protocol is an EDK II-specific debug interface
+  that reports how the DXE Core handle database resolves protocol GUIDs, so
+  platform owners can find the protocols that dominate lookup cost.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __PROTOCOL_DATABASE_STATISTICS_H__
+#define __PROTOCOL_DATABASE_STATISTICS_H__
+
+#define EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL_GUID \
+  { \
+    0xe22d6f51, 0x76fe, 0x45af, { 0x9a, 0x40, 0xbc, 0xbb, 0xf5, 0x79, 0xf2, 0xd4 } \
+  }
+
+#define EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL_REVISION  0x00010000
+
+typedef struct _EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL  EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL;
+
+///
+/// Lookup statistics of one protocol GUID in the protocol database.
+///
+typedef struct {
+  ///
+  /// The protocol GUID.
+  ///
+  EFI_GUID    ProtocolGuid;
+  ///
+  /// Number of times the protocol entry was looked up by GUID.
+  ///
+  UINT64      LookupCount;
+  ///
+  /// Total number of entries compared in the hash bucket over all lookups.
+  /// LookupChainLength / LookupCount is the average chain length.
+  ///
+  UINT64      LookupChainLength;
+  ///
+  /// Number of interfaces currently installed for the protocol.
+  ///
+  UINT32      InterfaceCount;
+  ///
+  /// Index of the hash bucket holding the protocol entry.
+  ///
+  UINT32      HashBucket;
+} EDKII_PROTOCOL_DATABASE_STATISTICS_ENTRY;
+
+/**
+  Retrieve the lookup statistics of all protocol GUIDs in the protocol database.
+
+  @param[in]      This          The EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL instance.
+  @param[in, out] BufferSize    On input, the size in bytes of Buffer.
+                                On output, the size in bytes of the data returned in Buffer,
+                                or the size required if Buffer is too small.
+  @param[out]     Buffer        Array of EDKII_PROTOCOL_DATABASE_STATISTICS_ENTRY, one per protocol GUID.
+  @param[out]     BucketCount   Optional. Number of hash buckets in the protocol database.
+
+  @retval EFI_SUCCESS           The statistics were returned in Buffer.
+  @retval EFI_INVALID_PARAMETER BufferSize is NULL, or Buffer is NULL and *BufferSize is not 0.
+  @retval EFI_BUFFER_TOO_SMALL  Buffer is too small. *BufferSize is updated with the required size.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_PROTOCOL_DATABASE_STATISTICS_GET_STATISTICS) (
+  IN     EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL  *This,
+  IN OUT UINTN                                        *BufferSize,
+  OUT    EDKII_PROTOCOL_DATABASE_STATISTICS_ENTRY     *Buffer,
+  OUT    UINTN                                        *BucketCount OPTIONAL
+  );
+
+///
+/// Protocol Database Statistics Protocol reports per GUID lookup counts and
+/// hash chain lengths of the DXE Core protocol database.
+///
+struct _EDKII_PROTOCOL_DATABASE_STATISTICS_PROTOCOL {
+  UINT32                                              Revision;
+  EDKII_PROTOCOL_DATABASE_STATISTICS_GET_STATISTICS   GetStatistics;
+};
+
+extern EFI_GUID gEdkiiProtocolDatabaseStatisticsProtocolGuid;
+
+#endif
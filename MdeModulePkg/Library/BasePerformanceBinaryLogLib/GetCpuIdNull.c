@@ -0,0 +1,34 @@
+/** @file
+  Processor ID for the architectures without a supported way to identify the
+  executing processor.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "PerformanceBinaryLogInternal.h"
+
+/**
+  Return an ID of the executing processor, unique among the processors of the
+  system.
+
+  All processors share the first ring, which is still safe because the records
+  of a ring are reserved with an atomic increment.
+
+  @return ID of the executing processor.
+
+**/
+UINT32
+InternalPerformanceBinaryLogGetCpuId (
+  VOID
+  )
+{
+  return 0;
+}
@@ -0,0 +1,617 @@
+/** @file
+  Format and append records into a binary performance log.
+
+  Every processor appends into the ring it claimed with its processor ID, the
+  slot of a record is reserved by an atomic increment of the write count of the
+  ring and the record is published by writing its sequence number last. The
+  strings are interned into an open addressing hash table whose slots are
+  claimed by compare-and-exchange. No lock is taken and nothing is allocated,
+  so records may be appended from any phase and from application processors.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "PerformanceBinaryLogInternal.h"
+
+/**
+  Check if a value is a non zero power of 2.
+
+  @param[in] Value      The value to check.
+
+  @retval TRUE          Value is a power of 2.
+  @retval FALSE         Value is not a power of 2.
+
+**/
+BOOLEAN
+InternalIsPowerOfTwo (
+  IN UINT32  Value
+  )
+{
+  return (BOOLEAN) ((Value != 0) && ((Value & (Value - 1)) == 0));
+}
+
+/**
+  Compute the layout of a binary performance log.
+
+  @param[in]  StringCount       Number of string table slots.
+  @param[in]  RingCount         Number of rings.
+  @param[in]  RingRecordCount   Number of records of each ring.
+  @param[out] RingOffset        Offset of the first ring.
+  @param[out] RingLength        Length of a ring including its header.
+
+  @return The size of the log in bytes, or 0 if the geometry is invalid.
+
+**/
+UINT32
+InternalGetLayout (
+  IN  UINT32  StringCount,
+  IN  UINT32  RingCount,
+  IN  UINT32  RingRecordCount,
+  OUT UINT32  *RingOffset,
+  OUT UINT32  *RingLength
+  )
+{
+  UINT64  Length;
+  UINT64  Offset;
+  UINT64  Size;
+
+  if (!InternalIsPowerOfTwo (StringCount) ||
+      (StringCount > PERFORMANCE_BINARY_LOG_MAX_STRING_COUNT) ||
+      (RingCount == 0) ||
+      !InternalIsPowerOfTwo (RingRecordCount)) {
+    return 0;
+  }
+
+  Length = sizeof (PERFORMANCE_BINARY_LOG_RING) +
+           MultU64x32 (sizeof (PERFORMANCE_BINARY_LOG_RECORD), RingRecordCount);
+  if (Length > MAX_UINT32) {
+    return 0;
+  }
+  Offset = sizeof (PERFORMANCE_BINARY_LOG_HEADER) +
+           MultU64x32 (sizeof (PERFORMANCE_BINARY_LOG_STRING), StringCount);
+  Size   = Offset + MultU64x32 (Length, RingCount);
+  if (Size > MAX_UINT32) {
+    return 0;
+  }
+
+  *RingOffset = (UINT32) Offset;
+  *RingLength = (UINT32) Length;
+  return (UINT32) Size;
+}
+
+/**
+  Return the size of a binary performance log.
+
+  @param[in] StringCount        Number of string table slots, a power of 2.
+  @param[in] RingCount          Number of rings.
+  @param[in] RingRecordCount    Number of records of each ring, a power of 2.
+
+  @return The size of the log in bytes, or 0 if the geometry is invalid.
+
+**/
+UINTN
+EFIAPI
+PerformanceBinaryLogGetSize (
+  IN UINT32                         StringCount,
+  IN UINT32                         RingCount,
+  IN UINT32                         RingRecordCount
+  )
+{
+  UINT32  RingOffset;
+  UINT32  RingLength;
+
+  return InternalGetLayout (StringCount, RingCount, RingRecordCount, &RingOffset, &RingLength);
+}
+
+/**
+  Format an empty binary performance log in a buffer.
+
+  @param[out] Context           Context of the new log.
+  @param[in]  Buffer            Buffer to hold the log.
+  @param[in]  BufferSize        Size of Buffer in bytes.
+  @param[in]  StringCount       Number of string table slots, a power of 2.
+  @param[in]  RingCount         Number of rings.
+  @param[in]  RingRecordCount   Number of records of each ring, a power of 2.
+
+  @retval RETURN_SUCCESS            The log is formatted.
+  @retval RETURN_INVALID_PARAMETER  The geometry is invalid.
+  @retval RETURN_BUFFER_TOO_SMALL   Buffer can not hold the log.
+
+**/
+RETURN_STATUS
+EFIAPI
+PerformanceBinaryLogInitialize (
+  OUT PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN  VOID                            *Buffer,
+  IN  UINTN                           BufferSize,
+  IN  UINT32                          StringCount,
+  IN  UINT32                          RingCount,
+  IN  UINT32                          RingRecordCount
+  )
+{
+  PERFORMANCE_BINARY_LOG_HEADER  *Header;
+  PERFORMANCE_BINARY_LOG_RING    *Ring;
+  UINT32                         Size;
+  UINT32                         RingOffset;
+  UINT32                         RingLength;
+  UINT32                         Index;
+
+  ASSERT (Context != NULL);
+  ASSERT (Buffer != NULL);
+
+  Size = InternalGetLayout (StringCount, RingCount, RingRecordCount, &RingOffset, &RingLength);
+  if (Size == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  if (BufferSize < Size) {
+    return RETURN_BUFFER_TOO_SMALL;
+  }
+
+  ZeroMem (Buffer, Size);
+  Header = (PERFORMANCE_BINARY_LOG_HEADER *) Buffer;
+  Header->Signature         = PERFORMANCE_BINARY_LOG_SIGNATURE;
+  Header->Revision          = PERFORMANCE_BINARY_LOG_REVISION;
+  Header->HeaderLength      = sizeof (PERFORMANCE_BINARY_LOG_HEADER);
+  Header->Length            = Size;
+  Header->StringCount       = StringCount;
+  Header->StringTableOffset = sizeof (PERFORMANCE_BINARY_LOG_HEADER);
+  Header->RingCount         = RingCount;
+  Header->RingRecordCount   = RingRecordCount;
+  Header->RingOffset        = RingOffset;
+  Header->RingLength        = RingLength;
+  Header->TimerFrequency    = GetPerformanceCounterProperties (&Header->TimerStartValue, &Header->TimerEndValue);
+
+  Context->Header          = Header;
+  Context->Strings         = (PERFORMANCE_BINARY_LOG_STRING *) (Header + 1);
+  Context->Rings           = (UINT8 *) Header + RingOffset;
+  Context->StringCount     = StringCount;
+  Context->RingCount       = RingCount;
+  Context->RingRecordCount = RingRecordCount;
+  Context->RingLength      = RingLength;
+
+  for (Index = 0; Index < RingCount; Index++) {
+    Ring = (PERFORMANCE_BINARY_LOG_RING *) (Context->Rings + (UINTN) Index * RingLength);
+    Ring->CpuId = PERFORMANCE_BINARY_LOG_RING_FREE;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Validate an existing binary performance log and capture its geometry.
+
+  @param[out] Context           Context of the log.
+  @param[in]  Buffer            Buffer holding the log.
+  @param[in]  BufferSize        Size of Buffer in bytes.
+
+  @retval RETURN_SUCCESS            The log is valid.
+  @retval RETURN_VOLUME_CORRUPTED   Buffer does not hold a valid log.
+
+**/
+RETURN_STATUS
+EFIAPI
+PerformanceBinaryLogOpen (
+  OUT PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN  VOID                            *Buffer,
+  IN  UINTN                           BufferSize
+  )
+{
+  PERFORMANCE_BINARY_LOG_HEADER  Header;
+  UINT32                         Size;
+  UINT32                         RingOffset;
+  UINT32                         RingLength;
+
+  ASSERT (Context != NULL);
+
+  if ((Buffer == NULL) || (BufferSize < sizeof (PERFORMANCE_BINARY_LOG_HEADER))) {
+    return RETURN_VOLUME_CORRUPTED;
+  }
+
+  //
+  // Validate a copy, the log may be modified while it is validated.
+  //
+  CopyMem (&Header, Buffer, sizeof (Header));
+  if ((Header.Signature != PERFORMANCE_BINARY_LOG_SIGNATURE) ||
+      (Header.Revision != PERFORMANCE_BINARY_LOG_REVISION) ||
+      (Header.HeaderLength != sizeof (PERFORMANCE_BINARY_LOG_HEADER)) ||
+      (Header.StringTableOffset != sizeof (PERFORMANCE_BINARY_LOG_HEADER))) {
+    return RETURN_VOLUME_CORRUPTED;
+  }
+
+  Size = InternalGetLayout (Header.StringCount, Header.RingCount, Header.RingRecordCount, &RingOffset, &RingLength);
+  if ((Size == 0) ||
+      (Size != Header.Length) ||
+      (Size > BufferSize) ||
+      (RingOffset != Header.RingOffset) ||
+      (RingLength != Header.RingLength)) {
+    return RETURN_VOLUME_CORRUPTED;
+  }
+
+  Context->Header          = (PERFORMANCE_BINARY_LOG_HEADER *) Buffer;
+  Context->Strings         = (PERFORMANCE_BINARY_LOG_STRING *) (Context->Header + 1);
+  Context->Rings           = (UINT8 *) Buffer + RingOffset;
+  Context->StringCount     = Header.StringCount;
+  Context->RingCount       = Header.RingCount;
+  Context->RingRecordCount = Header.RingRecordCount;
+  Context->RingLength      = RingLength;
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Compute the hash of the significant characters of a string.
+
+  @param[in] String     Null-terminated ASCII string.
+
+  @return The hash of String, never PERFORMANCE_BINARY_LOG_STRING_FREE or
+          PERFORMANCE_BINARY_LOG_STRING_BUSY.
+
+**/
+UINT32
+InternalHashString (
+  IN CONST CHAR8  *String
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+
+  //
+  // FNV-1a
+  //
+  Hash = 0x811C9DC5;
+  for (Index = 0; (Index < PERFORMANCE_BINARY_LOG_STRING_LENGTH) && (String[Index] != '\0'); Index++) {
+    Hash = (Hash ^ (UINT8) String[Index]) * 0x01000193;
+  }
+
+  if (Hash <= PERFORMANCE_BINARY_LOG_STRING_BUSY) {
+    Hash += PERFORMANCE_BINARY_LOG_STRING_BUSY + 1;
+  }
+  return Hash;
+}
+
+/**
+  Compare the significant characters of a string with a string table name.
+
+  @param[in] Name       Name of a string table slot, it may not be terminated.
+  @param[in] String     Null-terminated ASCII string.
+
+  @retval TRUE          The strings are the same.
+  @retval FALSE         The strings are different.
+
+**/
+BOOLEAN
+InternalIsSameString (
+  IN CONST CHAR8  *Name,
+  IN CONST CHAR8  *String
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < PERFORMANCE_BINARY_LOG_STRING_LENGTH; Index++) {
+    if (Name[Index] != String[Index]) {
+      return FALSE;
+    }
+    if (String[Index] == '\0') {
+      return TRUE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Return the ID of a string in the string table of a log, adding it if needed.
+
+  @param[in] Context            Context of the log.
+  @param[in] String             Null-terminated ASCII string, only its first
+                                PERFORMANCE_BINARY_LOG_STRING_LENGTH characters
+                                are significant.
+
+  @return PERFORMANCE_BINARY_LOG_STRING_ID_NONE if String is NULL or empty,
+          PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW if the table is full,
+          the ID of the string otherwise.
+
+**/
+UINT16
+EFIAPI
+PerformanceBinaryLogInternString (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN CONST CHAR8                           *String  OPTIONAL
+  )
+{
+  PERFORMANCE_BINARY_LOG_STRING  *Entry;
+  UINT32                         Hash;
+  UINT32                         EntryHash;
+  UINT32                         Mask;
+  UINT32                         Slot;
+  UINT32                         Probe;
+  UINTN                          Spin;
+  UINTN                          Index;
+
+  if ((String == NULL) || (*String == '\0')) {
+    return PERFORMANCE_BINARY_LOG_STRING_ID_NONE;
+  }
+
+  Hash = InternalHashString (String);
+  Mask = Context->StringCount - 1;
+  Slot = Hash & Mask;
+  for (Probe = 0; Probe < Context->StringCount; Probe++, Slot = (Slot + 1) & Mask) {
+    Entry     = &Context->Strings[Slot];
+    EntryHash = *(volatile UINT32 *) &Entry->Hash;
+
+    if (EntryHash == PERFORMANCE_BINARY_LOG_STRING_FREE) {
+      EntryHash = InterlockedCompareExchange32 (
+                    &Entry->Hash,
+                    PERFORMANCE_BINARY_LOG_STRING_FREE,
+                    PERFORMANCE_BINARY_LOG_STRING_BUSY
+                    );
+      if (EntryHash == PERFORMANCE_BINARY_LOG_STRING_FREE) {
+        //
+        // The slot is ours, fill the name before publishing the hash.
+        //
+        for (Index = 0; (Index < PERFORMANCE_BINARY_LOG_STRING_LENGTH) && (String[Index] != '\0'); Index++) {
+          Entry->Name[Index] = String[Index];
+        }
+        for (; Index < PERFORMANCE_BINARY_LOG_STRING_SIZE; Index++) {
+          Entry->Name[Index] = '\0';
+        }
+        MemoryFence ();
+        *(volatile UINT32 *) &Entry->Hash = Hash;
+        return (UINT16) (Slot + 1);
+      }
+    }
+
+    for (Spin = 0; (EntryHash == PERFORMANCE_BINARY_LOG_STRING_BUSY) && (Spin < PERFORMANCE_BINARY_LOG_STRING_SPIN_COUNT); Spin++) {
+      CpuPause ();
+      EntryHash = *(volatile UINT32 *) &Entry->Hash;
+    }
+
+    if ((EntryHash == Hash) && InternalIsSameString (Entry->Name, String)) {
+      return (UINT16) (Slot + 1);
+    }
+  }
+
+  return PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW;
+}
+
+/**
+  Return the ring owned by a processor, claiming a free one if needed.
+
+  When all the rings are owned by other processors, the processors share the
+  ring their IDs select, which is safe but mixes their records.
+
+  @param[in] Context    Context of the log.
+  @param[in] CpuId      ID of the processor.
+
+  @return The ring of the processor.
+
+**/
+PERFORMANCE_BINARY_LOG_RING *
+InternalGetRing (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN UINT32                                CpuId
+  )
+{
+  PERFORMANCE_BINARY_LOG_RING  *Ring;
+  UINT32                       Start;
+  UINT32                       Index;
+  UINT32                       Owner;
+
+  Start = CpuId % Context->RingCount;
+  Index = Start;
+  do {
+    Ring  = (PERFORMANCE_BINARY_LOG_RING *) (Context->Rings + (UINTN) Index * Context->RingLength);
+    Owner = *(volatile UINT32 *) &Ring->CpuId;
+    if (Owner == PERFORMANCE_BINARY_LOG_RING_FREE) {
+      Owner = InterlockedCompareExchange32 (&Ring->CpuId, PERFORMANCE_BINARY_LOG_RING_FREE, CpuId);
+      if (Owner == PERFORMANCE_BINARY_LOG_RING_FREE) {
+        return Ring;
+      }
+    }
+    if (Owner == CpuId) {
+      return Ring;
+    }
+
+    Index++;
+    if (Index == Context->RingCount) {
+      Index = 0;
+    }
+  } while (Index != Start);
+
+  return (PERFORMANCE_BINARY_LOG_RING *) (Context->Rings + (UINTN) Start * Context->RingLength);
+}
+
+/**
+  Append a record into a ring.
+
+  @param[in] Context    Context of the log.
+  @param[in] Ring       Ring to append into.
+  @param[in] Type       Type of the record.
+  @param[in] Handle     Handle of the record.
+  @param[in] TokenId    String ID of the token.
+  @param[in] ModuleId   String ID of the module.
+  @param[in] TimeStamp  Time stamp of the record.
+  @param[in] Identifier Identifier of the record.
+
+**/
+VOID
+InternalAppendRecord (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN PERFORMANCE_BINARY_LOG_RING           *Ring,
+  IN UINT8                                 Type,
+  IN UINT64                                Handle,
+  IN UINT16                                TokenId,
+  IN UINT16                                ModuleId,
+  IN UINT64                                TimeStamp,
+  IN UINT32                                Identifier
+  )
+{
+  PERFORMANCE_BINARY_LOG_RECORD  *Record;
+  UINT32                         Sequence;
+
+  Sequence = InterlockedIncrement (&Ring->WriteCount);
+  Record   = (PERFORMANCE_BINARY_LOG_RECORD *) (Ring + 1) + ((Sequence - 1) & (Context->RingRecordCount - 1));
+
+  *(volatile UINT32 *) &Record->Sequence = 0;
+  Record->Type       = Type;
+  Record->Reserved1  = 0;
+  Record->TokenId    = TokenId;
+  Record->ModuleId   = ModuleId;
+  Record->Reserved2  = 0;
+  Record->Identifier = Identifier;
+  Record->Handle     = Handle;
+  Record->TimeStamp  = TimeStamp;
+  MemoryFence ();
+  *(volatile UINT32 *) &Record->Sequence = Sequence;
+}
+
+/**
+  Append a record into the ring of the executing processor.
+
+  @param[in] Context            Context of the log.
+  @param[in] Type               PERFORMANCE_BINARY_LOG_RECORD_START or PERFORMANCE_BINARY_LOG_RECORD_END.
+  @param[in] Handle             Pointer to environment specific context used
+                                to identify the component being measured.
+  @param[in] Token              Pointer to a Null-terminated ASCII string
+                                that identifies the component being measured.
+  @param[in] Module             Pointer to a Null-terminated ASCII string
+                                that identifies the module being measured.
+  @param[in] TimeStamp          64-bit time stamp, 0 to use the current time stamp.
+  @param[in] Identifier         32-bit identifier.
+
+  @retval RETURN_SUCCESS            The record is appended.
+  @retval RETURN_INVALID_PARAMETER  Type is not valid.
+
+**/
+RETURN_STATUS
+EFIAPI
+PerformanceBinaryLogAppend (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Context,
+  IN UINT8                                 Type,
+  IN CONST VOID                            *Handle,  OPTIONAL
+  IN CONST CHAR8                           *Token,   OPTIONAL
+  IN CONST CHAR8                           *Module,  OPTIONAL
+  IN UINT64                                TimeStamp,
+  IN UINT32                                Identifier
+  )
+{
+  if ((Type != PERFORMANCE_BINARY_LOG_RECORD_START) && (Type != PERFORMANCE_BINARY_LOG_RECORD_END)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (TimeStamp == 0) {
+    TimeStamp = GetPerformanceCounter ();
+  }
+
+  InternalAppendRecord (
+    Context,
+    InternalGetRing (Context, InternalPerformanceBinaryLogGetCpuId ()),
+    Type,
+    (UINT64) (UINTN) Handle,
+    PerformanceBinaryLogInternString (Context, Token),
+    PerformanceBinaryLogInternString (Context, Module),
+    TimeStamp,
+    Identifier
+    );
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Translate a string ID of a log into the string ID of another log.
+
+  @param[in] Destination        Context of the log to translate into.
+  @param[in] Source             Context of the log to translate from.
+  @param[in] StringId           String ID in Source.
+
+  @return The string ID in Destination.
+
+**/
+UINT16
+InternalTranslateStringId (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Destination,
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Source,
+  IN UINT16                                StringId
+  )
+{
+  PERFORMANCE_BINARY_LOG_STRING  *Entry;
+  CHAR8                          Name[PERFORMANCE_BINARY_LOG_STRING_SIZE];
+
+  if ((StringId == PERFORMANCE_BINARY_LOG_STRING_ID_NONE) ||
+      (StringId == PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW)) {
+    return StringId;
+  }
+  if (StringId > Source->StringCount) {
+    return PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW;
+  }
+
+  Entry = &Source->Strings[StringId - 1];
+  if (Entry->Hash <= PERFORMANCE_BINARY_LOG_STRING_BUSY) {
+    return PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW;
+  }
+  CopyMem (Name, Entry->Name, PERFORMANCE_BINARY_LOG_STRING_LENGTH);
+  Name[PERFORMANCE_BINARY_LOG_STRING_LENGTH] = '\0';
+
+  return PerformanceBinaryLogInternString (Destination, Name);
+}
+
+/**
+  Append the records of a log into another one.
+
+  The records of every ring of Source are appended, oldest first, into the
+  ring of Destination owned by the same processor, and their strings are
+  interned into the string table of Destination.
+
+  @param[in] Destination        Context of the log to append into.
+  @param[in] Source             Context of the log to append from.
+
+**/
+VOID
+EFIAPI
+PerformanceBinaryLogMerge (
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Destination,
+  IN CONST PERFORMANCE_BINARY_LOG_CONTEXT  *Source
+  )
+{
+  PERFORMANCE_BINARY_LOG_RING    *SourceRing;
+  PERFORMANCE_BINARY_LOG_RING    *DestinationRing;
+  PERFORMANCE_BINARY_LOG_RECORD  *Record;
+  UINT32                         Index;
+  UINT32                         WriteCount;
+  UINT32                         Count;
+  UINT32                         Sequence;
+
+  for (Index = 0; Index < Source->RingCount; Index++) {
+    SourceRing = (PERFORMANCE_BINARY_LOG_RING *) (Source->Rings + (UINTN) Index * Source->RingLength);
+    if (SourceRing->CpuId == PERFORMANCE_BINARY_LOG_RING_FREE) {
+      continue;
+    }
+
+    DestinationRing = InternalGetRing (Destination, SourceRing->CpuId);
+    WriteCount      = SourceRing->WriteCount;
+    Count           = MIN (WriteCount, Source->RingRecordCount);
+    for (Sequence = WriteCount - Count + 1; Count > 0; Sequence++, Count--) {
+      Record = (PERFORMANCE_BINARY_LOG_RECORD *) (SourceRing + 1) + ((Sequence - 1) & (Source->RingRecordCount - 1));
+      if (Record->Sequence != Sequence) {
+        continue;
+      }
+      InternalAppendRecord (
+        Destination,
+        DestinationRing,
+        Record->Type,
+        Record->Handle,
+        InternalTranslateStringId (Destination, Source, Record->TokenId),
+        InternalTranslateStringId (Destination, Source, Record->ModuleId),
+        Record->TimeStamp,
+        Record->Identifier
+        );
+    }
+  }
+}
@@ -0,0 +1,46 @@
+/** @file
+  Internal header of the base binary performance log library instance.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef _PERFORMANCE_BINARY_LOG_INTERNAL_H_
+#define _PERFORMANCE_BINARY_LOG_INTERNAL_H_
+
+#include <Base.h>
+#include <Uefi/UefiBaseType.h>
+
+#include <Library/PerformanceBinaryLogLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/TimerLib.h>
+
+//
+// Bound of the wait for another processor to finish adding a string, the slot
+// is considered lost after it so a corrupted log can not hang the caller.
+//
+#define PERFORMANCE_BINARY_LOG_STRING_SPIN_COUNT  0x100000
+
+/**
+  Return an ID of the executing processor, unique among the processors of the
+  system.
+
+  @return ID of the executing processor.
+
+**/
+UINT32
+InternalPerformanceBinaryLogGetCpuId (
+  VOID
+  );
+
+#endif
@@ -0,0 +1,50 @@
+/** @file
+  Return the APIC ID of the executing IA32 or X64 processor.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "PerformanceBinaryLogInternal.h"
+
+#define CPUID_SIGNATURE                  0x00
+#define CPUID_VERSION_INFO               0x01
+#define CPUID_EXTENDED_TOPOLOGY          0x0B
+
+/**
+  Return an ID of the executing processor, unique among the processors of the
+  system.
+
+  The x2APIC ID is used when the extended topology leaf is supported, the
+  initial APIC ID otherwise. Neither depends on the mode of the local APIC.
+
+  @return ID of the executing processor.
+
+**/
+UINT32
+InternalPerformanceBinaryLogGetCpuId (
+  VOID
+  )
+{
+  UINT32  MaxLeaf;
+  UINT32  RegEbx;
+  UINT32  RegEdx;
+
+  AsmCpuid (CPUID_SIGNATURE, &MaxLeaf, NULL, NULL, NULL);
+  if (MaxLeaf >= CPUID_EXTENDED_TOPOLOGY) {
+    AsmCpuidEx (CPUID_EXTENDED_TOPOLOGY, 0, NULL, &RegEbx, NULL, &RegEdx);
+    if ((RegEbx & 0xFFFF) != 0) {
+      return RegEdx;
+    }
+  }
+
+  AsmCpuid (CPUID_VERSION_INFO, NULL, &RegEbx, NULL, NULL);
+  return RegEbx >> 24;
+}
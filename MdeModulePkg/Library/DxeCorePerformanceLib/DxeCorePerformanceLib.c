@@ -10,6 +10,10 @@
   This library is mainly used by DxeCore to start performance logging to ensure that
   Performance Protocol is installed at the very beginning of DXE phase.
 
+  When PcdPerformanceBinaryLogEnable is TRUE, the measurements are appended into the
+  binary performance log instead, which takes over the PEI binary performance log and
+  is installed as a configuration table for Dp and the OS tools.
+
 Copyright (c) 2006 - 2016, Intel Corporation. All rights reserved.<BR>
 (C) Copyright 2016 Hewlett Packard Enterprise Development LP<BR>
 This program and the accompanying materials
@@ -38,6 +42,13 @@ GAUGE_DATA_HEADER    *mGaugeData;
 //
 UINT32               mMaxGaugeRecords;
 
+//
+// The binary performance log, used instead of the gauge array when
+// mPerformanceBinaryLogEnabled is TRUE.
+//
+PERFORMANCE_BINARY_LOG_CONTEXT  mPerformanceBinaryLog;
+BOOLEAN                         mPerformanceBinaryLogEnabled = FALSE;
+
 //
 // The handle to install Performance Protocol instance.
 //
@@ -161,6 +172,18 @@ StartGaugeEx (
   GAUGE_DATA_HEADER         *OldGaugeData;
   UINT32                    Index;
 
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable) && mPerformanceBinaryLogEnabled) {
+    return (EFI_STATUS) PerformanceBinaryLogAppend (
+                          &mPerformanceBinaryLog,
+                          PERFORMANCE_BINARY_LOG_RECORD_START,
+                          Handle,
+                          Token,
+                          Module,
+                          TimeStamp,
+                          Identifier
+                          );
+  }
+
   Index = mGaugeData->NumberOfEntries;
   if (Index >= mMaxGaugeRecords) {
     //
@@ -249,6 +272,22 @@ EndGaugeEx (
   GAUGE_DATA_ENTRY_EX *GaugeEntryExArray;
   UINT32              Index;
 
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable) && mPerformanceBinaryLogEnabled) {
+    //
+    // The end record is paired with its start record by the log consumers,
+    // which keeps the recording cost constant.
+    //
+    return (EFI_STATUS) PerformanceBinaryLogAppend (
+                          &mPerformanceBinaryLog,
+                          PERFORMANCE_BINARY_LOG_RECORD_END,
+                          Handle,
+                          Token,
+                          Module,
+                          TimeStamp,
+                          Identifier
+                          );
+  }
+
   if (TimeStamp == 0) {
     TimeStamp = GetPerformanceCounter ();
   }
@@ -481,6 +520,69 @@ InternalGetPeiPerformance (
   mGaugeData->NumberOfEntries = NumberOfEntries;
 }
 
+/**
+  Allocates the binary performance log of DXE phase, appends the PEI binary performance
+  log into it and installs it as a configuration table.
+
+  The log is allocated in reserved memory so that it is still available to the OS tools.
+  The gauge array keeps being used if the log can not be allocated.
+
+**/
+VOID
+InternalInitializePerformanceBinaryLog (
+  VOID
+  )
+{
+  EFI_STATUS                      Status;
+  EFI_HOB_GUID_TYPE               *GuidHob;
+  PERFORMANCE_BINARY_LOG_CONTEXT  PeiBinaryLog;
+  UINTN                           Pages;
+  VOID                            *Buffer;
+
+  Pages = EFI_SIZE_TO_PAGES (
+            PerformanceBinaryLogGetSize (
+              PcdGet32 (PcdPerformanceBinaryLogStringCount),
+              PcdGet32 (PcdPerformanceBinaryLogRingCount),
+              PcdGet32 (PcdPerformanceBinaryLogRingRecordCount)
+              )
+            );
+  if (Pages == 0) {
+    DEBUG ((DEBUG_ERROR, "DXE binary performance log geometry is invalid\n"));
+    return;
+  }
+
+  Buffer = AllocateReservedPages (Pages);
+  if (Buffer == NULL) {
+    return;
+  }
+
+  Status = PerformanceBinaryLogInitialize (
+             &mPerformanceBinaryLog,
+             Buffer,
+             EFI_PAGES_TO_SIZE (Pages),
+             PcdGet32 (PcdPerformanceBinaryLogStringCount),
+             PcdGet32 (PcdPerformanceBinaryLogRingCount),
+             PcdGet32 (PcdPerformanceBinaryLogRingRecordCount)
+             );
+  ASSERT_EFI_ERROR (Status);
+
+  GuidHob = GetFirstGuidHob (&gEdkiiPerformanceBinaryLogGuid);
+  if (GuidHob != NULL) {
+    Status = PerformanceBinaryLogOpen (&PeiBinaryLog, GET_GUID_HOB_DATA (GuidHob), GET_GUID_HOB_DATA_SIZE (GuidHob));
+    if (!RETURN_ERROR (Status)) {
+      PerformanceBinaryLogMerge (&mPerformanceBinaryLog, &PeiBinaryLog);
+    }
+  }
+
+  Status = gBS->InstallConfigurationTable (&gEdkiiPerformanceBinaryLogGuid, Buffer);
+  if (EFI_ERROR (Status)) {
+    FreePages (Buffer, Pages);
+    return;
+  }
+
+  mPerformanceBinaryLogEnabled = TRUE;
+}
+
 /**
   The constructor function initializes Performance infrastructure for DXE phase.
 
@@ -531,6 +633,10 @@ DxeCorePerformanceLibConstructor (
 
   InternalGetPeiPerformance ();
 
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable)) {
+    InternalInitializePerformanceBinaryLog ();
+  }
+
   return Status;
 }
 
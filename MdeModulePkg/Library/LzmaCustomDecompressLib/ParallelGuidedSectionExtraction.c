@@ -0,0 +1,374 @@
+/** @file
+  LZMA block-parallel Decompress GUIDed Section Extraction Library.
+  It wraps Lzma decompress interfaces to GUIDed Section Extraction interfaces
+  and registers them into GUIDed handler table. The independently compressed
+  blocks of a section are decompressed on all enabled processors through the
+  PEI MP Services PPI.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+#include <Ppi/MpServices.h>
+#include <Library/PeiServicesLib.h>
+#include <Library/PeiServicesTablePointerLib.h>
+#include <Library/SynchronizationLib.h>
+
+//
+// Size of the LZMA stream header, LZMA properties and 64-bit decoded size.
+//
+#define LZMA_BLOCK_HEADER_SIZE  13
+
+///
+/// State shared by the processors decompressing the blocks of one section.
+///
+typedef struct {
+  CONST UINT8      *Data;           ///< Start of the LZMA_PARALLEL_HEADER
+  CONST UINT32     *BlockOffset;    ///< BlockCount + 1 offsets relative to Data
+  UINT32           BlockSize;
+  UINT32           BlockCount;
+  UINT32           DecodedSize;
+  UINT32           ScratchSize;     ///< Largest scratch buffer size of a block
+  UINT8            *Destination;
+  UINT8            *Scratch;        ///< BlockCount scratch buffers of ScratchSize
+  UINT32           NextBlock;       ///< Index of the next block to decompress
+  UINT32           FailedBlocks;
+} LZMA_PARALLEL_CONTEXT;
+
+/**
+  Validate the data of a LZMA block-parallel GUIDed section and initialize the
+  decompression context from it.
+
+  Every block is checked to be inside the section and to decode to its share
+  of the decoded size, so the blocks can be decompressed without further checks.
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] Context       The context to initialize.
+
+  @retval  RETURN_SUCCESS            The section is valid and Context was initialized.
+  @retval  RETURN_INVALID_PARAMETER  The section is not a valid LZMA block-parallel section.
+
+**/
+RETURN_STATUS
+LzmaParallelInitContext (
+  IN  CONST VOID             *InputSection,
+  OUT LZMA_PARALLEL_CONTEXT  *Context
+  )
+{
+  CONST LZMA_PARALLEL_HEADER  *Header;
+  CONST EFI_GUID              *SectionGuid;
+  UINT32                      DataSize;
+  UINT32                      Index;
+  UINT32                      BlockStart;
+  UINT32                      BlockEnd;
+  UINT32                      ExpectedSize;
+  UINT32                      DecodedSize;
+  UINT32                      ScratchSize;
+  RETURN_STATUS               Status;
+
+  if (IS_SECTION2 (InputSection)) {
+    SectionGuid = &((EFI_GUID_DEFINED_SECTION2 *) InputSection)->SectionDefinitionGuid;
+    Header      = (LZMA_PARALLEL_HEADER *) ((UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset);
+    DataSize    = SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset;
+  } else {
+    SectionGuid = &((EFI_GUID_DEFINED_SECTION *) InputSection)->SectionDefinitionGuid;
+    Header      = (LZMA_PARALLEL_HEADER *) ((UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset);
+    DataSize    = SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset;
+  }
+
+  if (!CompareGuid (&gLzmaParallelCustomDecompressGuid, SectionGuid)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if ((DataSize < sizeof (LZMA_PARALLEL_HEADER)) ||
+      (Header->Signature != LZMA_PARALLEL_SIGNATURE) ||
+      (Header->BlockSize == 0) ||
+      (Header->DecodedSize == 0) ||
+      (Header->BlockCount != (Header->DecodedSize - 1) / Header->BlockSize + 1) ||
+      (Header->BlockCount >= (DataSize - sizeof (LZMA_PARALLEL_HEADER)) / sizeof (UINT32))) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Context->Data         = (CONST UINT8 *) Header;
+  Context->BlockOffset  = (CONST UINT32 *) (Header + 1);
+  Context->BlockSize    = Header->BlockSize;
+  Context->BlockCount   = Header->BlockCount;
+  Context->DecodedSize  = Header->DecodedSize;
+  Context->ScratchSize  = 0;
+  Context->Destination  = NULL;
+  Context->Scratch      = NULL;
+  Context->NextBlock    = 0;
+  Context->FailedBlocks = 0;
+
+  for (Index = 0; Index < Context->BlockCount; Index++) {
+    BlockStart = Context->BlockOffset[Index];
+    BlockEnd   = Context->BlockOffset[Index + 1];
+    if ((BlockEnd > DataSize) || (BlockStart > BlockEnd) ||
+        (BlockEnd - BlockStart < LZMA_BLOCK_HEADER_SIZE)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    if (Index == Context->BlockCount - 1) {
+      ExpectedSize = Context->DecodedSize - Index * Context->BlockSize;
+    } else {
+      ExpectedSize = Context->BlockSize;
+    }
+
+    Status = LzmaUefiDecompressGetInfo (
+               Context->Data + BlockStart,
+               BlockEnd - BlockStart,
+               &DecodedSize,
+               &ScratchSize
+               );
+    if (RETURN_ERROR (Status) || (DecodedSize != ExpectedSize)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    Context->ScratchSize = MAX (Context->ScratchSize, ScratchSize);
+  }
+
+  if ((Context->ScratchSize != 0) && (Context->BlockCount > MAX_UINT32 / Context->ScratchSize)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompress the blocks of a section until there are none left.
+
+  It runs on the APs and on the BSP. Each processor takes the next block that
+  is not taken yet, so no block is decompressed twice. It must not call any
+  PEI service, as it runs on the APs.
+
+  @param[in, out] Buffer  The LZMA_PARALLEL_CONTEXT of the section.
+
+**/
+VOID
+EFIAPI
+LzmaParallelDecompressBlocks (
+  IN OUT VOID  *Buffer
+  )
+{
+  LZMA_PARALLEL_CONTEXT  *Context;
+  UINT32                 Index;
+  RETURN_STATUS          Status;
+
+  Context = (LZMA_PARALLEL_CONTEXT *) Buffer;
+
+  while (TRUE) {
+    Index = InterlockedIncrement (&Context->NextBlock) - 1;
+    if (Index >= Context->BlockCount) {
+      break;
+    }
+
+    Status = LzmaUefiDecompress (
+               Context->Data + Context->BlockOffset[Index],
+               Context->BlockOffset[Index + 1] - Context->BlockOffset[Index],
+               Context->Destination + (UINTN) Index * Context->BlockSize,
+               Context->Scratch + (UINTN) Index * Context->ScratchSize
+               );
+    if (RETURN_ERROR (Status)) {
+      InterlockedIncrement (&Context->FailedBlocks);
+    }
+  }
+}
+
+/**
+  Examines a GUIDed section and returns the size of the decoded buffer and the
+  size of an scratch buffer required to actually decode the data in a GUIDed section.
+
+  Examines a GUIDed section specified by InputSection.
+  If GUID for InputSection does not match the GUID that this handler supports,
+  then RETURN_UNSUPPORTED is returned.
+  If the required information can not be retrieved from InputSection,
+  then RETURN_INVALID_PARAMETER is returned.
+  If the GUID of InputSection does match the GUID that this handler supports,
+  then the size required to hold the decoded buffer is returned in OututBufferSize,
+  the size of an optional scratch buffer is returned in ScratchSize, and the Attributes field
+  from EFI_GUID_DEFINED_SECTION header of InputSection is returned in SectionAttribute.
+
+  If InputSection is NULL, then ASSERT().
+  If OutputBufferSize is NULL, then ASSERT().
+  If ScratchBufferSize is NULL, then ASSERT().
+  If SectionAttribute is NULL, then ASSERT().
+
+
+  @param[in]  InputSection       A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize   A pointer to the size, in bytes, of an output buffer required
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] ScratchBufferSize  A pointer to the size, in bytes, required as scratch space
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] SectionAttribute   A pointer to the attributes of the GUIDed section. See the Attributes
+                                 field of EFI_GUID_DEFINED_SECTION in the PI Specification.
+
+  @retval  RETURN_SUCCESS            The information about InputSection was returned.
+  @retval  RETURN_UNSUPPORTED        The section specified by InputSection does not match the GUID this handler supports.
+  @retval  RETURN_INVALID_PARAMETER  The information can not be retrieved from the section specified by InputSection.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaParallelGuidedSectionGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *ScratchBufferSize,
+  OUT UINT16      *SectionAttribute
+  )
+{
+  LZMA_PARALLEL_CONTEXT  Context;
+  RETURN_STATUS          Status;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBufferSize != NULL);
+  ASSERT (ScratchBufferSize != NULL);
+  ASSERT (SectionAttribute != NULL);
+
+  Status = LzmaParallelInitContext (InputSection, &Context);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  if (IS_SECTION2 (InputSection)) {
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->Attributes;
+  } else {
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION *) InputSection)->Attributes;
+  }
+
+  //
+  // Each block gets its own scratch buffer, so any processor can decompress any block.
+  //
+  *OutputBufferSize  = Context.DecodedSize;
+  *ScratchBufferSize = Context.BlockCount * Context.ScratchSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompress a LZMA block-parallel GUIDed section into a caller allocated output buffer.
+
+  Decodes the GUIDed section specified by InputSection.
+  If GUID for InputSection does not match the GUID that this handler supports, then RETURN_UNSUPPORTED is returned.
+  If the data in InputSection can not be decoded, then RETURN_INVALID_PARAMETER is returned.
+  If the GUID of InputSection does match the GUID that this handler supports, then InputSection
+  is decoded into the buffer specified by OutputBuffer and the authentication status of this
+  decode operation is returned in AuthenticationStatus.  If the decoded buffer is identical to the
+  data in InputSection, then OutputBuffer is set to point at the data in InputSection.  Otherwise,
+  the decoded data will be placed in caller allocated buffer specified by OutputBuffer.
+
+  The blocks are decompressed by all enabled processors when the PEI MP Services PPI
+  is installed, or by the BSP alone otherwise.
+
+  If InputSection is NULL, then ASSERT().
+  If OutputBuffer is NULL, then ASSERT().
+  If ScratchBuffer is NULL and this decode operation requires a scratch buffer, then ASSERT().
+  If AuthenticationStatus is NULL, then ASSERT().
+
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBuffer  A pointer to a buffer that contains the result of a decode operation.
+  @param[out] ScratchBuffer A caller allocated buffer that may be required by this function
+                            as a scratch buffer to perform the decode operation.
+  @param[out] AuthenticationStatus
+                            A pointer to the authentication status of the decoded output buffer.
+                            See the definition of authentication status in the EFI_PEI_GUIDED_SECTION_EXTRACTION_PPI
+                            section of the PI Specification. EFI_AUTH_STATUS_PLATFORM_OVERRIDE must
+                            never be set by this handler.
+
+  @retval  RETURN_SUCCESS            The buffer specified by InputSection was decoded.
+  @retval  RETURN_UNSUPPORTED        The section specified by InputSection does not match the GUID this handler supports.
+  @retval  RETURN_INVALID_PARAMETER  The section specified by InputSection can not be decoded.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaParallelGuidedSectionExtraction (
+  IN CONST  VOID    *InputSection,
+  OUT       VOID    **OutputBuffer,
+  OUT       VOID    *ScratchBuffer,        OPTIONAL
+  OUT       UINT32  *AuthenticationStatus
+  )
+{
+  LZMA_PARALLEL_CONTEXT    Context;
+  EFI_PEI_MP_SERVICES_PPI  *MpServices;
+  RETURN_STATUS            Status;
+  EFI_STATUS               MpStatus;
+
+  ASSERT (OutputBuffer != NULL);
+  ASSERT (InputSection != NULL);
+  ASSERT (ScratchBuffer != NULL);
+
+  Status = LzmaParallelInitContext (InputSection, &Context);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Authentication is set to Zero, which may be ignored.
+  //
+  *AuthenticationStatus = 0;
+
+  Context.Destination = *OutputBuffer;
+  Context.Scratch     = ScratchBuffer;
+
+  if (Context.BlockCount > 1) {
+    MpStatus = PeiServicesLocatePpi (&gEfiPeiMpServicesPpiGuid, 0, NULL, (VOID **) &MpServices);
+    if (!EFI_ERROR (MpStatus)) {
+      //
+      // StartupAllAPs() of the PEI MP Services PPI only returns when all APs
+      // are done, so the BSP can not decompress blocks at the same time.
+      //
+      MpStatus = MpServices->StartupAllAPs (
+                               GetPeiServicesTablePointer (),
+                               MpServices,
+                               LzmaParallelDecompressBlocks,
+                               FALSE,
+                               0,
+                               &Context
+                               );
+    }
+    DEBUG ((DEBUG_INFO, "LzmaParallel: %d blocks, APs %r\n", Context.BlockCount, MpStatus));
+  }
+
+  //
+  // The BSP decompresses the blocks left by the APs, which are all of them
+  // when there is no MP Services PPI or no enabled AP.
+  //
+  LzmaParallelDecompressBlocks (&Context);
+
+  if (Context.FailedBlocks != 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Register LzmaParallelGuidedSectionExtraction and LzmaParallelGuidedSectionGetInfo
+  handlers with LzmaParallelCustomDecompressGuid.
+
+  @param  FileHandle   The handle of FFS header the loaded driver.
+  @param  PeiServices  The pointer to the PEI services.
+
+  @retval  RETURN_SUCCESS            Register successfully.
+  @retval  RETURN_OUT_OF_RESOURCES   No enough memory to store this handler.
+**/
+EFI_STATUS
+EFIAPI
+LzmaParallelDecompressLibConstructor (
+  IN EFI_PEI_FILE_HANDLE     FileHandle,
+  IN CONST EFI_PEI_SERVICES  **PeiServices
+  )
+{
+  return ExtractGuidedSectionRegisterHandlers (
+          &gLzmaParallelCustomDecompressGuid,
+          LzmaParallelGuidedSectionGetInfo,
+          LzmaParallelGuidedSectionExtraction
+          );
+}
@@ -19,6 +19,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/ExtractGuidedSectionLib.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/BaseLib.h>
 
 ///
 /// CRC32 Guided Section header
@@ -33,32 +34,6 @@ typedef struct {
   UINT32                    CRC32Checksum;       ///< 32bit CRC check sum
 } CRC32_SECTION2_HEADER;
 
-/**
-  This internal function reverses bits for 32bit data.
-
-  @param  Value                 The data to be reversed.
-
-  @return                       Data reversed.
-
-**/
-UINT32
-PeiCrc32GuidedSectionExtractLibReverseBits (
-  UINT32  Value
-  )
-{
-  UINTN   Index;
-  UINT32  NewValue;
-
-  NewValue = 0;
-  for (Index = 0; Index < 32; Index++) {
-    if ((Value & (1 << Index)) != 0) {
-      NewValue = NewValue | (1 << (31 - Index));
-    }
-  }
-
-  return NewValue;
-}
-
 /**
   Calculate CRC32 for target data.
 
@@ -79,41 +54,11 @@ PeiCrc32GuidedSectionExtractLibCalculateCrc32 (
   OUT UINT32  *CrcOut
   )
 {
-  UINT32  CrcTable[256];
-  UINTN   TableEntry;
-  UINTN   Index;
-  UINT32  Value;
-  UINT32  Crc;
-  UINT8   *Ptr;
-
   if (Data == NULL || DataSize == 0 || CrcOut == NULL) {
     return EFI_INVALID_PARAMETER;
   }
-  
-  //
-  // Initialize CRC32 table.
-  //
-  for (TableEntry = 0; TableEntry < 256; TableEntry++) {
-    Value = PeiCrc32GuidedSectionExtractLibReverseBits ((UINT32) TableEntry);
-    for (Index = 0; Index < 8; Index++) {
-      if ((Value & 0x80000000) != 0) {
-        Value = (Value << 1) ^ 0x04c11db7;
-      } else {
-        Value = Value << 1;
-      }
-    }
-    CrcTable[TableEntry] = PeiCrc32GuidedSectionExtractLibReverseBits (Value);
-  }
-
-  //
-  // Compute CRC
-  //
-  Crc = 0xffffffff;
-  for (Index = 0, Ptr = Data; Index < DataSize; Index++, Ptr++) {
-    Crc = (Crc >> 8) ^ CrcTable[(UINT8) Crc ^ *Ptr];
-  }
 
-  *CrcOut = Crc ^ 0xffffffff;
+  *CrcOut = CalculateCrc32 (Data, DataSize);
   return EFI_SUCCESS;
 }
 
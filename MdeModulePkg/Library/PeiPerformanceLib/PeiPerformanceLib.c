@@ -7,6 +7,10 @@
   number of performance logging entry is specified by PcdMaxPeiPerformanceLogEntries or 
   PcdMaxPeiPerformanceLogEntries16.
 
+  When PcdPerformanceBinaryLogEnable is TRUE, the measurements are appended into
+  the binary performance log GUIDed HOB instead, and their start and end records
+  are paired by the log consumers.
+
 Copyright (c) 2006 - 2016, Intel Corporation. All rights reserved.<BR>
 (C) Copyright 2015-2016 Hewlett Packard Enterprise Development LP<BR>
 This program and the accompanying materials
@@ -31,6 +35,14 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/TimerLib.h>
 #include <Library/PcdLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/PerformanceBinaryLogLib.h>
+
+//
+// Maximum number of strings of the PEI binary performance log, and maximum size
+// of the log limited by the 16-bit length of its GUIDed HOB.
+//
+#define PEI_PERFORMANCE_BINARY_LOG_STRING_COUNT  128
+#define PEI_PERFORMANCE_BINARY_LOG_MAX_SIZE      (0xFFF8 - sizeof (EFI_HOB_GUID_TYPE))
 
 
 /**
@@ -86,6 +98,60 @@ InternalGetPerformanceHobLog (
   }
 }
 
+/**
+  Gets the binary performance log of PEI phase.
+
+  This internal function searches for the GUID HOB of the binary performance log.
+  If that GUID HOB is not found, it will build a new one. The number of records
+  of each ring is the largest power of 2 not greater than
+  PcdPerformanceBinaryLogRingRecordCount that lets the log fit in a HOB.
+
+  @param    Context             Context of the binary performance log.
+
+  @retval   RETURN_SUCCESS              The log is returned.
+  @retval   RETURN_OUT_OF_RESOURCES     The log can not be built.
+  @retval   RETURN_VOLUME_CORRUPTED     The log in the GUID HOB is not valid.
+
+**/
+RETURN_STATUS
+InternalGetPerformanceBinaryLog (
+  OUT PERFORMANCE_BINARY_LOG_CONTEXT  *Context
+  )
+{
+  EFI_HOB_GUID_TYPE           *GuidHob;
+  VOID                        *Buffer;
+  UINTN                       Size;
+  UINT32                      StringCount;
+  UINT32                      RingCount;
+  UINT32                      RingRecordCount;
+
+  GuidHob = GetFirstGuidHob (&gEdkiiPerformanceBinaryLogGuid);
+  if (GuidHob != NULL) {
+    return PerformanceBinaryLogOpen (Context, GET_GUID_HOB_DATA (GuidHob), GET_GUID_HOB_DATA_SIZE (GuidHob));
+  }
+
+  StringCount     = MIN (PcdGet32 (PcdPerformanceBinaryLogStringCount), PEI_PERFORMANCE_BINARY_LOG_STRING_COUNT);
+  RingCount       = PcdGet32 (PcdPerformanceBinaryLogRingCount);
+  RingRecordCount = PcdGet32 (PcdPerformanceBinaryLogRingRecordCount);
+  while (TRUE) {
+    Size = PerformanceBinaryLogGetSize (StringCount, RingCount, RingRecordCount);
+    if ((Size != 0) && (Size <= PEI_PERFORMANCE_BINARY_LOG_MAX_SIZE)) {
+      break;
+    }
+    if (RingRecordCount <= 1) {
+      DEBUG ((DEBUG_ERROR, "PEI binary performance log does not fit in a HOB\n"));
+      return RETURN_OUT_OF_RESOURCES;
+    }
+    RingRecordCount >>= 1;
+  }
+
+  Buffer = BuildGuidHob (&gEdkiiPerformanceBinaryLogGuid, Size);
+  if (Buffer == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+  return PerformanceBinaryLogInitialize (Context, Buffer, Size, StringCount, RingCount, RingRecordCount);
+}
+
 /**
   Searches in the log array with keyword Handle, Token, Module and Identifier.
 
@@ -185,6 +251,16 @@ StartPerformanceMeasurementEx (
   PEI_PERFORMANCE_LOG_ENTRY   *LogEntryArray;
   UINT32                      Index;
   UINT16                      PeiPerformanceLogEntries;
+  PERFORMANCE_BINARY_LOG_CONTEXT  BinaryLog;
+  RETURN_STATUS               Status;
+
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable)) {
+    Status = InternalGetPerformanceBinaryLog (&BinaryLog);
+    if (RETURN_ERROR (Status)) {
+      return RETURN_OUT_OF_RESOURCES;
+    }
+    return PerformanceBinaryLogAppend (&BinaryLog, PERFORMANCE_BINARY_LOG_RECORD_START, Handle, Token, Module, TimeStamp, Identifier);
+  }
 
   PeiPerformanceLogEntries = (UINT16) (PcdGet16 (PcdMaxPeiPerformanceLogEntries16) != 0 ?
                                        PcdGet16 (PcdMaxPeiPerformanceLogEntries16) :
@@ -256,6 +332,19 @@ EndPerformanceMeasurementEx (
   UINT32                      *PeiPerformanceIdArray;
   PEI_PERFORMANCE_LOG_ENTRY   *LogEntryArray;
   UINT32                      Index;
+  PERFORMANCE_BINARY_LOG_CONTEXT  BinaryLog;
+  RETURN_STATUS               Status;
+
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable)) {
+    //
+    // The end record is paired with its start record by the log consumers.
+    //
+    Status = InternalGetPerformanceBinaryLog (&BinaryLog);
+    if (RETURN_ERROR (Status)) {
+      return RETURN_NOT_FOUND;
+    }
+    return PerformanceBinaryLogAppend (&BinaryLog, PERFORMANCE_BINARY_LOG_RECORD_END, Handle, Token, Module, TimeStamp, Identifier);
+  }
 
   if (TimeStamp == 0) {
     TimeStamp = GetPerformanceCounter ();
@@ -9,6 +9,10 @@
   This library is mainly used by SMM Core to start performance logging to ensure that
   SMM Performance and PerformanceEx Protocol are installed at the very beginning of SMM phase.
 
+  When PcdPerformanceBinaryLogEnable is TRUE, the measurements are appended into the
+  binary performance log installed by DxeCorePerformanceLib instead. Only the geometry
+  of the log captured in SMRAM is trusted, since the log lives outside SMRAM.
+
  Caution: This module requires additional review when modified.
  This driver will have external input - performance data and communicate buffer in SMM mode.
  This external input must be validated carefully to avoid security issue like
@@ -51,6 +55,13 @@ BOOLEAN                 mPerformanceMeasurementEnabled;
 
 SPIN_LOCK               mSmmPerfLock;
 
+//
+// The binary performance log, used instead of the gauge array when
+// mPerformanceBinaryLogEnabled is TRUE.
+//
+PERFORMANCE_BINARY_LOG_CONTEXT  mPerformanceBinaryLog;
+BOOLEAN                         mPerformanceBinaryLogEnabled = FALSE;
+
 //
 // Interfaces for SMM Performance Protocol.
 //
@@ -169,6 +180,18 @@ StartGaugeEx (
   GAUGE_DATA_HEADER         *OldGaugeData;
   UINT32                    Index;
 
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable) && mPerformanceBinaryLogEnabled) {
+    return (EFI_STATUS) PerformanceBinaryLogAppend (
+                          &mPerformanceBinaryLog,
+                          PERFORMANCE_BINARY_LOG_RECORD_START,
+                          Handle,
+                          Token,
+                          Module,
+                          TimeStamp,
+                          Identifier
+                          );
+  }
+
   AcquireSpinLock (&mSmmPerfLock);
 
   Index = mGaugeData->NumberOfEntries;
@@ -262,6 +285,21 @@ EndGaugeEx (
   GAUGE_DATA_ENTRY_EX *GaugeEntryExArray;
   UINT32              Index;
 
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable) && mPerformanceBinaryLogEnabled) {
+    //
+    // The end record is paired with its start record by the log consumers.
+    //
+    return (EFI_STATUS) PerformanceBinaryLogAppend (
+                          &mPerformanceBinaryLog,
+                          PERFORMANCE_BINARY_LOG_RECORD_END,
+                          Handle,
+                          Token,
+                          Module,
+                          TimeStamp,
+                          Identifier
+                          );
+  }
+
   AcquireSpinLock (&mSmmPerfLock);
 
   if (TimeStamp == 0) {
@@ -670,6 +708,48 @@ SmmPerformanceHandler (
   return EFI_SUCCESS;
 }
 
+/**
+  Opens the binary performance log installed as a configuration table in DXE phase.
+
+  The log must be outside SMRAM. Its geometry is validated and captured now, before
+  any untrusted code runs, and is not read from the log again.
+
+**/
+VOID
+InternalOpenPerformanceBinaryLog (
+  VOID
+  )
+{
+  RETURN_STATUS                   Status;
+  PERFORMANCE_BINARY_LOG_HEADER   *Header;
+  UINT32                          Length;
+  UINTN                           Index;
+
+  for (Index = 0; Index < gST->NumberOfTableEntries; Index++) {
+    if (!CompareGuid (&gST->ConfigurationTable[Index].VendorGuid, &gEdkiiPerformanceBinaryLogGuid)) {
+      continue;
+    }
+
+    Header = (PERFORMANCE_BINARY_LOG_HEADER *) gST->ConfigurationTable[Index].VendorTable;
+    if (!SmmIsBufferOutsideSmmValid ((EFI_PHYSICAL_ADDRESS) (UINTN) Header, sizeof (*Header))) {
+      break;
+    }
+    Length = Header->Length;
+    if (!SmmIsBufferOutsideSmmValid ((EFI_PHYSICAL_ADDRESS) (UINTN) Header, Length)) {
+      break;
+    }
+
+    Status = PerformanceBinaryLogOpen (&mPerformanceBinaryLog, Header, Length);
+    if (!RETURN_ERROR (Status)) {
+      mPerformanceBinaryLogEnabled = TRUE;
+      return;
+    }
+    break;
+  }
+
+  DEBUG ((DEBUG_WARN, "SMM binary performance log is not available\n"));
+}
+
 /**
   SmmBase2 protocol notify callback function, when SMST and SMM memory service get initialized 
   this function is callbacked to initialize the Smm Performance Lib 
@@ -697,6 +777,10 @@ InitializeSmmCorePerformanceLib (
 
   mGaugeData = AllocateZeroPool (sizeof (GAUGE_DATA_HEADER) + (sizeof (GAUGE_DATA_ENTRY_EX) * mMaxGaugeRecords));
   ASSERT (mGaugeData != NULL);
+
+  if (FeaturePcdGet (PcdPerformanceBinaryLogEnable)) {
+    InternalOpenPerformanceBinaryLog ();
+  }
   
   //
   // Install the protocol interfaces.
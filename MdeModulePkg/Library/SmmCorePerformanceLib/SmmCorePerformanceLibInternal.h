@@ -33,6 +33,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/MemoryAllocationLib.h>
 #include <Library/SynchronizationLib.h>
 #include <Library/SmmMemLib.h>
+#include <Library/PerformanceBinaryLogLib.h>
 
 #include <Protocol/SmmBase2.h>
 
@@ -98,6 +98,11 @@ GetLbaAndOffsetByAddress (
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
 
+  Only the range from the first to the last byte that differs from the
+  variable storage space is written, in one Fault Tolerant Write record.
+  Reclaim keeps the leading run of valid variables in place, so the range
+  is usually the tail of the variable storage space.
+
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
 
@@ -117,6 +122,9 @@ FtwVariableSpace (
   EFI_LBA                            VarLba;
   UINTN                              VarOffset;
   UINTN                              FtwBufferSize;
+  UINTN                              DirtyStart;
+  UINTN                              DirtyEnd;
+  UINT8                              *FlashBuffer;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
 
   //
@@ -133,28 +141,50 @@ FtwVariableSpace (
   if (EFI_ERROR (Status)) {
     return Status;
   }
+
+  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
+  ASSERT (FtwBufferSize == VariableBuffer->Size);
+
+  //
+  // Find the range that differs from the variable storage space.
+  //
+  FlashBuffer = (UINT8 *) (UINTN) VariableBase;
+  for (DirtyStart = 0; DirtyStart < FtwBufferSize; DirtyStart++) {
+    if (FlashBuffer[DirtyStart] != ((UINT8 *) VariableBuffer)[DirtyStart]) {
+      break;
+    }
+  }
+  if (DirtyStart == FtwBufferSize) {
+    //
+    // Nothing was reclaimed.
+    //
+    return EFI_SUCCESS;
+  }
+  for (DirtyEnd = FtwBufferSize; DirtyEnd > DirtyStart; DirtyEnd--) {
+    if (FlashBuffer[DirtyEnd - 1] != ((UINT8 *) VariableBuffer)[DirtyEnd - 1]) {
+      break;
+    }
+  }
+
   //
   // Get LBA and Offset by address.
   //
-  Status = GetLbaAndOffsetByAddress (VariableBase, &VarLba, &VarOffset);
+  Status = GetLbaAndOffsetByAddress (VariableBase + DirtyStart, &VarLba, &VarOffset);
   if (EFI_ERROR (Status)) {
     return EFI_ABORTED;
   }
 
-  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
-  ASSERT (FtwBufferSize == VariableBuffer->Size);
-
   //
   // FTW write record.
   //
   Status = FtwProtocol->Write (
                           FtwProtocol,
-                          VarLba,         // LBA
-                          VarOffset,      // Offset
-                          FtwBufferSize,  // NumBytes
-                          NULL,           // PrivateData NULL
-                          FvbHandle,      // Fvb Handle
-                          (VOID *) VariableBuffer // write buffer
+                          VarLba,                   // LBA
+                          VarOffset,                // Offset
+                          DirtyEnd - DirtyStart,    // NumBytes
+                          NULL,                     // PrivateData NULL
+                          FvbHandle,                // Fvb Handle
+                          (UINT8 *) VariableBuffer + DirtyStart // write buffer
                           );
 
   return Status;
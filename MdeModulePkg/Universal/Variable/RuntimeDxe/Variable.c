@@ -978,6 +978,199 @@ InitializeVariableQuota (
   CalculateCommonUserVariableTotalSize ();
 }
 
+/**
+  Compute the hash of a variable name and vendor GUID for the variable store index.
+
+  @param[in]  VariableName      Name of the variable.
+  @param[in]  MaxNameSize       Maximum size in bytes of VariableName to hash.
+  @param[in]  VendorGuid        Vendor GUID of the variable.
+
+  @return The hash value.
+
+**/
+UINT32
+VariableIndexHash (
+  IN CHAR16                     *VariableName,
+  IN UINTN                      MaxNameSize,
+  IN EFI_GUID                   *VendorGuid
+  )
+{
+  UINT32    Hash;
+  UINTN     Index;
+
+  //
+  // FNV-1a over the name characters, folded with the first GUID dword.
+  //
+  Hash = 2166136261U;
+  for (Index = 0; Index < MaxNameSize / sizeof (CHAR16) && VariableName[Index] != 0; Index++) {
+    Hash = (Hash ^ VariableName[Index]) * 16777619U;
+  }
+  Hash ^= ReadUnaligned32 ((UINT32 *) VendorGuid);
+  Hash ^= Hash >> 16;
+
+  return Hash;
+}
+
+/**
+  Drop all entries of a variable store index. It will be rebuilt on the next lookup.
+
+  This must be called whenever the variable store is rewritten rather than appended to.
+
+  @param[in, out] StoreIndex    The variable store index to reset.
+
+**/
+VOID
+ResetVariableIndex (
+  IN OUT VARIABLE_STORE_INDEX   *StoreIndex
+  )
+{
+  ZeroMem (StoreIndex->Head, sizeof (StoreIndex->Head));
+  ZeroMem (StoreIndex->Tail, sizeof (StoreIndex->Tail));
+  StoreIndex->EntryCount    = 0;
+  StoreIndex->IndexedOffset = 0;
+}
+
+/**
+  Allocate the entries of a variable store index.
+
+  If the allocation fails the index is left without entries and lookups in
+  the variable store fall back to walking it.
+
+  @param[out] StoreIndex        The variable store index to initialize.
+  @param[in]  StoreSize         Size in bytes of the variable store.
+
+**/
+VOID
+InitializeVariableIndex (
+  OUT VARIABLE_STORE_INDEX      *StoreIndex,
+  IN  UINTN                     StoreSize
+  )
+{
+  //
+  // Every header takes at least sizeof (VARIABLE_HEADER) bytes of the store.
+  //
+  StoreIndex->MaxEntryCount = (UINT32) (StoreSize / sizeof (VARIABLE_HEADER) + 1);
+  StoreIndex->Entries       = AllocateRuntimePool (StoreIndex->MaxEntryCount * sizeof (VARIABLE_INDEX_ENTRY));
+  ResetVariableIndex (StoreIndex);
+}
+
+/**
+  Add the headers appended to the variable store since the last call to its index.
+
+  @param[in, out] StoreIndex          The variable store index.
+  @param[in]      VariableStoreHeader The variable store.
+  @param[in]      LastVariableOffset  Offset of the end of the last variable in the store.
+
+  @retval TRUE    The index covers all variables of the store.
+  @retval FALSE   The index is unusable, the store must be walked instead.
+
+**/
+BOOLEAN
+SyncVariableIndex (
+  IN OUT VARIABLE_STORE_INDEX   *StoreIndex,
+  IN     VARIABLE_STORE_HEADER  *VariableStoreHeader,
+  IN     UINTN                  LastVariableOffset
+  )
+{
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *LastVariable;
+  VARIABLE_INDEX_ENTRY  *Entry;
+  UINT32                Bucket;
+
+  if (StoreIndex->Entries == NULL) {
+    return FALSE;
+  }
+
+  if (LastVariableOffset < StoreIndex->IndexedOffset) {
+    ResetVariableIndex (StoreIndex);
+  }
+
+  if (StoreIndex->IndexedOffset == 0) {
+    Variable = GetStartPointer (VariableStoreHeader);
+  } else {
+    Variable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + StoreIndex->IndexedOffset);
+  }
+  LastVariable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + LastVariableOffset);
+
+  while (Variable < LastVariable && IsValidVariableHeader (Variable, GetEndPointer (VariableStoreHeader))) {
+    if (StoreIndex->EntryCount == StoreIndex->MaxEntryCount) {
+      ResetVariableIndex (StoreIndex);
+      return FALSE;
+    }
+
+    Bucket = VariableIndexHash (
+               GetVariableNamePtr (Variable),
+               NameSizeOfVariable (Variable),
+               GetVendorGuidPtr (Variable)
+               ) & (VARIABLE_INDEX_BUCKET_COUNT - 1);
+
+    Entry         = &StoreIndex->Entries[StoreIndex->EntryCount];
+    Entry->Offset = (UINT32) ((UINTN) Variable - (UINTN) VariableStoreHeader);
+    Entry->Next   = 0;
+    StoreIndex->EntryCount++;
+
+    if (StoreIndex->Tail[Bucket] == 0) {
+      StoreIndex->Head[Bucket] = StoreIndex->EntryCount;
+    } else {
+      StoreIndex->Entries[StoreIndex->Tail[Bucket] - 1].Next = StoreIndex->EntryCount;
+    }
+    StoreIndex->Tail[Bucket] = StoreIndex->EntryCount;
+
+    Variable = GetNextVariablePtr (Variable);
+  }
+
+  //
+  // Headers past an invalid one are not reachable by walking the store either.
+  //
+  StoreIndex->IndexedOffset = LastVariableOffset;
+  return TRUE;
+}
+
+/**
+  Get the up to date index of the variable store searched by a pointer track.
+
+  @param[in]  PtrTrack              Variable Track Pointer structure with the range to search.
+  @param[out] VariableStoreHeader   The variable store of the range.
+
+  @return The variable store index, or NULL if the range is not an indexed variable store.
+
+**/
+VARIABLE_STORE_INDEX *
+GetVariableIndex (
+  IN  VARIABLE_POINTER_TRACK    *PtrTrack,
+  OUT VARIABLE_STORE_HEADER     **VariableStoreHeader
+  )
+{
+  VARIABLE_STORE_HEADER *VolatileStore;
+
+  if (mVariableModuleGlobal == NULL) {
+    return NULL;
+  }
+
+  VolatileStore = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  if (VolatileStore != NULL &&
+      PtrTrack->StartPtr == GetStartPointer (VolatileStore) &&
+      PtrTrack->EndPtr == GetEndPointer (VolatileStore)) {
+    if (!SyncVariableIndex (&mVariableModuleGlobal->VolatileIndex, VolatileStore, mVariableModuleGlobal->VolatileLastVariableOffset)) {
+      return NULL;
+    }
+    *VariableStoreHeader = VolatileStore;
+    return &mVariableModuleGlobal->VolatileIndex;
+  }
+
+  if (mNvVariableCache != NULL &&
+      PtrTrack->StartPtr == GetStartPointer (mNvVariableCache) &&
+      PtrTrack->EndPtr == GetEndPointer (mNvVariableCache)) {
+    if (!SyncVariableIndex (&mVariableModuleGlobal->NvIndex, mNvVariableCache, mVariableModuleGlobal->NonVolatileLastVariableOffset)) {
+      return NULL;
+    }
+    *VariableStoreHeader = mNvVariableCache;
+    return &mVariableModuleGlobal->NvIndex;
+  }
+
+  return NULL;
+}
+
 /**
 
   Variable store garbage collection and reclaim operation.
@@ -1253,16 +1446,75 @@ Reclaim (
 Done:
   if (IsVolatile) {
     FreePool (ValidBuffer);
+    ResetVariableIndex (&mVariableModuleGlobal->VolatileIndex);
   } else {
     //
     // For NV variable reclaim, we use mNvVariableCache as the buffer, so copy the data back.
     //
     CopyMem (mNvVariableCache, (UINT8 *)(UINTN)VariableBase, VariableStoreHeader->Size);
+    ResetVariableIndex (&mVariableModuleGlobal->NvIndex);
   }
 
   return Status;
 }
 
+/**
+  Check the variable pointed to by PtrTrack->CurrPtr against the variable to be found.
+
+  @param[in]       VariableName        Name of the variable to be found, or an empty
+                                       string to match any variable.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in, out]  InDeletedVariable   The matching variable in delete transition state found so far.
+
+  @retval          TRUE                The variable is found, PtrTrack is updated.
+  @retval          FALSE               Continue the search.
+**/
+BOOLEAN
+FindVariableMatch (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN OUT VARIABLE_HEADER         **InDeletedVariable
+  )
+{
+  VOID                           *Point;
+
+  if (PtrTrack->CurrPtr->State != VAR_ADDED &&
+      PtrTrack->CurrPtr->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)
+     ) {
+    return FALSE;
+  }
+
+  if (!IgnoreRtCheck && AtRuntime () && ((PtrTrack->CurrPtr->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+    return FALSE;
+  }
+
+  if (VariableName[0] != 0) {
+    if (!CompareGuid (VendorGuid, GetVendorGuidPtr (PtrTrack->CurrPtr))) {
+      return FALSE;
+    }
+
+    Point = (VOID *) GetVariableNamePtr (PtrTrack->CurrPtr);
+
+    ASSERT (NameSizeOfVariable (PtrTrack->CurrPtr) != 0);
+    if (CompareMem (VariableName, Point, NameSizeOfVariable (PtrTrack->CurrPtr)) != 0) {
+      return FALSE;
+    }
+  }
+
+  if (PtrTrack->CurrPtr->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+    *InDeletedVariable = PtrTrack->CurrPtr;
+    return FALSE;
+  }
+
+  PtrTrack->InDeletedTransitionPtr = *InDeletedVariable;
+  return TRUE;
+}
+
 /**
   Find the variable in the specified variable store.
 
@@ -1284,7 +1536,9 @@ FindVariableEx (
   )
 {
   VARIABLE_HEADER                *InDeletedVariable;
-  VOID                           *Point;
+  VARIABLE_STORE_INDEX           *StoreIndex;
+  VARIABLE_STORE_HEADER          *VariableStoreHeader;
+  UINT32                         EntryNumber;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
@@ -1293,36 +1547,29 @@ FindVariableEx (
   //
   InDeletedVariable  = NULL;
 
-  for ( PtrTrack->CurrPtr = PtrTrack->StartPtr
-      ; IsValidVariableHeader (PtrTrack->CurrPtr, PtrTrack->EndPtr)
-      ; PtrTrack->CurrPtr = GetNextVariablePtr (PtrTrack->CurrPtr)
-      ) {
-    if (PtrTrack->CurrPtr->State == VAR_ADDED ||
-        PtrTrack->CurrPtr->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)
-       ) {
-      if (IgnoreRtCheck || !AtRuntime () || ((PtrTrack->CurrPtr->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) != 0)) {
-        if (VariableName[0] == 0) {
-          if (PtrTrack->CurrPtr->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
-            InDeletedVariable   = PtrTrack->CurrPtr;
-          } else {
-            PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
-            return EFI_SUCCESS;
-          }
-        } else {
-          if (CompareGuid (VendorGuid, GetVendorGuidPtr (PtrTrack->CurrPtr))) {
-            Point = (VOID *) GetVariableNamePtr (PtrTrack->CurrPtr);
-
-            ASSERT (NameSizeOfVariable (PtrTrack->CurrPtr) != 0);
-            if (CompareMem (VariableName, Point, NameSizeOfVariable (PtrTrack->CurrPtr)) == 0) {
-              if (PtrTrack->CurrPtr->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
-                InDeletedVariable     = PtrTrack->CurrPtr;
-              } else {
-                PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
-                return EFI_SUCCESS;
-              }
-            }
-          }
-        }
+  //
+  // Only visit the headers hashed to the same bucket if the store is indexed.
+  // The bucket chain keeps the store order, so the result is the same as walking the store.
+  //
+  StoreIndex = NULL;
+  if (VariableName[0] != 0) {
+    StoreIndex = GetVariableIndex (PtrTrack, &VariableStoreHeader);
+  }
+  if (StoreIndex != NULL) {
+    EntryNumber = StoreIndex->Head[VariableIndexHash (VariableName, MAX_UINTN, VendorGuid) & (VARIABLE_INDEX_BUCKET_COUNT - 1)];
+    for (; EntryNumber != 0; EntryNumber = StoreIndex->Entries[EntryNumber - 1].Next) {
+      PtrTrack->CurrPtr = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + StoreIndex->Entries[EntryNumber - 1].Offset);
+      if (FindVariableMatch (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, &InDeletedVariable)) {
+        return EFI_SUCCESS;
+      }
+    }
+  } else {
+    for ( PtrTrack->CurrPtr = PtrTrack->StartPtr
+        ; IsValidVariableHeader (PtrTrack->CurrPtr, PtrTrack->EndPtr)
+        ; PtrTrack->CurrPtr = GetNextVariablePtr (PtrTrack->CurrPtr)
+        ) {
+      if (FindVariableMatch (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, &InDeletedVariable)) {
+        return EFI_SUCCESS;
       }
     }
   }
@@ -3597,6 +3844,7 @@ ReclaimForOS(
   EFI_STATUS                     Status;
   UINTN                          RemainingCommonRuntimeVariableSpace;
   UINTN                          RemainingHwErrVariableSpace;
+  UINTN                          ReclaimThreshold;
   STATIC BOOLEAN                 Reclaimed;
 
   //
@@ -3617,11 +3865,18 @@ ReclaimForOS(
 
   RemainingHwErrVariableSpace = PcdGet32 (PcdHwErrStorageSize) - mVariableModuleGlobal->HwErrVariableTotalSize;
 
+  //
+  // Reclaim before the OS runs when the free area cannot hold the largest variable
+  // or has dropped below the platform threshold, so a runtime SetVariable does not
+  // need to reclaim.
+  //
+  ReclaimThreshold = MAX (mVariableModuleGlobal->MaxVariableSize, mVariableModuleGlobal->MaxAuthVariableSize);
+  ReclaimThreshold = MAX (ReclaimThreshold, PcdGet32 (PcdVariableReclaimThreshold));
+
   //
   // Check if the free area is below a threshold.
   //
-  if (((RemainingCommonRuntimeVariableSpace < mVariableModuleGlobal->MaxVariableSize) ||
-       (RemainingCommonRuntimeVariableSpace < mVariableModuleGlobal->MaxAuthVariableSize)) ||
+  if ((RemainingCommonRuntimeVariableSpace < ReclaimThreshold) ||
       ((PcdGet32 (PcdHwErrStorageSize) != 0) &&
        (RemainingHwErrVariableSpace < PcdGet32 (PcdMaxHardwareErrorVariableSize)))){
     Status = Reclaim (
@@ -4142,6 +4397,13 @@ VariableCommonInitialize (
   VolatileVariableStore->Reserved    = 0;
   VolatileVariableStore->Reserved1   = 0;
 
+  //
+  // Build the name/GUID hash index of the volatile and non-volatile variable stores.
+  //
+  InitializeVariableIndex (&mVariableModuleGlobal->VolatileIndex, VolatileVariableStore->Size);
+  InitializeVariableIndex (&mVariableModuleGlobal->NvIndex, mNvVariableCache->Size);
+  SyncVariableIndex (&mVariableModuleGlobal->NvIndex, mNvVariableCache, mVariableModuleGlobal->NonVolatileLastVariableOffset);
+
   return EFI_SUCCESS;
 }
 
@@ -78,6 +78,39 @@ typedef struct {
   BOOLEAN         Volatile;
 } VARIABLE_POINTER_TRACK;
 
+///
+/// Number of hash buckets in a VARIABLE_STORE_INDEX, must be a power of 2.
+///
+#define VARIABLE_INDEX_BUCKET_COUNT   256
+
+typedef struct {
+  ///
+  /// Offset of the variable header from the variable store header.
+  ///
+  UINT32  Offset;
+  ///
+  /// One based number of the next entry in the same bucket, 0 ends the chain.
+  ///
+  UINT32  Next;
+} VARIABLE_INDEX_ENTRY;
+
+///
+/// In-memory hash index of a variable store, keyed on variable name and vendor GUID.
+/// Each bucket chains the headers in variable store order. Only offsets are kept, so the
+/// index stays valid after SetVirtualAddressMap() once Entries has been converted.
+///
+typedef struct {
+  UINT32                Head[VARIABLE_INDEX_BUCKET_COUNT];
+  UINT32                Tail[VARIABLE_INDEX_BUCKET_COUNT];
+  VARIABLE_INDEX_ENTRY  *Entries;
+  UINT32                MaxEntryCount;
+  UINT32                EntryCount;
+  //
+  // All headers below this offset of the variable store have been indexed.
+  //
+  UINTN                 IndexedOffset;
+} VARIABLE_STORE_INDEX;
+
 typedef struct {
   EFI_PHYSICAL_ADDRESS  HobVariableBase;
   EFI_PHYSICAL_ADDRESS  VolatileVariableBase;
@@ -106,6 +139,8 @@ typedef struct {
   CHAR8           *PlatformLang;
   CHAR8           Lang[ISO_639_2_ENTRY_SIZE + 1];
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL *FvbInstance;
+  VARIABLE_STORE_INDEX  VolatileIndex;
+  VARIABLE_STORE_INDEX  NvIndex;
 } VARIABLE_MODULE_GLOBAL;
 
 /**
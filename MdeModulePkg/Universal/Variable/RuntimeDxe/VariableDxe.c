@@ -243,6 +243,8 @@ VariableClassAddressChangeEvent (
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase);
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VariableGlobal.VolatileVariableBase);
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VariableGlobal.HobVariableBase);
+  EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VolatileIndex.Entries);
+  EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->NvIndex.Entries);
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal);
   EfiConvertPointer (0x0, (VOID **) &mNvVariableCache);
   EfiConvertPointer (0x0, (VOID **) &mNvFvHeaderCache);
@@ -1,14 +1,17 @@
 /** @file
 
-  This driver produces Block I/O Protocol instances for virtio-blk devices.
+  This driver produces Block I/O and Block I/O 2 Protocol instances for
+  virtio-blk devices.
 
   The implementation is basic:
 
   - No attach/detach (ie. removable media).
 
-  - Although the non-blocking interfaces of EFI_BLOCK_IO2_PROTOCOL could be a
-    good match for multiple in-flight virtio-blk requests, we stick to
-    synchronous requests and EFI_BLOCK_IO_PROTOCOL for now.
+  - Transfers are split into as many virtio-blk requests as the host limits
+    require, and all requests that fit in the ring are in flight at the same
+    time. The used ring is polled: by the blocking functions until their
+    transfer completes, and by a periodic timer while non-blocking
+    EFI_BLOCK_IO2_PROTOCOL transfers are pending.
 
   Copyright (C) 2012, Red Hat, Inc.
   Copyright (c) 2012 - 2016, Intel Corporation. All rights reserved.<BR>
@@ -183,13 +186,342 @@ VerifyReadWriteRequest (
 
 /**
 
-  Format a read / write / flush request as three consecutive virtio
-  descriptors, push them to the host, and poll for the response.
+  Complete a transfer whose requests have all been submitted and completed.
+
+  A non-blocking transfer is freed after its token is updated and its event
+  is signaled. A blocking transfer is only marked done, its caller polls for
+  that.
+
+  Called at TPL_NOTIFY.
+
+  @param[in] Transfer  The transfer to complete.
+
+**/
+
+STATIC
+VOID
+VirtioBlkFinishTransfer (
+  IN VBLK_TRANSFER *Transfer
+  )
+{
+  EFI_BLOCK_IO2_TOKEN *Token;
+
+  ASSERT (!Transfer->Queued);
+  ASSERT (Transfer->InFlight == 0);
+
+  Token = Transfer->Token;
+  if (Token == NULL) {
+    Transfer->Done = TRUE;
+    return;
+  }
+
+  Token->TransactionStatus = Transfer->Status;
+  FreePool (Transfer);
+  gBS->SignalEvent (Token->Event);
+}
+
+
+/**
+
+  Fail all queued and in-flight transfers, because the host could not be
+  notified of new requests. The device is not used anymore afterwards.
+
+  Called at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+
+STATIC
+VOID
+VirtioBlkFailAll (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINT16        DescIdx;
+  VBLK_TRANSFER *Transfer;
+
+  Dev->Failed = TRUE;
+
+  while (!IsListEmpty (&Dev->TransferQueue)) {
+    Transfer = VBLK_TRANSFER_FROM_LINK (GetFirstNode (&Dev->TransferQueue));
+    RemoveEntryList (&Transfer->Link);
+    Transfer->Queued = FALSE;
+    Transfer->Status = EFI_DEVICE_ERROR;
+    if (Transfer->InFlight == 0) {
+      VirtioBlkFinishTransfer (Transfer);
+    }
+  }
+
+  for (DescIdx = 0; DescIdx < Dev->Ring.QueueSize; ++DescIdx) {
+    Transfer = Dev->Requests[DescIdx].Transfer;
+    if (Transfer == NULL) {
+      continue;
+    }
+    Dev->Requests[DescIdx].Transfer = NULL;
+    Dev->InFlight--;
+    Transfer->InFlight--;
+    Transfer->Status = EFI_DEVICE_ERROR;
+    if (Transfer->InFlight == 0) {
+      VirtioBlkFinishTransfer (Transfer);
+    }
+  }
+  ASSERT (Dev->InFlight == 0);
+}
+
+
+/**
+
+  Submit the requests of the queued transfers to the host, in order, as long
+  as the ring has free descriptors for them.
+
+  A flush request is only submitted when no other request is in flight, and
+  no request queued after it is submitted before it completes.
+
+  Called at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+
+STATIC
+VOID
+VirtioBlkSubmitTransfers (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  VBLK_TRANSFER *Transfer;
+  VBLK_REQUEST  *Request;
+  UINT32        BlockSize;
+  UINTN         RequestSize;
+  BOOLEAN       IsFlush;
+  UINT16        HeadDescIdx;
+  EFI_STATUS    Status;
+
+  BlockSize = Dev->BlockIoMedia.BlockSize;
+
+  //
+  // ensured by VirtioBlkInit()
+  //
+  ASSERT (BlockSize > 0);
+  ASSERT (BlockSize % 512 == 0);
+
+  while (!IsListEmpty (&Dev->TransferQueue)) {
+    Transfer = VBLK_TRANSFER_FROM_LINK (GetFirstNode (&Dev->TransferQueue));
+    IsFlush  = Transfer->FlushPending;
+    if (IsFlush && Dev->InFlight > 0) {
+      break;
+    }
+
+    while (!EFI_ERROR (Transfer->Status) &&
+           (Transfer->Remaining > 0 || Transfer->FlushPending)) {
+      RequestSize = IsFlush ? 0 :
+                    VirtioBlkQueueRequestSize (&Dev->Queue, BlockSize,
+                      Transfer->Remaining);
+
+      //
+      // The chain will start at the first free descriptor, whose request
+      // slot is idle. Prepare virtio-blk request header, setting zero size
+      // for flush. IO Priority is homogeneously 0. Preset a host status for
+      // ourselves that we do not accept as success.
+      //
+      Request = &Dev->Requests[Dev->Queue.FreeHead];
+      ASSERT (Request->Transfer == NULL);
+      Request->Header.Type   = Transfer->RequestIsWrite ?
+                               (IsFlush ? VIRTIO_BLK_T_FLUSH :
+                                VIRTIO_BLK_T_OUT) :
+                               VIRTIO_BLK_T_IN;
+      Request->Header.IoPrio = 0;
+      Request->Header.Sector = MultU64x32 (Transfer->Lba, BlockSize / 512);
+      Request->HostStatus    = VIRTIO_BLK_S_IOERR;
+
+      Status = VirtioBlkQueueAppendRequest (&Dev->Queue, &Request->Header,
+                 Transfer->Buffer, RequestSize, Transfer->RequestIsWrite,
+                 &Request->HostStatus, &HeadDescIdx);
+      if (EFI_ERROR (Status)) {
+        //
+        // The ring is full, continue when requests complete.
+        //
+        goto Notify;
+      }
+      ASSERT (&Dev->Requests[HeadDescIdx] == Request);
+
+      Request->Transfer       = Transfer;
+      Transfer->Lba          += RequestSize / BlockSize;
+      Transfer->Buffer       += RequestSize;
+      Transfer->Remaining    -= RequestSize;
+      Transfer->FlushPending  = FALSE;
+      Transfer->InFlight++;
+      Dev->InFlight++;
+    }
+
+    //
+    // The transfer is fully submitted (or it failed); it completes with its
+    // last request.
+    //
+    RemoveEntryList (&Transfer->Link);
+    Transfer->Queued = FALSE;
+    if (Transfer->InFlight == 0) {
+      VirtioBlkFinishTransfer (Transfer);
+    }
+
+    if (IsFlush && Dev->InFlight > 0) {
+      break;
+    }
+  }
+
+Notify:
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device. virtio-blk's only virtqueue
+  // is #0, called "requestq" (see Appendix D).
+  //
+  if (VirtioBlkQueuePublish (&Dev->Queue)) {
+    Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, 0);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: SetQueueNotify(): %r\n", __FUNCTION__,
+        Status));
+      VirtioBlkFailAll (Dev);
+    }
+  }
+}
+
+
+/**
+
+  Harvest the requests the host completed, complete the transfers all of
+  whose requests are done, and submit more requests in the freed descriptors.
+
+  Called at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+
+STATIC
+VOID
+VirtioBlkProcessCompletions (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINT16        HeadDescIdx;
+  VBLK_REQUEST  *Request;
+  VBLK_TRANSFER *Transfer;
+
+  if (Dev->Failed) {
+    return;
+  }
+
+  while (VirtioBlkQueueHarvest (&Dev->Queue, &HeadDescIdx)) {
+    Request  = &Dev->Requests[HeadDescIdx];
+    Transfer = Request->Transfer;
+    ASSERT (Transfer != NULL);
+    ASSERT (Transfer->Signature == VBLK_TRANSFER_SIG);
+
+    Request->Transfer = NULL;
+    if (Request->HostStatus != VIRTIO_BLK_S_OK) {
+      Transfer->Status = EFI_DEVICE_ERROR;
+    }
+
+    Dev->InFlight--;
+    Transfer->InFlight--;
+    if (Transfer->InFlight == 0 && !Transfer->Queued) {
+      VirtioBlkFinishTransfer (Transfer);
+    }
+  }
+
+  VirtioBlkSubmitTransfers (Dev);
+}
+
+
+/**
+
+  Notification function of the periodic timer that polls the used ring while
+  non-blocking transfers are pending.
+
+  @param[in] Event    The poll timer event.
+
+  @param[in] Context  Pointer to the VBLK_DEV structure.
+
+**/
+
+STATIC
+VOID
+EFIAPI
+VirtioBlkPollTimer (
+  IN EFI_EVENT Event,
+  IN VOID      *Context
+  )
+{
+  VBLK_DEV *Dev;
+
+  Dev = Context;
+  VirtioBlkProcessCompletions (Dev);
+
+  if (Dev->InFlight == 0 && IsListEmpty (&Dev->TransferQueue)) {
+    gBS->SetTimer (Dev->PollTimer, TimerCancel, 0);
+    Dev->PollTimerArmed = FALSE;
+  }
+}
+
+
+/**
+
+  Wait until a condition on the device state holds, processing completions
+  meanwhile. The TPL is restored to the caller's between polls, so that the
+  poll timer and other events may run.
+
+  Called at TPL_NOTIFY, returns at TPL_NOTIFY.
+
+  @param[in out] Dev       The virtio-blk device.
+
+  @param[in] OldTpl        The TPL of the caller.
+
+  @param[in] Transfer      The blocking transfer to wait for, or NULL to wait
+                           until no request is in flight.
+
+**/
+
+STATIC
+VOID
+VirtioBlkWait (
+  IN OUT VBLK_DEV      *Dev,
+  IN     EFI_TPL       OldTpl,
+  IN     VBLK_TRANSFER *Transfer
+  )
+{
+  UINTN PollPeriodUsecs;
+
+  //
+  // Keep slowing down until we reach a poll period of slightly above 1 ms,
+  // like VirtioFlush() does.
+  //
+  PollPeriodUsecs = 1;
+  for (;;) {
+    VirtioBlkProcessCompletions (Dev);
+    if (Transfer != NULL ? Transfer->Done : Dev->InFlight == 0) {
+      return;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+    gBS->Stall (PollPeriodUsecs);
+    if (PollPeriodUsecs < 1024) {
+      PollPeriodUsecs *= 2;
+    }
+    gBS->RaiseTPL (TPL_NOTIFY);
+  }
+}
+
+
+/**
+
+  Queue a read / write / flush transfer, split it into as many virtio-blk
+  requests as needed, and push them to the host.
 
   This is the main workhorse function. Two use cases are supported, read/write
   and flush. The function may only be called after the request parameters have
   been verified by
-  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
+  - specific checks in the EFI_BLOCK_IO_PROTOCOL and EFI_BLOCK_IO2_PROTOCOL
+    functions, and
   - VerifyReadWriteRequest() (for read/write only).
 
   Parameters handled commonly:
@@ -197,6 +529,13 @@ VerifyReadWriteRequest (
     @param[in] Dev             The virtio-blk device the request is targeted
                                at.
 
+    @param[in out] Token       If NULL, or if Token->Event is NULL, the
+                               function polls for the completion of the
+                               transfer. Otherwise it returns as soon as the
+                               transfer is queued; Token->TransactionStatus is
+                               set and Token->Event is signaled when the
+                               transfer completes.
+
   Flush request:
 
     @param[in] Lba             Must be zero.
@@ -223,114 +562,134 @@ VerifyReadWriteRequest (
                                device.
 
   Return values are common to both use cases, and are appropriate to be
-  forwarded by the EFI_BLOCK_IO_PROTOCOL functions (ReadBlocks(),
-  WriteBlocks(), FlushBlocks()).
+  forwarded by the EFI_BLOCK_IO_PROTOCOL and EFI_BLOCK_IO2_PROTOCOL functions.
 
 
-  @retval EFI_SUCCESS          Transfer complete.
+  @retval EFI_SUCCESS           Transfer complete, or queued for a
+                                non-blocking call.
 
-  @retval EFI_DEVICE_ERROR     Failed to notify host side via VirtIo write, or
-                               unable to parse host response, or host response
-                               is not VIRTIO_BLK_S_OK.
+  @retval EFI_DEVICE_ERROR      Failed to notify host side via VirtIo write, or
+                                host response is not VIRTIO_BLK_S_OK.
+
+  @retval EFI_OUT_OF_RESOURCES  The non-blocking transfer could not be queued
+                                due to a lack of resources.
 
 **/
 
 STATIC
 EFI_STATUS
-EFIAPI
-SynchronousRequest (
-  IN              VBLK_DEV *Dev,
-  IN              EFI_LBA  Lba,
-  IN              UINTN    BufferSize,
-  IN OUT volatile VOID     *Buffer,
-  IN              BOOLEAN  RequestIsWrite
+VirtioBlkTransfer (
+  IN     VBLK_DEV            *Dev,
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token,
+  IN     EFI_LBA             Lba,
+  IN     UINTN               BufferSize,
+  IN OUT VOID                *Buffer,
+  IN     BOOLEAN             RequestIsWrite
   )
 {
-  UINT32                  BlockSize;
-  volatile VIRTIO_BLK_REQ Request;
-  volatile UINT8          HostStatus;
-  DESC_INDICES            Indices;
-
-  BlockSize = Dev->BlockIoMedia.BlockSize;
-
-  //
-  // ensured by VirtioBlkInit()
-  //
-  ASSERT (BlockSize > 0);
-  ASSERT (BlockSize % 512 == 0);
+  VBLK_TRANSFER BlockingTransfer;
+  VBLK_TRANSFER *Transfer;
+  EFI_TPL       OldTpl;
 
   //
   // ensured by contract above, plus VerifyReadWriteRequest()
   //
-  ASSERT (BufferSize % BlockSize == 0);
+  ASSERT (BufferSize % Dev->BlockIoMedia.BlockSize == 0);
+  ASSERT (BufferSize <= SIZE_1GB);
+
+  if (Token == NULL || Token->Event == NULL) {
+    Token    = NULL;
+    Transfer = &BlockingTransfer;
+  } else {
+    Transfer = AllocatePool (sizeof *Transfer);
+    if (Transfer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
 
-  //
-  // Prepare virtio-blk request header, setting zero size for flush.
-  // IO Priority is homogeneously 0.
-  //
-  Request.Type   = RequestIsWrite ?
-                   (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
-                   VIRTIO_BLK_T_IN;
-  Request.IoPrio = 0;
-  Request.Sector = MultU64x32(Lba, BlockSize / 512);
+  Transfer->Signature      = VBLK_TRANSFER_SIG;
+  Transfer->Token          = Token;
+  Transfer->Lba            = Lba;
+  Transfer->Buffer         = Buffer;
+  Transfer->Remaining      = BufferSize;
+  Transfer->RequestIsWrite = RequestIsWrite;
+  Transfer->FlushPending   = (BOOLEAN) (BufferSize == 0);
+  Transfer->Queued         = TRUE;
+  Transfer->Done           = FALSE;
+  Transfer->InFlight       = 0;
+  Transfer->Status         = EFI_SUCCESS;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Dev->Failed) {
+    gBS->RestoreTPL (OldTpl);
+    if (Token != NULL) {
+      FreePool (Transfer);
+    }
+    return EFI_DEVICE_ERROR;
+  }
 
-  VirtioPrepare (&Dev->Ring, &Indices);
+  InsertTailList (&Dev->TransferQueue, &Transfer->Link);
+  VirtioBlkSubmitTransfers (Dev);
 
-  //
-  // preset a host status for ourselves that we do not accept as success
-  //
-  HostStatus = VIRTIO_BLK_S_IOERR;
+  if (Token != NULL) {
+    //
+    // The transfer may have completed already, only poll for its completion
+    // if it's still pending.
+    //
+    if (!Dev->PollTimerArmed &&
+        (Dev->InFlight > 0 || !IsListEmpty (&Dev->TransferQueue))) {
+      gBS->SetTimer (Dev->PollTimer, TimerPeriodic,
+             EFI_TIMER_PERIOD_MILLISECONDS (1));
+      Dev->PollTimerArmed = TRUE;
+    }
+    gBS->RestoreTPL (OldTpl);
+    return EFI_SUCCESS;
+  }
 
-  //
-  // ensured by VirtioBlkInit() -- this predicate, in combination with the
-  // lock-step progress, ensures we don't have to track free descriptors.
-  //
-  ASSERT (Dev->Ring.QueueSize >= 3);
+  VirtioBlkWait (Dev, OldTpl, Transfer);
+  gBS->RestoreTPL (OldTpl);
+  return Transfer->Status;
+}
 
-  //
-  // virtio-blk header in first desc
-  //
-  VirtioAppendDesc (&Dev->Ring, (UINTN) &Request, sizeof Request,
-    VRING_DESC_F_NEXT, &Indices);
 
-  //
-  // data buffer for read/write in second desc
-  //
-  if (BufferSize > 0) {
-    //
-    // From virtio-0.9.5, 2.3.2 Descriptor Table:
-    // "no descriptor chain may be more than 2^32 bytes long in total".
-    //
-    // The predicate is ensured by the call contract above (for flush), or
-    // VerifyReadWriteRequest() (for read/write). It also implies that
-    // converting BufferSize to UINT32 will not truncate it.
-    //
-    ASSERT (BufferSize <= SIZE_1GB);
+/**
 
-    //
-    // VRING_DESC_F_WRITE is interpreted from the host's point of view.
-    //
-    VirtioAppendDesc (&Dev->Ring, (UINTN) Buffer, (UINT32) BufferSize,
-      VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
-      &Indices);
+  Abort the transfers that have not been submitted to the host yet, and wait
+  for the in-flight requests to complete.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+
+STATIC
+VOID
+VirtioBlkAbortTransfers (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  VBLK_TRANSFER *Transfer;
+  EFI_TPL       OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  while (!IsListEmpty (&Dev->TransferQueue)) {
+    Transfer = VBLK_TRANSFER_FROM_LINK (GetFirstNode (&Dev->TransferQueue));
+    RemoveEntryList (&Transfer->Link);
+    Transfer->Queued = FALSE;
+    Transfer->Status = EFI_ABORTED;
+    if (Transfer->InFlight == 0) {
+      VirtioBlkFinishTransfer (Transfer);
+    }
   }
 
-  //
-  // host status in last (second or third) desc
-  //
-  VirtioAppendDesc (&Dev->Ring, (UINTN) &HostStatus, sizeof HostStatus,
-    VRING_DESC_F_WRITE, &Indices);
+  VirtioBlkWait (Dev, OldTpl, NULL);
 
-  //
-  // virtio-blk's only virtqueue is #0, called "requestq" (see Appendix D).
-  //
-  if (VirtioFlush (Dev->VirtIo, 0, &Dev->Ring, &Indices,
-        NULL) == EFI_SUCCESS &&
-      HostStatus == VIRTIO_BLK_S_OK) {
-    return EFI_SUCCESS;
+  if (Dev->PollTimerArmed) {
+    gBS->SetTimer (Dev->PollTimer, TimerCancel, 0);
+    Dev->PollTimerArmed = FALSE;
   }
 
-  return EFI_DEVICE_ERROR;
+  gBS->RestoreTPL (OldTpl);
 }
 
 
@@ -345,7 +704,7 @@ SynchronousRequest (
     ReadBlocksEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and VirtioBlkTransfer().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -380,8 +739,9 @@ VirtioBlkReadBlocks (
     return Status;
   }
 
-  return SynchronousRequest (
+  return VirtioBlkTransfer (
            Dev,
+           NULL,       // Token
            Lba,
            BufferSize,
            Buffer,
@@ -400,7 +760,7 @@ VirtioBlkReadBlocks (
     WriteBlockEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and VirtioBlkTransfer().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -435,8 +795,9 @@ VirtioBlkWriteBlocks (
     return Status;
   }
 
-  return SynchronousRequest (
+  return VirtioBlkTransfer (
            Dev,
+           NULL,       // Token
            Lba,
            BufferSize,
            Buffer,
@@ -472,8 +833,9 @@ VirtioBlkFlushBlocks (
 
   Dev = VIRTIO_BLK_FROM_BLOCK_IO (This);
   return Dev->BlockIoMedia.WriteCaching ?
-           SynchronousRequest (
+           VirtioBlkTransfer (
              Dev,
+             NULL, // Token
              0,    // Lba
              0,    // BufferSize
              NULL, // Buffer
@@ -483,6 +845,196 @@ VirtioBlkFlushBlocks (
 }
 
 
+/**
+
+  Reset() operation of EFI_BLOCK_IO2_PROTOCOL for virtio-blk.
+
+  Transfers that have not been submitted to the host yet are aborted, and the
+  function waits for the in-flight requests to complete.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  VirtioBlkAbortTransfers (VIRTIO_BLK_FROM_BLOCK_IO2 (This));
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Complete a non-blocking request of EFI_BLOCK_IO2_PROTOCOL that has nothing
+  to transfer.
+
+  @param[in out] Token  The token of the request, or NULL.
+
+  @retval EFI_SUCCESS  The request is complete.
+
+**/
+
+STATIC
+EFI_STATUS
+VirtioBlkCompleteToken (
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token
+  )
+{
+  if (Token != NULL && Token->Event != NULL) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.4, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+
+  If Token is NULL or Token->Event is NULL, the read is blocking. Otherwise
+  the transfer is queued, and Token->Event is signaled when it completes.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  VBLK_DEV   *Dev;
+  EFI_STATUS Status;
+
+  if (BufferSize == 0) {
+    return VirtioBlkCompleteToken (Token);
+  }
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             FALSE               // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return VirtioBlkTransfer (
+           Dev,
+           Token,
+           Lba,
+           BufferSize,
+           Buffer,
+           FALSE       // RequestIsWrite
+           );
+}
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.4, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+
+  If Token is NULL or Token->Event is NULL, the write is blocking. Otherwise
+  the transfer is queued, and Token->Event is signaled when it completes.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  VBLK_DEV   *Dev;
+  EFI_STATUS Status;
+
+  if (BufferSize == 0) {
+    return VirtioBlkCompleteToken (Token);
+  }
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             TRUE                // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return VirtioBlkTransfer (
+           Dev,
+           Token,
+           Lba,
+           BufferSize,
+           Buffer,
+           TRUE        // RequestIsWrite
+           );
+}
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.4, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+
+  The flush request is submitted to the host after all the transfers queued
+  before it completed, and the transfers queued after it wait for it. As with
+  FlushBlocks(), we do nothing, successfully, if the device doesn't support
+  flushing.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  VBLK_DEV *Dev;
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  return Dev->BlockIoMedia.WriteCaching ?
+           VirtioBlkTransfer (
+             Dev,
+             Token,
+             0,    // Lba
+             0,    // BufferSize
+             NULL, // Buffer
+             TRUE  // RequestIsWrite
+             ) :
+           VirtioBlkCompleteToken (Token);
+}
+
+
 /**
 
   Device probe function for this driver.
@@ -599,11 +1151,15 @@ VirtioBlkInit (
   UINT8      PhysicalBlockExp;
   UINT8      AlignmentOffset;
   UINT32     OptIoSize;
+  UINT32     SegMax;
+  UINT32     SizeMax;
   UINT16     QueueSize;
 
   PhysicalBlockExp = 0;
   AlignmentOffset = 0;
   OptIoSize = 0;
+  SegMax = 0;
+  SizeMax = 0;
 
   //
   // Execute virtio-0.9.5, 2.2.1 Device Initialization Sequence.
@@ -692,8 +1248,27 @@ VirtioBlkInit (
     }
   }
 
+  //
+  // Requests are split so that they respect the limits of the host on the
+  // number and size of the data descriptors, if any.
+  //
+  if (Features & VIRTIO_BLK_F_SEG_MAX) {
+    Status = VIRTIO_CFG_READ (Dev, SegMax, &SegMax);
+    if (EFI_ERROR (Status)) {
+      goto Failed;
+    }
+  }
+
+  if (Features & VIRTIO_BLK_F_SIZE_MAX) {
+    Status = VIRTIO_CFG_READ (Dev, SizeMax, &SizeMax);
+    if (EFI_ERROR (Status)) {
+      goto Failed;
+    }
+  }
+
   Features &= VIRTIO_BLK_F_BLK_SIZE | VIRTIO_BLK_F_TOPOLOGY | VIRTIO_BLK_F_RO |
-              VIRTIO_BLK_F_FLUSH | VIRTIO_F_VERSION_1;
+              VIRTIO_BLK_F_FLUSH | VIRTIO_BLK_F_SEG_MAX |
+              VIRTIO_BLK_F_SIZE_MAX | VIRTIO_F_VERSION_1;
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -717,7 +1292,7 @@ VirtioBlkInit (
   if (EFI_ERROR (Status)) {
     goto Failed;
   }
-  if (QueueSize < 3) { // SynchronousRequest() uses at most three descriptors
+  if (QueueSize < 3) { // a request takes at least three descriptors
     Status = EFI_UNSUPPORTED;
     goto Failed;
   }
@@ -727,18 +1302,37 @@ VirtioBlkInit (
     goto Failed;
   }
 
+  //
+  // Track the descriptors of the in-flight requests. A request must be able
+  // to carry at least one logical block.
+  //
+  VirtioBlkQueueInit (&Dev->Queue, &Dev->Ring, SegMax, SizeMax);
+  if (MultU64x32 (Dev->Queue.SizeMax, Dev->Queue.SegMax) < BlockSize) {
+    Status = EFI_UNSUPPORTED;
+    goto ReleaseQueue;
+  }
+
+  Dev->Requests = AllocateZeroPool (QueueSize * sizeof *Dev->Requests);
+  if (Dev->Requests == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ReleaseQueue;
+  }
+  InitializeListHead (&Dev->TransferQueue);
+  Dev->InFlight = 0;
+  Dev->Failed   = FALSE;
+
   //
   // Additional steps for MMIO: align the queue appropriately, and set the
   // size. If anything fails from here on, we must release the ring resources.
   //
   Status = Dev->VirtIo->SetQueueNum (Dev->VirtIo, QueueSize);
   if (EFI_ERROR (Status)) {
-    goto ReleaseQueue;
+    goto FreeRequests;
   }
 
   Status = Dev->VirtIo->SetQueueAlign (Dev->VirtIo, EFI_PAGE_SIZE);
   if (EFI_ERROR (Status)) {
-    goto ReleaseQueue;
+    goto FreeRequests;
   }
 
   //
@@ -746,7 +1340,7 @@ VirtioBlkInit (
   //
   Status = Dev->VirtIo->SetQueueAddress (Dev->VirtIo, &Dev->Ring);
   if (EFI_ERROR (Status)) {
-    goto ReleaseQueue;
+    goto FreeRequests;
   }
 
 
@@ -757,7 +1351,7 @@ VirtioBlkInit (
     Features &= ~(UINT64)VIRTIO_F_VERSION_1;
     Status = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
-      goto ReleaseQueue;
+      goto FreeRequests;
     }
   }
 
@@ -767,7 +1361,7 @@ VirtioBlkInit (
   NextDevStat |= VSTAT_DRIVER_OK;
   Status = Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, NextDevStat);
   if (EFI_ERROR (Status)) {
-    goto ReleaseQueue;
+    goto FreeRequests;
   }
 
   //
@@ -791,9 +1385,17 @@ VirtioBlkInit (
   Dev->BlockIoMedia.LastBlock        = DivU64x32 (NumSectors,
                                          BlockSize / 512) - 1;
 
+  Dev->BlockIo2.Media                = &Dev->BlockIoMedia;
+  Dev->BlockIo2.Reset                = &VirtioBlkResetEx;
+  Dev->BlockIo2.ReadBlocksEx         = &VirtioBlkReadBlocksEx;
+  Dev->BlockIo2.WriteBlocksEx        = &VirtioBlkWriteBlocksEx;
+  Dev->BlockIo2.FlushBlocksEx        = &VirtioBlkFlushBlocksEx;
+
   DEBUG ((DEBUG_INFO, "%a: LbaSize=0x%x[B] NumBlocks=0x%Lx[Lba]\n",
     __FUNCTION__, Dev->BlockIoMedia.BlockSize,
     Dev->BlockIoMedia.LastBlock + 1));
+  DEBUG ((DEBUG_INFO, "%a: QueueSize=%d SegMax=%d SizeMax=0x%x[B]\n",
+    __FUNCTION__, QueueSize, Dev->Queue.SegMax, Dev->Queue.SizeMax));
 
   if (Features & VIRTIO_BLK_F_TOPOLOGY) {
     Dev->BlockIo.Revision = EFI_BLOCK_IO_PROTOCOL_REVISION3;
@@ -810,6 +1412,9 @@ VirtioBlkInit (
   }
   return EFI_SUCCESS;
 
+FreeRequests:
+  FreePool (Dev->Requests);
+
 ReleaseQueue:
   VirtioRingUninit (&Dev->Ring);
 
@@ -849,8 +1454,10 @@ VirtioBlkUninit (
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
 
   VirtioRingUninit (&Dev->Ring);
+  FreePool (Dev->Requests);
 
   SetMem (&Dev->BlockIo,      sizeof Dev->BlockIo,      0x00);
+  SetMem (&Dev->BlockIo2,     sizeof Dev->BlockIo2,     0x00);
   SetMem (&Dev->BlockIoMedia, sizeof Dev->BlockIoMedia, 0x00);
 }
 
@@ -905,13 +1512,15 @@ VirtioBlkExitBoot (
 
   @retval EFI_SUCCESS           Driver instance has been created and
                                 initialized  for the virtio-blk device, it
-                                is now accessible via EFI_BLOCK_IO_PROTOCOL.
+                                is now accessible via EFI_BLOCK_IO_PROTOCOL
+                                and EFI_BLOCK_IO2_PROTOCOL.
 
   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
   @return                       Error codes from the OpenProtocol() boot
                                 service, the VirtIo protocol, VirtioBlkInit(),
-                                or the InstallProtocolInterface() boot service.
+                                or the InstallMultipleProtocolInterfaces() boot
+                                service.
 
 **/
 
@@ -952,19 +1561,30 @@ VirtioBlkDriverBindingStart (
     goto UninitDev;
   }
 
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY,
+                  &VirtioBlkPollTimer, Dev, &Dev->PollTimer);
+  if (EFI_ERROR (Status)) {
+    goto CloseExitBoot;
+  }
+
   //
-  // Setup complete, attempt to export the driver instance's BlockIo interface.
+  // Setup complete, attempt to export the driver instance's BlockIo and
+  // BlockIo2 interfaces.
   //
   Dev->Signature = VBLK_SIG;
-  Status = gBS->InstallProtocolInterface (&DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, EFI_NATIVE_INTERFACE,
-                  &Dev->BlockIo);
+  Status = gBS->InstallMultipleProtocolInterfaces (&DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
-    goto CloseExitBoot;
+    goto ClosePollTimer;
   }
 
   return EFI_SUCCESS;
 
+ClosePollTimer:
+  gBS->CloseEvent (Dev->PollTimer);
+
 CloseExitBoot:
   gBS->CloseEvent (Dev->ExitBoot);
 
@@ -984,7 +1604,8 @@ FreeVirtioBlk:
 
 /**
 
-  Stop driving a virtio-blk device and remove its BlockIo interface.
+  Stop driving a virtio-blk device and remove its BlockIo and BlockIo2
+  interfaces.
 
   This function replays the success path of DriverBindingStart() in reverse.
   The host side virtio-blk device is reset, so that the OS boot loader or the
@@ -1035,12 +1656,20 @@ VirtioBlkDriverBindingStop (
   //
   // Handle Stop() requests for in-use driver instances gracefully.
   //
-  Status = gBS->UninstallProtocolInterface (DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo);
+  Status = gBS->UninstallMultipleProtocolInterfaces (DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  //
+  // Complete the pending non-blocking transfers before the ring goes away.
+  //
+  VirtioBlkAbortTransfers (Dev);
+  gBS->CloseEvent (Dev->PollTimer);
+
   gBS->CloseEvent (Dev->ExitBoot);
 
   VirtioBlkUninit (Dev);
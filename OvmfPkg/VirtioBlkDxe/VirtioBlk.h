@@ -1,7 +1,7 @@
 /** @file
 
   Internal definitions for the virtio-blk driver, which produces Block I/O
-  Protocol instances for virtio-blk devices.
+  and Block I/O 2 Protocol instances for virtio-blk devices.
 
   Copyright (C) 2012, Red Hat, Inc.
 
@@ -19,10 +19,70 @@
 #define _VIRTIO_BLK_DXE_H_
 
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
+#include <Protocol/VirtioDevice.h>
 
-#include <IndustryStandard/Virtio.h>
+#include <IndustryStandard/VirtioBlk.h>
+
+
+//
+// Submission queue model of the virtio-blk requestq.
+//
+// Any number of requests may be in flight, each taking a chain of
+// descriptors from a free list of the descriptor table. The free list is
+// linked through the VRING_DESC.Next fields, which the host doesn't look at
+// for descriptors it doesn't own. New chains are published to the available
+// ring in batches, and chains are returned to the free list as the host puts
+// them on the used ring, in any order.
+//
+typedef struct {
+  VRING  *Ring;
+  UINT16 FreeHead;      // first descriptor of the free list
+  UINT16 FreeCount;     // length of the free list
+  UINT16 NextAvailIdx;  // shadow of *Ring->Avail.Idx, not yet published
+  UINT16 LastUsedIdx;   // next used ring element to harvest
+  UINT32 SegMax;        // max data descriptors per request (VIRTIO_BLK_F_SEG_MAX)
+  UINT32 SizeMax;       // max bytes per data descriptor (VIRTIO_BLK_F_SIZE_MAX)
+} VBLK_QUEUE;
+
+//
+// A transfer requested through EFI_BLOCK_IO_PROTOCOL or
+// EFI_BLOCK_IO2_PROTOCOL. It is split into as many virtio-blk requests as the
+// SEG_MAX and SIZE_MAX limits of the device and the ring size require.
+//
+#define VBLK_TRANSFER_SIG SIGNATURE_32 ('V', 'B', 'L', 'T')
+
+typedef struct {
+  UINT32              Signature;
+  LIST_ENTRY          Link;           // VBLK_DEV.TransferQueue, until fully
+                                      // submitted
+  EFI_BLOCK_IO2_TOKEN *Token;         // NULL for a blocking transfer
+  EFI_LBA             Lba;            // first block not submitted yet
+  UINT8               *Buffer;        // first byte not submitted yet
+  UINTN               Remaining;      // bytes not submitted yet
+  BOOLEAN             RequestIsWrite;
+  BOOLEAN             FlushPending;   // flush request not submitted yet
+  BOOLEAN             Queued;         // on VBLK_DEV.TransferQueue
+  BOOLEAN             Done;           // blocking transfer completed
+  UINTN               InFlight;       // requests submitted, not completed
+  EFI_STATUS          Status;
+} VBLK_TRANSFER;
+
+#define VBLK_TRANSFER_FROM_LINK(LinkPointer) \
+        CR (LinkPointer, VBLK_TRANSFER, Link, VBLK_TRANSFER_SIG)
+
+//
+// The device accessible part of an in-flight virtio-blk request. There is
+// one per descriptor of the ring, used by the request whose chain starts at
+// that descriptor.
+//
+typedef struct {
+  volatile VIRTIO_BLK_REQ Header;
+  volatile UINT8          HostStatus;
+  VBLK_TRANSFER           *Transfer;
+} VBLK_REQUEST;
 
 
 #define VBLK_SIG SIGNATURE_32 ('V', 'B', 'L', 'K')
@@ -39,13 +99,158 @@ typedef struct {
   VIRTIO_DEVICE_PROTOCOL *VirtIo;              // DriverBindingStart  0
   EFI_EVENT              ExitBoot;             // DriverBindingStart  0
   VRING                  Ring;                 // VirtioRingInit      2
+  VBLK_QUEUE             Queue;                // VirtioBlkInit       1
+  VBLK_REQUEST           *Requests;            // VirtioBlkInit       1
+  LIST_ENTRY             TransferQueue;        // VirtioBlkInit       1
+  UINTN                  InFlight;             // VirtioBlkInit       1
+  BOOLEAN                Failed;               // VirtioBlkInit       1
+  EFI_EVENT              PollTimer;            // DriverBindingStart  0
+  BOOLEAN                PollTimerArmed;       // DriverBindingStart  0
   EFI_BLOCK_IO_PROTOCOL  BlockIo;              // VirtioBlkInit       1
+  EFI_BLOCK_IO2_PROTOCOL BlockIo2;             // VirtioBlkInit       1
   EFI_BLOCK_IO_MEDIA     BlockIoMedia;         // VirtioBlkInit       1
 } VBLK_DEV;
 
 #define VIRTIO_BLK_FROM_BLOCK_IO(BlockIoPointer) \
         CR (BlockIoPointer, VBLK_DEV, BlockIo, VBLK_SIG)
 
+#define VIRTIO_BLK_FROM_BLOCK_IO2(BlockIo2Pointer) \
+        CR (BlockIo2Pointer, VBLK_DEV, BlockIo2, VBLK_SIG)
+
+
+/**
+
+  Initialize the submission queue model of a virtio ring. All descriptors are
+  put on the free list, and the host is asked not to interrupt.
+
+  @param[out] Queue    The queue to initialize.
+
+  @param[in] Ring      The virtio ring, as initialized by VirtioRingInit().
+
+  @param[in] SegMax    Maximum number of data descriptors per request, 0 if
+                       the device doesn't limit it.
+
+  @param[in] SizeMax   Maximum number of bytes per data descriptor, 0 if the
+                       device doesn't limit it.
+
+**/
+
+VOID
+VirtioBlkQueueInit (
+  OUT VBLK_QUEUE *Queue,
+  IN  VRING      *Ring,
+  IN  UINT32     SegMax,
+  IN  UINT32     SizeMax
+  );
+
+
+/**
+
+  Compute the number of bytes the next request of a transfer can carry.
+
+  @param[in] Queue      The submission queue.
+
+  @param[in] BlockSize  The logical block size of the device.
+
+  @param[in] Remaining  Positive number of bytes left in the transfer, an
+                        integral multiple of BlockSize.
+
+  @return  A positive integral multiple of BlockSize, not larger than
+           Remaining, that fits in the SEG_MAX and SIZE_MAX limits of the
+           device, in the ring, and in a descriptor chain.
+
+**/
+
+UINTN
+VirtioBlkQueueRequestSize (
+  IN CONST VBLK_QUEUE *Queue,
+  IN       UINT32     BlockSize,
+  IN       UINTN      Remaining
+  );
+
+
+/**
+
+  Build the descriptor chain of a virtio-blk request: the request header,
+  the data buffer split into SIZE_MAX sized descriptors, and the host status.
+  The chain is put on the available ring, but not published to the host.
+
+  @param[in,out] Queue       The submission queue.
+
+  @param[in] Header          The request header, read by the host.
+
+  @param[in] Buffer          The data buffer, read or written by the host.
+
+  @param[in] BufferSize      The size of the data buffer, as returned by
+                             VirtioBlkQueueRequestSize(), or 0 for a flush.
+
+  @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
+                             device.
+
+  @param[in] HostStatus      The host status byte, written by the host.
+
+  @param[out] HeadDescIdx    The index of the first descriptor of the chain.
+
+  @retval EFI_SUCCESS           The chain is on the available ring.
+
+  @retval EFI_OUT_OF_RESOURCES  Not enough free descriptors, retry after
+                                in-flight requests complete.
+
+**/
+
+EFI_STATUS
+VirtioBlkQueueAppendRequest (
+  IN OUT VBLK_QUEUE              *Queue,
+  IN     volatile VIRTIO_BLK_REQ *Header,
+  IN     VOID                    *Buffer,
+  IN     UINTN                   BufferSize,
+  IN     BOOLEAN                 RequestIsWrite,
+  IN     volatile UINT8          *HostStatus,
+  OUT    UINT16                  *HeadDescIdx
+  );
+
+
+/**
+
+  Publish the chains appended since the last call to the host, by updating
+  the index of the available ring.
+
+  @param[in,out] Queue  The submission queue.
+
+  @retval TRUE   New chains were published, the host must be notified.
+
+  @retval FALSE  There was nothing to publish.
+
+**/
+
+BOOLEAN
+VirtioBlkQueuePublish (
+  IN OUT VBLK_QUEUE *Queue
+  );
+
+
+/**
+
+  Harvest the next request the host completed, and return its descriptor
+  chain to the free list.
+
+  @param[in,out] Queue     The submission queue.
+
+  @param[out] HeadDescIdx  The index of the first descriptor of the chain of
+                           the completed request.
+
+  @retval TRUE   A completed request was harvested.
+
+  @retval FALSE  The host has not completed any other request.
+
+**/
+
+BOOLEAN
+VirtioBlkQueueHarvest (
+  IN OUT VBLK_QUEUE *Queue,
+  OUT    UINT16     *HeadDescIdx
+  );
+
 
 /**
 
@@ -187,7 +392,7 @@ VirtioBlkReset (
     ReadBlocksEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and VirtioBlkTransfer().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -216,7 +421,7 @@ VirtioBlkReadBlocks (
     WriteBlockEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and VirtioBlkTransfer().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -258,6 +463,94 @@ VirtioBlkFlushBlocks (
   );
 
 
+/**
+
+  Reset() operation of EFI_BLOCK_IO2_PROTOCOL for virtio-blk.
+
+  Transfers that have not been submitted to the host yet are aborted, and the
+  function waits for the in-flight requests to complete.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  );
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.4, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+
+  If Token is NULL or Token->Event is NULL, the read is blocking. Otherwise
+  the transfer is queued, and Token->Event is signaled when it completes.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  );
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.4, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+
+  If Token is NULL or Token->Event is NULL, the write is blocking. Otherwise
+  the transfer is queued, and Token->Event is signaled when it completes.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  );
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.4, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+
+  The flush request is submitted to the host after all the transfers queued
+  before it completed, and the transfers queued after it wait for it.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  );
+
+
 //
 // The purpose of the following scaffolding (EFI_COMPONENT_NAME_PROTOCOL and
 // EFI_COMPONENT_NAME2_PROTOCOL implementation) is to format the driver's name
@@ -0,0 +1,367 @@
+/** @file
+
+  Submission queue model of the virtio-blk requestq.
+
+  The functions in this file keep track of the descriptors and of the
+  available and used ring indices of the requestq, so that many requests can
+  be in flight at the same time. They only access the ring memory, never the
+  virtio device, and they don't depend on boot services.
+
+  Copyright (C) 2012, Red Hat, Inc.
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+
+  This program and the accompanying materials are licensed and made available
+  under the terms and conditions of the BSD License which accompanies this
+  distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS, WITHOUT
+  WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+
+#include "VirtioBlk.h"
+
+//
+// From virtio-0.9.5, 2.3.2 Descriptor Table: "no descriptor chain may be more
+// than 2^32 bytes long in total". Like the synchronous driver did, we stay
+// well below that.
+//
+#define VBLK_MAX_REQUEST_SIZE SIZE_1GB
+
+//
+// The request header and the host status take one descriptor each.
+//
+#define VBLK_HEADER_STATUS_DESCS 2
+
+
+/**
+
+  Initialize the submission queue model of a virtio ring. All descriptors are
+  put on the free list, and the host is asked not to interrupt.
+
+  @param[out] Queue    The queue to initialize.
+
+  @param[in] Ring      The virtio ring, as initialized by VirtioRingInit().
+
+  @param[in] SegMax    Maximum number of data descriptors per request, 0 if
+                       the device doesn't limit it.
+
+  @param[in] SizeMax   Maximum number of bytes per data descriptor, 0 if the
+                       device doesn't limit it.
+
+**/
+
+VOID
+VirtioBlkQueueInit (
+  OUT VBLK_QUEUE *Queue,
+  IN  VRING      *Ring,
+  IN  UINT32     SegMax,
+  IN  UINT32     SizeMax
+  )
+{
+  UINT16 DescIdx;
+
+  ASSERT (Ring->QueueSize > VBLK_HEADER_STATUS_DESCS);
+
+  Queue->Ring         = Ring;
+  Queue->FreeHead     = 0;
+  Queue->FreeCount    = Ring->QueueSize;
+  Queue->NextAvailIdx = *Ring->Avail.Idx;
+  Queue->LastUsedIdx  = *Ring->Used.Idx;
+
+  //
+  // A request never needs more data descriptors than fit in the ring, nor
+  // larger ones than a descriptor chain may be long.
+  //
+  if (SegMax == 0 || SegMax > (UINT32) Ring->QueueSize - VBLK_HEADER_STATUS_DESCS) {
+    SegMax = Ring->QueueSize - VBLK_HEADER_STATUS_DESCS;
+  }
+  if (SizeMax == 0 || SizeMax > VBLK_MAX_REQUEST_SIZE) {
+    SizeMax = VBLK_MAX_REQUEST_SIZE;
+  }
+  Queue->SegMax  = SegMax;
+  Queue->SizeMax = SizeMax;
+
+  for (DescIdx = 0; DescIdx < Ring->QueueSize; ++DescIdx) {
+    Ring->Desc[DescIdx].Next = (UINT16) (DescIdx + 1);
+  }
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device: we poll the
+  // used ring, the host should not send an interrupt.
+  //
+  *Ring->Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+}
+
+
+/**
+
+  Compute the number of bytes the next request of a transfer can carry.
+
+  @param[in] Queue      The submission queue.
+
+  @param[in] BlockSize  The logical block size of the device.
+
+  @param[in] Remaining  Positive number of bytes left in the transfer, an
+                        integral multiple of BlockSize.
+
+  @return  A positive integral multiple of BlockSize, not larger than
+           Remaining, that fits in the SEG_MAX and SIZE_MAX limits of the
+           device, in the ring, and in a descriptor chain.
+
+**/
+
+UINTN
+VirtioBlkQueueRequestSize (
+  IN CONST VBLK_QUEUE *Queue,
+  IN       UINT32     BlockSize,
+  IN       UINTN      Remaining
+  )
+{
+  UINT64 MaxSize;
+
+  ASSERT (Remaining > 0);
+  ASSERT (Remaining % BlockSize == 0);
+
+  MaxSize = MultU64x32 (Queue->SizeMax, Queue->SegMax);
+  if (MaxSize > VBLK_MAX_REQUEST_SIZE) {
+    MaxSize = VBLK_MAX_REQUEST_SIZE;
+  }
+
+  //
+  // ensured by VirtioBlkInit(): a request can carry at least one block
+  //
+  MaxSize -= ModU64x32 (MaxSize, BlockSize);
+  ASSERT (MaxSize > 0);
+
+  return (Remaining < MaxSize) ? Remaining : (UINTN) MaxSize;
+}
+
+
+/**
+
+  Take a descriptor from the free list and fill it in.
+
+  @param[in,out] Queue     The submission queue, with a non-empty free list.
+
+  @param[in] BufferAddr    (Guest pseudo-physical) start address of the
+                           buffer.
+
+  @param[in] BufferSize    Number of bytes in the buffer.
+
+  @param[in] Flags         A bitmask of VRING_DESC_F_* flags. The Next field
+                           of the descriptor is always left linked to the next
+                           free descriptor, which the caller takes next for
+                           the same chain if VRING_DESC_F_NEXT is set.
+
+  @return  The index of the descriptor.
+
+**/
+
+STATIC
+UINT16
+VirtioBlkQueueTakeDesc (
+  IN OUT VBLK_QUEUE *Queue,
+  IN     UINTN      BufferAddr,
+  IN     UINT32     BufferSize,
+  IN     UINT16     Flags
+  )
+{
+  volatile VRING_DESC *Desc;
+  UINT16              DescIdx;
+
+  ASSERT (Queue->FreeCount > 0);
+
+  DescIdx     = Queue->FreeHead;
+  Desc        = &Queue->Ring->Desc[DescIdx];
+  Desc->Addr  = BufferAddr;
+  Desc->Len   = BufferSize;
+  Desc->Flags = Flags;
+
+  Queue->FreeHead = Desc->Next;
+  Queue->FreeCount--;
+  return DescIdx;
+}
+
+
+/**
+
+  Build the descriptor chain of a virtio-blk request: the request header,
+  the data buffer split into SIZE_MAX sized descriptors, and the host status.
+  The chain is put on the available ring, but not published to the host.
+
+  @param[in,out] Queue       The submission queue.
+
+  @param[in] Header          The request header, read by the host.
+
+  @param[in] Buffer          The data buffer, read or written by the host.
+
+  @param[in] BufferSize      The size of the data buffer, as returned by
+                             VirtioBlkQueueRequestSize(), or 0 for a flush.
+
+  @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
+                             device.
+
+  @param[in] HostStatus      The host status byte, written by the host.
+
+  @param[out] HeadDescIdx    The index of the first descriptor of the chain.
+
+  @retval EFI_SUCCESS           The chain is on the available ring.
+
+  @retval EFI_OUT_OF_RESOURCES  Not enough free descriptors, retry after
+                                in-flight requests complete.
+
+**/
+
+EFI_STATUS
+VirtioBlkQueueAppendRequest (
+  IN OUT VBLK_QUEUE              *Queue,
+  IN     volatile VIRTIO_BLK_REQ *Header,
+  IN     VOID                    *Buffer,
+  IN     UINTN                   BufferSize,
+  IN     BOOLEAN                 RequestIsWrite,
+  IN     volatile UINT8          *HostStatus,
+  OUT    UINT16                  *HeadDescIdx
+  )
+{
+  UINTN  SegCount;
+  UINTN  Offset;
+  UINT32 SegSize;
+  VRING  *Ring;
+
+  ASSERT (BufferSize <= VBLK_MAX_REQUEST_SIZE);
+
+  SegCount = (BufferSize + Queue->SizeMax - 1) / Queue->SizeMax;
+  ASSERT (SegCount <= Queue->SegMax);
+  if (SegCount + VBLK_HEADER_STATUS_DESCS > Queue->FreeCount) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // virtio-blk header in first desc
+  //
+  *HeadDescIdx = VirtioBlkQueueTakeDesc (Queue, (UINTN) Header,
+                   sizeof *Header, VRING_DESC_F_NEXT);
+
+  //
+  // data buffer for read/write in the next descs; VRING_DESC_F_WRITE is
+  // interpreted from the host's point of view.
+  //
+  for (Offset = 0; Offset < BufferSize; Offset += SegSize) {
+    SegSize = (UINT32) MIN (BufferSize - Offset, Queue->SizeMax);
+    VirtioBlkQueueTakeDesc (Queue, (UINTN) Buffer + Offset, SegSize,
+      VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE));
+  }
+
+  //
+  // host status in last desc
+  //
+  VirtioBlkQueueTakeDesc (Queue, (UINTN) HostStatus, sizeof *HostStatus,
+    VRING_DESC_F_WRITE);
+
+  //
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring: each entry references
+  // the head descriptor of a chain.
+  //
+  Ring = Queue->Ring;
+  Ring->Avail.Ring[Queue->NextAvailIdx++ % Ring->QueueSize] = *HeadDescIdx;
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Publish the chains appended since the last call to the host, by updating
+  the index of the available ring.
+
+  @param[in,out] Queue  The submission queue.
+
+  @retval TRUE   New chains were published, the host must be notified.
+
+  @retval FALSE  There was nothing to publish.
+
+**/
+
+BOOLEAN
+VirtioBlkQueuePublish (
+  IN OUT VBLK_QUEUE *Queue
+  )
+{
+  if (*Queue->Ring->Avail.Idx == Queue->NextAvailIdx) {
+    return FALSE;
+  }
+
+  //
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field
+  //
+  MemoryFence ();
+  *Queue->Ring->Avail.Idx = Queue->NextAvailIdx;
+  MemoryFence ();
+  return TRUE;
+}
+
+
+/**
+
+  Harvest the next request the host completed, and return its descriptor
+  chain to the free list.
+
+  @param[in,out] Queue     The submission queue.
+
+  @param[out] HeadDescIdx  The index of the first descriptor of the chain of
+                           the completed request.
+
+  @retval TRUE   A completed request was harvested.
+
+  @retval FALSE  The host has not completed any other request.
+
+**/
+
+BOOLEAN
+VirtioBlkQueueHarvest (
+  IN OUT VBLK_QUEUE *Queue,
+  OUT    UINT16     *HeadDescIdx
+  )
+{
+  VRING               *Ring;
+  volatile VRING_DESC *Desc;
+  UINT16              DescIdx;
+  UINT16              Count;
+
+  Ring = Queue->Ring;
+
+  MemoryFence ();
+  if (*Ring->Used.Idx == Queue->LastUsedIdx) {
+    return FALSE;
+  }
+  MemoryFence ();
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  DescIdx = (UINT16) Ring->Used.UsedElem[Queue->LastUsedIdx++ % Ring->QueueSize].Id;
+  ASSERT (DescIdx < Ring->QueueSize);
+  *HeadDescIdx = DescIdx;
+
+  //
+  // The chain is linked through the Next fields, and its last descriptor is
+  // the one without VRING_DESC_F_NEXT; put the whole chain in front of the
+  // free list.
+  //
+  Count = 1;
+  Desc  = &Ring->Desc[DescIdx];
+  while ((Desc->Flags & VRING_DESC_F_NEXT) != 0) {
+    Desc = &Ring->Desc[Desc->Next];
+    Count++;
+  }
+  Desc->Next       = Queue->FreeHead;
+  Queue->FreeHead  = DescIdx;
+  Queue->FreeCount = (UINT16) (Queue->FreeCount + Count);
+  ASSERT (Queue->FreeCount <= Ring->QueueSize);
+
+  return TRUE;
+}
@@ -65,7 +65,6 @@ VirtioNetGetStatus (
   EFI_TPL    OldTpl;
   EFI_STATUS Status;
   UINT16     RxCurUsed;
-  UINT16     TxCurUsed;
 
   if (This == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -103,9 +102,13 @@ VirtioNetGetStatus (
   //
   MemoryFence ();
   RxCurUsed = *Dev->RxRing.Used.Idx;
-  TxCurUsed = *Dev->TxRing.Used.Idx;
   MemoryFence ();
 
+  //
+  // collect all transmit completions in one go
+  //
+  VirtioNetReapTx (Dev);
+
   if (InterruptStatus != NULL) {
     //
     // report the receive interrupt if there is data available for reception,
@@ -115,40 +118,23 @@ VirtioNetGetStatus (
     if (Dev->RxLastUsed != RxCurUsed) {
       *InterruptStatus |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
     }
-    if (Dev->TxLastUsed != TxCurUsed) {
-      ASSERT (Dev->TxCurPending > 0);
+    if (Dev->TxDoneCount > 0) {
       *InterruptStatus |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
     }
   }
 
   if (TxBuf != NULL) {
-    if (Dev->TxLastUsed == TxCurUsed) {
+    if (Dev->TxDoneCount == 0) {
       *TxBuf = NULL;
     }
     else {
-      UINT16 UsedElemIdx;
-      UINT32 DescIdx;
-
-      //
-      // fetch the first descriptor among those that the hypervisor reports
-      // completed
-      //
-      ASSERT (Dev->TxCurPending > 0);
-      ASSERT (Dev->TxCurPending <= Dev->TxMaxPending);
-
-      UsedElemIdx = Dev->TxLastUsed++ % Dev->TxRing.QueueSize;
-      DescIdx = Dev->TxRing.Used.UsedElem[UsedElemIdx].Id;
-      ASSERT (DescIdx < (UINT32) (2 * Dev->TxMaxPending - 1));
-
-      //
-      // report buffer address to caller that has been enqueued by caller
-      //
-      *TxBuf = (VOID *)(UINTN) Dev->TxRing.Desc[DescIdx + 1].Addr;
-
       //
-      // now this descriptor can be used again to enqueue a transmit buffer
+      // report the oldest buffer address that has been enqueued by the caller
+      // and reaped as transmitted
       //
-      Dev->TxFreeStack[--Dev->TxCurPending] = (UINT16) DescIdx;
+      *TxBuf = Dev->TxDoneQueue[Dev->TxDoneHead];
+      Dev->TxDoneHead = (UINT16) ((Dev->TxDoneHead + 1) % Dev->TxMaxPending);
+      Dev->TxDoneCount--;
     }
   }
 
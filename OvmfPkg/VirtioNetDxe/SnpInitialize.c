@@ -67,8 +67,9 @@ VirtioNetInitRing (
   }
 
   //
-  // For each packet (RX and TX alike), we need two descriptors:
-  // one for the virtio-net request header, and another one for the data
+  // For each packet (TX always, RX without VIRTIO_NET_F_MRG_RXBUF), we need two
+  // descriptors: one for the virtio-net request header, and another one for
+  // the data
   //
   if (QueueSize < 2) {
     return EFI_UNSUPPORTED;
@@ -119,6 +120,7 @@ ReleaseQueue:
   - fully populate the TX queue with a static pattern of virtio descriptor
     chains,
   - tracking of heads of free descriptor chains from the above,
+  - the queue of transmitted buffers not yet reported by VirtioNetGetStatus(),
   - one common virtio-net request header (never modified by the host) for all
     pending TX packets,
   - select polling over TX interrupt.
@@ -127,7 +129,8 @@ ReleaseQueue:
                            EfiSimpleNetworkInitialized state.
 
   @retval EFI_OUT_OF_RESOURCES  Failed to allocate the stack to track the heads
-                                of free descriptor chains.
+                                of free descriptor chains, or the queue of
+                                transmitted buffers.
   @retval EFI_SUCCESS           TX setup successful.
 */
 
@@ -138,11 +141,10 @@ VirtioNetInitTx (
   IN OUT VNET_DEV *Dev
   )
 {
-  UINTN TxSharedReqSize;
   UINTN PktIdx;
 
   Dev->TxMaxPending = (UINT16) MIN (Dev->TxRing.QueueSize / 2,
-                                 VNET_MAX_PENDING);
+                                 VNET_MAX_TX_PENDING);
   Dev->TxCurPending = 0;
   Dev->TxFreeStack  = AllocatePool (Dev->TxMaxPending *
                         sizeof *Dev->TxFreeStack);
@@ -150,13 +152,14 @@ VirtioNetInitTx (
     return EFI_OUT_OF_RESOURCES;
   }
 
-  //
-  // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
-  //
-  TxSharedReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                    sizeof Dev->TxSharedReq.V0_9_5 :
-                    sizeof Dev->TxSharedReq;
+  Dev->TxDoneHead  = 0;
+  Dev->TxDoneCount = 0;
+  Dev->TxDoneQueue = AllocatePool (Dev->TxMaxPending *
+                       sizeof *Dev->TxDoneQueue);
+  if (Dev->TxDoneQueue == NULL) {
+    FreePool (Dev->TxFreeStack);
+    return EFI_OUT_OF_RESOURCES;
+  }
 
   for (PktIdx = 0; PktIdx < Dev->TxMaxPending; ++PktIdx) {
     UINT16 DescIdx;
@@ -169,7 +172,7 @@ VirtioNetInitTx (
     // (unmodified by the host) virtio-net request header.
     //
     Dev->TxRing.Desc[DescIdx].Addr  = (UINTN) &Dev->TxSharedReq;
-    Dev->TxRing.Desc[DescIdx].Len   = (UINT32) TxSharedReqSize;
+    Dev->TxRing.Desc[DescIdx].Len   = (UINT32) Dev->NetReqSize;
     Dev->TxRing.Desc[DescIdx].Flags = VRING_DESC_F_NEXT;
     Dev->TxRing.Desc[DescIdx].Next  = (UINT16) (DescIdx + 1);
 
@@ -187,7 +190,8 @@ VirtioNetInitTx (
   Dev->TxSharedReq.V0_9_5.GsoType = VIRTIO_NET_HDR_GSO_NONE;
 
   //
-  // For VirtIo 1.0 only -- the field exists, but it is unused
+  // For VirtIo 1.0 and VIRTIO_NET_F_MRG_RXBUF only -- the field exists, but it
+  // is unused
   //
   Dev->TxSharedReq.NumBuffers = 0;
 
@@ -218,7 +222,9 @@ VirtioNetInitTx (
     packet data into,
   - select polling over RX interrupt,
   - fully populate the RX queue with a static pattern of virtio descriptor
-    chains.
+    chains: two-part chains, or single descriptors that receive both the
+    virtio-net request header and the packet data if VIRTIO_NET_F_MRG_RXBUF
+    has been negotiated.
 
   @param[in,out] Dev       The VNET_DEV driver instance about to enter the
                            EfiSimpleNetworkInitialized state.
@@ -237,7 +243,6 @@ VirtioNetInitRx (
   )
 {
   EFI_STATUS Status;
-  UINTN      VirtioNetReqSize;
   UINTN      RxBufSize;
   UINT16     RxAlwaysPending;
   UINTN      PktIdx;
@@ -245,27 +250,26 @@ VirtioNetInitRx (
   UINT8      *RxPtr;
 
   //
-  // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
-  //
-  VirtioNetReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                     sizeof (VIRTIO_NET_REQ) :
-                     sizeof (VIRTIO_1_0_NET_REQ);
-
-  //
-  // For each incoming packet we must supply two descriptors:
+  // For each incoming packet we must supply
   // - the recipient for the virtio-net request header, plus
   // - the recipient for the network data (which consists of Ethernet header
   //   and Ethernet payload).
   //
-  RxBufSize = VirtioNetReqSize +
+  RxBufSize = Dev->NetReqSize +
               (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize);
 
   //
-  // Limit the number of pending RX packets if the queue is big. The division
-  // by two is due to the above "two descriptors per packet" trait.
+  // Limit the number of pending RX packets if the queue is big. Without
+  // mergeable RX buffers the two recipients must be separate descriptors, so
+  // each packet takes two of them. With mergeable RX buffers the host accepts
+  // them in a single descriptor, and we can keep twice as many packets
+  // pending.
   //
-  RxAlwaysPending = (UINT16) MIN (Dev->RxRing.QueueSize / 2, VNET_MAX_PENDING);
+  RxAlwaysPending = (UINT16) MIN (
+                               Dev->RxMergeable ? Dev->RxRing.QueueSize :
+                                                  Dev->RxRing.QueueSize / 2,
+                               VNET_MAX_RX_PENDING
+                               );
 
   Dev->RxBuf = AllocatePool (RxAlwaysPending * RxBufSize);
   if (Dev->RxBuf == NULL) {
@@ -287,8 +291,8 @@ VirtioNetInitRx (
   *Dev->RxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
 
   //
-  // now set up a separate, two-part descriptor chain for each RX packet, and
-  // link each chain into (from) the available ring as well
+  // now set up a separate descriptor chain for each RX packet, and link each
+  // chain into (from) the available ring as well
   //
   DescIdx = 0;
   RxPtr = Dev->RxBuf;
@@ -302,14 +306,22 @@ VirtioNetInitRx (
     //
     // virtio-0.9.5, 2.4.1.1 Placing Buffers into the Descriptor Table
     //
+    if (Dev->RxMergeable) {
+      Dev->RxRing.Desc[DescIdx].Addr  = (UINTN) RxPtr;
+      Dev->RxRing.Desc[DescIdx].Len   = (UINT32) RxBufSize;
+      Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
+      RxPtr += Dev->RxRing.Desc[DescIdx++].Len;
+      continue;
+    }
+
     Dev->RxRing.Desc[DescIdx].Addr  = (UINTN) RxPtr;
-    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) VirtioNetReqSize;
+    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) Dev->NetReqSize;
     Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
     Dev->RxRing.Desc[DescIdx].Next  = (UINT16) (DescIdx + 1);
     RxPtr += Dev->RxRing.Desc[DescIdx++].Len;
 
     Dev->RxRing.Desc[DescIdx].Addr  = (UINTN) RxPtr;
-    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) (RxBufSize - VirtioNetReqSize);
+    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) (RxBufSize - Dev->NetReqSize);
     Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
     RxPtr += Dev->RxRing.Desc[DescIdx++].Len;
   }
@@ -439,7 +451,31 @@ VirtioNetInitialize (
   ASSERT (Dev->Snm.MediaPresentSupported ==
     !!(Features & VIRTIO_NET_F_STATUS));
 
-  Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_F_VERSION_1;
+  //
+  // Mergeable RX buffers let each RX packet take a single descriptor. We
+  // don't negotiate the TSO / UFO features, so the host never needs to merge
+  // more than one buffer; VirtioNetReceive() handles it nonetheless.
+  //
+  // With VIRTIO_NET_F_GUEST_CSUM, the host may skip computing the checksum of
+  // packets that originate from itself, leaving it to the guest. The SNP
+  // client can't be told, so VirtioNetReceive() completes such checksums.
+  //
+  // Transmit checksum offload (VIRTIO_NET_F_CSUM) is useless for us: the
+  // SNP client always fills in the checksums.
+  //
+  Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_NET_F_MRG_RXBUF |
+              VIRTIO_NET_F_GUEST_CSUM | VIRTIO_F_VERSION_1;
+  Dev->RxMergeable = (BOOLEAN) ((Features & VIRTIO_NET_F_MRG_RXBUF) != 0);
+  Dev->RxGuestCsum = (BOOLEAN) ((Features & VIRTIO_NET_F_GUEST_CSUM) != 0);
+
+  //
+  // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
+  // VIRTIO_NET_F_MRG_RXBUF.
+  //
+  Dev->NetReqSize = (Dev->VirtIo->Revision >= VIRTIO_SPEC_REVISION (1, 0, 0) ||
+                     Dev->RxMergeable) ?
+                    sizeof (VIRTIO_1_0_NET_REQ) :
+                    sizeof (VIRTIO_NET_REQ);
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -21,6 +21,121 @@
 
 #include "VirtioNet.h"
 
+/**
+  Locate the packet data in an RX buffer that the host has returned on the
+  Used Ring.
+
+  @param[in]  Dev          The VNET_DEV driver instance.
+  @param[in]  UsedOffset   The offset of the Used Ring Element from the first
+                           one not processed yet by the guest.
+  @param[out] DescIdx      The index of the head descriptor of the buffer, to
+                           be recycled to the Available Ring.
+  @param[out] Data         The packet data the host has written to the buffer.
+
+  @return  The number of packet data bytes the host has written to the buffer.
+*/
+
+STATIC
+UINT32
+VirtioNetRxBufferData (
+  IN  VNET_DEV *Dev,
+  IN  UINT16   UsedOffset,
+  OUT UINT16   *DescIdx,
+  OUT UINT8    **Data
+  )
+{
+  UINT16 UsedElemIdx;
+  UINT32 Len;
+
+  UsedElemIdx = (UINT16) (Dev->RxLastUsed + UsedOffset) %
+                Dev->RxRing.QueueSize;
+  *DescIdx = (UINT16) Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
+  Len      = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
+
+  if (!Dev->RxMergeable) {
+    //
+    // the virtio-net request header must be complete; we skip it
+    //
+    ASSERT (Len >= Dev->RxRing.Desc[*DescIdx].Len);
+    Len -= Dev->RxRing.Desc[*DescIdx].Len;
+    //
+    // the host must not have filled in more data than requested
+    //
+    ASSERT (Len <= Dev->RxRing.Desc[*DescIdx + 1].Len);
+    *Data = (UINT8 *)(UINTN) Dev->RxRing.Desc[*DescIdx + 1].Addr;
+    return Len;
+  }
+
+  //
+  // With mergeable RX buffers, the virtio-net request header is at the start
+  // of the first buffer of the packet only.
+  //
+  ASSERT (Len <= Dev->RxRing.Desc[*DescIdx].Len);
+  *Data = (UINT8 *)(UINTN) Dev->RxRing.Desc[*DescIdx].Addr;
+  if (UsedOffset == 0) {
+    ASSERT (Len >= Dev->NetReqSize);
+    Len   -= (UINT32) Dev->NetReqSize;
+    *Data += Dev->NetReqSize;
+  }
+  return Len;
+}
+
+
+/**
+  Complete the partial checksum of a packet that the host has left to the
+  guest (VIRTIO_NET_HDR_F_NEEDS_CSUM).
+
+  The host has stored the checksum of the pseudo header in the checksum field;
+  the ones' complement sum from CsumStart to the end of the packet is folded
+  into it.
+
+  @param[in,out] Packet      The packet, starting with the media header.
+  @param[in]     PacketSize  The size of the packet in bytes.
+  @param[in]     CsumStart   The offset in the packet to start summing from.
+  @param[in]     CsumOffset  The offset of the checksum field from CsumStart.
+
+  @retval EFI_SUCCESS       The checksum has been completed.
+  @retval EFI_DEVICE_ERROR  The checksum field is not within the packet.
+*/
+
+STATIC
+EFI_STATUS
+VirtioNetCompleteChecksum (
+  IN OUT UINT8  *Packet,
+  IN     UINTN  PacketSize,
+  IN     UINT16 CsumStart,
+  IN     UINT16 CsumOffset
+  )
+{
+  UINT32 Sum;
+  UINTN  Idx;
+
+  if (CsumStart >= PacketSize ||
+      PacketSize - CsumStart < (UINTN) CsumOffset + sizeof (UINT16)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  //
+  // A packet is not larger than 64KB, so the 32-bit sum doesn't overflow.
+  //
+  Sum = 0;
+  for (Idx = CsumStart; Idx + 1 < PacketSize; Idx += 2) {
+    Sum += (UINT32) ((Packet[Idx] << 8) | Packet[Idx + 1]);
+  }
+  if (Idx < PacketSize) {
+    Sum += (UINT32) Packet[Idx] << 8;
+  }
+  while ((Sum >> 16) != 0) {
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+  }
+
+  Sum = ~Sum & 0xFFFF;
+  Packet[CsumStart + CsumOffset]     = (UINT8) (Sum >> 8);
+  Packet[CsumStart + CsumOffset + 1] = (UINT8) Sum;
+  return EFI_SUCCESS;
+}
+
+
 /**
   Receives a packet from a network interface.
 
@@ -71,17 +186,21 @@ VirtioNetReceive (
   OUT UINT16                     *Protocol   OPTIONAL
   )
 {
-  VNET_DEV   *Dev;
-  EFI_TPL    OldTpl;
-  EFI_STATUS Status;
-  UINT16     RxCurUsed;
-  UINT16     UsedElemIdx;
-  UINT32     DescIdx;
-  UINT32     RxLen;
-  UINTN      OrigBufferSize;
-  UINT8      *RxPtr;
-  UINT16     AvailIdx;
-  EFI_STATUS NotifyStatus;
+  VNET_DEV           *Dev;
+  EFI_TPL            OldTpl;
+  EFI_STATUS         Status;
+  UINT16             RxCurUsed;
+  UINT16             NumBuffers;
+  UINT16             BufIdx;
+  UINT16             DescIdx;
+  UINT32             RxLen;
+  UINT32             BufLen;
+  UINTN              OrigBufferSize;
+  UINT8              *RxPtr;
+  UINT8              *Dest;
+  VIRTIO_1_0_NET_REQ NetReq;
+  UINT16             AvailIdx;
+  EFI_STATUS         NotifyStatus;
 
   if (This == NULL || BufferSize == NULL || Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -112,19 +231,37 @@ VirtioNetReceive (
     goto Exit;
   }
 
-  UsedElemIdx = Dev->RxLastUsed % Dev->RxRing.QueueSize;
-  DescIdx = Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
-  RxLen   = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
-
   //
-  // the virtio-net request header must be complete; we skip it
+  // Save the virtio-net request header before the buffer is recycled.
   //
-  ASSERT (RxLen >= Dev->RxRing.Desc[DescIdx].Len);
-  RxLen -= Dev->RxRing.Desc[DescIdx].Len;
+  RxLen = VirtioNetRxBufferData (Dev, 0, &DescIdx, &RxPtr);
+  CopyMem (&NetReq, (VOID *)(UINTN) Dev->RxRing.Desc[DescIdx].Addr,
+    Dev->NetReqSize);
+
   //
-  // the host must not have filled in more data than requested
+  // With mergeable RX buffers, a packet may span several buffers, which the
+  // host returns on the Used Ring together.
   //
-  ASSERT (RxLen <= Dev->RxRing.Desc[DescIdx + 1].Len);
+  NumBuffers = 1;
+  if (Dev->RxMergeable) {
+    //
+    // A packet can not span more buffers than we keep on the RX ring; waiting
+    // for them would stall the RX ring forever.
+    //
+    if (NetReq.NumBuffers == 0 ||
+        NetReq.NumBuffers > (UINT16) (*Dev->RxRing.Avail.Idx - Dev->RxLastUsed)) {
+      Status = EFI_DEVICE_ERROR;
+      goto RecycleDesc; // drop malformed packet
+    }
+    if ((UINT16) (RxCurUsed - Dev->RxLastUsed) < NetReq.NumBuffers) {
+      Status = EFI_NOT_READY;
+      goto Exit;
+    }
+    NumBuffers = NetReq.NumBuffers;
+    for (BufIdx = 1; BufIdx < NumBuffers; ++BufIdx) {
+      RxLen += VirtioNetRxBufferData (Dev, BufIdx, &DescIdx, &RxPtr);
+    }
+  }
 
   OrigBufferSize = *BufferSize;
   *BufferSize = RxLen;
@@ -139,13 +276,27 @@ VirtioNetReceive (
     goto RecycleDesc; // drop useless short packet
   }
 
+  Dest = Buffer;
+  for (BufIdx = 0; BufIdx < NumBuffers; ++BufIdx) {
+    BufLen = VirtioNetRxBufferData (Dev, BufIdx, &DescIdx, &RxPtr);
+    CopyMem (Dest, RxPtr, BufLen);
+    Dest += BufLen;
+  }
+
+  if (Dev->RxGuestCsum &&
+      (NetReq.V0_9_5.Flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0) {
+    Status = VirtioNetCompleteChecksum (Buffer, RxLen,
+               NetReq.V0_9_5.CsumStart, NetReq.V0_9_5.CsumOffset);
+    if (EFI_ERROR (Status)) {
+      goto RecycleDesc; // drop packet with bogus checksum request
+    }
+  }
+
   if (HeaderSize != NULL) {
     *HeaderSize = Dev->Snm.MediaHeaderSize;
   }
 
-  RxPtr = (UINT8 *)(UINTN) Dev->RxRing.Desc[DescIdx + 1].Addr;
-  CopyMem (Buffer, RxPtr, RxLen);
-
+  RxPtr = Buffer;
   if (DestAddr != NULL) {
     CopyMem (DestAddr, RxPtr, SIZE_OF_VNET (Mac));
   }
@@ -164,20 +315,20 @@ VirtioNetReceive (
   Status = EFI_SUCCESS;
 
 RecycleDesc:
-  ++Dev->RxLastUsed;
-
   //
   // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
   //
   AvailIdx = *Dev->RxRing.Avail.Idx;
-  Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] =
-    (UINT16) DescIdx;
+  for (BufIdx = 0; BufIdx < NumBuffers; ++BufIdx) {
+    VirtioNetRxBufferData (Dev, BufIdx, &DescIdx, &RxPtr);
+    Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] = DescIdx;
+  }
+  Dev->RxLastUsed = (UINT16) (Dev->RxLastUsed + NumBuffers);
 
   MemoryFence ();
   *Dev->RxRing.Avail.Idx = AvailIdx;
 
-  MemoryFence ();
-  NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
+  NotifyStatus = VirtioNetNotifyQueue (Dev, VIRTIO_NET_Q_RX, &Dev->RxRing);
   if (!EFI_ERROR (Status)) { // earlier error takes precedence
     Status = NotifyStatus;
   }
@@ -14,6 +14,7 @@
 
 **/
 
+#include <Library/BaseLib.h>
 #include <Library/MemoryAllocationLib.h>
 
 #include "VirtioNet.h"
@@ -49,5 +50,96 @@ VirtioNetShutdownTx (
   IN OUT VNET_DEV *Dev
   )
 {
+  FreePool (Dev->TxDoneQueue);
   FreePool (Dev->TxFreeStack);
 }
+
+
+/**
+  Notify the host of new buffers on the Available Ring of a virtio queue,
+  unless the host has asked not to be notified.
+
+  The host sets VRING_USED_F_NO_NOTIFY while it is processing the queue anyway
+  (or, for RX, while it has enough buffers), so each notification we can skip
+  saves a trap to the hypervisor.
+
+  @param[in] Dev       The VNET_DEV driver instance in the
+                       EfiSimpleNetworkInitialized state.
+  @param[in] Selector  Identifies the transfer direction (virtio queue) of the
+                       network device.
+  @param[in] Ring      The virtio-ring inside the VNET_DEV structure,
+                       corresponding to Selector, whose Available Index has
+                       just been updated.
+
+  @return  Status codes from VIRTIO_DEVICE_PROTOCOL.SetQueueNotify().
+*/
+
+EFI_STATUS
+EFIAPI
+VirtioNetNotifyQueue (
+  IN VNET_DEV *Dev,
+  IN UINT16   Selector,
+  IN VRING    *Ring
+  )
+{
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device -- the Available Index must be
+  // visible to the host before we look at the Used Ring flags
+  //
+  MemoryFence ();
+  if ((*Ring->Used.Flags & VRING_USED_F_NO_NOTIFY) != 0) {
+    return EFI_SUCCESS;
+  }
+  return Dev->VirtIo->SetQueueNotify (Dev->VirtIo, Selector);
+}
+
+
+/**
+  Recycle all TX descriptor chains the host has processed since the last call,
+  and queue the addresses of their packet buffers for VirtioNetGetStatus() to
+  report.
+
+  Completions are reaped in one batch, so that VirtioNetTransmit() can reuse
+  the descriptor chains before the client collects the buffers one by one. A
+  completion stays on the Used Ring if the queue of buffers to report is full.
+
+  @param[in,out] Dev  The VNET_DEV driver instance in the
+                      EfiSimpleNetworkInitialized state.
+*/
+
+VOID
+EFIAPI
+VirtioNetReapTx (
+  IN OUT VNET_DEV *Dev
+  )
+{
+  UINT16 TxCurUsed;
+  UINT16 UsedElemIdx;
+  UINT32 DescIdx;
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  MemoryFence ();
+  TxCurUsed = *Dev->TxRing.Used.Idx;
+  MemoryFence ();
+
+  while (Dev->TxLastUsed != TxCurUsed &&
+         Dev->TxDoneCount < Dev->TxMaxPending) {
+    ASSERT (Dev->TxCurPending > 0);
+    ASSERT (Dev->TxCurPending <= Dev->TxMaxPending);
+
+    UsedElemIdx = Dev->TxLastUsed++ % Dev->TxRing.QueueSize;
+    DescIdx = Dev->TxRing.Used.UsedElem[UsedElemIdx].Id;
+    ASSERT (DescIdx < (UINT32) (2 * Dev->TxMaxPending - 1));
+
+    //
+    // queue the buffer address that has been enqueued by the caller for
+    // reporting, and make the descriptor chain available again
+    //
+    Dev->TxDoneQueue[(Dev->TxDoneHead + Dev->TxDoneCount++) %
+                     Dev->TxMaxPending] =
+      (VOID *)(UINTN) Dev->TxRing.Desc[DescIdx + 1].Addr;
+    Dev->TxFreeStack[--Dev->TxCurPending] = (UINT16) DescIdx;
+  }
+}
@@ -106,9 +106,13 @@ VirtioNetTransmit (
   }
 
   //
-  // check if we have room for transmission
+  // check if we have room for transmission; if not, recycle the descriptor
+  // chains of the packets transmitted meanwhile
   //
   ASSERT (Dev->TxCurPending <= Dev->TxMaxPending);
+  if (Dev->TxCurPending == Dev->TxMaxPending) {
+    VirtioNetReapTx (Dev);
+  }
   if (Dev->TxCurPending == Dev->TxMaxPending) {
     Status = EFI_NOT_READY;
     goto Exit;
@@ -160,8 +164,7 @@ VirtioNetTransmit (
   MemoryFence ();
   *Dev->TxRing.Avail.Idx = AvailIdx;
 
-  MemoryFence ();
-  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_TX);
+  Status = VirtioNetNotifyQueue (Dev, VIRTIO_NET_Q_TX, &Dev->TxRing);
 
 Exit:
   gBS->RestoreTPL (OldTpl);
@@ -29,9 +29,12 @@
 #define VNET_SIG SIGNATURE_32 ('V', 'N', 'E', 'T')
 
 //
-// maximum number of pending packets, separately for each direction
+// maximum number of pending packets, separately for each direction; more RX
+// buffers are kept posted so that the host doesn't have to drop incoming
+// bursts while the SNP client is busy
 //
-#define VNET_MAX_PENDING 64
+#define VNET_MAX_TX_PENDING 64
+#define VNET_MAX_RX_PENDING 256
 
 //
 // State diagram:
@@ -81,6 +84,10 @@ typedef struct {
   EFI_DEVICE_PATH_PROTOCOL    *MacDevicePath;    // VirtioNetDriverBindingStart
   EFI_HANDLE                  MacHandle;         // VirtioNetDriverBindingStart
 
+  UINTN                       NetReqSize;        // VirtioNetInitialize
+  BOOLEAN                     RxMergeable;       // VirtioNetInitialize
+  BOOLEAN                     RxGuestCsum;       // VirtioNetInitialize
+
   VRING                       RxRing;            // VirtioNetInitRing
   UINT8                       *RxBuf;            // VirtioNetInitRx
   UINT16                      RxLastUsed;        // VirtioNetInitRx
@@ -89,6 +96,9 @@ typedef struct {
   UINT16                      TxMaxPending;      // VirtioNetInitTx
   UINT16                      TxCurPending;      // VirtioNetInitTx
   UINT16                      *TxFreeStack;      // VirtioNetInitTx
+  VOID                        **TxDoneQueue;     // VirtioNetInitTx
+  UINT16                      TxDoneHead;        // VirtioNetInitTx
+  UINT16                      TxDoneCount;       // VirtioNetInitTx
   VIRTIO_1_0_NET_REQ          TxSharedReq;       // VirtioNetInitTx
   UINT16                      TxLastUsed;        // VirtioNetInitTx
 } VNET_DEV;
@@ -263,6 +273,20 @@ VirtioNetShutdownTx (
   IN OUT VNET_DEV *Dev
   );
 
+EFI_STATUS
+EFIAPI
+VirtioNetNotifyQueue (
+  IN VNET_DEV *Dev,
+  IN UINT16   Selector,
+  IN VRING    *Ring
+  );
+
+VOID
+EFIAPI
+VirtioNetReapTx (
+  IN OUT VNET_DEV *Dev
+  );
+
 //
 // event callbacks
 //
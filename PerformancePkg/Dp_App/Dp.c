@@ -80,6 +80,14 @@ PERF_CUM_DATA CumData[] = {
 /// Number of items for which we are gathering cumulative statistics.
 UINT32 const      NumCum = sizeof(CumData) / sizeof(PERF_CUM_DATA);
 
+/// Values of the -f option, in DP_EXPORT_FORMAT order.
+CHAR16 *mExportFormatNames[] = {
+  L"chrome",
+  L"flame",
+  L"csv",
+  L"raw"
+};
+
 PARAM_ITEM_LIST  ParamList[] = {
   {STRING_TOKEN (STR_DP_OPTION_QH), TypeFlag},   // -?   Help
   {STRING_TOKEN (STR_DP_OPTION_LH), TypeFlag},   // -h   Help
@@ -96,7 +104,10 @@ PARAM_ITEM_LIST  ParamList[] = {
   {STRING_TOKEN (STR_DP_OPTION_LI), TypeFlag},   // -i   Display Identifier
   {STRING_TOKEN (STR_DP_OPTION_LC), TypeValue},  // -c   Display cumulative data.
   {STRING_TOKEN (STR_DP_OPTION_LN), TypeValue},  // -n # Number of records to display for A and R
-  {STRING_TOKEN (STR_DP_OPTION_LT), TypeValue}   // -t # Threshold of interest
+  {STRING_TOKEN (STR_DP_OPTION_LT), TypeValue},  // -t # Threshold of interest
+  {STRING_TOKEN (STR_DP_OPTION_LO), TypeValue},  // -o   Export measurements to a file
+  {STRING_TOKEN (STR_DP_OPTION_LF), TypeValue},  // -f   Export format
+  {STRING_TOKEN (STR_DP_OPTION_LD), TypeFlag}    // -d   Dispatch analysis
   };
 
 ///@}
@@ -153,6 +164,9 @@ ShowHelp( void )
   PrintToken (STRING_TOKEN (STR_DP_HELP_COUNT));
   PrintToken (STRING_TOKEN (STR_DP_HELP_ID));
   PrintToken (STRING_TOKEN (STR_DP_HELP_CUM_DATA));
+  PrintToken (STRING_TOKEN (STR_DP_HELP_EXPORT));
+  PrintToken (STRING_TOKEN (STR_DP_HELP_FORMAT));
+  PrintToken (STRING_TOKEN (STR_DP_HELP_DISPATCH));
   PrintToken (STRING_TOKEN (STR_DP_HELP_HELP));
   Print(L"\n");
 }
@@ -219,6 +233,9 @@ InitializeDp (
   BOOLEAN                       ProfileMode;
   BOOLEAN                       ExcludeMode;
   BOOLEAN                       CumulativeMode;
+  BOOLEAN                       DispatchMode;
+  CONST CHAR16                  *ExportFileName;
+  DP_EXPORT_FORMAT              ExportFormat;
   CONST CHAR16                  *CustomCumulativeToken;
   PERF_CUM_DATA                 *CustomCumulativeData;
   UINTN                         NameSize;
@@ -239,6 +256,9 @@ InitializeDp (
   EFI_STRING                StringDpOptionLt;
   EFI_STRING                StringDpOptionLi;
   EFI_STRING                StringDpOptionLc;
+  EFI_STRING                StringDpOptionLo;
+  EFI_STRING                StringDpOptionLf;
+  EFI_STRING                StringDpOptionLd;
   
   SummaryMode     = FALSE;
   VerboseMode     = FALSE;
@@ -248,6 +268,9 @@ InitializeDp (
   ProfileMode     = FALSE;
   ExcludeMode     = FALSE;
   CumulativeMode = FALSE;
+  DispatchMode    = FALSE;
+  ExportFileName  = NULL;
+  ExportFormat    = DpExportChromeTrace;
   CustomCumulativeData = NULL;
 
   StringDpOptionQh = NULL;
@@ -265,6 +288,9 @@ InitializeDp (
   StringDpOptionLt = NULL;
   StringDpOptionLi = NULL;
   StringDpOptionLc = NULL;
+  StringDpOptionLo = NULL;
+  StringDpOptionLf = NULL;
+  StringDpOptionLd = NULL;
   StringPtr        = NULL;
 
   // Get DP's entry time as soon as possible.
@@ -339,6 +365,9 @@ InitializeDp (
       StringDpOptionLt = HiiGetString (gHiiHandle, STRING_TOKEN (STR_DP_OPTION_LT), NULL);
       StringDpOptionLi = HiiGetString (gHiiHandle, STRING_TOKEN (STR_DP_OPTION_LI), NULL);
       StringDpOptionLc = HiiGetString (gHiiHandle, STRING_TOKEN (STR_DP_OPTION_LC), NULL);
+      StringDpOptionLo = HiiGetString (gHiiHandle, STRING_TOKEN (STR_DP_OPTION_LO), NULL);
+      StringDpOptionLf = HiiGetString (gHiiHandle, STRING_TOKEN (STR_DP_OPTION_LF), NULL);
+      StringDpOptionLd = HiiGetString (gHiiHandle, STRING_TOKEN (STR_DP_OPTION_LD), NULL);
       
       // Boolean Options
       // 
@@ -354,6 +383,7 @@ InitializeDp (
       ExcludeMode = ShellCommandLineGetFlag (ParamPackage, StringDpOptionLx);
       mShowId     =  ShellCommandLineGetFlag (ParamPackage, StringDpOptionLi);
       CumulativeMode = ShellCommandLineGetFlag (ParamPackage, StringDpOptionLc);
+      DispatchMode   = ShellCommandLineGetFlag (ParamPackage, StringDpOptionLd);
 
       // Options with Values
       CmdLineArg  = ShellCommandLineGetValue (ParamPackage, StringDpOptionLn);
@@ -373,6 +403,21 @@ InitializeDp (
       else {
         mInterestThreshold = StrDecimalToUint64(CmdLineArg);
       }
+      ExportFileName = ShellCommandLineGetValue (ParamPackage, StringDpOptionLo);
+      CmdLineArg     = ShellCommandLineGetValue (ParamPackage, StringDpOptionLf);
+      if (CmdLineArg != NULL) {
+        for (ExportFormat = DpExportChromeTrace; ExportFormat < DpExportMax; ExportFormat++) {
+          if (StrCmp (CmdLineArg, mExportFormatNames[ExportFormat]) == 0) {
+            break;
+          }
+        }
+        if ((ExportFormat == DpExportMax) || (ExportFileName == NULL)) {
+          PrintToken (STRING_TOKEN (STR_DP_INVALID_ARG));
+          ShowHelp();
+          Status = EFI_INVALID_PARAMETER;
+          goto Done;
+        }
+      }
       // Handle Flag combinations and default behaviors
       // If both TraceMode and ProfileMode are FALSE, set them both to TRUE
       if ((! TraceMode) && (! ProfileMode)) {
@@ -459,6 +504,23 @@ InitializeDp (
 ****    !T &&  P  := (2) Only Profile records are displayed
 ****     T &&  P  := (3) Same as Default, both are displayed
 ****************************************************************************/
+      if ((ExportFileName != NULL) || DispatchMode) {
+        //
+        // Export and dispatch analysis read the measurements on their own and
+        // replace the other reports.
+        //
+        if (ExportFileName != NULL) {
+          Status = ExportGauges (ExportFileName, ExportFormat);
+          if (EFI_ERROR (Status)) {
+            goto Done;
+          }
+        }
+        if (DispatchMode) {
+          Status = ProcessDispatch (Number2Display);
+        }
+        goto Done;
+      }
+
       GatherStatistics (CustomCumulativeData);
       if (CumulativeMode) {                       
         ProcessCumulative (CustomCumulativeData);
@@ -544,6 +606,9 @@ Done:
   SafeFreePool (StringDpOptionLt);
   SafeFreePool (StringDpOptionLi);
   SafeFreePool (StringDpOptionLc);
+  SafeFreePool (StringDpOptionLo);
+  SafeFreePool (StringDpOptionLf);
+  SafeFreePool (StringDpOptionLd);
   SafeFreePool (StringPtr);
   SafeFreePool (mPrintTokenBuffer);
 
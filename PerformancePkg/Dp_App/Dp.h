@@ -17,7 +17,7 @@
 #include <Library/ShellLib.h>
 
 #define DP_MAJOR_VERSION        2
-#define DP_MINOR_VERSION        3
+#define DP_MINOR_VERSION        4
 
 /**
   * The value assigned to DP_DEBUG controls which debug output
@@ -98,4 +98,39 @@ typedef struct {
   UINT16             Token;
   SHELL_PARAM_TYPE   Type;
 } PARAM_ITEM_LIST;
+
+/// Formats of the measurements written by the -o option.
+typedef enum {
+  DpExportChromeTrace,      ///< Chrome trace event JSON.
+  DpExportCollapsedStack,   ///< Collapsed stacks, the input of flame graph tools.
+  DpExportCsv,              ///< Comma separated values, one measurement per line.
+  DpExportRaw,              ///< Copy of the binary performance log.
+  DpExportMax
+} DP_EXPORT_FORMAT;
+
+#define DP_NAME_SIZE            48
+#define DP_NO_PARENT            0xFFFFFFFF
+
+/// A complete measurement, paired and nested by time on its processor.
+typedef struct {
+  UINT64                Handle;
+  UINT64                Start;            ///< Start time in ticks since the timer started counting.
+  UINT64                End;              ///< End time in ticks since the timer started counting.
+  UINT64                SelfDuration;     ///< Duration not covered by nested measurements, in ticks.
+  UINT32                Identifier;
+  UINT32                CpuId;            ///< Processor the measurement was taken on.
+  UINT32                Parent;           ///< Index of the innermost enclosing measurement, or DP_NO_PARENT.
+  CHAR8                 Token[DXE_PERFORMANCE_STRING_SIZE];
+  CHAR8                 Module[DXE_PERFORMANCE_STRING_SIZE];
+  CHAR8                 Name[DP_NAME_SIZE];  ///< Printable name of the measured component.
+} DP_GAUGE;
+
+/// Time accumulated for one firmware volume, driver or notification function.
+typedef struct {
+  UINT64                Key;
+  UINT64                Duration;         ///< Cumulative duration in ticks.
+  UINT64                MaxDuration;      ///< Longest single duration in ticks.
+  UINT32                Count;
+  CHAR16                Name[DP_NAME_SIZE];
+} DP_ATTRIBUTION;
 #endif  // _EFI_APP_DP_H_
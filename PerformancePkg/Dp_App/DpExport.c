@@ -0,0 +1,1328 @@
+/** @file
+  Measurement export and dispatch analysis for the Dp utility.
+
+  The measurements are read from the binary performance log when the platform
+  publishes one, through the PerformanceLib otherwise.  Start and end records
+  are paired, nested by time on each processor, then either written to a file
+  as Chrome trace events, collapsed stacks or CSV, or summarized as the
+  dispatch critical path and the time spent per firmware volume, driver
+  binding Start() and protocol notification function.
+
+  Copyright (c) 2016, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/PerformanceBinaryLogLib.h>
+#include <Library/PrintLib.h>
+#include <Library/HiiLib.h>
+#include <Library/SortLib.h>
+#include <Library/UefiLib.h>
+#include <Library/DevicePathLib.h>
+
+#include <Pi/PiFirmwareVolume.h>
+#include <Protocol/LoadedImage.h>
+#include <Protocol/FirmwareVolumeBlock.h>
+
+#include <Guid/Performance.h>
+#include <Guid/PerformanceBinaryLog.h>
+
+#include <PerformanceTokens.h>
+#include "Dp.h"
+#include "Literals.h"
+#include "DpInternal.h"
+
+#define DP_EXPORT_BUFFER_SIZE   0x4000
+#define DP_EXPORT_LINE_SIZE     0x200
+#define DP_MAX_STACK_DEPTH      64
+
+//
+// End time of a measurement whose end record has not been found yet.
+//
+#define DP_OPEN_GAUGE           MAX_UINT64
+
+DP_GAUGE                        *mDpGauges      = NULL;
+UINTN                           mDpGaugeCount   = 0;
+PERFORMANCE_BINARY_LOG_CONTEXT  mDpBinaryLog;
+BOOLEAN                         mDpBinaryLogFound = FALSE;
+
+SHELL_FILE_HANDLE               mExportFile;
+CHAR8                           *mExportBuffer  = NULL;
+UINTN                           mExportLength;
+EFI_STATUS                      mExportStatus;
+
+/**
+  Replace the characters of a name which are not printable or have a meaning
+  in one of the export formats.
+
+  @param[in, out] Name    Null-terminated ASCII string to sanitize.
+
+**/
+VOID
+SanitizeName (
+  IN OUT CHAR8  *Name
+  )
+{
+  for (; *Name != '\0'; Name++) {
+    if ((*Name < ' ') || (*Name > '~') ||
+        (*Name == '"') || (*Name == '\\') || (*Name == ';') || (*Name == ',')) {
+      *Name = '_';
+    }
+  }
+}
+
+/**
+  Convert a time stamp to ticks since the timer started counting.
+
+  @param[in]  TimeStamp   Time stamp of a measurement, 1 is the release of reset.
+
+  @return     The number of ticks since the timer started counting.
+**/
+UINT64
+NormalizeTimeStamp (
+  IN UINT64     TimeStamp
+  )
+{
+  if (TimeStamp == 1) {
+    return 0;
+  }
+  if (TimerInfo.CountUp) {
+    return TimeStamp - TimerInfo.StartCount;
+  }
+  return TimerInfo.StartCount - TimeStamp;
+}
+
+/**
+  Append an open measurement to the gauge array.
+
+  @param[in]  Handle      Handle of the measurement.
+  @param[in]  Token       Token of the measurement.
+  @param[in]  Module      Module of the measurement.
+  @param[in]  TimeStamp   Start time stamp of the measurement.
+  @param[in]  Identifier  Identifier of the measurement.
+  @param[in]  CpuId       Processor the measurement was taken on.
+
+  @return     The new measurement.
+**/
+DP_GAUGE *
+AddGauge (
+  IN UINT64       Handle,
+  IN CONST CHAR8  *Token,
+  IN CONST CHAR8  *Module,
+  IN UINT64       TimeStamp,
+  IN UINT32       Identifier,
+  IN UINT32       CpuId
+  )
+{
+  DP_GAUGE        *Gauge;
+
+  Gauge             = &mDpGauges[mDpGaugeCount++];
+  Gauge->Handle     = Handle;
+  Gauge->Start      = NormalizeTimeStamp (TimeStamp);
+  Gauge->End        = DP_OPEN_GAUGE;
+  Gauge->Identifier = Identifier;
+  Gauge->CpuId      = CpuId;
+  Gauge->Parent     = DP_NO_PARENT;
+  AsciiStrnCpyS (Gauge->Token, sizeof (Gauge->Token), Token, sizeof (Gauge->Token) - 1);
+  AsciiStrnCpyS (Gauge->Module, sizeof (Gauge->Module), Module, sizeof (Gauge->Module) - 1);
+  SanitizeName (Gauge->Token);
+  SanitizeName (Gauge->Module);
+  return Gauge;
+}
+
+/**
+  Return a string of the binary performance log.
+
+  @param[in]  Id          ID of the string.
+
+  @return     The string, truncated to PERFORMANCE_BINARY_LOG_STRING_LENGTH characters.
+**/
+CONST CHAR8 *
+GetBinaryLogString (
+  IN UINT16       Id
+  )
+{
+  PERFORMANCE_BINARY_LOG_STRING   *Entry;
+
+  if (Id == PERFORMANCE_BINARY_LOG_STRING_ID_OVERFLOW) {
+    return "?";
+  }
+  if ((Id == PERFORMANCE_BINARY_LOG_STRING_ID_NONE) || (Id > mDpBinaryLog.StringCount)) {
+    return "";
+  }
+  Entry = &mDpBinaryLog.Strings[Id - 1];
+  if (Entry->Hash <= PERFORMANCE_BINARY_LOG_STRING_BUSY) {
+    return "";
+  }
+  return Entry->Name;
+}
+
+/**
+  Walk the records of the binary performance log.
+
+  Each end record closes the most recent open measurement of its processor
+  with the same Handle, Token, Module and Identifier.  End records without a
+  start record, which was overwritten, are ignored.
+
+  @param[in]  Capacity    Number of entries of the gauge array, 0 to only count the start records.
+
+  @return     The number of start records.
+**/
+UINTN
+WalkBinaryLog (
+  IN UINTN        Capacity
+  )
+{
+  PERFORMANCE_BINARY_LOG_RING     *Ring;
+  PERFORMANCE_BINARY_LOG_RECORD   *Record;
+  DP_GAUGE                        *Gauge;
+  CONST CHAR8                     *Token;
+  CONST CHAR8                     *Module;
+  UINTN                           StartCount;
+  UINTN                           Index;
+  UINT32                          RingIndex;
+  UINT32                          WriteCount;
+  UINT32                          Count;
+  UINT32                          Sequence;
+
+  StartCount = 0;
+  for (RingIndex = 0; RingIndex < mDpBinaryLog.RingCount; RingIndex++) {
+    Ring = (PERFORMANCE_BINARY_LOG_RING *) (mDpBinaryLog.Rings + RingIndex * mDpBinaryLog.RingLength);
+    if (Ring->CpuId == PERFORMANCE_BINARY_LOG_RING_FREE) {
+      continue;
+    }
+
+    WriteCount = Ring->WriteCount;
+    Count      = MIN (WriteCount, mDpBinaryLog.RingRecordCount);
+    for (Sequence = WriteCount - Count + 1; Count > 0; Sequence++, Count--) {
+      Record = (PERFORMANCE_BINARY_LOG_RECORD *) (Ring + 1) + ((Sequence - 1) & (mDpBinaryLog.RingRecordCount - 1));
+      if (Record->Sequence != Sequence) {
+        continue;
+      }
+
+      if (Record->Type == PERFORMANCE_BINARY_LOG_RECORD_START) {
+        if (StartCount < Capacity) {
+          AddGauge (
+            Record->Handle,
+            GetBinaryLogString (Record->TokenId),
+            GetBinaryLogString (Record->ModuleId),
+            Record->TimeStamp,
+            Record->Identifier,
+            Ring->CpuId
+            );
+        }
+        StartCount++;
+      } else if ((Record->Type == PERFORMANCE_BINARY_LOG_RECORD_END) && (Capacity != 0)) {
+        Token  = GetBinaryLogString (Record->TokenId);
+        Module = GetBinaryLogString (Record->ModuleId);
+        for (Index = mDpGaugeCount; Index > 0; Index--) {
+          Gauge = &mDpGauges[Index - 1];
+          if ((Gauge->End == DP_OPEN_GAUGE) &&
+              (Gauge->CpuId == Ring->CpuId) &&
+              (Gauge->Handle == Record->Handle) &&
+              (Gauge->Identifier == Record->Identifier) &&
+              (AsciiStrnCmp (Gauge->Token, Token, sizeof (Gauge->Token) - 1) == 0) &&
+              (AsciiStrnCmp (Gauge->Module, Module, sizeof (Gauge->Module) - 1) == 0)) {
+            Gauge->End = NormalizeTimeStamp (Record->TimeStamp);
+            break;
+          }
+        }
+      }
+    }
+  }
+  return StartCount;
+}
+
+/**
+  Read the complete measurements through the PerformanceLib.
+
+  @retval EFI_SUCCESS           The measurements are read.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the gauge array.
+**/
+EFI_STATUS
+LoadPerformanceLibGauges (
+  VOID
+  )
+{
+  MEASUREMENT_RECORD        Measurement;
+  DP_GAUGE                  *Gauge;
+  UINTN                     LogEntryKey;
+  UINTN                     Count;
+
+  Count       = 0;
+  LogEntryKey = 0;
+  while ((LogEntryKey = GetPerformanceMeasurementEx (
+                          LogEntryKey,
+                          &Measurement.Handle,
+                          &Measurement.Token,
+                          &Measurement.Module,
+                          &Measurement.StartTimeStamp,
+                          &Measurement.EndTimeStamp,
+                          &Measurement.Identifier)) != 0)
+  {
+    Count++;
+  }
+
+  mDpGauges = AllocateZeroPool ((Count + 1) * sizeof (DP_GAUGE));
+  if (mDpGauges == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  LogEntryKey = 0;
+  while ((mDpGaugeCount < Count) &&
+         ((LogEntryKey = GetPerformanceMeasurementEx (
+                           LogEntryKey,
+                           &Measurement.Handle,
+                           &Measurement.Token,
+                           &Measurement.Module,
+                           &Measurement.StartTimeStamp,
+                           &Measurement.EndTimeStamp,
+                           &Measurement.Identifier)) != 0))
+  {
+    if (Measurement.EndTimeStamp == 0) {
+      continue;
+    }
+    Gauge = AddGauge (
+              (UINT64) (UINTN) Measurement.Handle,
+              Measurement.Token,
+              Measurement.Module,
+              Measurement.StartTimeStamp,
+              Measurement.Identifier,
+              0
+              );
+    Gauge->End = NormalizeTimeStamp (Measurement.EndTimeStamp);
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Compare two measurements by processor, then start time, then the longest first
+  so that a measurement sorts before the ones it encloses.
+
+  @param[in] Buffer1    The pointer to the first DP_GAUGE.
+  @param[in] Buffer2    The pointer to the second DP_GAUGE.
+
+  @retval 0             Buffer1 equal to Buffer2.
+  @return <0            Buffer1 is less than Buffer2.
+  @return >0            Buffer1 is greater than Buffer2.
+**/
+INTN
+EFIAPI
+CompareGauge (
+  IN CONST VOID   *Buffer1,
+  IN CONST VOID   *Buffer2
+  )
+{
+  CONST DP_GAUGE  *Gauge1;
+  CONST DP_GAUGE  *Gauge2;
+
+  Gauge1 = (CONST DP_GAUGE *) Buffer1;
+  Gauge2 = (CONST DP_GAUGE *) Buffer2;
+  if (Gauge1->CpuId != Gauge2->CpuId) {
+    return (Gauge1->CpuId < Gauge2->CpuId) ? -1 : 1;
+  }
+  if (Gauge1->Start != Gauge2->Start) {
+    return (Gauge1->Start < Gauge2->Start) ? -1 : 1;
+  }
+  if (Gauge1->End != Gauge2->End) {
+    return (Gauge1->End > Gauge2->End) ? -1 : 1;
+  }
+  return 0;
+}
+
+/**
+  Find the innermost enclosing measurement of each measurement and compute the
+  time not covered by nested measurements.
+
+  @pre    The gauge array is sorted with CompareGauge().
+
+  @retval EFI_SUCCESS           The measurements are nested.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the nesting stack.
+**/
+EFI_STATUS
+NestGauges (
+  VOID
+  )
+{
+  UINT32      *Stack;
+  UINTN       Depth;
+  UINTN       Index;
+  DP_GAUGE    *Gauge;
+  DP_GAUGE    *Parent;
+  UINT64      Duration;
+
+  Stack = AllocatePool ((mDpGaugeCount + 1) * sizeof (UINT32));
+  if (Stack == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Depth = 0;
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    Gauge               = &mDpGauges[Index];
+    Duration            = Gauge->End - Gauge->Start;
+    Gauge->SelfDuration = Duration;
+    if ((Index > 0) && (Gauge->CpuId != mDpGauges[Index - 1].CpuId)) {
+      Depth = 0;
+    }
+
+    //
+    // Measurements which ended before this one ends, even if they overlap it,
+    // do not enclose it.
+    //
+    while ((Depth > 0) && (mDpGauges[Stack[Depth - 1]].End < Gauge->End)) {
+      Depth--;
+    }
+    if (Depth > 0) {
+      Gauge->Parent         = Stack[Depth - 1];
+      Parent                = &mDpGauges[Gauge->Parent];
+      Parent->SelfDuration -= MIN (Duration, Parent->SelfDuration);
+    }
+    Stack[Depth++] = (UINT32) Index;
+  }
+
+  FreePool (Stack);
+  return EFI_SUCCESS;
+}
+
+/**
+  Get a printable name for a code address from the image containing it.
+
+  @param[in]  Address       The code address.
+  @param[in]  ImageHandles  Handles of the loaded images.
+  @param[in]  ImageCount    Number of handles in ImageHandles.
+  @param[out] Name          The name, in the form ImageName+Offset.
+
+**/
+VOID
+GetNameFromAddress (
+  IN  UINT64          Address,
+  IN  EFI_HANDLE      *ImageHandles,
+  IN  UINTN           ImageCount,
+  OUT CHAR8           *Name
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_LOADED_IMAGE_PROTOCOL   *Image;
+  UINTN                       Index;
+
+  for (Index = 0; Index < ImageCount; Index++) {
+    Status = gBS->HandleProtocol (ImageHandles[Index], &gEfiLoadedImageProtocolGuid, (VOID **) &Image);
+    if (EFI_ERROR (Status) ||
+        (Address < (UINTN) Image->ImageBase) ||
+        (Address - (UINTN) Image->ImageBase >= Image->ImageSize)) {
+      continue;
+    }
+    GetNameFromHandle (ImageHandles[Index]);
+    AsciiSPrint (Name, DP_NAME_SIZE, "%s+0x%lx", mGaugeString, Address - (UINTN) Image->ImageBase);
+    return;
+  }
+  AsciiSPrint (Name, DP_NAME_SIZE, "0x%lx", Address);
+}
+
+/**
+  Give each measurement a printable name.
+
+  The name of a protocol notification is the image containing the function,
+  the name of a PEIM is its file GUID, the name of other measurements with a
+  handle is the driver name, else the module or the token.
+**/
+VOID
+NameGauges (
+  VOID
+  )
+{
+  EFI_STATUS    Status;
+  EFI_HANDLE    *ImageHandles;
+  UINTN         ImageCount;
+  UINTN         Index;
+  DP_GAUGE      *Gauge;
+
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiLoadedImageProtocolGuid, NULL, &ImageCount, &ImageHandles);
+  if (EFI_ERROR (Status)) {
+    ImageHandles = NULL;
+    ImageCount   = 0;
+  }
+
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    Gauge = &mDpGauges[Index];
+    if (AsciiStrCmp (Gauge->Token, PROTOCOL_NOTIFY_TOK) == 0) {
+      GetNameFromAddress (Gauge->Handle, ImageHandles, ImageCount, Gauge->Name);
+    } else if ((AsciiStrCmp (Gauge->Token, ALit_PEIM) == 0) && (Gauge->Handle != 0)) {
+      //
+      // PEIM FILE Handle is the start address of its FFS file that contains its file guid.
+      //
+      AsciiSPrint (Gauge->Name, DP_NAME_SIZE, "%g", (EFI_GUID *) (UINTN) Gauge->Handle);
+    } else if (Gauge->Handle != 0) {
+      GetNameFromHandle ((EFI_HANDLE) (UINTN) Gauge->Handle);
+      AsciiSPrint (Gauge->Name, DP_NAME_SIZE, "%s", mGaugeString);
+    } else if (Gauge->Module[0] != '\0') {
+      AsciiStrCpyS (Gauge->Name, DP_NAME_SIZE, Gauge->Module);
+    } else {
+      AsciiStrCpyS (Gauge->Name, DP_NAME_SIZE, Gauge->Token);
+    }
+    SanitizeName (Gauge->Name);
+  }
+
+  SafeFreePool (ImageHandles);
+}
+
+/**
+  Gather, pair, nest and name the complete Trace measurements.
+
+  When the binary performance log is used, its timer properties replace the
+  ones of the TimerLib of Dp.
+
+  @retval EFI_SUCCESS           The measurements are gathered.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to gather the measurements.
+**/
+EFI_STATUS
+LoadGauges (
+  VOID
+  )
+{
+  EFI_STATUS                      Status;
+  PERFORMANCE_BINARY_LOG_HEADER   *Header;
+  UINTN                           Count;
+  UINTN                           Index;
+
+  Header            = NULL;
+  mDpBinaryLogFound = FALSE;
+  Status = EfiGetSystemConfigurationTable (&gEdkiiPerformanceBinaryLogGuid, (VOID **) &Header);
+  if (!EFI_ERROR (Status) && (Header != NULL)) {
+    Status = (EFI_STATUS) PerformanceBinaryLogOpen (&mDpBinaryLog, Header, Header->Length);
+    mDpBinaryLogFound = (BOOLEAN) !EFI_ERROR (Status);
+  }
+
+  if (mDpBinaryLogFound) {
+    if (Header->TimerFrequency != 0) {
+      TimerInfo.StartCount = Header->TimerStartValue;
+      TimerInfo.EndCount   = Header->TimerEndValue;
+      TimerInfo.Frequency  = (UINT32) DivU64x32 (Header->TimerFrequency, 1000);
+      TimerInfo.CountUp    = (BOOLEAN) (TimerInfo.EndCount >= TimerInfo.StartCount);
+    }
+    Count     = WalkBinaryLog (0);
+    mDpGauges = AllocateZeroPool ((Count + 1) * sizeof (DP_GAUGE));
+    if (mDpGauges == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    WalkBinaryLog (Count);
+  } else {
+    Status = LoadPerformanceLibGauges ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Keep the complete measurements only.
+  //
+  Count = 0;
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    if ((mDpGauges[Index].End != DP_OPEN_GAUGE) && (mDpGauges[Index].End >= mDpGauges[Index].Start)) {
+      CopyMem (&mDpGauges[Count++], &mDpGauges[Index], sizeof (DP_GAUGE));
+    }
+  }
+  mDpGaugeCount = Count;
+
+  PerformQuickSort (mDpGauges, mDpGaugeCount, sizeof (DP_GAUGE), CompareGauge);
+  Status = NestGauges ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  NameGauges ();
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the gauge array.
+**/
+VOID
+FreeGauges (
+  VOID
+  )
+{
+  SafeFreePool (mDpGauges);
+  mDpGauges     = NULL;
+  mDpGaugeCount = 0;
+}
+
+/**
+  Convert a duration to nanoseconds.
+
+  @param[in]  Duration   The duration in timer ticks.
+
+  @return     The duration in nanoseconds.
+**/
+UINT64
+DurationInNanoSeconds (
+  IN UINT64 Duration
+  )
+{
+  return DivU64x32 (MultU64x32 (Duration, 1000000), TimerInfo.Frequency);
+}
+
+/**
+  Write the buffered export data into the export file.
+**/
+VOID
+ExportFlush (
+  VOID
+  )
+{
+  UINTN     Size;
+
+  if ((mExportLength != 0) && !EFI_ERROR (mExportStatus)) {
+    Size          = mExportLength;
+    mExportStatus = ShellWriteFile (mExportFile, &Size, mExportBuffer);
+  }
+  mExportLength = 0;
+}
+
+/**
+  Formatted print into the export file.
+
+  @param[in]  Format  Null-terminated ASCII format string, the output of one
+                      call is at most DP_EXPORT_LINE_SIZE - 1 characters.
+  @param[in]  ...     The variable argument list.
+
+**/
+VOID
+EFIAPI
+ExportPrint (
+  IN CONST CHAR8  *Format,
+  ...
+  )
+{
+  VA_LIST     Marker;
+
+  if (mExportLength + DP_EXPORT_LINE_SIZE > DP_EXPORT_BUFFER_SIZE) {
+    ExportFlush ();
+  }
+  VA_START (Marker, Format);
+  mExportLength += AsciiVSPrint (mExportBuffer + mExportLength, DP_EXPORT_LINE_SIZE, Format, Marker);
+  VA_END (Marker);
+}
+
+/**
+  Print a time in microseconds with a nanosecond fraction into the export file.
+
+  @param[in]  Ticks   The time in timer ticks.
+
+**/
+VOID
+ExportMicroSeconds (
+  IN UINT64   Ticks
+  )
+{
+  UINT32      Remainder;
+  UINT64      MicroSeconds;
+
+  MicroSeconds = DivU64x32Remainder (DurationInNanoSeconds (Ticks), 1000, &Remainder);
+  ExportPrint ("%ld.%03d", MicroSeconds, Remainder);
+}
+
+/**
+  Print the frame name of a measurement into the export file.
+
+  @param[in]  Gauge   The measurement.
+
+**/
+VOID
+ExportFrame (
+  IN DP_GAUGE   *Gauge
+  )
+{
+  UINTN       Length;
+
+  Length = AsciiStrLen (Gauge->Token);
+  if (AsciiStrCmp (Gauge->Token, Gauge->Name) == 0) {
+    ExportPrint ("%a", Gauge->Name);
+  } else if ((Length > 0) && (Gauge->Token[Length - 1] == ':')) {
+    ExportPrint ("%a%a", Gauge->Token, Gauge->Name);
+  } else {
+    ExportPrint ("%a:%a", Gauge->Token, Gauge->Name);
+  }
+}
+
+/**
+  Export the measurements as Chrome trace events, one complete event per
+  measurement with the processor as thread.
+**/
+VOID
+ExportChromeTrace (
+  VOID
+  )
+{
+  UINTN       Index;
+  DP_GAUGE    *Gauge;
+
+  ExportPrint ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    Gauge = &mDpGauges[Index];
+    ExportPrint (
+      "%a{\"name\":\"%a\",\"cat\":\"%a\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":",
+      (Index == 0) ? "" : ",\n",
+      Gauge->Name,
+      Gauge->Token,
+      Gauge->CpuId
+      );
+    ExportMicroSeconds (Gauge->Start);
+    ExportPrint (",\"dur\":");
+    ExportMicroSeconds (Gauge->End - Gauge->Start);
+    ExportPrint (
+      ",\"args\":{\"module\":\"%a\",\"handle\":\"0x%lx\",\"id\":%d}}",
+      Gauge->Module,
+      Gauge->Handle,
+      Gauge->Identifier
+      );
+  }
+  ExportPrint ("\n]}\n");
+}
+
+/**
+  Export the time not covered by nested measurements as collapsed stacks, one
+  line per measurement, as consumed by flame graph tools.  The processor is the
+  root frame when the measurements were taken on several processors.
+**/
+VOID
+ExportCollapsedStack (
+  VOID
+  )
+{
+  UINTN       Index;
+  UINTN       Depth;
+  UINT32      Stack[DP_MAX_STACK_DEPTH];
+  UINT32      Current;
+  BOOLEAN     MultiCpu;
+  UINT64      MicroSeconds;
+
+  MultiCpu = (BOOLEAN) ((mDpGaugeCount > 0) && (mDpGauges[0].CpuId != mDpGauges[mDpGaugeCount - 1].CpuId));
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    MicroSeconds = DurationInMicroSeconds (mDpGauges[Index].SelfDuration);
+    if (MicroSeconds == 0) {
+      continue;
+    }
+
+    Depth = 0;
+    for (Current = (UINT32) Index; (Current != DP_NO_PARENT) && (Depth < DP_MAX_STACK_DEPTH); Current = mDpGauges[Current].Parent) {
+      Stack[Depth++] = Current;
+    }
+
+    if (MultiCpu) {
+      ExportPrint ("CPU%d;", mDpGauges[Index].CpuId);
+    }
+    while (Depth > 1) {
+      ExportFrame (&mDpGauges[Stack[--Depth]]);
+      ExportPrint (";");
+    }
+    ExportFrame (&mDpGauges[Stack[0]]);
+    ExportPrint (" %ld\n", MicroSeconds);
+  }
+}
+
+/**
+  Export the measurements as comma separated values, times in microseconds.
+**/
+VOID
+ExportCsv (
+  VOID
+  )
+{
+  UINTN       Index;
+  DP_GAUGE    *Gauge;
+
+  ExportPrint ("Index,Cpu,Token,Module,Name,Handle,Identifier,Start,End,Duration,Self,Parent\n");
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    Gauge = &mDpGauges[Index];
+    ExportPrint (
+      "%d,%d,%a,%a,%a,0x%lx,%d,",
+      Index,
+      Gauge->CpuId,
+      Gauge->Token,
+      Gauge->Module,
+      Gauge->Name,
+      Gauge->Handle,
+      Gauge->Identifier
+      );
+    ExportMicroSeconds (Gauge->Start);
+    ExportPrint (",");
+    ExportMicroSeconds (Gauge->End);
+    ExportPrint (",");
+    ExportMicroSeconds (Gauge->End - Gauge->Start);
+    ExportPrint (",");
+    ExportMicroSeconds (Gauge->SelfDuration);
+    if (Gauge->Parent == DP_NO_PARENT) {
+      ExportPrint (",\n");
+    } else {
+      ExportPrint (",%d\n", Gauge->Parent);
+    }
+  }
+}
+
+/**
+  Write all complete Trace measurements into a file.
+
+  The measurements are read from the binary performance log if the platform
+  publishes one, through the PerformanceLib otherwise.
+
+  @param[in]    FileName      Name of the file to create, an existing file is replaced.
+  @param[in]    Format        Format of the file.
+
+  @retval EFI_SUCCESS           The file is written.
+  @retval EFI_NOT_FOUND         Format is DpExportRaw and there is no binary performance log.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to gather the measurements.
+  @return Others                from the file operations.
+**/
+EFI_STATUS
+ExportGauges (
+  IN CONST CHAR16      *FileName,
+  IN DP_EXPORT_FORMAT  Format
+  )
+{
+  EFI_STATUS    Status;
+  EFI_STATUS    CloseStatus;
+  UINTN         Size;
+
+  Status = LoadGauges ();
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+  if ((Format == DpExportRaw) && !mDpBinaryLogFound) {
+    Status = EFI_NOT_FOUND;
+    goto Done;
+  }
+
+  mExportBuffer = AllocatePool (DP_EXPORT_BUFFER_SIZE);
+  if (mExportBuffer == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  if (!EFI_ERROR (ShellFileExists (FileName))) {
+    Status = ShellDeleteFileByName (FileName);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+  }
+  Status = ShellOpenFileByName (
+             FileName,
+             &mExportFile,
+             EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+             0
+             );
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  mExportLength = 0;
+  mExportStatus = EFI_SUCCESS;
+  switch (Format) {
+  case DpExportChromeTrace:
+    ExportChromeTrace ();
+    break;
+  case DpExportCollapsedStack:
+    ExportCollapsedStack ();
+    break;
+  case DpExportCsv:
+    ExportCsv ();
+    break;
+  default:
+    Size          = mDpBinaryLog.Header->Length;
+    mExportStatus = ShellWriteFile (mExportFile, &Size, mDpBinaryLog.Header);
+    break;
+  }
+  ExportFlush ();
+
+  Status      = mExportStatus;
+  CloseStatus = ShellCloseFile (&mExportFile);
+  if (!EFI_ERROR (Status)) {
+    Status = CloseStatus;
+  }
+
+Done:
+  if (EFI_ERROR (Status)) {
+    PrintToken (STRING_TOKEN (STR_DP_EXPORT_ERROR), FileName, Status);
+  } else {
+    PrintToken (STRING_TOKEN (STR_DP_EXPORT_DONE), mDpGaugeCount, FileName);
+  }
+  SafeFreePool (mExportBuffer);
+  mExportBuffer = NULL;
+  FreeGauges ();
+  return Status;
+}
+
+/**
+  Determine whether a measurement is the dispatch of a module or a callback
+  from the core: a PEIM or image entry point, an image load, a driver binding
+  Supported() or Start() call or a protocol notification.
+
+  @param[in]  Gauge   The measurement.
+
+  @retval     TRUE    The measurement is a dispatch unit.
+  @retval     FALSE   The measurement is not a dispatch unit.
+**/
+BOOLEAN
+IsDispatchUnit (
+  IN DP_GAUGE   *Gauge
+  )
+{
+  return (BOOLEAN) ((AsciiStrCmp (Gauge->Token, ALit_PEIM) == 0) ||
+                    (AsciiStrCmp (Gauge->Token, START_IMAGE_TOK) == 0) ||
+                    (AsciiStrCmp (Gauge->Token, LOAD_IMAGE_TOK) == 0) ||
+                    (AsciiStrCmp (Gauge->Token, DRIVERBINDING_START_TOK) == 0) ||
+                    (AsciiStrCmp (Gauge->Token, DRIVERBINDING_SUPPORT_TOK) == 0) ||
+                    (AsciiStrCmp (Gauge->Token, PROTOCOL_NOTIFY_TOK) == 0));
+}
+
+/**
+  Determine whether a measurement is a dispatch unit not nested in another one.
+
+  @param[in]  Index   Index of the measurement.
+
+  @retval     TRUE    The measurement is an outermost dispatch unit.
+  @retval     FALSE   The measurement is not an outermost dispatch unit.
+**/
+BOOLEAN
+IsOutermostDispatchUnit (
+  IN UINT32     Index
+  )
+{
+  if (!IsDispatchUnit (&mDpGauges[Index])) {
+    return FALSE;
+  }
+  for (Index = mDpGauges[Index].Parent; Index != DP_NO_PARENT; Index = mDpGauges[Index].Parent) {
+    if (IsDispatchUnit (&mDpGauges[Index])) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Compare two measurement indexes by decreasing duration.
+
+  @param[in] Buffer1    The pointer to the first index.
+  @param[in] Buffer2    The pointer to the second index.
+
+  @retval 0             Buffer1 equal to Buffer2.
+  @return <0            Buffer1 is less than Buffer2.
+  @return >0            Buffer1 is greater than Buffer2.
+**/
+INTN
+EFIAPI
+CompareGaugeDuration (
+  IN CONST VOID   *Buffer1,
+  IN CONST VOID   *Buffer2
+  )
+{
+  UINT64          Duration1;
+  UINT64          Duration2;
+
+  Duration1 = mDpGauges[*(CONST UINT32 *) Buffer1].End - mDpGauges[*(CONST UINT32 *) Buffer1].Start;
+  Duration2 = mDpGauges[*(CONST UINT32 *) Buffer2].End - mDpGauges[*(CONST UINT32 *) Buffer2].Start;
+  if (Duration1 == Duration2) {
+    return 0;
+  }
+  return (Duration1 > Duration2) ? -1 : 1;
+}
+
+/**
+  Compare two attributions by decreasing cumulative duration.
+
+  @param[in] Buffer1    The pointer to the first DP_ATTRIBUTION.
+  @param[in] Buffer2    The pointer to the second DP_ATTRIBUTION.
+
+  @retval 0             Buffer1 equal to Buffer2.
+  @return <0            Buffer1 is less than Buffer2.
+  @return >0            Buffer1 is greater than Buffer2.
+**/
+INTN
+EFIAPI
+CompareAttribution (
+  IN CONST VOID   *Buffer1,
+  IN CONST VOID   *Buffer2
+  )
+{
+  CONST DP_ATTRIBUTION  *Attribution1;
+  CONST DP_ATTRIBUTION  *Attribution2;
+
+  Attribution1 = (CONST DP_ATTRIBUTION *) Buffer1;
+  Attribution2 = (CONST DP_ATTRIBUTION *) Buffer2;
+  if (Attribution1->Duration == Attribution2->Duration) {
+    return 0;
+  }
+  return (Attribution1->Duration > Attribution2->Duration) ? -1 : 1;
+}
+
+/**
+  Print a section header.
+
+  @param[in]  Token   A HII token of the section name.
+
+**/
+VOID
+PrintSectionHeader (
+  IN UINT16   Token
+  )
+{
+  EFI_STRING  StringPtr;
+  EFI_STRING  StringPtrUnknown;
+
+  StringPtrUnknown = HiiGetString (gHiiHandle, STRING_TOKEN (STR_ALIT_UNKNOWN), NULL);
+  StringPtr        = HiiGetString (gHiiHandle, Token, NULL);
+  PrintToken (STRING_TOKEN (STR_DP_SECTION_HEADER),
+              (StringPtr == NULL) ? StringPtrUnknown : StringPtr);
+  SafeFreePool (StringPtr);
+  SafeFreePool (StringPtrUnknown);
+}
+
+/**
+  Gather and print the dispatch critical path.
+
+  The outermost dispatch units of the boot processor run one after the other,
+  so each of them delays all the later ones: they form the critical path and
+  the longest ones are printed.  The time between them is spent in the core.
+
+  @param[in]    Limit         The number of records to print.  Zero is ALL.
+
+  @retval EFI_SUCCESS           The operation was successful.
+  @retval EFI_ABORTED           The user aborts the operation.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the path.
+**/
+EFI_STATUS
+ProcessCriticalPath (
+  IN UINTN      Limit
+  )
+{
+  UINT32        *Path;
+  UINTN         PathLength;
+  UINT32        Index;
+  UINT32        CpuId;
+  UINT64        Measured;
+  UINT64        Span;
+  UINT64        Duration;
+  DP_GAUGE      *Gauge;
+
+  PrintSectionHeader (STRING_TOKEN (STR_DP_SECTION_CRITICAL_PATH));
+  if (mDpGaugeCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The DXE phase measurement is taken on the boot processor.
+  //
+  CpuId = mDpGauges[0].CpuId;
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    if ((mDpGauges[Index].Module[0] == '\0') && (AsciiStrCmp (mDpGauges[Index].Token, ALit_DXE) == 0)) {
+      CpuId = mDpGauges[Index].CpuId;
+      break;
+    }
+  }
+
+  Path = AllocatePool (mDpGaugeCount * sizeof (UINT32));
+  if (Path == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  PathLength = 0;
+  Measured   = 0;
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    if ((mDpGauges[Index].CpuId == CpuId) && IsOutermostDispatchUnit (Index)) {
+      Path[PathLength++] = Index;
+      Measured          += mDpGauges[Index].End - mDpGauges[Index].Start;
+    }
+  }
+  if (PathLength == 0) {
+    FreePool (Path);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The path is in start time order, the last unit does not necessarily end last.
+  //
+  Span = 0;
+  for (Index = 0; Index < PathLength; Index++) {
+    Span = MAX (Span, mDpGauges[Path[Index]].End);
+  }
+  Span -= mDpGauges[Path[0]].Start;
+  PrintToken (
+    STRING_TOKEN (STR_DP_CRITICAL_PATH_SUMMARY),
+    PathLength,
+    DurationInMicroSeconds (Measured),
+    DurationInMicroSeconds (Span),
+    (Span == 0) ? 0 : (UINTN) DivU64x64Remainder (MultU64x32 (Measured, 100), Span, NULL)
+    );
+
+  PerformQuickSort (Path, PathLength, sizeof (UINT32), CompareGaugeDuration);
+  PrintToken (STRING_TOKEN (STR_DP_CRITICAL_PATH_HEADR));
+  PrintToken (STRING_TOKEN (STR_DP_DASHES));
+  for (Index = 0; (Index < PathLength) && WITHIN_LIMIT (Index, Limit); Index++) {
+    Gauge    = &mDpGauges[Path[Index]];
+    Duration = Gauge->End - Gauge->Start;
+    PrintToken (
+      STRING_TOKEN (STR_DP_CRITICAL_PATH_VARS),
+      Index + 1,
+      DurationInMicroSeconds (Gauge->Start),
+      DurationInMicroSeconds (Duration),
+      (Span == 0) ? 0 : (UINTN) DivU64x64Remainder (MultU64x32 (Duration, 100), Span, NULL),
+      Gauge->Token,
+      Gauge->Name
+      );
+    if (ShellGetExecutionBreakFlag ()) {
+      FreePool (Path);
+      return EFI_ABORTED;
+    }
+  }
+
+  FreePool (Path);
+  return EFI_SUCCESS;
+}
+
+/**
+  Accumulate a duration into an attribution table.
+
+  @param[in, out] Table     The attribution table.
+  @param[in, out] Count     The number of entries of Table.
+  @param[in]      Key       The key of the entry to accumulate into.
+  @param[in]      Duration  The duration in timer ticks.
+
+  @return         The entry, its Name is empty if it was just added.
+**/
+DP_ATTRIBUTION *
+AttributeDuration (
+  IN OUT DP_ATTRIBUTION   *Table,
+  IN OUT UINTN            *Count,
+  IN     UINT64           Key,
+  IN     UINT64           Duration
+  )
+{
+  UINTN                   Index;
+  DP_ATTRIBUTION          *Entry;
+
+  for (Index = 0; Index < *Count; Index++) {
+    if (Table[Index].Key == Key) {
+      break;
+    }
+  }
+  Entry = &Table[Index];
+  if (Index == *Count) {
+    ZeroMem (Entry, sizeof (DP_ATTRIBUTION));
+    Entry->Key = Key;
+    (*Count)++;
+  }
+  Entry->Count++;
+  Entry->Duration   += Duration;
+  Entry->MaxDuration = MAX (Entry->MaxDuration, Duration);
+  return Entry;
+}
+
+/**
+  Sort and print an attribution table.
+
+  @param[in]  Token     A HII token of the section name.
+  @param[in]  Table     The attribution table.
+  @param[in]  Count     The number of entries of Table.
+  @param[in]  Limit     The number of entries to print.  Zero is ALL.
+
+  @retval EFI_SUCCESS   The operation was successful.
+  @retval EFI_ABORTED   The user aborts the operation.
+**/
+EFI_STATUS
+PrintAttribution (
+  IN UINT16             Token,
+  IN DP_ATTRIBUTION     *Table,
+  IN UINTN              Count,
+  IN UINTN              Limit
+  )
+{
+  UINTN                 Index;
+
+  PrintSectionHeader (Token);
+  PrintToken (STRING_TOKEN (STR_DP_ATTRIBUTION_HEADR));
+  PrintToken (STRING_TOKEN (STR_DP_DASHES));
+  PerformQuickSort (Table, Count, sizeof (DP_ATTRIBUTION), CompareAttribution);
+  for (Index = 0; (Index < Count) && WITHIN_LIMIT (Index, Limit); Index++) {
+    PrintToken (
+      STRING_TOKEN (STR_DP_ATTRIBUTION_VARS),
+      Index + 1,
+      Table[Index].Count,
+      DurationInMicroSeconds (Table[Index].Duration),
+      DurationInMicroSeconds (Table[Index].MaxDuration),
+      Table[Index].Name
+      );
+    if (ShellGetExecutionBreakFlag ()) {
+      return EFI_ABORTED;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Find the firmware volume a measurement of a PEIM or an image was dispatched from.
+
+  @param[in]  Gauge       The measurement.
+  @param[in]  FvHandles   Handles of the firmware volume block protocol instances.
+  @param[in]  FvCount     Number of handles in FvHandles.
+
+  @return     The handle of the firmware volume, NULL if it is not found.
+**/
+EFI_HANDLE
+GetGaugeFv (
+  IN DP_GAUGE     *Gauge,
+  IN EFI_HANDLE   *FvHandles,
+  IN UINTN        FvCount
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_LOADED_IMAGE_PROTOCOL           *Image;
+  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb;
+  EFI_PHYSICAL_ADDRESS                Address;
+  EFI_FIRMWARE_VOLUME_HEADER          *FwVolHeader;
+  UINTN                               Index;
+
+  if (AsciiStrCmp (Gauge->Token, ALit_PEIM) != 0) {
+    Status = gBS->HandleProtocol ((EFI_HANDLE) (UINTN) Gauge->Handle, &gEfiLoadedImageProtocolGuid, (VOID **) &Image);
+    return EFI_ERROR (Status) ? NULL : Image->DeviceHandle;
+  }
+
+  //
+  // PEIM FILE Handle is the start address of its FFS file in the firmware volume.
+  //
+  for (Index = 0; Index < FvCount; Index++) {
+    Status = gBS->HandleProtocol (FvHandles[Index], &gEfiFirmwareVolumeBlockProtocolGuid, (VOID **) &Fvb);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+    Status = Fvb->GetPhysicalAddress (Fvb, &Address);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+    FwVolHeader = (EFI_FIRMWARE_VOLUME_HEADER *) (UINTN) Address;
+    if ((Gauge->Handle >= Address) && (Gauge->Handle - Address < FwVolHeader->FvLength)) {
+      return FvHandles[Index];
+    }
+  }
+  return NULL;
+}
+
+/**
+  Gather and print the dispatch critical path and the time attributed to
+  firmware volumes, driver binding Start() and protocol notification functions.
+
+  @param[in]    Limit         The number of records to print in each section.  Zero is ALL.
+
+  @retval EFI_SUCCESS           The operation was successful.
+  @retval EFI_ABORTED           The user aborts the operation.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to gather the measurements.
+**/
+EFI_STATUS
+ProcessDispatch (
+  IN UINTN             Limit
+  )
+{
+  EFI_STATUS                Status;
+  DP_ATTRIBUTION            *Table;
+  DP_ATTRIBUTION            *Entry;
+  UINTN                     Count;
+  UINT32                    Index;
+  DP_GAUGE                  *Gauge;
+  EFI_HANDLE                *FvHandles;
+  UINTN                     FvCount;
+  EFI_HANDLE                FvHandle;
+  CHAR16                    *DevicePathText;
+  EFI_STRING                StringPtrUnknown;
+
+  Table = NULL;
+  Status = LoadGauges ();
+  if (!EFI_ERROR (Status)) {
+    Status = ProcessCriticalPath (Limit);
+  }
+  if (!EFI_ERROR (Status)) {
+    Table = AllocatePool ((mDpGaugeCount + 1) * sizeof (DP_ATTRIBUTION));
+    if (Table == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+  }
+  if (EFI_ERROR (Status)) {
+    FreeGauges ();
+    return Status;
+  }
+
+  //
+  // Time by firmware volume: image loads and entry points of the outermost
+  // dispatch units, so nested ones are not counted twice.
+  //
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiFirmwareVolumeBlockProtocolGuid, NULL, &FvCount, &FvHandles);
+  if (EFI_ERROR (Status)) {
+    FvHandles = NULL;
+    FvCount   = 0;
+  }
+  StringPtrUnknown = HiiGetString (gHiiHandle, STRING_TOKEN (STR_ALIT_UNKNOWN), NULL);
+  Count = 0;
+  for (Index = 0; Index < mDpGaugeCount; Index++) {
+    Gauge = &mDpGauges[Index];
+    if (((AsciiStrCmp (Gauge->Token, ALit_PEIM) != 0) &&
+         (AsciiStrCmp (Gauge->Token, START_IMAGE_TOK) != 0) &&
+         (AsciiStrCmp (Gauge->Token, LOAD_IMAGE_TOK) != 0)) ||
+        !IsOutermostDispatchUnit (Index)) {
+      continue;
+    }
+    FvHandle = GetGaugeFv (Gauge, FvHandles, FvCount);
+    Entry    = AttributeDuration (Table, &Count, (UINT64) (UINTN) FvHandle, Gauge->End - Gauge->Start);
+    if (Entry->Name[0] == L'\0') {
+      DevicePathText = NULL;
+      if (FvHandle != NULL) {
+        DevicePathText = ConvertDevicePathToText (DevicePathFromHandle (FvHandle), TRUE, TRUE);
+      }
+      if (DevicePathText != NULL) {
+        StrnCpyS (Entry->Name, DP_NAME_SIZE, DevicePathText, DP_NAME_SIZE - 1);
+        FreePool (DevicePathText);
+      } else if (StringPtrUnknown != NULL) {
+        StrnCpyS (Entry->Name, DP_NAME_SIZE, StringPtrUnknown, DP_NAME_SIZE - 1);
+      }
+    }
+  }
+  SafeFreePool (StringPtrUnknown);
+  SafeFreePool (FvHandles);
+  Status = PrintAttribution (STRING_TOKEN (STR_DP_SECTION_BY_FV), Table, Count, Limit);
+
+  //
+  // Time by driver binding Start() and by protocol notification function.
+  //
+  if (!EFI_ERROR (Status)) {
+    Count = 0;
+    for (Index = 0; Index < mDpGaugeCount; Index++) {
+      Gauge = &mDpGauges[Index];
+      if (AsciiStrCmp (Gauge->Token, DRIVERBINDING_START_TOK) == 0) {
+        Entry = AttributeDuration (Table, &Count, Gauge->Handle, Gauge->End - Gauge->Start);
+        AsciiStrToUnicodeStrS (Gauge->Name, Entry->Name, DP_NAME_SIZE);
+      }
+    }
+    Status = PrintAttribution (STRING_TOKEN (STR_DP_SECTION_BY_START), Table, Count, Limit);
+  }
+  if (!EFI_ERROR (Status)) {
+    Count = 0;
+    for (Index = 0; Index < mDpGaugeCount; Index++) {
+      Gauge = &mDpGauges[Index];
+      if (AsciiStrCmp (Gauge->Token, PROTOCOL_NOTIFY_TOK) == 0) {
+        Entry = AttributeDuration (Table, &Count, Gauge->Handle, Gauge->End - Gauge->Start);
+        AsciiStrToUnicodeStrS (Gauge->Name, Entry->Name, DP_NAME_SIZE);
+      }
+    }
+    Status = PrintAttribution (STRING_TOKEN (STR_DP_SECTION_BY_NOTIFY), Table, Count, Limit);
+  }
+
+  FreePool (Table);
+  FreeGauges ();
+  return Status;
+}
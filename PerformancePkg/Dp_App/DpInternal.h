@@ -371,6 +371,41 @@ DumpRawProfile(
   IN BOOLEAN        ExcludeFlag
   );
 
+/**
+  Write all complete Trace measurements into a file.
+
+  The measurements are read from the binary performance log if the platform
+  publishes one, through the PerformanceLib otherwise.
+
+  @param[in]    FileName      Name of the file to create, an existing file is replaced.
+  @param[in]    Format        Format of the file.
+
+  @retval EFI_SUCCESS           The file is written.
+  @retval EFI_NOT_FOUND         Format is DpExportRaw and there is no binary performance log.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to gather the measurements.
+  @return Others                from the file operations.
+**/
+EFI_STATUS
+ExportGauges (
+  IN CONST CHAR16      *FileName,
+  IN DP_EXPORT_FORMAT  Format
+  );
+
+/**
+  Gather and print the dispatch critical path and the time attributed to
+  firmware volumes, driver binding Start() and protocol notification functions.
+
+  @param[in]    Limit         The number of records to print in each section.  Zero is ALL.
+
+  @retval EFI_SUCCESS           The operation was successful.
+  @retval EFI_ABORTED           The user aborts the operation.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to gather the measurements.
+**/
+EFI_STATUS
+ProcessDispatch (
+  IN UINTN             Limit
+  );
+
 /**
   Wrap original FreePool to check NULL pointer first.
 
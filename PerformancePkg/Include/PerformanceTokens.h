@@ -24,5 +24,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define DRIVERBINDING_SUPPORT_TOK       "DB:Support:"     ///< Driver Binding Support() function call
 #define LOAD_IMAGE_TOK                  "LoadImage:"      ///< Load a dispatched module
 #define START_IMAGE_TOK                 "StartImage:"     ///< Dispatched Modules Entry Point execution
+#define PROTOCOL_NOTIFY_TOK             "ProtocolNotify:" ///< Protocol notification function call, Handle is the function
+#define PEIM_TOK                        "PEIM"            ///< PEIM Entry Point execution
 
 #endif  // __PERFORMANCE_TOKENS_H__